@@ -0,0 +1,445 @@
+#include "amg.hpp"
+#include "parallel.hpp"
+#include "vector_ops.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+  // Ennél nagyobb legdurvább szintet nem faktorizálunk sűrűn, hanem simítással közelítjük
+  const int maxDenseCoarse = 2000;
+
+  std::vector<double> inverse_diagonal(const CsrMatrix &A)
+  {
+    const std::vector<int> diag = A.pattern->diagonal_positions();
+    std::vector<double> inv(diag.size(), 1.0);
+    for (std::size_t i = 0; i < diag.size(); ++i)
+    {
+      const double d = diag[i] >= 0 ? A.values[static_cast<std::size_t>(diag[i])] : 0.0;
+      inv[i] = d != 0.0 ? 1.0 / d : 1.0;
+    }
+    return inv;
+  }
+
+  // rho(D^{-1} A) becslése: néhány hatványiteráció, felülről a Gershgorin korláttal vágva
+  double estimate_spectral_radius(const CsrMatrix &A, const std::vector<double> &invDiag)
+  {
+    const CsrPattern &P = *A.pattern;
+    const std::size_t n = static_cast<std::size_t>(P.rows);
+    double gershgorin = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      double row = 0.0;
+      for (int k = P.rowPtr[i]; k < P.rowPtr[i + 1]; ++k)
+      {
+        row += std::fabs(A.values[static_cast<std::size_t>(k)]);
+      }
+      gershgorin = std::max(gershgorin, row * std::fabs(invDiag[i]));
+    }
+
+    // Determinisztikus, nem sima kezdővektor, hogy a magas frekvenciás módusok is jelen legyenek
+    std::vector<double> x(n), y(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      x[i] = 1.0 + 0.5 * std::sin(static_cast<double>(i) * 1.7);
+    }
+    double rho = 0.0;
+    for (int it = 0; it < 15; ++it)
+    {
+      const double xNorm = norm2(x);
+      if (xNorm == 0.0)
+      {
+        break;
+      }
+      scale(1.0 / xNorm, x);
+      A.multiply(x, y);
+      parallel_for(0, n, [&](std::size_t i) { y[i] *= invDiag[i]; });
+      rho = norm2(y);
+      x.swap(y);
+    }
+    if (rho <= 0.0)
+    {
+      return gershgorin > 0.0 ? gershgorin : 1.0;
+    }
+    return std::min(1.05 * rho, gershgorin > 0.0 ? gershgorin : 1.05 * rho);
+  }
+
+  // Mohó aggregáció (Vanek-Mandel-Brezina) az erős kapcsolatok gráfján.
+  // Visszatér az aggregátumok számával; aggregate[i] a csomópont aggregátuma.
+  int aggregate_nodes(const CsrMatrix &A, double theta, std::vector<int> &aggregate)
+  {
+    const CsrPattern &P = *A.pattern;
+    const std::size_t n = static_cast<std::size_t>(P.rows);
+    const std::vector<int> diag = P.diagonal_positions();
+
+    // Erős szomszédok listája
+    std::vector<int> strongPtr(n + 1, 0);
+    std::vector<int> strongCol;
+    std::vector<double> strongVal;
+    strongCol.reserve(P.colIdx.size());
+    strongVal.reserve(P.colIdx.size());
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double aii = diag[i] >= 0 ? std::fabs(A.values[static_cast<std::size_t>(diag[i])]) : 0.0;
+      for (int k = P.rowPtr[i]; k < P.rowPtr[i + 1]; ++k)
+      {
+        const std::size_t j = static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)]);
+        if (j == i)
+        {
+          continue;
+        }
+        const double ajj = diag[j] >= 0 ? std::fabs(A.values[static_cast<std::size_t>(diag[j])]) : 0.0;
+        const double aij = std::fabs(A.values[static_cast<std::size_t>(k)]);
+        if (aij > 0.0 && aij >= theta * std::sqrt(aii * ajj))
+        {
+          strongCol.push_back(static_cast<int>(j));
+          strongVal.push_back(aij);
+        }
+      }
+      strongPtr[i + 1] = static_cast<int>(strongCol.size());
+    }
+
+    aggregate.assign(n, -1);
+    int count = 0;
+
+    // 1. fázis: olyan csomópont + teljes erős szomszédsága, ahol még senki sincs aggregálva
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (aggregate[i] >= 0 || strongPtr[i] == strongPtr[i + 1])
+      {
+        continue;
+      }
+      bool free = true;
+      for (int k = strongPtr[i]; k < strongPtr[i + 1] && free; ++k)
+      {
+        free = aggregate[static_cast<std::size_t>(strongCol[static_cast<std::size_t>(k)])] < 0;
+      }
+      if (!free)
+      {
+        continue;
+      }
+      aggregate[i] = count;
+      for (int k = strongPtr[i]; k < strongPtr[i + 1]; ++k)
+      {
+        aggregate[static_cast<std::size_t>(strongCol[static_cast<std::size_t>(k)])] = count;
+      }
+      ++count;
+    }
+
+    // 2. fázis: a maradék a legerősebben kapcsolt (1. fázisbeli) szomszéd aggregátumához csatlakozik
+    const std::vector<int> phase1 = aggregate;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (aggregate[i] >= 0)
+      {
+        continue;
+      }
+      double best = -1.0;
+      for (int k = strongPtr[i]; k < strongPtr[i + 1]; ++k)
+      {
+        const int a = phase1[static_cast<std::size_t>(strongCol[static_cast<std::size_t>(k)])];
+        if (a >= 0 && strongVal[static_cast<std::size_t>(k)] > best)
+        {
+          best = strongVal[static_cast<std::size_t>(k)];
+          aggregate[i] = a;
+        }
+      }
+    }
+
+    // 3. fázis: ami még mindig szabad, a szabad erős szomszédaival új aggregátumot alkot
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (aggregate[i] >= 0)
+      {
+        continue;
+      }
+      aggregate[i] = count;
+      for (int k = strongPtr[i]; k < strongPtr[i + 1]; ++k)
+      {
+        const std::size_t j = static_cast<std::size_t>(strongCol[static_cast<std::size_t>(k)]);
+        if (aggregate[j] < 0)
+        {
+          aggregate[j] = count;
+        }
+      }
+      ++count;
+    }
+    return count;
+  }
+
+  // Tentatív prolongátor: T(i, aggregate[i]) = 1 / sqrt(|aggregátum|)
+  CsrMatrix tentative_prolongator(const std::vector<int> &aggregate, int count)
+  {
+    std::vector<int> size(static_cast<std::size_t>(count), 0);
+    for (int a : aggregate)
+    {
+      ++size[static_cast<std::size_t>(a)];
+    }
+    std::shared_ptr<CsrPattern> pattern = std::make_shared<CsrPattern>();
+    pattern->rows = static_cast<int>(aggregate.size());
+    pattern->cols = count;
+    pattern->rowPtr.resize(aggregate.size() + 1);
+    pattern->colIdx = aggregate;
+    CsrMatrix T;
+    T.values.resize(aggregate.size());
+    for (std::size_t i = 0; i < aggregate.size(); ++i)
+    {
+      pattern->rowPtr[i] = static_cast<int>(i);
+      T.values[i] = 1.0 / std::sqrt(static_cast<double>(size[static_cast<std::size_t>(aggregate[i])]));
+    }
+    pattern->rowPtr[aggregate.size()] = static_cast<int>(aggregate.size());
+    T.pattern = pattern;
+    return T;
+  }
+
+  std::size_t csr_bytes(const CsrMatrix &M)
+  {
+    return M.pattern ? M.memory_bytes() + M.pattern->memory_bytes() : 0;
+  }
+}
+
+AmgPreconditioner::AmgPreconditioner(const CsrMatrix &A, const AmgOptions &options)
+    : m_fine(A), m_options(options)
+{
+  m_levels.emplace_back();
+  while (true)
+  {
+    const std::size_t l = m_levels.size() - 1;
+    const CsrMatrix &Al = level_matrix(l);
+    m_levels[l].invDiag = inverse_diagonal(Al);
+    const double omega = 4.0 / (3.0 * estimate_spectral_radius(Al, m_levels[l].invDiag));
+    m_levels[l].omega = omega;
+
+    const int n = Al.rows();
+    if (n <= m_options.coarseSize || static_cast<int>(m_levels.size()) >= m_options.maxLevels)
+    {
+      break;
+    }
+    std::vector<int> aggregate;
+    const int count = aggregate_nodes(Al, m_options.strength, aggregate);
+    if (count <= 0 || count >= n - n / 10)
+    {
+      break; // a durvítás elakadt, nincs értelme újabb szintnek
+    }
+
+    // P = (I - w D^{-1} A) T; A*T mintázata tartalmazza T mintázatát (a diagonális miatt)
+    const CsrMatrix T = tentative_prolongator(aggregate, count);
+    CsrMatrix P = csr_multiply(Al, T);
+    const std::vector<double> &invDiag = m_levels[l].invDiag;
+    parallel_for(0, static_cast<std::size_t>(n), [&](std::size_t i) {
+      for (int k = P.pattern->rowPtr[i]; k < P.pattern->rowPtr[i + 1]; ++k)
+      {
+        P.values[static_cast<std::size_t>(k)] *= -omega * invDiag[i];
+      }
+      const int pos = P.pattern->find(static_cast<int>(i), aggregate[i]);
+      if (pos >= 0)
+      {
+        P.values[static_cast<std::size_t>(pos)] += T.values[i];
+      }
+    });
+    CsrMatrix R = csr_transpose(P);
+    CsrMatrix coarse = csr_multiply(R, csr_multiply(Al, P));
+
+    m_levels[l].P = P;
+    m_levels[l].R = R;
+    m_levels.emplace_back();
+    m_levels.back().A = coarse;
+  }
+
+  for (std::size_t l = 0; l < m_levels.size(); ++l)
+  {
+    const std::size_t n = static_cast<std::size_t>(level_matrix(l).rows());
+    m_levels[l].x.resize(n);
+    m_levels[l].b.resize(n);
+    m_levels[l].r.resize(n);
+    m_levels[l].tmp.resize(n);
+  }
+  factor_coarse(level_matrix(m_levels.size() - 1));
+}
+
+void AmgPreconditioner::factor_coarse(const CsrMatrix &A)
+{
+  const int n = A.rows();
+  if (n > maxDenseCoarse)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] AMG: a legdurvább szint túl nagy (" << n
+              << "), direkt megoldás helyett simítást használok.\n";
+    m_coarseN = 0;
+    m_coarseL.clear();
+    return;
+  }
+  const std::size_t N = static_cast<std::size_t>(n);
+  std::vector<double> dense(N * N, 0.0);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    for (int k = A.pattern->rowPtr[i]; k < A.pattern->rowPtr[i + 1]; ++k)
+    {
+      dense[i * N + static_cast<std::size_t>(A.pattern->colIdx[static_cast<std::size_t>(k)])] = A.values[static_cast<std::size_t>(k)];
+    }
+  }
+
+  // Sűrű Cholesky; numerikus elakadásnál kis relatív eltolással újra
+  double shift = 0.0;
+  while (true)
+  {
+    m_coarseL.assign(N * N, 0.0);
+    bool ok = true;
+    for (std::size_t j = 0; j < N && ok; ++j)
+    {
+      double d = dense[j * N + j] * (1.0 + shift);
+      for (std::size_t k = 0; k < j; ++k)
+      {
+        d -= m_coarseL[j * N + k] * m_coarseL[j * N + k];
+      }
+      if (d <= 0.0)
+      {
+        ok = false;
+        break;
+      }
+      const double ljj = std::sqrt(d);
+      m_coarseL[j * N + j] = ljj;
+      for (std::size_t i = j + 1; i < N; ++i)
+      {
+        double s = dense[i * N + j];
+        for (std::size_t k = 0; k < j; ++k)
+        {
+          s -= m_coarseL[i * N + k] * m_coarseL[j * N + k];
+        }
+        m_coarseL[i * N + j] = s / ljj;
+      }
+    }
+    if (ok)
+    {
+      break;
+    }
+    shift = shift == 0.0 ? 1e-10 : shift * 100.0;
+    if (shift > 1.0)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] AMG: a durva Cholesky faktorizáció nem sikerült, simítást használok.\n";
+      m_coarseN = 0;
+      m_coarseL.clear();
+      return;
+    }
+  }
+  m_coarseN = n;
+}
+
+void AmgPreconditioner::coarse_solve(std::vector<double> &x, const std::vector<double> &b) const
+{
+  const std::size_t N = static_cast<std::size_t>(m_coarseN);
+  // L y = b, majd L^T x = y
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    double s = b[i];
+    for (std::size_t k = 0; k < i; ++k)
+    {
+      s -= m_coarseL[i * N + k] * x[k];
+    }
+    x[i] = s / m_coarseL[i * N + i];
+  }
+  for (std::size_t i = N; i-- > 0;)
+  {
+    double s = x[i];
+    for (std::size_t k = i + 1; k < N; ++k)
+    {
+      s -= m_coarseL[k * N + i] * x[k];
+    }
+    x[i] = s / m_coarseL[i * N + i];
+  }
+}
+
+void AmgPreconditioner::smooth(std::size_t l, int sweeps) const
+{
+  const Level &L = m_levels[l];
+  const CsrMatrix &A = level_matrix(l);
+  const std::size_t n = L.x.size();
+  for (int s = 0; s < sweeps; ++s)
+  {
+    A.multiply(L.x, L.tmp);
+    parallel_for(0, n, [&](std::size_t i) { L.x[i] += L.omega * L.invDiag[i] * (L.b[i] - L.tmp[i]); });
+  }
+}
+
+void AmgPreconditioner::cycle(std::size_t l) const
+{
+  const Level &L = m_levels[l];
+  const std::size_t n = L.x.size();
+  const int sweeps = std::max(m_options.sweeps, 1);
+
+  if (l + 1 == m_levels.size())
+  {
+    if (m_coarseN > 0)
+    {
+      coarse_solve(L.x, L.b);
+    }
+    else
+    {
+      std::fill(L.x.begin(), L.x.end(), 0.0);
+      smooth(l, 4 * sweeps);
+    }
+    return;
+  }
+
+  // Elősimítás nulla kezdőértékről: az első Jacobi lépés szorzás nélkül
+  parallel_for(0, n, [&](std::size_t i) { L.x[i] = L.omega * L.invDiag[i] * L.b[i]; });
+  smooth(l, sweeps - 1);
+
+  // Durvarács korrekció: b_c = R (b - A x), x += P x_c
+  level_matrix(l).multiply(L.x, L.r);
+  parallel_for(0, n, [&](std::size_t i) { L.r[i] = L.b[i] - L.r[i]; });
+  const Level &C = m_levels[l + 1];
+  L.R.multiply(L.r, C.b);
+  cycle(l + 1);
+  L.P.multiply_add(1.0, C.x, L.x);
+
+  smooth(l, sweeps);
+}
+
+void AmgPreconditioner::apply(const std::vector<double> &r, std::vector<double> &z) const
+{
+  const Level &L = m_levels.front();
+  std::copy(r.begin(), r.end(), L.b.begin());
+  cycle(0);
+  z.resize(r.size());
+  std::copy(L.x.begin(), L.x.end(), z.begin());
+}
+
+std::size_t AmgPreconditioner::memory_bytes() const
+{
+  std::size_t bytes = m_coarseL.size() * sizeof(double);
+  for (std::size_t l = 0; l < m_levels.size(); ++l)
+  {
+    const Level &L = m_levels[l];
+    bytes += csr_bytes(L.A) + csr_bytes(L.P) + csr_bytes(L.R);
+    bytes += (L.invDiag.size() + L.x.size() + L.b.size() + L.r.size() + L.tmp.size()) * sizeof(double);
+  }
+  return bytes;
+}
+
+double AmgPreconditioner::operator_complexity() const
+{
+  const double fine = static_cast<double>(m_fine.pattern->nnz());
+  double total = 0.0;
+  for (std::size_t l = 0; l < m_levels.size(); ++l)
+  {
+    total += static_cast<double>(level_matrix(l).pattern->nnz());
+  }
+  return fine > 0.0 ? total / fine : 1.0;
+}
+
+std::string AmgPreconditioner::details() const
+{
+  std::ostringstream out;
+  out << "AMG " << m_levels.size() << " szint, n = ";
+  for (std::size_t l = 0; l < m_levels.size(); ++l)
+  {
+    out << (l > 0 ? "/" : "") << level_matrix(l).rows();
+  }
+  out.setf(std::ios::fixed);
+  out.precision(2);
+  out << ", operátor komplexitás " << operator_complexity()
+      << (m_coarseN > 0 ? ", durva: Cholesky" : ", durva: Jacobi");
+  return out.str();
+}
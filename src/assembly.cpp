@@ -0,0 +1,518 @@
+#include "assembly.hpp"
+#include "parallel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  std::string lookup_phys_name(const Mesh &mesh, int phys)
+  {
+    std::map<int, std::string>::const_iterator it = mesh.physNames.find(phys);
+    if (it != mesh.physNames.end())
+    {
+      return it->second;
+    }
+    return std::string();
+  }
+
+  // P1 lokális mátrixok: unitMass = integral N_i N_j, unitStiff = integral grad N_i . grad N_j
+  void local_matrices(const ElementGeometry &geo, double unitMass[9], double unitStiff[9])
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        unitMass[i * 3 + j] = geo.area / 12.0 * (i == j ? 2.0 : 1.0);
+        unitStiff[i * 3 + j] = geo.area * (geo.b[i] * geo.b[j] + geo.c[i] * geo.c[j]);
+      }
+    }
+  }
+}
+
+std::size_t DiffusionSystem::memory_bytes() const
+{
+  std::size_t bytes = pattern ? pattern->memory_bytes() : 0;
+  for (const CsrMatrix &m : groupMatrix)
+  {
+    bytes += m.memory_bytes();
+  }
+  for (const GroupCoupling &c : scatter)
+  {
+    bytes += c.matrix.memory_bytes();
+  }
+  for (const GroupCoupling &c : fission)
+  {
+    bytes += c.matrix.memory_bytes();
+  }
+  bytes += mass.memory_bytes();
+  bytes += elementMaterial.size() * sizeof(int);
+  bytes += geometry.size() * sizeof(ElementGeometry);
+  bytes += elementSlots.size() * sizeof(int);
+  bytes += coloring.order.size() * sizeof(int);
+  bytes += nodeVolume.size() * sizeof(double);
+  return bytes;
+}
+
+std::vector<int> resolve_element_materials(const Mesh &mesh, const XsLibrary &library)
+{
+  // Fizikai csoport id -> anyagindex, egyszer kiszámolva
+  std::map<int, int> physToMaterial;
+  for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+  {
+    physToMaterial[it->first] = library.material_index(it->second);
+  }
+
+  std::vector<int> result(mesh.tris.size(), -1);
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    const int phys = mesh.tris[e].phys;
+    std::map<int, int>::const_iterator it = physToMaterial.find(phys);
+    if (it == physToMaterial.end() || it->second < 0)
+    {
+      throw AssemblyError("Nincs keresztmetszet anyag a(z) " + std::to_string(e + 1) + ". háromszöghöz (phys=" +
+                          std::to_string(phys) + ", név: \"" + lookup_phys_name(mesh, phys) + "\").");
+    }
+    result[e] = it->second;
+  }
+  return result;
+}
+
+std::vector<ElementGeometry> compute_element_geometry(const Mesh &mesh)
+{
+  std::vector<ElementGeometry> geometry(mesh.tris.size());
+  std::atomic<bool> degenerate(false);
+  parallel_for(0, mesh.tris.size(), [&](std::size_t e) {
+    const Mesh::Tri &t = mesh.tris[e];
+    const Mesh::Node &p0 = mesh.nodes[static_cast<std::size_t>(t.a)];
+    const Mesh::Node &p1 = mesh.nodes[static_cast<std::size_t>(t.b)];
+    const Mesh::Node &p2 = mesh.nodes[static_cast<std::size_t>(t.c)];
+    const double twiceArea = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+    if (std::fabs(twiceArea) < 1e-300)
+    {
+      degenerate = true;
+      return;
+    }
+    ElementGeometry &geo = geometry[e];
+    geo.area = 0.5 * std::fabs(twiceArea);
+    // Előjeles területtel osztunk, így az orientációtól független a gradiens
+    geo.b[0] = (p1.y - p2.y) / twiceArea;
+    geo.b[1] = (p2.y - p0.y) / twiceArea;
+    geo.b[2] = (p0.y - p1.y) / twiceArea;
+    geo.c[0] = (p2.x - p1.x) / twiceArea;
+    geo.c[1] = (p0.x - p2.x) / twiceArea;
+    geo.c[2] = (p1.x - p0.x) / twiceArea;
+  });
+  if (degenerate)
+  {
+    throw AssemblyError("Elfajult (nulla területű) háromszög a hálóban.");
+  }
+  return geometry;
+}
+
+ElementColoring color_elements(const Mesh &mesh)
+{
+  const std::size_t nodeSlots = mesh.nodes.size();
+  const std::size_t elemCount = mesh.tris.size();
+
+  // Csomópont -> elemek (CSR)
+  std::vector<int> nodePtr(nodeSlots + 1, 0);
+  for (const Mesh::Tri &t : mesh.tris)
+  {
+    ++nodePtr[static_cast<std::size_t>(t.a) + 1];
+    ++nodePtr[static_cast<std::size_t>(t.b) + 1];
+    ++nodePtr[static_cast<std::size_t>(t.c) + 1];
+  }
+  for (std::size_t i = 0; i < nodeSlots; ++i)
+  {
+    nodePtr[i + 1] += nodePtr[i];
+  }
+  std::vector<int> nodeElems(static_cast<std::size_t>(nodePtr.back()));
+  std::vector<int> fill(nodePtr.begin(), nodePtr.end() - 1);
+  for (std::size_t e = 0; e < elemCount; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    nodeElems[static_cast<std::size_t>(fill[static_cast<std::size_t>(t.a)]++)] = static_cast<int>(e);
+    nodeElems[static_cast<std::size_t>(fill[static_cast<std::size_t>(t.b)]++)] = static_cast<int>(e);
+    nodeElems[static_cast<std::size_t>(fill[static_cast<std::size_t>(t.c)]++)] = static_cast<int>(e);
+  }
+
+  // Mohó színezés: a legkisebb szín, amit egyik szomszéd (közös csomópontú elem) sem használ
+  std::vector<int> color(elemCount, -1);
+  std::vector<int> forbidden; // forbidden[szín] == e --> az e elem nem kaphatja
+  int colorCount = 0;
+  for (std::size_t e = 0; e < elemCount; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int nodes[3] = {t.a, t.b, t.c};
+    for (int k = 0; k < 3; ++k)
+    {
+      const std::size_t n = static_cast<std::size_t>(nodes[k]);
+      for (int p = nodePtr[n]; p < nodePtr[n + 1]; ++p)
+      {
+        const int c = color[static_cast<std::size_t>(nodeElems[static_cast<std::size_t>(p)])];
+        if (c >= 0)
+        {
+          forbidden[static_cast<std::size_t>(c)] = static_cast<int>(e);
+        }
+      }
+    }
+    int chosen = 0;
+    while (chosen < colorCount && forbidden[static_cast<std::size_t>(chosen)] == static_cast<int>(e))
+    {
+      ++chosen;
+    }
+    if (chosen == colorCount)
+    {
+      ++colorCount;
+      forbidden.push_back(-1);
+    }
+    color[e] = chosen;
+  }
+
+  ElementColoring coloring;
+  coloring.colorPtr.assign(static_cast<std::size_t>(colorCount) + 1, 0);
+  for (std::size_t e = 0; e < elemCount; ++e)
+  {
+    ++coloring.colorPtr[static_cast<std::size_t>(color[e]) + 1];
+  }
+  for (int c = 0; c < colorCount; ++c)
+  {
+    coloring.colorPtr[static_cast<std::size_t>(c) + 1] += coloring.colorPtr[static_cast<std::size_t>(c)];
+  }
+  coloring.order.resize(elemCount);
+  std::vector<int> cursor(coloring.colorPtr.begin(), coloring.colorPtr.end() - 1);
+  for (std::size_t e = 0; e < elemCount; ++e)
+  {
+    coloring.order[static_cast<std::size_t>(cursor[static_cast<std::size_t>(color[e])]++)] = static_cast<int>(e);
+  }
+  return coloring;
+}
+
+void assemble_diffusion(const Mesh &mesh, const XsLibrary &library, DiffusionSystem &system)
+{
+  assemble_diffusion(mesh, library, resolve_element_materials(mesh, library), system);
+}
+
+namespace
+{
+
+// structure != nullptr: a geometria, a mintázat, az elemenkénti pozíciók és a színezés onnan jön
+void assemble_system(const Mesh &mesh, const XsLibrary &library, const std::vector<int> &elementMaterial,
+                     const DiffusionSystem *structure, DiffusionSystem &system)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const XsCompiled &xs = library.compiled;
+  const int G = library.energyGroupCount;
+  if (xs.groupCount != G || xs.materialCount != static_cast<int>(library.materials.size()))
+  {
+    throw AssemblyError("Az XS könyvtár nincs lefordítva (compile_xs hiányzik).");
+  }
+  if (mesh.tris.empty())
+  {
+    throw AssemblyError("A hálóban nincs háromszög elem.");
+  }
+
+  DiffusionSystem fresh;
+  fresh.groupCount = G;
+  fresh.nodeCount = mesh.nodes.empty() ? 0 : static_cast<int>(mesh.nodes.size()) - 1;
+  const std::size_t N = static_cast<std::size_t>(fresh.nodeCount);
+
+  // --- 1) Anyagok + geometria ---
+  std::chrono::steady_clock::time_point phase = std::chrono::steady_clock::now();
+  if (elementMaterial.size() != mesh.tris.size())
+  {
+    throw AssemblyError("Az elemenkénti anyagindexek száma nem egyezik a háromszögek számával.");
+  }
+  for (int m : elementMaterial)
+  {
+    if (m < 0 || m >= xs.materialCount)
+    {
+      throw AssemblyError("Érvénytelen elemenkénti anyagindex: " + std::to_string(m));
+    }
+  }
+  fresh.elementMaterial = elementMaterial;
+  if (structure)
+  {
+    if (structure->nodeCount != fresh.nodeCount || structure->geometry.size() != mesh.tris.size() || !structure->pattern)
+    {
+      throw AssemblyError("Az újrahasznált operátor szerkezete nem ehhez a hálóhoz tartozik.");
+    }
+    fresh.geometry = structure->geometry;
+    fresh.pattern = structure->pattern;
+    fresh.elementSlots = structure->elementSlots;
+    fresh.coloring = structure->coloring;
+  }
+  else
+  {
+    fresh.geometry = compute_element_geometry(mesh);
+  }
+  fresh.timings.geometryMs = elapsed_ms(phase);
+
+  // --- 2) Közös CSR mintázat + elemenkénti 3x3 pozíciók ---
+  phase = std::chrono::steady_clock::now();
+  if (!structure)
+  {
+    std::vector<std::vector<int>> rowColumns(N);
+    for (const Mesh::Tri &t : mesh.tris)
+    {
+      const int nodes[3] = {t.a - 1, t.b - 1, t.c - 1};
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          rowColumns[static_cast<std::size_t>(nodes[i])].push_back(nodes[j]);
+        }
+      }
+    }
+    // Háromszöghöz nem tartozó csomópont (pl. geometriai segédpont): csak diagonális
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      if (rowColumns[i].empty())
+      {
+        rowColumns[i].push_back(static_cast<int>(i));
+      }
+    }
+    fresh.pattern = build_csr_pattern(rowColumns);
+    fresh.elementSlots.resize(mesh.tris.size() * 9);
+    parallel_for(0, mesh.tris.size(), [&](std::size_t e) {
+      const Mesh::Tri &t = mesh.tris[e];
+      const int nodes[3] = {t.a - 1, t.b - 1, t.c - 1};
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          fresh.elementSlots[e * 9 + static_cast<std::size_t>(i * 3 + j)] = fresh.pattern->find(nodes[i], nodes[j]);
+        }
+      }
+    });
+  }
+  fresh.timings.patternMs = elapsed_ms(phase);
+
+  // --- 3) Színezés ---
+  phase = std::chrono::steady_clock::now();
+  if (!structure)
+  {
+    fresh.coloring = color_elements(mesh);
+  }
+  fresh.timings.coloringMs = elapsed_ms(phase);
+
+  // --- 4) Numerikus összegzés ---
+  phase = std::chrono::steady_clock::now();
+
+  // Mely csatolások nem nullák a használt anyagokban?
+  std::vector<char> materialUsed(static_cast<std::size_t>(xs.materialCount), 0);
+  for (int m : fresh.elementMaterial)
+  {
+    materialUsed[static_cast<std::size_t>(m)] = 1;
+  }
+  for (int from = 0; from < G; ++from)
+  {
+    for (int to = 0; to < G; ++to)
+    {
+      bool scatterNonZero = false;
+      bool fissionNonZero = false;
+      for (int m = 0; m < xs.materialCount; ++m)
+      {
+        if (!materialUsed[static_cast<std::size_t>(m)])
+        {
+          continue;
+        }
+        if (from != to && xs.scatter_of(m)[from * G + to] != 0.0)
+        {
+          scatterNonZero = true;
+        }
+        if (xs.chi[xs.index(m, to)] * xs.nu_sigma_f[xs.index(m, from)] != 0.0)
+        {
+          fissionNonZero = true;
+        }
+      }
+      if (scatterNonZero)
+      {
+        GroupCoupling coupling;
+        coupling.from = from;
+        coupling.to = to;
+        fresh.scatter.push_back(coupling);
+      }
+      if (fissionNonZero)
+      {
+        GroupCoupling coupling;
+        coupling.from = from;
+        coupling.to = to;
+        fresh.fission.push_back(coupling);
+      }
+    }
+  }
+
+  const std::size_t nnz = fresh.pattern->nnz();
+  fresh.groupMatrix.resize(static_cast<std::size_t>(G));
+  for (CsrMatrix &m : fresh.groupMatrix)
+  {
+    m.pattern = fresh.pattern;
+    m.values.assign(nnz, 0.0);
+  }
+  for (GroupCoupling &c : fresh.scatter)
+  {
+    c.matrix.pattern = fresh.pattern;
+    c.matrix.values.assign(nnz, 0.0);
+  }
+  for (GroupCoupling &c : fresh.fission)
+  {
+    c.matrix.pattern = fresh.pattern;
+    c.matrix.values.assign(nnz, 0.0);
+  }
+  fresh.mass.pattern = fresh.pattern;
+  fresh.mass.values.assign(nnz, 0.0);
+
+  // Színenként párhuzamosan: egy színen belül nincs két elem közös csomóponttal,
+  // ezért a CSR értékekbe zárolás nélkül írhatunk.
+  for (int color = 0; color < fresh.coloring.color_count(); ++color)
+  {
+    const std::size_t begin = static_cast<std::size_t>(fresh.coloring.colorPtr[static_cast<std::size_t>(color)]);
+    const std::size_t end = static_cast<std::size_t>(fresh.coloring.colorPtr[static_cast<std::size_t>(color) + 1]);
+    parallel_for(begin, end, [&](std::size_t p) {
+      const std::size_t e = static_cast<std::size_t>(fresh.coloring.order[p]);
+      const int m = fresh.elementMaterial[e];
+      const int *slots = &fresh.elementSlots[e * 9];
+      double unitMass[9];
+      double unitStiff[9];
+      local_matrices(fresh.geometry[e], unitMass, unitStiff);
+
+      for (int g = 0; g < G; ++g)
+      {
+        const double D = xs.diffusion[xs.index(m, g)];
+        const double sr = xs.sigma_r[xs.index(m, g)];
+        double *values = fresh.groupMatrix[static_cast<std::size_t>(g)].values.data();
+        for (int k = 0; k < 9; ++k)
+        {
+          values[slots[k]] += D * unitStiff[k] + sr * unitMass[k];
+        }
+      }
+      const double *sigS = xs.scatter_of(m);
+      for (GroupCoupling &c : fresh.scatter)
+      {
+        const double coeff = sigS[c.from * G + c.to];
+        if (coeff == 0.0)
+        {
+          continue;
+        }
+        double *values = c.matrix.values.data();
+        for (int k = 0; k < 9; ++k)
+        {
+          values[slots[k]] += coeff * unitMass[k];
+        }
+      }
+      for (GroupCoupling &c : fresh.fission)
+      {
+        const double coeff = xs.chi[xs.index(m, c.to)] * xs.nu_sigma_f[xs.index(m, c.from)];
+        if (coeff == 0.0)
+        {
+          continue;
+        }
+        double *values = c.matrix.values.data();
+        for (int k = 0; k < 9; ++k)
+        {
+          values[slots[k]] += coeff * unitMass[k];
+        }
+      }
+      double *massValues = fresh.mass.values.data();
+      for (int k = 0; k < 9; ++k)
+      {
+        massValues[slots[k]] += unitMass[k];
+      }
+    });
+  }
+
+  // Izolált csomópontok: egységnyi diagonális, hogy a rendszer ne legyen szinguláris
+  {
+    std::vector<char> touched(N, 0);
+    for (const Mesh::Tri &t : mesh.tris)
+    {
+      touched[static_cast<std::size_t>(t.a - 1)] = 1;
+      touched[static_cast<std::size_t>(t.b - 1)] = 1;
+      touched[static_cast<std::size_t>(t.c - 1)] = 1;
+    }
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      if (!touched[i])
+      {
+        const int pos = fresh.pattern->find(static_cast<int>(i), static_cast<int>(i));
+        for (CsrMatrix &m : fresh.groupMatrix)
+        {
+          m.values[static_cast<std::size_t>(pos)] = 1.0;
+        }
+      }
+    }
+  }
+  fresh.timings.numericMs = elapsed_ms(phase);
+
+  // --- 5) Marshak (vákuum) peremfeltétel: 1/2 * integral phi v ds a vákuum típusú 1D elemeken ---
+  phase = std::chrono::steady_clock::now();
+  for (std::size_t l = 0; l < mesh.lines.size(); ++l)
+  {
+    const Mesh::Line &line = mesh.lines[l];
+    const XsBoundary *boundary = library.find_boundary(lookup_phys_name(mesh, line.phys));
+    if (boundary == nullptr || boundary->type != "vacuum")
+    {
+      continue;
+    }
+    fresh.vacuumLines.push_back(static_cast<int>(l));
+
+    const Mesh::Node &pa = mesh.nodes[static_cast<std::size_t>(line.a)];
+    const Mesh::Node &pb = mesh.nodes[static_cast<std::size_t>(line.b)];
+    const double length = std::sqrt((pb.x - pa.x) * (pb.x - pa.x) + (pb.y - pa.y) * (pb.y - pa.y));
+    const int nodes[2] = {line.a - 1, line.b - 1};
+    for (int i = 0; i < 2; ++i)
+    {
+      for (int j = 0; j < 2; ++j)
+      {
+        const int pos = fresh.pattern->find(nodes[i], nodes[j]);
+        if (pos < 0)
+        {
+          throw AssemblyError("A(z) " + std::to_string(l + 1) + ". peremél csomópontjai nem szomszédosak a háromszöghálóban.");
+        }
+        const double value = 0.5 * length / 6.0 * (i == j ? 2.0 : 1.0);
+        for (CsrMatrix &m : fresh.groupMatrix)
+        {
+          m.values[static_cast<std::size_t>(pos)] += value;
+        }
+      }
+    }
+  }
+  fresh.timings.boundaryMs = elapsed_ms(phase);
+
+  // Lumped tömeg (sorösszeg) csomópontonként
+  fresh.nodeVolume.assign(N, 0.0);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    for (int k = fresh.pattern->rowPtr[i]; k < fresh.pattern->rowPtr[i + 1]; ++k)
+    {
+      fresh.nodeVolume[i] += fresh.mass.values[static_cast<std::size_t>(k)];
+    }
+  }
+
+  fresh.timings.totalMs = elapsed_ms(totalStart);
+  system = std::move(fresh);
+}
+
+} // namespace
+
+void assemble_diffusion(const Mesh &mesh, const XsLibrary &library, const std::vector<int> &elementMaterial,
+                        DiffusionSystem &system)
+{
+  assemble_system(mesh, library, elementMaterial, nullptr, system);
+}
+
+void assemble_diffusion(const Mesh &mesh, const XsLibrary &library, const std::vector<int> &elementMaterial,
+                        const DiffusionSystem &structure, DiffusionSystem &system)
+{
+  assemble_system(mesh, library, elementMaterial, &structure, system);
+}
@@ -0,0 +1,101 @@
+#ifndef ASSEMBLY_HPP
+#define ASSEMBLY_HPP
+
+#include "mesh.hpp"
+#include "sparse.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Egy háromszög előre kiszámolt geometriája (P1 elem).
+// A bázisfüggvények gradiense: grad N_i = (b[i], c[i]).
+struct ElementGeometry
+{
+  double area = 0.0;
+  double b[3] = {0.0, 0.0, 0.0};
+  double c[3] = {0.0, 0.0, 0.0};
+};
+
+// Az elemek színezése: egy színen belül két elemnek nincs közös csomópontja,
+// így egy színt párhuzamosan, zárolás nélkül lehet összegezni (scatter).
+struct ElementColoring
+{
+  std::vector<int> colorPtr; // színenként az elemek kezdete az order tömbben (colorCount + 1)
+  std::vector<int> order;    // elemindexek színek szerint csoportosítva
+
+  int color_count() const { return colorPtr.empty() ? 0 : static_cast<int>(colorPtr.size()) - 1; }
+};
+
+// Fázisonkénti időmérés (ms)
+struct AssemblyTimings
+{
+  double geometryMs = 0.0;
+  double patternMs = 0.0;
+  double coloringMs = 0.0;
+  double numericMs = 0.0;
+  double boundaryMs = 0.0;
+  double totalMs = 0.0;
+};
+
+// Két csoport közötti csatolás: matrix * phi_from a to csoport egyenletébe kerül
+struct GroupCoupling
+{
+  int from = 0;
+  int to = 0;
+  CsrMatrix matrix;
+};
+
+// A teljes többcsoportos P1 diffúziós operátor:
+//   A_g phi_g - sum_{g' != g} S_{g'->g} phi_g' = (1/k) sum_g' F_{g<-g'} phi_g'
+// ahol A_g = K(D_g) + M(sigma_r,g) + Marshak peremtag a vákuum pereken.
+struct DiffusionSystem
+{
+  int groupCount = 0;
+  int nodeCount = 0; // ismeretlenek: csomópont id - 1
+
+  CsrPattern::CPtr pattern;              // közös mintázat minden mátrixhoz
+  std::vector<CsrMatrix> groupMatrix;    // A_g, csoportonként
+  std::vector<GroupCoupling> scatter;    // S_{from->to}, csak a nem nulla csatolások
+  std::vector<GroupCoupling> fission;    // F_{to<-from} = M(chi_to * nuSigmaF_from)
+  CsrMatrix mass;                        // egységnyi tömegmátrix (normáláshoz, integrálokhoz)
+
+  std::vector<int> elementMaterial;      // háromszögenként az XS anyagindex
+  std::vector<ElementGeometry> geometry; // háromszögenként a cache-elt geometria
+  ElementColoring coloring;
+  std::vector<int> elementSlots;         // háromszögenként 9 pozíció a CSR értéktömbben (3x3 lokális mátrix)
+  std::vector<int> vacuumLines;          // Mesh::lines indexei, amik vákuum peremek
+  std::vector<double> nodeVolume;        // csomópontonként a lumped tömeg (sorösszeg)
+
+  AssemblyTimings timings;
+
+  std::size_t memory_bytes() const;
+};
+
+class AssemblyError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+// Háromszögenként az XS anyagindex a fizikai csoport neve alapján (Fuel -> "Fuel" anyag, stb.)
+std::vector<int> resolve_element_materials(const Mesh &mesh, const XsLibrary &library);
+
+// Geometria cache (terület, gradiensek); elfajult elemre AssemblyError
+std::vector<ElementGeometry> compute_element_geometry(const Mesh &mesh);
+
+// Mohó színezés: az elemek csomópont-diszjunkt színosztályokba kerülnek
+ElementColoring color_elements(const Mesh &mesh);
+
+// A teljes operátor felépítése. Szálpárhuzamos (színenként), fázisonként időméréssel.
+void assemble_diffusion(const Mesh &mesh, const XsLibrary &library, DiffusionSystem &system);
+// Ugyanez előre megadott elemenkénti anyagindexekkel (pl. régiónként külön anyag a kiégésnél)
+void assemble_diffusion(const Mesh &mesh, const XsLibrary &library, const std::vector<int> &elementMaterial,
+                        DiffusionSystem &system);
+// Csak a numerikus rész: a geometria, a CSR mintázat, az elemenkénti pozíciók és a színezés egy korábban
+// ugyanerre a hálóra felépített rendszerből jön (paraméter vizsgálatoknál esetenként csak az XS változik)
+void assemble_diffusion(const Mesh &mesh, const XsLibrary &library, const std::vector<int> &elementMaterial,
+                        const DiffusionSystem &structure, DiffusionSystem &system);
+
+#endif // ASSEMBLY_HPP
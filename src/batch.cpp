@@ -0,0 +1,574 @@
+#include "batch.hpp"
+#include "cholesky.hpp"
+#include "cmfd.hpp"
+#include "eigen.hpp"
+#include "inner_solver.hpp"
+#include "parallel.hpp"
+#include "pin_power.hpp"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  std::string strip_comment(const std::string &line)
+  {
+    const std::size_t hashPos = line.find('#');
+    return hashPos == std::string::npos ? line : line.substr(0, hashPos);
+  }
+
+  std::vector<std::string> split(const std::string &text, char separator)
+  {
+    std::vector<std::string> parts;
+    std::string part;
+    std::istringstream iss(text);
+    while (std::getline(iss, part, separator))
+    {
+      parts.push_back(part);
+    }
+    return parts;
+  }
+
+  double parse_number(const std::string &token, std::size_t lineNo, const std::string &what)
+  {
+    std::istringstream iss(token);
+    double value = 0.0;
+    std::string extra;
+    if (!(iss >> value) || (iss >> extra))
+    {
+      throw BatchParseError(lineNo, "Érvénytelen " + what + ": \"" + token + "\"");
+    }
+    return value;
+  }
+
+  BatchChange parse_change(const std::string &token, const std::string &caseName, std::size_t lineNo)
+  {
+    const std::size_t eq = token.find('=');
+    if (eq == std::string::npos || eq == 0)
+    {
+      throw BatchParseError(lineNo, "Érvénytelen változtatás: \"" + token + "\" (kulcs=érték alakú kell legyen).");
+    }
+    BatchChange change;
+    change.kind = token.substr(0, eq);
+    const std::vector<std::string> fields = split(token.substr(eq + 1), ':');
+    if (change.kind == "density" || change.kind == "temperature")
+    {
+      if (fields.size() != 2 || fields[0].empty())
+      {
+        throw BatchParseError(lineNo, "A(z) " + change.kind + " változtatás alakja: " + change.kind + "=név:érték");
+      }
+      change.target = fields[0];
+      change.value = parse_number(fields[1], lineNo, change.kind == "density" ? "sűrűség" : "hőmérséklet");
+      if (!(change.value > 0.0))
+      {
+        throw BatchParseError(lineNo, "A(z) " + change.kind + " értéke pozitív kell legyen.");
+      }
+    }
+    else if (change.kind == "boundary")
+    {
+      if (fields.size() != 2 || fields[0].empty() || (fields[1] != "vacuum" && fields[1] != "interface"))
+      {
+        throw BatchParseError(lineNo, "A boundary változtatás alakja: boundary=perem:vacuum|interface");
+      }
+      change.target = fields[0];
+      change.type = fields[1];
+    }
+    else if (change.kind == "xs")
+    {
+      // Ugyanaz, mint a perturbáció fájl egy sora, az eset nevével
+      std::vector<std::string> tokens(1, caseName);
+      tokens.insert(tokens.end(), fields.begin(), fields.end());
+      try
+      {
+        change.perturbation = parse_perturbation(tokens, lineNo);
+      }
+      catch (const PerturbationError &ex)
+      {
+        throw BatchParseError(lineNo, std::string("xs változtatás: ") + ex.what());
+      }
+      change.target = change.perturbation.target;
+    }
+    else
+    {
+      throw BatchParseError(lineNo, "Ismeretlen változtatás: \"" + change.kind + "\" (density | xs | boundary | temperature).");
+    }
+    return change;
+  }
+
+  // A keverék sűrűségének változása: a keveréket használó zónák anyagainak makroszkopikus keresztmetszetei
+  // a sűrűséggel arányosak (a D a compile_xs-ben a sigma_tr-ből újra számolódik)
+  void apply_density(const Mesh &mesh, const ModelLibrary &model, const BatchChange &change, XsLibrary &library)
+  {
+    const Mixture *mixture = model.findMixture(change.target);
+    if (mixture == nullptr)
+    {
+      throw BatchError("Ismeretlen keverék: \"" + change.target + "\"");
+    }
+    if (!(mixture->density > 0.0))
+    {
+      throw BatchError("A(z) \"" + change.target + "\" keverék sűrűsége nem pozitív, nem skálázható.");
+    }
+    const double ratio = change.value / mixture->density;
+    std::set<int> scaled;
+    for (const Material &assignment : model.materials)
+    {
+      if (assignment.mixtureName != change.target)
+      {
+        continue;
+      }
+      for (const std::string &groupName : target_physical_groups(mesh, model, assignment.zoneName))
+      {
+        const int m = library.material_index(groupName);
+        if (m < 0 || !scaled.insert(m).second)
+        {
+          continue;
+        }
+        XsMaterial &mat = library.materials[static_cast<std::size_t>(m)];
+        for (std::size_t g = 0; g < mat.sigma_t.size(); ++g)
+        {
+          mat.sigma_t[g] *= ratio;
+          mat.sigma_a[g] *= ratio;
+          mat.nu_sigma_f[g] *= ratio;
+          for (double &s : mat.scatter[g])
+          {
+            s *= ratio;
+          }
+        }
+      }
+    }
+    if (scaled.empty())
+    {
+      throw BatchError("A(z) \"" + change.target + "\" keveréket egyetlen XS anyaggal rendelkező zóna sem használja.");
+    }
+  }
+
+  // Egy eset keresztmetszet könyvtára: a közös könyvtár másolata a változtatásokkal, lefordítva
+  XsLibrary case_library(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const BatchCase &batchCase)
+  {
+    XsLibrary lib = library;
+    for (const BatchChange &change : batchCase.changes)
+    {
+      if (change.kind == "density")
+      {
+        apply_density(mesh, model, change, lib);
+      }
+      else if (change.kind == "xs")
+      {
+        lib = perturbed_library(mesh, lib, model, change.perturbation);
+      }
+      else if (change.kind == "boundary")
+      {
+        XsBoundary *boundary = nullptr;
+        for (XsBoundary &b : lib.boundaries)
+        {
+          if (b.name == change.target)
+          {
+            boundary = &b;
+          }
+        }
+        if (boundary == nullptr)
+        {
+          throw BatchError("Ismeretlen perem az XS könyvtárban: \"" + change.target + "\"");
+        }
+        boundary->type = change.type;
+      }
+      else if (change.kind == "temperature")
+      {
+        const XsFeedback *feedback = library.find_feedback(change.target);
+        const int m = lib.material_index(change.target);
+        if (feedback == nullptr || m < 0)
+        {
+          throw BatchError("A(z) \"" + change.target + "\" anyaghoz nincs hőmérséklet visszacsatolási adat ($Feedback).");
+        }
+        apply_temperature(lib.materials[static_cast<std::size_t>(m)], *feedback, change.value);
+      }
+    }
+    compile_xs(lib);
+    return lib;
+  }
+
+  // Munkásonkénti esetsorok: a saját sor elejéről veszünk, üres saját sornál a többi sor végéről lopunk.
+  // Új eset futás közben nem keletkezik, így ha minden sor üres, a munka elfogyott.
+  class CaseQueues
+  {
+  public:
+    CaseQueues(std::size_t caseCount, int workers)
+        : m_queues(static_cast<std::size_t>(workers)), m_locks(static_cast<std::size_t>(workers))
+    {
+      const std::size_t n = static_cast<std::size_t>(workers);
+      const std::size_t chunk = (caseCount + n - 1) / n;
+      for (std::size_t c = 0; c < caseCount; ++c)
+      {
+        m_queues[c / chunk].push_back(c);
+      }
+    }
+
+    bool next(int worker, std::size_t &index, bool &stolen)
+    {
+      const std::size_t n = m_queues.size();
+      const std::size_t own = static_cast<std::size_t>(worker);
+      {
+        std::lock_guard<std::mutex> lock(m_locks[own]);
+        if (!m_queues[own].empty())
+        {
+          index = m_queues[own].front();
+          m_queues[own].pop_front();
+          stolen = false;
+          return true;
+        }
+      }
+      for (std::size_t k = 1; k < n; ++k)
+      {
+        const std::size_t victim = (own + k) % n;
+        std::lock_guard<std::mutex> lock(m_locks[victim]);
+        if (!m_queues[victim].empty())
+        {
+          index = m_queues[victim].back();
+          m_queues[victim].pop_back();
+          stolen = true;
+          return true;
+        }
+      }
+      return false;
+    }
+
+  private:
+    std::vector<std::deque<std::size_t>> m_queues;
+    std::vector<std::mutex> m_locks;
+  };
+}
+
+// Minden eset által olvasott, egyszer felépített adatok
+struct BatchSession::Shared
+{
+  SolverConfig config;
+  EigenOptions eigen;
+  CholeskySymbolic::CPtr symbolic;
+  CmfdOptions cmfdOptions;
+  std::unique_ptr<CoarseMesh> coarse;
+  std::unique_ptr<PinLattice> lattice;
+  std::vector<std::vector<double>> referenceFlux; // üres, ha nincs warm start
+  BatchCaseResult reference;
+  std::string solverName;
+  double setupMs = 0.0;
+};
+
+BatchSession::BatchSession(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model,
+                           const DiffusionSystem &base, const SolverConfig &config, bool warmStart)
+    : m_mesh(mesh), m_library(library), m_model(model), m_base(base), m_shared(new Shared)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Shared &shared = *m_shared;
+  shared.config = config;
+  if (config.getString("spmv", "sell") == "matrix_free")
+  {
+    // A mátrixmentes operátor az XS-t is tartalmazza, esetenként újra kellene építeni
+    std::cerr << "[FIGYELMEZTETÉS] Az esetenkénti megoldás nem használ mátrixmentes operátort, sell-t használok.\n";
+    shared.config.options["spmv"] = "sell";
+  }
+  shared.eigen = read_eigen_options(shared.config);
+  const std::string innerType = shared.config.getString("inner_solver", "pcg");
+  if (innerType == "direct" || innerType == "cholesky")
+  {
+    shared.symbolic = analyze_cholesky(*base.pattern, read_inner_options(shared.config).cholesky);
+  }
+  shared.cmfdOptions = read_cmfd_options(shared.config);
+  if (shared.cmfdOptions.enabled)
+  {
+    try
+    {
+      shared.coarse.reset(new CoarseMesh(build_coarse_mesh(mesh, base, shared.cmfdOptions)));
+    }
+    catch (const CmfdError &ex)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] CMFD kikapcsolva: " << ex.what() << "\n";
+    }
+  }
+  const PinPowerOptions pinOptions = read_pin_power_options(shared.config);
+  if (pinOptions.enabled)
+  {
+    try
+    {
+      shared.lattice.reset(new PinLattice(identify_pins(mesh, pinOptions)));
+    }
+    catch (const PinPowerError &ex)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] Pin tally kikapcsolva: " << ex.what() << "\n";
+    }
+  }
+
+  // Referencia: a módosítatlan rendszer (a Delta rho alapja, a kezdőfluxus és a változtatás nélküli esetek eredménye)
+  GroupSolver::UPtr inner = make_group_solver(base, shared.config, nullptr, shared.symbolic);
+  std::unique_ptr<CmfdAccelerator> cmfd;
+  if (shared.coarse)
+  {
+    cmfd.reset(new CmfdAccelerator(mesh, base, *shared.coarse, shared.cmfdOptions));
+  }
+  EigenResult reference;
+  solve_eigenvalue(base, *inner, shared.eigen, reference, cmfd.get());
+  shared.solverName = inner->name();
+  shared.reference.name = "reference";
+  shared.reference.ok = true;
+  shared.reference.keff = reference.keff;
+  shared.reference.converged = reference.converged;
+  shared.reference.outerIterations = reference.outerIterations;
+  shared.reference.innerIterations = reference.innerIterations;
+  if (shared.lattice)
+  {
+    PinPowerResult pins;
+    tally_pins(mesh, library, base, *shared.lattice, reference.flux, pins);
+    shared.reference.peaking = pins.peaking;
+    shared.reference.pinPower = pins.power;
+  }
+  if (warmStart)
+  {
+    shared.referenceFlux = reference.flux;
+  }
+  shared.setupMs = elapsed_ms(start);
+  shared.reference.totalMs = shared.setupMs;
+}
+
+BatchSession::~BatchSession() {}
+
+const BatchCaseResult &BatchSession::reference() const
+{
+  return m_shared->reference;
+}
+
+const std::string &BatchSession::solver_name() const
+{
+  return m_shared->solverName;
+}
+
+double BatchSession::setup_ms() const
+{
+  return m_shared->setupMs;
+}
+
+bool BatchSession::has_pins() const
+{
+  return m_shared->lattice != nullptr;
+}
+
+std::size_t BatchSession::pin_count() const
+{
+  return m_shared->lattice ? m_shared->lattice->pins.size() : 0;
+}
+
+void BatchSession::solve(const BatchCase &batchCase, BatchCaseResult &result) const
+{
+  const Shared &shared = *m_shared;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  result = BatchCaseResult();
+  result.name = batchCase.name;
+  if (batchCase.changes.empty())
+  {
+    // Változtatás nélkül a referencia megoldás maga az eredmény, semmit nem kell újraszámolni
+    result = shared.reference;
+    result.name = batchCase.name;
+    result.outerIterations = 0;
+    result.innerIterations = 0;
+    result.totalMs = elapsed_ms(start);
+    return;
+  }
+  try
+  {
+    std::chrono::steady_clock::time_point phase = std::chrono::steady_clock::now();
+    const XsLibrary lib = case_library(m_mesh, m_library, m_model, batchCase);
+    result.xsMs = elapsed_ms(phase);
+
+    phase = std::chrono::steady_clock::now();
+    DiffusionSystem system;
+    assemble_diffusion(m_mesh, lib, m_base.elementMaterial, m_base, system);
+    result.assemblyMs = elapsed_ms(phase);
+
+    phase = std::chrono::steady_clock::now();
+    GroupSolver::UPtr inner = make_group_solver(system, shared.config, nullptr, shared.symbolic);
+    std::unique_ptr<CmfdAccelerator> cmfd;
+    if (shared.coarse)
+    {
+      cmfd.reset(new CmfdAccelerator(m_mesh, system, *shared.coarse, shared.cmfdOptions));
+    }
+    result.setupMs = elapsed_ms(phase);
+
+    phase = std::chrono::steady_clock::now();
+    EigenResult eigen;
+    if (!shared.referenceFlux.empty())
+    {
+      eigen.flux = shared.referenceFlux;
+      eigen.keff = shared.reference.keff;
+    }
+    solve_eigenvalue(system, *inner, shared.eigen, eigen, cmfd.get());
+    result.eigenMs = elapsed_ms(phase);
+
+    result.keff = eigen.keff;
+    result.deltaRho = 1.0 / shared.reference.keff - 1.0 / eigen.keff;
+    result.converged = eigen.converged;
+    result.outerIterations = eigen.outerIterations;
+    result.innerIterations = eigen.innerIterations;
+    if (shared.lattice)
+    {
+      PinPowerResult pins;
+      tally_pins(m_mesh, lib, system, *shared.lattice, eigen.flux, pins);
+      result.peaking = pins.peaking;
+      result.pinPower = pins.power;
+    }
+    result.ok = true;
+  }
+  catch (const std::runtime_error &ex)
+  {
+    result.ok = false;
+    result.error = ex.what();
+  }
+  result.totalMs = elapsed_ms(start);
+}
+
+BatchOptions read_batch_options(const SolverConfig &config)
+{
+  BatchOptions options;
+  options.file = config.getString("batch_file", options.file);
+  options.workers = config.getInt("batch_workers", options.workers);
+  options.warmStart = config.getBool("batch_warm_start", options.warmStart);
+  options.csv = config.getString("batch_csv", options.csv);
+  if (options.file.empty())
+  {
+    throw BatchError("A batch módhoz meg kell adni az esetlistát (batch_file).");
+  }
+  if (options.workers < 0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A batch_workers nem lehet negatív, a szálak számát használom.\n";
+    options.workers = 0;
+  }
+  return options;
+}
+
+BatchCase parse_batch_case(const std::vector<std::string> &tokens, std::size_t lineNo)
+{
+  if (tokens.empty())
+  {
+    throw BatchParseError(lineNo, "Hiányzó esetnév.");
+  }
+  BatchCase batchCase;
+  batchCase.name = tokens[0];
+  batchCase.line = lineNo;
+  for (std::size_t i = 1; i < tokens.size(); ++i)
+  {
+    batchCase.changes.push_back(parse_change(tokens[i], batchCase.name, lineNo));
+  }
+  return batchCase;
+}
+
+void load_batch_cases(const std::string &path, std::vector<BatchCase> &cases)
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    throw BatchError("Nem sikerült megnyitni az esetlistát: " + path);
+  }
+  std::vector<BatchCase> fresh;
+  std::set<std::string> names;
+  std::string line;
+  std::size_t lineNo = 0;
+  while (std::getline(in, line))
+  {
+    ++lineNo;
+    std::istringstream iss(strip_comment(line));
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token)
+    {
+      tokens.push_back(token);
+    }
+    if (tokens.empty())
+    {
+      continue;
+    }
+    const BatchCase batchCase = parse_batch_case(tokens, lineNo);
+    if (!names.insert(batchCase.name).second)
+    {
+      throw BatchParseError(lineNo, "Ismétlődő esetnév: \"" + batchCase.name + "\"");
+    }
+    fresh.push_back(batchCase);
+  }
+  if (fresh.empty())
+  {
+    throw BatchError("Az esetlista üres: " + path);
+  }
+  cases = std::move(fresh);
+}
+
+void run_batch(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &base,
+               const SolverConfig &config, const std::vector<BatchCase> &cases, const BatchOptions &options,
+               BatchResult &result)
+{
+  BatchResult fresh;
+  const BatchSession session(mesh, library, model, base, config, options.warmStart);
+  fresh.keffReference = session.reference().keff;
+  fresh.referenceOuter = session.reference().outerIterations;
+  fresh.solverName = session.solver_name();
+  fresh.referenceMs = session.setup_ms();
+
+  // Esetek párhuzamosan: a szálkészlet minden szála egy munkás, egy eseten belül minden soros
+  ThreadPool &pool = ThreadPool::instance();
+  int workers = options.workers > 0 ? std::min(options.workers, pool.size()) : pool.size();
+  workers = std::max(1, std::min(workers, static_cast<int>(cases.size())));
+  fresh.workers = workers;
+  fresh.cases.resize(cases.size());
+  CaseQueues queues(cases.size(), workers);
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const std::function<void(int)> job = [&](int worker) {
+    if (worker >= workers)
+    {
+      return;
+    }
+    std::size_t index = 0;
+    bool stolen = false;
+    while (queues.next(worker, index, stolen))
+    {
+      BatchCaseResult &caseResult = fresh.cases[index];
+      session.solve(cases[index], caseResult);
+      caseResult.worker = worker;
+      caseResult.stolen = stolen;
+    }
+  };
+  pool.run(job);
+  fresh.wallMs = elapsed_ms(start);
+
+  for (const BatchCaseResult &c : fresh.cases)
+  {
+    fresh.steals += c.stolen ? 1 : 0;
+  }
+  result = std::move(fresh);
+}
+
+void write_batch_summary(const std::string &path, const BatchResult &result)
+{
+  std::ofstream out(path);
+  if (!out)
+  {
+    throw BatchError("Nem sikerült megnyitni a batch összesítő fájlt: " + path);
+  }
+  out << "case,status,keff,delta_rho_pcm,converged,outer,inner,peaking,worker,stolen,xs_ms,assembly_ms,setup_ms,eigen_ms,total_ms\n";
+  out.precision(10);
+  for (const BatchCaseResult &c : result.cases)
+  {
+    out << c.name << "," << (c.ok ? "ok" : "error") << "," << c.keff << "," << c.deltaRho * 1e5 << ","
+        << (c.converged ? 1 : 0) << "," << c.outerIterations << "," << c.innerIterations << "," << c.peaking << ","
+        << c.worker << "," << (c.stolen ? 1 : 0) << "," << c.xsMs << "," << c.assemblyMs << "," << c.setupMs << ","
+        << c.eigenMs << "," << c.totalMs << "\n";
+  }
+}
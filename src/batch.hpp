@@ -0,0 +1,155 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "perturbation.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Paraméteres esetsorozat (mode batch): egy esetlista minden sorára sajátérték számítás ugyanazon a hálón.
+//
+// A háló, a geometria cache, a közös CSR mintázat, az elemenkénti pozíciók és a színezés egyszer készül (a fő
+// assembly-ből), és minden eset csak olvassa; esetenként csak a keresztmetszet könyvtár másolata, a numerikus
+// összegzés, a prekondicionálók numerikus része és a sajátérték megoldás fut. A direkt megoldó szimbolikus
+// Cholesky analízise, a CMFD durva hálója és a pin rács szintén közös.
+//
+// Ütemezés: munkásonként egy esetsor (az esetek folytonos blokkokban kiosztva); a saját sor elejéről vesz,
+// ha kiürült, a többi sor végéről lop. Egy eseten belül a műveletek sorosan futnak (a szálkészlet foglalt), így
+// a párhuzamosság az esetek között van. Minden eset a módosítatlan referencia fluxusából indul, ezért az
+// eredmény nem függ attól, melyik munkás és milyen sorrendben számolta.
+
+class BatchError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class BatchParseError : public BatchError
+{
+public:
+  BatchParseError(std::size_t line, const std::string &message)
+      : BatchError(message), m_line(line)
+  {
+  }
+
+  std::size_t line() const noexcept { return m_line; }
+
+private:
+  std::size_t m_line = 0;
+};
+
+struct BatchOptions
+{
+  std::string file;             // esetlista (kötelező)
+  int workers = 0;              // párhuzamos esetek száma (0 = a szálak száma)
+  bool warmStart = true;        // a referencia fluxusa a kezdőérték
+  std::string csv;              // esetenkénti összesítő CSV (üres = nincs)
+};
+
+BatchOptions read_batch_options(const SolverConfig &config);
+
+// Egy eset egy változtatása
+struct BatchChange
+{
+  std::string kind;             // density | xs | boundary | temperature
+  std::string target;           // keverék (density), peremtípus neve (boundary), XS anyag (temperature)
+  std::string type;             // boundary: vacuum | interface
+  double value = 0.0;           // density: új sűrűség, temperature: hőmérséklet [K]
+  XsPerturbation perturbation;  // xs
+};
+
+struct BatchCase
+{
+  std::string name;
+  std::vector<BatchChange> changes;
+  std::size_t line = 0;
+};
+
+// Esetlista beolvasása. Soronként (üres sor és # komment megengedett):
+//   név [változtatás ...]
+// változtatások (szóközzel elválasztva, egy esetben több is lehet, a megadás sorrendjében hatnak):
+//   density=keverék:sűrűség                    a keveréket használó zónák makroszkopikus XS-e a sűrűséggel arányos
+//   xs=zóna:mennyiség:csoport[:cél]:rel|abs:érték  mint a perturbáció fájl egy sora (':' a szóköz helyett)
+//   boundary=perem:vacuum|interface            az XS könyvtár peremtípusa
+//   temperature=anyag:T                        az anyag XS-e a $Feedback adatai szerint T hőmérsékleten
+void load_batch_cases(const std::string &path, std::vector<BatchCase> &cases);
+// Egy már szavakra bontott sor (név [változtatás ...]) értelmezése
+BatchCase parse_batch_case(const std::vector<std::string> &tokens, std::size_t lineNo);
+
+struct BatchCaseResult
+{
+  std::string name;
+  bool ok = false;
+  std::string error;            // ha !ok
+  double keff = 0.0;
+  double deltaRho = 0.0;        // 1/k_ref - 1/k (abszolút, nem pcm)
+  bool converged = false;
+  int outerIterations = 0;
+  long innerIterations = 0;
+  double peaking = 0.0;         // legnagyobb relatív pin teljesítmény (0, ha nincs pin tally)
+  std::vector<double> pinPower; // relatív pin teljesítmények a PinLattice::pins sorrendjében (üres, ha nincs pin tally)
+  int worker = 0;
+  bool stolen = false;          // más munkás sorából lopott eset
+  double xsMs = 0.0;            // XS másolat + változtatások + compile_xs
+  double assemblyMs = 0.0;      // numerikus összegzés a közös szerkezetre
+  double setupMs = 0.0;         // belső megoldó (prekondicionálók / faktorizáció)
+  double eigenMs = 0.0;
+  double totalMs = 0.0;
+};
+
+struct BatchResult
+{
+  double keffReference = 0.0;
+  int referenceOuter = 0;
+  int workers = 0;
+  int steals = 0;
+  std::string solverName;
+  double referenceMs = 0.0;     // referencia megoldás + közös szerkezetek
+  double wallMs = 0.0;          // az esetek párhuzamos futása
+  std::vector<BatchCaseResult> cases; // az esetlista sorrendjében
+};
+
+// A közös szerkezetek és a referencia megoldás. A konstruktor felépíti a közös adatokat és megoldja a módosítatlan
+// rendszert (base: a módosítatlan könyvtárral felépített operátor); utána a solve több szálról egyszerre is hívható.
+// A háló, a könyvtár, a model és a base élettartama a sessionét kell lefedje.
+class BatchSession
+{
+public:
+  BatchSession(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &base,
+               const SolverConfig &config, bool warmStart);
+  ~BatchSession();
+
+  // Egy eset megoldása; a hibák a result.error-ba kerülnek. Változtatás nélküli eset a referencia eredményt kapja.
+  void solve(const BatchCase &batchCase, BatchCaseResult &result) const;
+
+  const BatchCaseResult &reference() const;
+  const std::string &solver_name() const;
+  double setup_ms() const;      // közös szerkezetek + referencia megoldás
+  bool has_pins() const;
+  std::size_t pin_count() const;
+
+private:
+  struct Shared;
+
+  const Mesh &m_mesh;
+  const XsLibrary &m_library;
+  const ModelLibrary &m_model;
+  const DiffusionSystem &m_base;
+  std::unique_ptr<Shared> m_shared;
+};
+
+void run_batch(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &base,
+               const SolverConfig &config, const std::vector<BatchCase> &cases, const BatchOptions &options,
+               BatchResult &result);
+
+// Esetenkénti összesítő CSV-be
+void write_batch_summary(const std::string &path, const BatchResult &result);
+
+#endif // BATCH_HPP
@@ -0,0 +1,330 @@
+#include "block_sparse.hpp"
+#include "parallel.hpp"
+#include "xs_kernels.hpp"
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+  // acc += B x egy G x G blokkal (sorfolytonos: B[to * G + from])
+  template <int FixedG>
+  inline void block_mat_vec(int runtimeG, const double *B, const double *x, double *acc)
+  {
+    const int G = xs_kernels::Groups<FixedG>::count(runtimeG);
+    for (int to = 0; to < G; ++to)
+    {
+      double s = 0.0;
+      for (int from = 0; from < G; ++from)
+      {
+        s += B[to * G + from] * x[from];
+      }
+      acc[to] += s;
+    }
+  }
+
+  // acc -= B x
+  template <int FixedG>
+  inline void block_mat_vec_sub(int runtimeG, const double *B, const double *x, double *acc)
+  {
+    const int G = xs_kernels::Groups<FixedG>::count(runtimeG);
+    for (int to = 0; to < G; ++to)
+    {
+      double s = 0.0;
+      for (int from = 0; from < G; ++from)
+      {
+        s += B[to * G + from] * x[from];
+      }
+      acc[to] -= s;
+    }
+  }
+
+  // Sűrű G x G inverz részleges főelem-kiválasztásos Gauss–Jordan eliminációval (csak setup)
+  bool invert_block(int G, const double *B, double *inverse)
+  {
+    const std::size_t n = static_cast<std::size_t>(G);
+    std::vector<double> a(B, B + n * n);
+    for (std::size_t i = 0; i < n * n; ++i)
+    {
+      inverse[i] = (i / n == i % n) ? 1.0 : 0.0;
+    }
+    for (std::size_t c = 0; c < n; ++c)
+    {
+      std::size_t pivot = c;
+      for (std::size_t r = c + 1; r < n; ++r)
+      {
+        if (std::fabs(a[r * n + c]) > std::fabs(a[pivot * n + c]))
+        {
+          pivot = r;
+        }
+      }
+      if (a[pivot * n + c] == 0.0)
+      {
+        return false;
+      }
+      if (pivot != c)
+      {
+        for (std::size_t k = 0; k < n; ++k)
+        {
+          std::swap(a[c * n + k], a[pivot * n + k]);
+          std::swap(inverse[c * n + k], inverse[pivot * n + k]);
+        }
+      }
+      const double inv = 1.0 / a[c * n + c];
+      for (std::size_t k = 0; k < n; ++k)
+      {
+        a[c * n + k] *= inv;
+        inverse[c * n + k] *= inv;
+      }
+      for (std::size_t r = 0; r < n; ++r)
+      {
+        if (r == c || a[r * n + c] == 0.0)
+        {
+          continue;
+        }
+        const double f = a[r * n + c];
+        for (std::size_t k = 0; k < n; ++k)
+        {
+          a[r * n + k] -= f * a[c * n + k];
+          inverse[r * n + k] -= f * inverse[c * n + k];
+        }
+      }
+    }
+    return true;
+  }
+
+  // C = A B (G x G, csak setup)
+  void block_mat_mul(int G, const double *A, const double *B, double *C)
+  {
+    for (int i = 0; i < G; ++i)
+    {
+      for (int j = 0; j < G; ++j)
+      {
+        double s = 0.0;
+        for (int k = 0; k < G; ++k)
+        {
+          s += A[i * G + k] * B[k * G + j];
+        }
+        C[i * G + j] = s;
+      }
+    }
+  }
+
+  void invert_diagonal_blocks(const BlockCsrMatrix &B, const std::vector<double> &values, const std::vector<int> &diagPos,
+                              std::vector<double> &invDiag)
+  {
+    const std::size_t GG = B.block_size();
+    const std::size_t n = static_cast<std::size_t>(B.block_rows());
+    invDiag.assign(n * GG, 0.0);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (diagPos[i] < 0 || !invert_block(B.groupCount, &values[static_cast<std::size_t>(diagPos[i]) * GG], &invDiag[i * GG]))
+      {
+        throw BlockSparseError("Szinguláris diagonális blokk a(z) " + std::to_string(i + 1) + ". csomópontnál.");
+      }
+    }
+  }
+}
+
+void BlockCsrMatrix::multiply(const std::vector<double> &x, std::vector<double> &y) const
+{
+  const std::size_t G = static_cast<std::size_t>(groupCount);
+  const std::size_t GG = block_size();
+  y.resize(static_cast<std::size_t>(block_rows()) * G);
+  const CsrPattern &P = *pattern;
+  xs_kernels::dispatch_groups(groupCount, [&](auto fixed) {
+    constexpr int FG = decltype(fixed)::value;
+    parallel_chunks(0, static_cast<std::size_t>(P.rows), [&](int, std::size_t b, std::size_t e) {
+      typename xs_kernels::Groups<FG>::Vec acc = xs_kernels::Groups<FG>::make(groupCount);
+      for (std::size_t i = b; i < e; ++i)
+      {
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          acc[g] = 0.0;
+        }
+        for (int k = P.rowPtr[i]; k < P.rowPtr[i + 1]; ++k)
+        {
+          const std::size_t j = static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)]);
+          block_mat_vec<FG>(groupCount, &values[static_cast<std::size_t>(k) * GG], &x[j * G], &acc[0]);
+        }
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          y[i * G + g] = acc[g];
+        }
+      }
+    });
+    return 0;
+  });
+}
+
+BlockCsrMatrix build_block_system(const DiffusionSystem &system)
+{
+  BlockCsrMatrix B;
+  B.groupCount = system.groupCount;
+  B.pattern = system.pattern;
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t GG = G * G;
+  const std::size_t nnz = system.pattern->nnz();
+  B.values.assign(nnz * GG, 0.0);
+  parallel_for(0, nnz, [&](std::size_t k) {
+    double *block = &B.values[k * GG];
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      block[g * G + g] = system.groupMatrix[g].values[k];
+    }
+    for (const GroupCoupling &c : system.scatter)
+    {
+      block[static_cast<std::size_t>(c.to) * G + static_cast<std::size_t>(c.from)] -= c.matrix.values[k];
+    }
+  });
+  return B;
+}
+
+BlockJacobiPreconditioner::BlockJacobiPreconditioner(const BlockCsrMatrix &B)
+    : m_groupCount(B.groupCount)
+{
+  invert_diagonal_blocks(B, B.values, B.pattern->diagonal_positions(), m_invDiag);
+}
+
+void BlockJacobiPreconditioner::apply(const std::vector<double> &r, std::vector<double> &z) const
+{
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t GG = G * G;
+  z.resize(r.size());
+  const std::size_t n = r.size() / G;
+  xs_kernels::dispatch_groups(m_groupCount, [&](auto fixed) {
+    constexpr int FG = decltype(fixed)::value;
+    parallel_for(0, n, [&](std::size_t i) {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        z[i * G + g] = 0.0;
+      }
+      block_mat_vec<FG>(m_groupCount, &m_invDiag[i * GG], &r[i * G], &z[i * G]);
+    });
+    return 0;
+  });
+}
+
+BlockIlu0Preconditioner::BlockIlu0Preconditioner(const BlockCsrMatrix &B)
+    : m_groupCount(B.groupCount), m_pattern(B.pattern), m_diagPos(B.pattern->diagonal_positions()), m_lu(B.values)
+{
+  const CsrPattern &P = *m_pattern;
+  const std::size_t n = static_cast<std::size_t>(P.rows);
+  const int G = m_groupCount;
+  const std::size_t GG = B.block_size();
+  m_invDiag.assign(n * GG, 0.0);
+  std::vector<int> marker(n, -1);
+  std::vector<double> lik(GG);
+
+  // IKJ változat: az i. blokksor a már kész k < i sorokkal frissül, a kitöltés eldobva
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (int kk = P.rowPtr[i]; kk < P.rowPtr[i + 1]; ++kk)
+    {
+      marker[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(kk)])] = kk;
+    }
+    for (int kk = P.rowPtr[i]; kk < P.rowPtr[i + 1]; ++kk)
+    {
+      const std::size_t k = static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(kk)]);
+      if (k >= i)
+      {
+        break;
+      }
+      // L_ik = B_ik U_kk^{-1}
+      block_mat_mul(G, &m_lu[static_cast<std::size_t>(kk) * GG], &m_invDiag[k * GG], lik.data());
+      std::copy(lik.begin(), lik.end(), m_lu.begin() + static_cast<std::ptrdiff_t>(static_cast<std::size_t>(kk) * GG));
+      for (int kj = m_diagPos[k] + 1; kj < P.rowPtr[k + 1]; ++kj)
+      {
+        const int ij = marker[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(kj)])];
+        if (ij < 0)
+        {
+          continue;
+        }
+        // B_ij -= L_ik U_kj
+        double *target = &m_lu[static_cast<std::size_t>(ij) * GG];
+        const double *ukj = &m_lu[static_cast<std::size_t>(kj) * GG];
+        for (int a = 0; a < G; ++a)
+        {
+          for (int b = 0; b < G; ++b)
+          {
+            double s = 0.0;
+            for (int c = 0; c < G; ++c)
+            {
+              s += lik[static_cast<std::size_t>(a * G + c)] * ukj[c * G + b];
+            }
+            target[a * G + b] -= s;
+          }
+        }
+      }
+    }
+    if (m_diagPos[i] < 0 || !invert_block(G, &m_lu[static_cast<std::size_t>(m_diagPos[i]) * GG], &m_invDiag[i * GG]))
+    {
+      throw BlockSparseError("A blokk ILU(0) faktorizáció elakadt a(z) " + std::to_string(i + 1) + ". csomópontnál.");
+    }
+    for (int kk = P.rowPtr[i]; kk < P.rowPtr[i + 1]; ++kk)
+    {
+      marker[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(kk)])] = -1;
+    }
+  }
+}
+
+void BlockIlu0Preconditioner::apply(const std::vector<double> &r, std::vector<double> &z) const
+{
+  const CsrPattern &P = *m_pattern;
+  const std::size_t n = static_cast<std::size_t>(P.rows);
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t GG = G * G;
+  z.resize(r.size());
+  xs_kernels::dispatch_groups(m_groupCount, [&](auto fixed) {
+    constexpr int FG = decltype(fixed)::value;
+    typename xs_kernels::Groups<FG>::Vec acc = xs_kernels::Groups<FG>::make(m_groupCount);
+    // L y = r (egység diagonális)
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        acc[g] = r[i * G + g];
+      }
+      for (int k = P.rowPtr[i]; k < m_diagPos[i]; ++k)
+      {
+        const std::size_t j = static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)]);
+        block_mat_vec_sub<FG>(m_groupCount, &m_lu[static_cast<std::size_t>(k) * GG], &z[j * G], &acc[0]);
+      }
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        z[i * G + g] = acc[g];
+      }
+    }
+    // U x = y
+    for (std::size_t i = n; i-- > 0;)
+    {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        acc[g] = z[i * G + g];
+      }
+      for (int k = m_diagPos[i] + 1; k < P.rowPtr[i + 1]; ++k)
+      {
+        const std::size_t j = static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)]);
+        block_mat_vec_sub<FG>(m_groupCount, &m_lu[static_cast<std::size_t>(k) * GG], &z[j * G], &acc[0]);
+      }
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        z[i * G + g] = 0.0;
+      }
+      block_mat_vec<FG>(m_groupCount, &m_invDiag[i * GG], &acc[0], &z[i * G]);
+    }
+    return 0;
+  });
+}
+
+BlockPreconditioner::UPtr make_block_preconditioner(const std::string &type, const BlockCsrMatrix &B)
+{
+  if (type == "bjacobi")
+  {
+    return BlockPreconditioner::UPtr(new BlockJacobiPreconditioner(B));
+  }
+  if (type != "bilu0")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen blokk prekondicionáló: \"" << type << "\", bilu0-t használok.\n";
+  }
+  return BlockPreconditioner::UPtr(new BlockIlu0Preconditioner(B));
+}
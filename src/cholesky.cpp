@@ -0,0 +1,609 @@
+#include "cholesky.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  // A beágyazott felbontás munkaterülete: részhalmaz jelölés és BFS szintek
+  class Dissector
+  {
+  public:
+    Dissector(const CsrPattern &pattern, int leafSize)
+        : m_pattern(pattern), m_leafSize(std::max(leafSize, 4)),
+          m_mark(static_cast<std::size_t>(pattern.rows), 0), m_visit(static_cast<std::size_t>(pattern.rows), 0),
+          m_level(static_cast<std::size_t>(pattern.rows), 0)
+    {
+      m_order.reserve(static_cast<std::size_t>(pattern.rows));
+    }
+
+    std::vector<int> run()
+    {
+      std::vector<int> all(static_cast<std::size_t>(m_pattern.rows));
+      std::iota(all.begin(), all.end(), 0);
+      dissect(all);
+      return m_order;
+    }
+
+  private:
+    // BFS a jelölt részhalmazon belül; a bejárt csúcsok szintenként a queue-ba kerülnek
+    int bfs(int root, int stamp, std::vector<int> &queue)
+    {
+      ++m_visitStamp;
+      queue.clear();
+      queue.push_back(root);
+      m_visit[static_cast<std::size_t>(root)] = m_visitStamp;
+      m_level[static_cast<std::size_t>(root)] = 0;
+      int depth = 0;
+      for (std::size_t head = 0; head < queue.size(); ++head)
+      {
+        const int v = queue[head];
+        depth = m_level[static_cast<std::size_t>(v)];
+        for (int k = m_pattern.rowPtr[static_cast<std::size_t>(v)]; k < m_pattern.rowPtr[static_cast<std::size_t>(v) + 1]; ++k)
+        {
+          const int u = m_pattern.colIdx[static_cast<std::size_t>(k)];
+          if (m_mark[static_cast<std::size_t>(u)] == stamp && m_visit[static_cast<std::size_t>(u)] != m_visitStamp)
+          {
+            m_visit[static_cast<std::size_t>(u)] = m_visitStamp;
+            m_level[static_cast<std::size_t>(u)] = depth + 1;
+            queue.push_back(u);
+          }
+        }
+      }
+      return depth;
+    }
+
+    int degree(int v) const
+    {
+      return m_pattern.rowPtr[static_cast<std::size_t>(v) + 1] - m_pattern.rowPtr[static_cast<std::size_t>(v)];
+    }
+
+    void dissect(std::vector<int> nodes)
+    {
+      std::vector<int> queue;
+      while (true)
+      {
+        if (static_cast<int>(nodes.size()) <= m_leafSize)
+        {
+          m_order.insert(m_order.end(), nodes.begin(), nodes.end());
+          return;
+        }
+        const int stamp = ++m_stamp;
+        for (int v : nodes)
+        {
+          m_mark[static_cast<std::size_t>(v)] = stamp;
+        }
+
+        // Pszeudo-periferikus csúcs: az utolsó szint legkisebb fokszámú csúcsából újraindított BFS-ek
+        int depth = bfs(nodes.front(), stamp, queue);
+        for (int attempt = 0; attempt < 4; ++attempt)
+        {
+          int candidate = queue.back();
+          for (std::size_t q = queue.size(); q-- > 0 && m_level[static_cast<std::size_t>(queue[q])] == depth;)
+          {
+            if (degree(queue[q]) < degree(candidate))
+            {
+              candidate = queue[q];
+            }
+          }
+          const int newDepth = bfs(candidate, stamp, queue);
+          if (newDepth <= depth)
+          {
+            depth = newDepth;
+            break;
+          }
+          depth = newDepth;
+        }
+
+        // Nem összefüggő részhalmaz: a bejárt komponens külön, a maradékkal folytatjuk
+        if (queue.size() < nodes.size())
+        {
+          std::vector<int> rest;
+          rest.reserve(nodes.size() - queue.size());
+          for (int v : nodes)
+          {
+            if (m_visit[static_cast<std::size_t>(v)] != m_visitStamp)
+            {
+              rest.push_back(v);
+            }
+          }
+          dissect(queue);
+          nodes.swap(rest);
+          continue;
+        }
+        if (depth < 2)
+        {
+          m_order.insert(m_order.end(), queue.begin(), queue.end());
+          return;
+        }
+
+        // Szeparátor: az a szint, ahol a kumulált csúcsszám eléri a felét
+        std::vector<int> levelCount(static_cast<std::size_t>(depth) + 1, 0);
+        for (int v : queue)
+        {
+          ++levelCount[static_cast<std::size_t>(m_level[static_cast<std::size_t>(v)])];
+        }
+        int separator = 0;
+        std::size_t cumulative = 0;
+        while (separator < depth && cumulative + static_cast<std::size_t>(levelCount[static_cast<std::size_t>(separator)]) < queue.size() / 2)
+        {
+          cumulative += static_cast<std::size_t>(levelCount[static_cast<std::size_t>(separator)]);
+          ++separator;
+        }
+        separator = std::min(std::max(separator, 1), depth - 1);
+
+        std::vector<int> first, second, sep;
+        for (int v : queue)
+        {
+          const int l = m_level[static_cast<std::size_t>(v)];
+          (l < separator ? first : (l > separator ? second : sep)).push_back(v);
+        }
+        dissect(first);
+        dissect(second);
+        m_order.insert(m_order.end(), sep.begin(), sep.end());
+        return;
+      }
+    }
+
+    const CsrPattern &m_pattern;
+    int m_leafSize;
+    std::vector<int> m_mark, m_visit, m_level;
+    int m_stamp = 0;
+    int m_visitStamp = 0;
+    std::vector<int> m_order;
+  };
+}
+
+std::vector<int> nested_dissection_order(const CsrPattern &pattern, int leafSize)
+{
+  Dissector dissector(pattern, leafSize);
+  return dissector.run();
+}
+
+std::size_t CholeskySymbolic::memory_bytes() const
+{
+  return (perm.size() + iperm.size() + superFirst.size() + rowPtr.size() + rows.size() + superParent.size() +
+          levelPtr.size() + levelOrder.size()) * sizeof(int) +
+         valuePtr.size() * sizeof(std::size_t);
+}
+
+CholeskySymbolic::CPtr analyze_cholesky(const CsrPattern &pattern, const CholeskyOptions &options)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::shared_ptr<CholeskySymbolic> sym = std::make_shared<CholeskySymbolic>();
+  const int n = pattern.rows;
+  const std::size_t N = static_cast<std::size_t>(n);
+  sym->n = n;
+
+  if (options.ordering == "natural")
+  {
+    sym->perm.resize(N);
+    std::iota(sym->perm.begin(), sym->perm.end(), 0);
+  }
+  else
+  {
+    sym->perm = nested_dissection_order(pattern, options.leafSize);
+  }
+  sym->iperm.assign(N, 0);
+  for (int j = 0; j < n; ++j)
+  {
+    sym->iperm[static_cast<std::size_t>(sym->perm[static_cast<std::size_t>(j)])] = j;
+  }
+  const std::vector<int> &perm = sym->perm;
+  const std::vector<int> &iperm = sym->iperm;
+
+  // Eliminációs fa (Liu algoritmusa, útvonal tömörítéssel)
+  std::vector<int> parent(N, -1), ancestor(N, -1);
+  for (int j = 0; j < n; ++j)
+  {
+    const std::size_t old = static_cast<std::size_t>(perm[static_cast<std::size_t>(j)]);
+    for (int q = pattern.rowPtr[old]; q < pattern.rowPtr[old + 1]; ++q)
+    {
+      int r = iperm[static_cast<std::size_t>(pattern.colIdx[static_cast<std::size_t>(q)])];
+      if (r >= j)
+      {
+        continue;
+      }
+      ++sym->lowerNnzA;
+      while (ancestor[static_cast<std::size_t>(r)] != -1 && ancestor[static_cast<std::size_t>(r)] != j)
+      {
+        const int t = ancestor[static_cast<std::size_t>(r)];
+        ancestor[static_cast<std::size_t>(r)] = j;
+        r = t;
+      }
+      if (ancestor[static_cast<std::size_t>(r)] == -1)
+      {
+        ancestor[static_cast<std::size_t>(r)] = j;
+        parent[static_cast<std::size_t>(r)] = j;
+      }
+    }
+  }
+  sym->lowerNnzA += N;
+
+  std::vector<int> childPtr(N + 1, 0), children(N, 0);
+  for (std::size_t j = 0; j < N; ++j)
+  {
+    if (parent[j] >= 0)
+    {
+      ++childPtr[static_cast<std::size_t>(parent[j]) + 1];
+    }
+  }
+  std::partial_sum(childPtr.begin(), childPtr.end(), childPtr.begin());
+  {
+    std::vector<int> cursor(childPtr.begin(), childPtr.end() - 1);
+    for (std::size_t j = 0; j < N; ++j)
+    {
+      if (parent[j] >= 0)
+      {
+        children[static_cast<std::size_t>(cursor[static_cast<std::size_t>(parent[j])]++)] = static_cast<int>(j);
+      }
+    }
+  }
+
+  // Oszloponkénti szigorúan alsó struktúra: A oszlopa + a gyerekek struktúrája (a szülő nélkül)
+  std::vector<std::vector<int>> colStruct(N);
+  for (int j = 0; j < n; ++j)
+  {
+    std::vector<int> &s = colStruct[static_cast<std::size_t>(j)];
+    const std::size_t old = static_cast<std::size_t>(perm[static_cast<std::size_t>(j)]);
+    for (int q = pattern.rowPtr[old]; q < pattern.rowPtr[old + 1]; ++q)
+    {
+      const int r = iperm[static_cast<std::size_t>(pattern.colIdx[static_cast<std::size_t>(q)])];
+      if (r > j)
+      {
+        s.push_back(r);
+      }
+    }
+    for (int c = childPtr[static_cast<std::size_t>(j)]; c < childPtr[static_cast<std::size_t>(j) + 1]; ++c)
+    {
+      for (int r : colStruct[static_cast<std::size_t>(children[static_cast<std::size_t>(c)])])
+      {
+        if (r > j)
+        {
+          s.push_back(r);
+        }
+      }
+    }
+    std::sort(s.begin(), s.end());
+    s.erase(std::unique(s.begin(), s.end()), s.end());
+  }
+
+  // Szupernódusok: lánc az eliminációs fában, legfeljebb relax explicit nulla oszloponként.
+  // Az összevont [f, j] blokk oszloponként (j - c + 1) + |struct(j)| elemet tárol, ebből valódi colCount(c) + 1.
+  sym->superFirst.push_back(0);
+  std::size_t actual = colStruct.empty() ? 0 : colStruct[0].size() + 1;
+  for (int j = 1; j <= n; ++j)
+  {
+    bool merge = false;
+    if (j < n && parent[static_cast<std::size_t>(j) - 1] == j)
+    {
+      const std::size_t width = static_cast<std::size_t>(j - sym->superFirst.back() + 1);
+      const std::size_t stored = width * (width + 1) / 2 + width * colStruct[static_cast<std::size_t>(j)].size();
+      const std::size_t withJ = actual + colStruct[static_cast<std::size_t>(j)].size() + 1;
+      merge = stored - withJ <= static_cast<std::size_t>(std::max(options.relax, 0)) * width;
+    }
+    if (!merge)
+    {
+      sym->superFirst.push_back(j);
+      actual = 0;
+    }
+    if (j < n)
+    {
+      actual += colStruct[static_cast<std::size_t>(j)].size() + 1;
+    }
+  }
+
+  const int S = sym->supernode_count();
+  std::vector<int> superOf(N, 0);
+  sym->rowPtr.assign(static_cast<std::size_t>(S) + 1, 0);
+  sym->valuePtr.assign(static_cast<std::size_t>(S) + 1, 0);
+  sym->superParent.assign(static_cast<std::size_t>(S), -1);
+  for (int s = 0; s < S; ++s)
+  {
+    const int f = sym->superFirst[static_cast<std::size_t>(s)];
+    const int l = sym->superFirst[static_cast<std::size_t>(s) + 1] - 1;
+    for (int c = f; c <= l; ++c)
+    {
+      superOf[static_cast<std::size_t>(c)] = s;
+      sym->rows.push_back(c);
+    }
+    const std::vector<int> &tail = colStruct[static_cast<std::size_t>(l)];
+    sym->rows.insert(sym->rows.end(), tail.begin(), tail.end());
+    sym->rowPtr[static_cast<std::size_t>(s) + 1] = static_cast<int>(sym->rows.size());
+    const std::size_t m = static_cast<std::size_t>(l - f + 1) + tail.size();
+    const std::size_t k = static_cast<std::size_t>(l - f + 1);
+    sym->valuePtr[static_cast<std::size_t>(s) + 1] = sym->valuePtr[static_cast<std::size_t>(s)] + m * k;
+    for (std::size_t c = 0; c < k; ++c)
+    {
+      const double rest = static_cast<double>(m - c);
+      sym->flops += rest * rest;
+    }
+  }
+  colStruct.clear();
+  for (int s = 0; s < S; ++s)
+  {
+    const int l = sym->superFirst[static_cast<std::size_t>(s) + 1] - 1;
+    const int p = parent[static_cast<std::size_t>(l)];
+    sym->superParent[static_cast<std::size_t>(s)] = p >= 0 ? superOf[static_cast<std::size_t>(p)] : -1;
+  }
+
+  // Szintek a levelek felől: egy szinten belül a szupernódusok egymástól függetlenek
+  std::vector<int> level(static_cast<std::size_t>(S), 0);
+  int maxLevel = 0;
+  for (int s = 0; s < S; ++s)
+  {
+    const int p = sym->superParent[static_cast<std::size_t>(s)];
+    if (p >= 0)
+    {
+      level[static_cast<std::size_t>(p)] = std::max(level[static_cast<std::size_t>(p)], level[static_cast<std::size_t>(s)] + 1);
+    }
+    maxLevel = std::max(maxLevel, level[static_cast<std::size_t>(s)]);
+  }
+  sym->levelPtr.assign(static_cast<std::size_t>(S > 0 ? maxLevel + 2 : 1), 0);
+  for (int s = 0; s < S; ++s)
+  {
+    ++sym->levelPtr[static_cast<std::size_t>(level[static_cast<std::size_t>(s)]) + 1];
+  }
+  std::partial_sum(sym->levelPtr.begin(), sym->levelPtr.end(), sym->levelPtr.begin());
+  sym->levelOrder.assign(static_cast<std::size_t>(S), 0);
+  {
+    std::vector<int> cursor(sym->levelPtr.begin(), sym->levelPtr.end() - 1);
+    for (int s = 0; s < S; ++s)
+    {
+      sym->levelOrder[static_cast<std::size_t>(cursor[static_cast<std::size_t>(level[static_cast<std::size_t>(s)])]++)] = s;
+    }
+  }
+
+  sym->analyzeMs = elapsed_ms(start);
+  return sym;
+}
+
+CholeskyFactor::CholeskyFactor(const CsrMatrix &A, CholeskySymbolic::CPtr symbolic)
+    : m_symbolic(symbolic)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const CholeskySymbolic &sym = *m_symbolic;
+  const CsrPattern &P = *A.pattern;
+  const int S = sym.supernode_count();
+  const std::size_t N = static_cast<std::size_t>(sym.n);
+  m_values.assign(sym.factor_nnz(), 0.0);
+  m_work.assign(N, 0.0);
+
+  std::vector<int> childPtr(static_cast<std::size_t>(S) + 1, 0), children(static_cast<std::size_t>(S), 0);
+  for (int s = 0; s < S; ++s)
+  {
+    const int p = sym.superParent[static_cast<std::size_t>(s)];
+    if (p >= 0)
+    {
+      ++childPtr[static_cast<std::size_t>(p) + 1];
+    }
+  }
+  std::partial_sum(childPtr.begin(), childPtr.end(), childPtr.begin());
+  {
+    std::vector<int> cursor(childPtr.begin(), childPtr.end() - 1);
+    for (int s = 0; s < S; ++s)
+    {
+      const int p = sym.superParent[static_cast<std::size_t>(s)];
+      if (p >= 0)
+      {
+        children[static_cast<std::size_t>(cursor[static_cast<std::size_t>(p)]++)] = s;
+      }
+    }
+  }
+
+  std::vector<std::vector<double>> updates(static_cast<std::size_t>(S)); // gyerek Schur-komplemensek
+  std::vector<std::vector<int>> position(static_cast<std::size_t>(thread_count()), std::vector<int>(N, -1));
+  std::atomic<int> failedColumn(-1);
+
+  // Egy szupernódus frontjának összegzése, részleges faktorizációja és a Schur-komplemens képzése
+  const auto factor_supernode = [&](int s, std::vector<int> &pos) {
+    const int f = sym.superFirst[static_cast<std::size_t>(s)];
+    const std::size_t k = static_cast<std::size_t>(sym.superFirst[static_cast<std::size_t>(s) + 1] - f);
+    const int *R = sym.rows.data() + sym.rowPtr[static_cast<std::size_t>(s)];
+    const std::size_t m = static_cast<std::size_t>(sym.rowPtr[static_cast<std::size_t>(s) + 1] - sym.rowPtr[static_cast<std::size_t>(s)]);
+    const std::size_t mu = m - k;
+    double *panel = m_values.data() + sym.valuePtr[static_cast<std::size_t>(s)];
+    std::vector<double> U(mu * mu, 0.0);
+    for (std::size_t i = 0; i < m; ++i)
+    {
+      pos[static_cast<std::size_t>(R[i])] = static_cast<int>(i);
+    }
+
+    // A oszlopai (alsó rész)
+    for (std::size_t c = 0; c < k; ++c)
+    {
+      const int j = f + static_cast<int>(c);
+      const std::size_t old = static_cast<std::size_t>(sym.perm[static_cast<std::size_t>(j)]);
+      for (int q = P.rowPtr[old]; q < P.rowPtr[old + 1]; ++q)
+      {
+        const int i = sym.iperm[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(q)])];
+        if (i >= j)
+        {
+          panel[static_cast<std::size_t>(pos[static_cast<std::size_t>(i)]) + c * m] += A.values[static_cast<std::size_t>(q)];
+        }
+      }
+    }
+
+    // Extend-add: a gyerekek frissítő mátrixai
+    for (int ci = childPtr[static_cast<std::size_t>(s)]; ci < childPtr[static_cast<std::size_t>(s) + 1]; ++ci)
+    {
+      const int ch = children[static_cast<std::size_t>(ci)];
+      const std::size_t kc = static_cast<std::size_t>(sym.superFirst[static_cast<std::size_t>(ch) + 1] - sym.superFirst[static_cast<std::size_t>(ch)]);
+      const int *Rc = sym.rows.data() + sym.rowPtr[static_cast<std::size_t>(ch)] + kc;
+      const std::size_t mc = static_cast<std::size_t>(sym.rowPtr[static_cast<std::size_t>(ch) + 1] - sym.rowPtr[static_cast<std::size_t>(ch)]) - kc;
+      std::vector<double> &Uc = updates[static_cast<std::size_t>(ch)];
+      for (std::size_t bc = 0; bc < mc; ++bc)
+      {
+        const std::size_t gc = static_cast<std::size_t>(pos[static_cast<std::size_t>(Rc[bc])]);
+        for (std::size_t a = bc; a < mc; ++a)
+        {
+          const std::size_t gr = static_cast<std::size_t>(pos[static_cast<std::size_t>(Rc[a])]);
+          const double v = Uc[a + bc * mc];
+          if (gc < k)
+          {
+            panel[gr + gc * m] += v;
+          }
+          else
+          {
+            U[(gr - k) + (gc - k) * mu] += v;
+          }
+        }
+      }
+      std::vector<double>().swap(Uc);
+    }
+
+    // Részleges sűrű Cholesky a panelen (balra néző, oszloponként)
+    for (std::size_t c = 0; c < k; ++c)
+    {
+      double *col = panel + c * m;
+      for (std::size_t p = 0; p < c; ++p)
+      {
+        const double a = panel[c + p * m];
+        if (a == 0.0)
+        {
+          continue;
+        }
+        const double *Lp = panel + p * m;
+        for (std::size_t i = c; i < m; ++i)
+        {
+          col[i] -= Lp[i] * a;
+        }
+      }
+      if (!(col[c] > 0.0))
+      {
+        failedColumn = f + static_cast<int>(c);
+        break;
+      }
+      const double d = std::sqrt(col[c]);
+      col[c] = d;
+      const double inv = 1.0 / d;
+      for (std::size_t i = c + 1; i < m; ++i)
+      {
+        col[i] *= inv;
+      }
+    }
+
+    // Schur-komplemens: U -= L21 L21^T (alsó háromszög), nagy frontnál oszloponként párhuzamosan
+    parallel_for(
+        0, mu,
+        [&](std::size_t bc) {
+          double *Ucol = U.data() + bc * mu;
+          for (std::size_t p = 0; p < k; ++p)
+          {
+            const double *Lp = panel + p * m + k;
+            const double a = Lp[bc];
+            if (a == 0.0)
+            {
+              continue;
+            }
+            for (std::size_t r = bc; r < mu; ++r)
+            {
+              Ucol[r] -= Lp[r] * a;
+            }
+          }
+        },
+        64);
+    updates[static_cast<std::size_t>(s)].swap(U);
+
+    for (std::size_t i = 0; i < m; ++i)
+    {
+      pos[static_cast<std::size_t>(R[i])] = -1;
+    }
+  };
+
+  for (std::size_t l = 0; l + 1 < sym.levelPtr.size(); ++l)
+  {
+    const std::size_t begin = static_cast<std::size_t>(sym.levelPtr[l]);
+    const std::size_t end = static_cast<std::size_t>(sym.levelPtr[l + 1]);
+    if (end - begin == 1)
+    {
+      // Egyetlen (felső) front: a belső Schur frissítés kapja a szálakat
+      factor_supernode(sym.levelOrder[begin], position[0]);
+    }
+    else
+    {
+      parallel_chunks(
+          begin, end,
+          [&](int tid, std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+              factor_supernode(sym.levelOrder[i], position[static_cast<std::size_t>(tid)]);
+            }
+          },
+          2);
+    }
+    if (failedColumn >= 0)
+    {
+      throw CholeskyError("A mátrix nem pozitív definit (a Cholesky faktorizáció elakadt a(z) " +
+                          std::to_string(sym.perm[static_cast<std::size_t>(failedColumn.load())] + 1) + ". ismeretlennél).");
+    }
+  }
+  m_factorMs = elapsed_ms(start);
+}
+
+void CholeskyFactor::solve(const std::vector<double> &b, std::vector<double> &x) const
+{
+  const CholeskySymbolic &sym = *m_symbolic;
+  const int S = sym.supernode_count();
+  const std::size_t N = static_cast<std::size_t>(sym.n);
+  std::vector<double> &y = m_work;
+  for (std::size_t j = 0; j < N; ++j)
+  {
+    y[j] = b[static_cast<std::size_t>(sym.perm[j])];
+  }
+
+  // L y = P b
+  for (int s = 0; s < S; ++s)
+  {
+    const int f = sym.superFirst[static_cast<std::size_t>(s)];
+    const std::size_t k = static_cast<std::size_t>(sym.superFirst[static_cast<std::size_t>(s) + 1] - f);
+    const int *R = sym.rows.data() + sym.rowPtr[static_cast<std::size_t>(s)];
+    const std::size_t m = static_cast<std::size_t>(sym.rowPtr[static_cast<std::size_t>(s) + 1] - sym.rowPtr[static_cast<std::size_t>(s)]);
+    const double *panel = m_values.data() + sym.valuePtr[static_cast<std::size_t>(s)];
+    for (std::size_t c = 0; c < k; ++c)
+    {
+      const double *col = panel + c * m;
+      const double yj = y[static_cast<std::size_t>(f) + c] / col[c];
+      y[static_cast<std::size_t>(f) + c] = yj;
+      for (std::size_t i = c + 1; i < m; ++i)
+      {
+        y[static_cast<std::size_t>(R[i])] -= col[i] * yj;
+      }
+    }
+  }
+
+  // L^T z = y
+  for (int s = S - 1; s >= 0; --s)
+  {
+    const int f = sym.superFirst[static_cast<std::size_t>(s)];
+    const std::size_t k = static_cast<std::size_t>(sym.superFirst[static_cast<std::size_t>(s) + 1] - f);
+    const int *R = sym.rows.data() + sym.rowPtr[static_cast<std::size_t>(s)];
+    const std::size_t m = static_cast<std::size_t>(sym.rowPtr[static_cast<std::size_t>(s) + 1] - sym.rowPtr[static_cast<std::size_t>(s)]);
+    const double *panel = m_values.data() + sym.valuePtr[static_cast<std::size_t>(s)];
+    for (std::size_t c = k; c-- > 0;)
+    {
+      const double *col = panel + c * m;
+      double sum = y[static_cast<std::size_t>(f) + c];
+      for (std::size_t i = c + 1; i < m; ++i)
+      {
+        sum -= col[i] * y[static_cast<std::size_t>(R[i])];
+      }
+      y[static_cast<std::size_t>(f) + c] = sum / col[c];
+    }
+  }
+
+  x.resize(N);
+  for (std::size_t j = 0; j < N; ++j)
+  {
+    x[static_cast<std::size_t>(sym.perm[j])] = y[j];
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef CHOLESKY_HPP
+#define CHOLESKY_HPP
+
+#include "sparse.hpp"
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Ritka direkt megoldó szimmetrikus pozitív definit mátrixokra: P A P^T = L L^T.
+//
+// A szimbolikus rész (rendezés, eliminációs fa, szupernódusok, L struktúrája) csak a mintázattól
+// függ, ezért a közös CSR mintázatú csoport mátrixok egyetlen CholeskySymbolic-ot osztanak meg.
+// A numerikus faktorizáció multifrontális: szupernódusonként egy sűrű frontális mátrix,
+// a gyerekek Schur-komplemenseinek összegzése (extend-add), részleges sűrű Cholesky.
+// Az eliminációs fa azonos szintjén lévő szupernódusok függetlenek, ezeket párhuzamosan dolgozzuk fel;
+// a nagy (felső szeparátor) frontoknál a Schur frissítés oszlopai oszlanak szét a szálak között.
+
+class CholeskyError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct CholeskyOptions
+{
+  std::string ordering = "nd"; // nd (beágyazott felbontás) | natural
+  int leafSize = 64;           // nd: ennél kisebb részgráfot már nem bontunk tovább
+  int relax = 4;               // szupernódus összevonás: ennyi explicit nulla oszloponként megengedett
+};
+
+// Kitöltést csökkentő rendezés beágyazott felbontással (nested dissection): BFS szintstruktúra
+// pszeudo-periferikus csúcsból, a középső szint a szeparátor; a két rész rekurzívan, a szeparátor utoljára.
+// Visszatér a permutációval: perm[új index] = régi index.
+std::vector<int> nested_dissection_order(const CsrPattern &pattern, int leafSize);
+
+struct CholeskySymbolic
+{
+  typedef std::shared_ptr<const CholeskySymbolic> CPtr;
+
+  int n = 0;
+  std::vector<int> perm, iperm; // perm[új] = régi, iperm[régi] = új
+
+  // Szupernódusok: az első oszlop, az oszlopok száma, a sorstruktúra (az első ncols elem maga a szupernódus)
+  std::vector<int> superFirst;  // supernodeCount + 1
+  std::vector<int> rowPtr;      // supernodeCount + 1, a rows tömbbe
+  std::vector<int> rows;        // szupernódusonként növekvő sorindexek (permutált)
+  std::vector<std::size_t> valuePtr; // supernodeCount + 1, szupernódusonként az L blokk kezdete (m x ncols, oszlopfolytonos)
+  std::vector<int> superParent; // szupernódus eliminációs fa (-1 = gyökér)
+  std::vector<int> levelPtr;    // szintenként (levelek felől) a szupernódusok kezdete a levelOrder-ben
+  std::vector<int> levelOrder;
+
+  std::size_t lowerNnzA = 0;    // A alsó háromszögének nem nulla elemei
+  double flops = 0.0;           // becsült lebegőpontos műveletszám a numerikus faktorizációhoz
+  double analyzeMs = 0.0;
+
+  int supernode_count() const { return superFirst.empty() ? 0 : static_cast<int>(superFirst.size()) - 1; }
+  std::size_t factor_nnz() const { return valuePtr.empty() ? 0 : valuePtr.back(); }
+  std::size_t memory_bytes() const;
+};
+
+// Szimbolikus analízis a mintázatból (egyszer, minden csoportra közös)
+CholeskySymbolic::CPtr analyze_cholesky(const CsrPattern &pattern, const CholeskyOptions &options);
+
+// Egy mátrix numerikus faktora; tetszőleges számú megoldáshoz újrahasználható
+class CholeskyFactor
+{
+public:
+  CholeskyFactor(const CsrMatrix &A, CholeskySymbolic::CPtr symbolic);
+
+  // x = A^{-1} b
+  void solve(const std::vector<double> &b, std::vector<double> &x) const;
+
+  const CholeskySymbolic &symbolic() const { return *m_symbolic; }
+  double factor_ms() const { return m_factorMs; }
+  std::size_t memory_bytes() const { return m_values.size() * sizeof(double) + m_work.size() * sizeof(double); }
+
+private:
+  CholeskySymbolic::CPtr m_symbolic;
+  std::vector<double> m_values;       // szupernódusonként m x ncols oszlopfolytonos blokk
+  mutable std::vector<double> m_work; // permutált jobb oldal / megoldás
+  double m_factorMs = 0.0;
+};
+
+#endif // CHOLESKY_HPP
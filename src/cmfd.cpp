@@ -0,0 +1,777 @@
+#include "cmfd.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  // Unió-keresés útvonal tömörítéssel
+  struct DisjointSets
+  {
+    std::vector<int> parent;
+
+    explicit DisjointSets(std::size_t n) : parent(n)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        parent[i] = static_cast<int>(i);
+      }
+    }
+
+    int find(int x)
+    {
+      while (parent[static_cast<std::size_t>(x)] != x)
+      {
+        parent[static_cast<std::size_t>(x)] = parent[static_cast<std::size_t>(parent[static_cast<std::size_t>(x)])];
+        x = parent[static_cast<std::size_t>(x)];
+      }
+      return x;
+    }
+
+    void unite(int a, int b)
+    {
+      a = find(a);
+      b = find(b);
+      if (a != b)
+      {
+        parent[static_cast<std::size_t>(std::max(a, b))] = std::min(a, b);
+      }
+    }
+  };
+
+  std::string phys_name(const Mesh &mesh, int phys)
+  {
+    const std::map<int, std::string>::const_iterator it = mesh.physNames.find(phys);
+    return it != mesh.physNames.end() ? it->second : "phys" + std::to_string(phys);
+  }
+
+  // Egy gyorsító lépésen belül ennyiszer bontjuk fel újra a durva mátrixot nagyobb eltolással
+  const int maxRefactor = 3;
+}
+
+CmfdOptions read_cmfd_options(const SolverConfig &config)
+{
+  CmfdOptions options;
+  options.enabled = config.getBool("cmfd", options.enabled);
+  options.cells = config.getString("cmfd_cells", options.cells);
+  options.cellSize = config.getDouble("cmfd_cell_size", options.cellSize);
+  options.start = config.getInt("cmfd_start", options.start);
+  options.shift = config.getDouble("cmfd_shift", options.shift);
+  options.tolerance = config.getDouble("cmfd_tol", options.tolerance);
+  options.maxIterations = config.getInt("cmfd_max_iter", options.maxIterations);
+  options.maxUnknowns = config.getInt("cmfd_max_unknowns", options.maxUnknowns);
+
+  if (options.cells != "pin" && options.cells != "region")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen cmfd_cells: \"" << options.cells << "\", pin cellák használata.\n";
+    options.cells = "pin";
+  }
+  if (options.start < 1)
+  {
+    options.start = 1;
+  }
+  if (options.shift <= 0.0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A cmfd_shift pozitív kell legyen, 0.1 használata.\n";
+    options.shift = 0.1;
+  }
+  if (options.maxIterations < 1)
+  {
+    options.maxIterations = 1;
+  }
+  return options;
+}
+
+CoarseMesh build_coarse_mesh(const Mesh &mesh, const DiffusionSystem &system, const CmfdOptions &options)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const std::size_t T = mesh.tris.size();
+  const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+  CoarseMesh coarse;
+  if (T == 0)
+  {
+    throw CmfdError("A hálóban nincs háromszög, durva cellák nem képezhetők.");
+  }
+
+  // 1) Fizikai csoportonként összefüggő komponensek (közös élen át)
+  DisjointSets triSets(T);
+  std::unordered_map<std::uint64_t, int> edgeOwner;
+  edgeOwner.reserve(3 * T);
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int nodes[3] = {t.a, t.b, t.c};
+    for (int k = 0; k < 3; ++k)
+    {
+      const std::uint64_t lo = static_cast<std::uint64_t>(std::min(nodes[k], nodes[(k + 1) % 3]));
+      const std::uint64_t hi = static_cast<std::uint64_t>(std::max(nodes[k], nodes[(k + 1) % 3]));
+      const std::pair<std::unordered_map<std::uint64_t, int>::iterator, bool> ins =
+          edgeOwner.emplace((lo << 32) | hi, static_cast<int>(e));
+      if (!ins.second && mesh.tris[static_cast<std::size_t>(ins.first->second)].phys == t.phys)
+      {
+        triSets.unite(ins.first->second, static_cast<int>(e));
+      }
+    }
+  }
+
+  std::vector<int> triComponent(T, -1);
+  std::vector<int> componentPhys;
+  std::vector<double> componentArea;
+  std::vector<int> rootComponent(T, -1);
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    const int root = triSets.find(static_cast<int>(e));
+    if (rootComponent[static_cast<std::size_t>(root)] < 0)
+    {
+      rootComponent[static_cast<std::size_t>(root)] = static_cast<int>(componentPhys.size());
+      componentPhys.push_back(mesh.tris[e].phys);
+      componentArea.push_back(0.0);
+    }
+    triComponent[e] = rootComponent[static_cast<std::size_t>(root)];
+    componentArea[static_cast<std::size_t>(triComponent[e])] += system.geometry[e].area;
+  }
+  const std::size_t C = componentPhys.size();
+  coarse.componentCount = static_cast<int>(C);
+
+  // 2) Rácsállandó: alapból a medián komponens méret kétszerese (pin rácsnál kb. a pin osztás)
+  coarse.cellSize = options.cellSize;
+  if (coarse.cellSize <= 0.0)
+  {
+    std::vector<double> sorted(componentArea);
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(C / 2), sorted.end());
+    coarse.cellSize = 2.0 * std::sqrt(sorted[C / 2]);
+  }
+  const double largeArea = coarse.cellSize * coarse.cellSize;
+
+  // 3) Pin mód: a szomszédos kis komponensek (különböző fizikai csoport, közös csomópont) összevonása
+  DisjointSets componentSets(C);
+  if (options.cells == "pin")
+  {
+    std::vector<int> nodeComponent(N, -1);
+    for (std::size_t e = 0; e < T; ++e)
+    {
+      const int comp = triComponent[e];
+      if (componentArea[static_cast<std::size_t>(comp)] > largeArea)
+      {
+        continue;
+      }
+      const Mesh::Tri &t = mesh.tris[e];
+      const int nodes[3] = {t.a - 1, t.b - 1, t.c - 1};
+      for (int node : nodes)
+      {
+        int &seen = nodeComponent[static_cast<std::size_t>(node)];
+        if (seen < 0)
+        {
+          seen = comp;
+        }
+        else if (seen != comp && componentPhys[static_cast<std::size_t>(seen)] != componentPhys[static_cast<std::size_t>(comp)])
+        {
+          componentSets.unite(seen, comp);
+        }
+      }
+    }
+  }
+
+  // 4) Cellák: kis komponens (csoportok) egyben, nagy komponens rácscellánként
+  double xmin = mesh.nodes.size() > 1 ? mesh.nodes[1].x : 0.0;
+  double ymin = mesh.nodes.size() > 1 ? mesh.nodes[1].y : 0.0;
+  for (std::size_t i = 1; i < mesh.nodes.size(); ++i)
+  {
+    xmin = std::min(xmin, mesh.nodes[i].x);
+    ymin = std::min(ymin, mesh.nodes[i].y);
+  }
+  std::vector<int> triCell(T, -1);
+  std::vector<int> mergedCell(C, -1);
+  std::map<std::pair<int, std::pair<long, long>>, int> gridCell;
+  std::vector<std::vector<int>> cellPhys;
+  std::vector<char> cellSplit;
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    const int comp = triComponent[e];
+    const Mesh::Tri &t = mesh.tris[e];
+    int cell = -1;
+    if (componentArea[static_cast<std::size_t>(comp)] > largeArea)
+    {
+      const Mesh::Node &a = mesh.nodes[static_cast<std::size_t>(t.a)];
+      const Mesh::Node &b = mesh.nodes[static_cast<std::size_t>(t.b)];
+      const Mesh::Node &c = mesh.nodes[static_cast<std::size_t>(t.c)];
+      const long ix = static_cast<long>(std::floor(((a.x + b.x + c.x) / 3.0 - xmin) / coarse.cellSize));
+      const long iy = static_cast<long>(std::floor(((a.y + b.y + c.y) / 3.0 - ymin) / coarse.cellSize));
+      const std::pair<std::map<std::pair<int, std::pair<long, long>>, int>::iterator, bool> ins =
+          gridCell.emplace(std::make_pair(comp, std::make_pair(ix, iy)), static_cast<int>(cellPhys.size()));
+      cell = ins.first->second;
+      if (ins.second)
+      {
+        cellPhys.push_back(std::vector<int>(1, t.phys));
+        cellSplit.push_back(1);
+      }
+    }
+    else
+    {
+      const int root = componentSets.find(comp);
+      if (mergedCell[static_cast<std::size_t>(root)] < 0)
+      {
+        mergedCell[static_cast<std::size_t>(root)] = static_cast<int>(cellPhys.size());
+        cellPhys.push_back(std::vector<int>());
+        cellSplit.push_back(0);
+      }
+      cell = mergedCell[static_cast<std::size_t>(root)];
+      std::vector<int> &phys = cellPhys[static_cast<std::size_t>(cell)];
+      if (std::find(phys.begin(), phys.end(), t.phys) == phys.end())
+      {
+        phys.push_back(t.phys);
+      }
+    }
+    triCell[e] = cell;
+  }
+
+  // 5) Csomópontok: ahhoz a cellához, amelyikben a legnagyobb a lumped térfogatuk (terület / 3)
+  std::vector<std::vector<std::pair<int, double>>> share(N);
+  std::vector<double> rawArea(cellPhys.size(), 0.0);
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int nodes[3] = {t.a - 1, t.b - 1, t.c - 1};
+    const double w = system.geometry[e].area / 3.0;
+    rawArea[static_cast<std::size_t>(triCell[e])] += system.geometry[e].area;
+    for (int node : nodes)
+    {
+      std::vector<std::pair<int, double>> &s = share[static_cast<std::size_t>(node)];
+      std::size_t k = 0;
+      while (k < s.size() && s[k].first != triCell[e])
+      {
+        ++k;
+      }
+      if (k == s.size())
+      {
+        s.push_back(std::make_pair(triCell[e], 0.0));
+      }
+      s[k].second += w;
+    }
+  }
+  std::vector<int> rawNodeCell(N, -1);
+  std::vector<int> rawNodeCount(cellPhys.size(), 0);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    double best = -1.0;
+    for (const std::pair<int, double> &s : share[i])
+    {
+      if (s.second > best || (s.second == best && s.first < rawNodeCell[i]))
+      {
+        best = s.second;
+        rawNodeCell[i] = s.first;
+      }
+    }
+    if (rawNodeCell[i] >= 0)
+    {
+      ++rawNodeCount[static_cast<std::size_t>(rawNodeCell[i])];
+    }
+  }
+
+  // 6) Üres (csomópont nélküli) cellák elhagyása, átszámozás
+  std::vector<int> renumber(cellPhys.size(), -1);
+  for (std::size_t c = 0; c < cellPhys.size(); ++c)
+  {
+    if (rawNodeCount[c] == 0)
+    {
+      continue;
+    }
+    renumber[c] = coarse.cellCount++;
+    coarse.cellArea.push_back(rawArea[c]);
+    std::string name;
+    for (int phys : cellPhys[c])
+    {
+      name += (name.empty() ? "" : "+") + phys_name(mesh, phys);
+    }
+    coarse.cellRegion.push_back(name);
+    coarse.splitCells += cellSplit[c] ? 1 : 0;
+    coarse.mergedCells += (!cellSplit[c] && cellPhys[c].size() > 1) ? 1 : 0;
+  }
+  coarse.nodeCell.assign(N, -1);
+  coarse.cellNodePtr.assign(static_cast<std::size_t>(coarse.cellCount) + 1, 0);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    if (rawNodeCell[i] >= 0)
+    {
+      coarse.nodeCell[i] = renumber[static_cast<std::size_t>(rawNodeCell[i])];
+      ++coarse.cellNodePtr[static_cast<std::size_t>(coarse.nodeCell[i]) + 1];
+    }
+  }
+  for (std::size_t c = 0; c < static_cast<std::size_t>(coarse.cellCount); ++c)
+  {
+    coarse.cellNodePtr[c + 1] += coarse.cellNodePtr[c];
+  }
+  coarse.cellNodes.resize(static_cast<std::size_t>(coarse.cellNodePtr.back()));
+  std::vector<int> fill(coarse.cellNodePtr.begin(), coarse.cellNodePtr.end() - 1);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    if (coarse.nodeCell[i] >= 0)
+    {
+      coarse.cellNodes[static_cast<std::size_t>(fill[static_cast<std::size_t>(coarse.nodeCell[i])]++)] = static_cast<int>(i);
+    }
+  }
+  coarse.buildMs = elapsed_ms(start);
+  return coarse;
+}
+
+CmfdAccelerator::CmfdAccelerator(const Mesh &mesh, const DiffusionSystem &system, CoarseMesh coarse, const CmfdOptions &options)
+    : m_system(system), m_coarse(std::move(coarse)), m_options(options)
+{
+  if (unknowns() > m_options.maxUnknowns)
+  {
+    throw CmfdError("A durva feladat túl nagy: " + std::to_string(unknowns()) + " ismeretlen (cmfd_max_unknowns = " +
+                    std::to_string(m_options.maxUnknowns) + "); növeld a cmfd_cell_size értékét.");
+  }
+
+  // Durva mintázat: két cella szomszédos, ha van köztük finom csatolás
+  const CsrPattern &P = *system.pattern;
+  std::vector<std::vector<int>> rowColumns(static_cast<std::size_t>(m_coarse.cellCount));
+  for (int i = 0; i < P.rows; ++i)
+  {
+    const int ci = m_coarse.nodeCell[static_cast<std::size_t>(i)];
+    if (ci < 0)
+    {
+      continue;
+    }
+    for (int k = P.rowPtr[static_cast<std::size_t>(i)]; k < P.rowPtr[static_cast<std::size_t>(i) + 1]; ++k)
+    {
+      const int cj = m_coarse.nodeCell[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)])];
+      if (cj >= 0)
+      {
+        rowColumns[static_cast<std::size_t>(ci)].push_back(cj);
+      }
+    }
+  }
+  m_pattern = build_csr_pattern(rowColumns);
+
+  // Cella térfogatok és súlypontok a lumped tömegekkel
+  const std::size_t cells = static_cast<std::size_t>(m_coarse.cellCount);
+  m_cellVolume.assign(cells, 0.0);
+  std::vector<double> cx(cells, 0.0), cy(cells, 0.0);
+  for (std::size_t i = 0; i < static_cast<std::size_t>(P.rows); ++i)
+  {
+    const int c = m_coarse.nodeCell[i];
+    if (c >= 0)
+    {
+      const double w = system.nodeVolume[i];
+      m_cellVolume[static_cast<std::size_t>(c)] += w;
+      cx[static_cast<std::size_t>(c)] += w * mesh.nodes[i + 1].x;
+      cy[static_cast<std::size_t>(c)] += w * mesh.nodes[i + 1].y;
+    }
+  }
+  for (std::size_t c = 0; c < cells; ++c)
+  {
+    cx[c] /= m_cellVolume[c];
+    cy[c] /= m_cellVolume[c];
+  }
+
+  // Durva diffúziós csatolás: D~_cd = sum_{i in c, j in d} max(-A_ij, 0) |x_i - x_j| / |x_c - x_d|,
+  // azaz a finom élvezetések (~ D L / h) átskálázva a cellák távolságára (~ D L / H)
+  m_fineToCoarse.assign(P.nnz(), -1);
+  m_coupling.assign(static_cast<std::size_t>(system.groupCount), std::vector<double>(m_pattern->nnz(), 0.0));
+  for (int i = 0; i < P.rows; ++i)
+  {
+    const int ci = m_coarse.nodeCell[static_cast<std::size_t>(i)];
+    if (ci < 0)
+    {
+      continue;
+    }
+    const Mesh::Node &pi = mesh.nodes[static_cast<std::size_t>(i) + 1];
+    for (int k = P.rowPtr[static_cast<std::size_t>(i)]; k < P.rowPtr[static_cast<std::size_t>(i) + 1]; ++k)
+    {
+      const int j = P.colIdx[static_cast<std::size_t>(k)];
+      const int cj = m_coarse.nodeCell[static_cast<std::size_t>(j)];
+      if (cj < 0 || cj == ci)
+      {
+        continue;
+      }
+      const int pos = m_pattern->find(ci, cj);
+      m_fineToCoarse[static_cast<std::size_t>(k)] = pos;
+      const Mesh::Node &pj = mesh.nodes[static_cast<std::size_t>(j) + 1];
+      const double length = std::hypot(pi.x - pj.x, pi.y - pj.y);
+      const double distance = std::hypot(cx[static_cast<std::size_t>(ci)] - cx[static_cast<std::size_t>(cj)],
+                                         cy[static_cast<std::size_t>(ci)] - cy[static_cast<std::size_t>(cj)]);
+      for (std::size_t g = 0; g < m_coupling.size(); ++g)
+      {
+        const double a = system.groupMatrix[g].values[static_cast<std::size_t>(k)];
+        m_coupling[g][static_cast<std::size_t>(pos)] += std::max(-a, 0.0) * length / std::max(distance, length);
+      }
+    }
+  }
+
+  const std::size_t n = static_cast<std::size_t>(unknowns());
+  m_cellFlux.assign(n, 0.0);
+  m_reaction.assign(n, 0.0);
+  m_exchange.assign(static_cast<std::size_t>(system.groupCount), std::vector<double>(m_pattern->nnz(), 0.0));
+  m_scatterRate.assign(system.scatter.size(), std::vector<double>(cells, 0.0));
+  m_fissionRate.assign(system.fission.size(), std::vector<double>(cells, 0.0));
+}
+
+bool CmfdAccelerator::homogenize(const std::vector<std::vector<double>> &flux)
+{
+  const CsrPattern &P = *m_system.pattern;
+  const CsrPattern &Q = *m_pattern;
+  const std::size_t G = static_cast<std::size_t>(m_system.groupCount);
+
+  // Cellánként párhuzamosan (egy cella csak a saját durva sorába ír): térfogati fluxus, reakció,
+  // cellák közti csere X_cd = sum_{i in c, j in d} A_ij (phi_j - phi_i), szórási és hasadási ráták
+  parallel_for(
+      0, static_cast<std::size_t>(m_coarse.cellCount),
+      [&](std::size_t c) {
+        const int first = m_coarse.cellNodePtr[c];
+        const int last = m_coarse.cellNodePtr[c + 1];
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          const CsrMatrix &A = m_system.groupMatrix[g];
+          const std::vector<double> &phi = flux[g];
+          std::vector<double> &exchange = m_exchange[g];
+          std::fill(exchange.begin() + Q.rowPtr[c], exchange.begin() + Q.rowPtr[c + 1], 0.0);
+          double volumeFlux = 0.0;
+          double reaction = 0.0;
+          for (int p = first; p < last; ++p)
+          {
+            const std::size_t i = static_cast<std::size_t>(m_coarse.cellNodes[static_cast<std::size_t>(p)]);
+            volumeFlux += m_system.nodeVolume[i] * phi[i];
+            for (int k = P.rowPtr[i]; k < P.rowPtr[i + 1]; ++k)
+            {
+              const double a = A.values[static_cast<std::size_t>(k)];
+              const std::size_t j = static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)]);
+              reaction += a * phi[i];
+              const int pos = m_fineToCoarse[static_cast<std::size_t>(k)];
+              if (pos >= 0)
+              {
+                exchange[static_cast<std::size_t>(pos)] += a * (phi[j] - phi[i]);
+              }
+            }
+          }
+          m_cellFlux[c * G + g] = volumeFlux;
+          m_reaction[c * G + g] = reaction;
+        }
+        auto cell_rate = [&](const CsrMatrix &S, const std::vector<double> &phi) {
+          double rate = 0.0;
+          for (int p = first; p < last; ++p)
+          {
+            const std::size_t i = static_cast<std::size_t>(m_coarse.cellNodes[static_cast<std::size_t>(p)]);
+            for (int k = P.rowPtr[i]; k < P.rowPtr[i + 1]; ++k)
+            {
+              rate += S.values[static_cast<std::size_t>(k)] * phi[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)])];
+            }
+          }
+          return rate;
+        };
+        for (std::size_t s = 0; s < m_scatterRate.size(); ++s)
+        {
+          m_scatterRate[s][c] = cell_rate(m_system.scatter[s].matrix, flux[static_cast<std::size_t>(m_system.scatter[s].from)]);
+        }
+        for (std::size_t f = 0; f < m_fissionRate.size(); ++f)
+        {
+          m_fissionRate[f][c] = cell_rate(m_system.fission[f].matrix, flux[static_cast<std::size_t>(m_system.fission[f].from)]);
+        }
+      },
+      8);
+
+  for (double u : m_cellFlux)
+  {
+    if (!(u > 0.0))
+    {
+      return false;
+    }
+  }
+
+  // Durva veszteség operátor U (cellára integrált fluxus) ismeretlenekre, Phi = U / W:
+  //   X^_cd = D~_cd (Phi_c - Phi_d) + D^_cd (Phi_c + Phi_d), a D^ korrekció a finom X_cd-t adja vissza
+  const std::size_t n = static_cast<std::size_t>(unknowns());
+  m_loss.assign(n * n, 0.0);
+  for (std::size_t c = 0; c < static_cast<std::size_t>(Q.rows); ++c)
+  {
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      const std::size_t row = c * G + g;
+      const double phiC = m_cellFlux[row] / m_cellVolume[c];
+      double &diagonal = m_loss[row * n + row];
+      diagonal += m_reaction[row] / m_cellFlux[row];
+      for (int k = Q.rowPtr[c]; k < Q.rowPtr[c + 1]; ++k)
+      {
+        const std::size_t d = static_cast<std::size_t>(Q.colIdx[static_cast<std::size_t>(k)]);
+        if (d == c)
+        {
+          continue;
+        }
+        const double phiD = m_cellFlux[d * G + g] / m_cellVolume[d];
+        const double tilde = m_coupling[g][static_cast<std::size_t>(k)];
+        const double hat = (m_exchange[g][static_cast<std::size_t>(k)] - tilde * (phiC - phiD)) / (phiC + phiD);
+        diagonal += (tilde + hat) / m_cellVolume[c];
+        m_loss[row * n + d * G + g] += (hat - tilde) / m_cellVolume[d];
+      }
+    }
+    for (std::size_t s = 0; s < m_scatterRate.size(); ++s)
+    {
+      const GroupCoupling &coupling = m_system.scatter[s];
+      const std::size_t from = c * G + static_cast<std::size_t>(coupling.from);
+      m_loss[(c * G + static_cast<std::size_t>(coupling.to)) * n + from] -= m_scatterRate[s][c] / m_cellFlux[from];
+    }
+  }
+
+  // Oszlopösszegek a mérleg alapú durva k-hoz: k = (1^T F U) / (1^T M U)
+  m_lossColumn.assign(n, 0.0);
+  m_productionColumn.assign(n, 0.0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      m_lossColumn[j] += m_loss[i * n + j];
+    }
+  }
+  for (std::size_t f = 0; f < m_fissionRate.size(); ++f)
+  {
+    for (std::size_t c = 0; c < static_cast<std::size_t>(Q.rows); ++c)
+    {
+      const std::size_t from = c * G + static_cast<std::size_t>(m_system.fission[f].from);
+      m_productionColumn[from] += m_fissionRate[f][c] / m_cellFlux[from];
+    }
+  }
+  return true;
+}
+
+bool CmfdAccelerator::factorize(double ks)
+{
+  const std::size_t G = static_cast<std::size_t>(m_system.groupCount);
+  const std::size_t n = static_cast<std::size_t>(unknowns());
+
+  // B = M - F / ks; a homogenizált hasadás cellán belüli (csoportok közti) csatolás
+  m_lu = m_loss;
+  for (std::size_t f = 0; f < m_fissionRate.size(); ++f)
+  {
+    const GroupCoupling &coupling = m_system.fission[f];
+    for (std::size_t c = 0; c < static_cast<std::size_t>(m_coarse.cellCount); ++c)
+    {
+      const std::size_t from = c * G + static_cast<std::size_t>(coupling.from);
+      m_lu[(c * G + static_cast<std::size_t>(coupling.to)) * n + from] -= m_fissionRate[f][c] / m_cellFlux[from] / ks;
+    }
+  }
+
+  // LU részleges főelem-kiválasztással; a Schur frissítés sorai párhuzamosan
+  m_pivot.resize(n);
+  for (std::size_t j = 0; j < n; ++j)
+  {
+    std::size_t p = j;
+    for (std::size_t i = j + 1; i < n; ++i)
+    {
+      if (std::fabs(m_lu[i * n + j]) > std::fabs(m_lu[p * n + j]))
+      {
+        p = i;
+      }
+    }
+    if (!(std::fabs(m_lu[p * n + j]) > 0.0))
+    {
+      return false;
+    }
+    m_pivot[j] = static_cast<int>(p);
+    if (p != j)
+    {
+      std::swap_ranges(m_lu.begin() + static_cast<std::ptrdiff_t>(j * n), m_lu.begin() + static_cast<std::ptrdiff_t>((j + 1) * n),
+                       m_lu.begin() + static_cast<std::ptrdiff_t>(p * n));
+    }
+    const double invPivot = 1.0 / m_lu[j * n + j];
+    const double *pivotRow = &m_lu[j * n];
+    parallel_for(
+        j + 1, n,
+        [&](std::size_t i) {
+          double *row = &m_lu[i * n];
+          const double l = row[j] * invPivot;
+          row[j] = l;
+          if (l != 0.0)
+          {
+            for (std::size_t q = j + 1; q < n; ++q)
+            {
+              row[q] -= l * pivotRow[q];
+            }
+          }
+        },
+        64);
+  }
+  return true;
+}
+
+void CmfdAccelerator::lu_solve(std::vector<double> &x) const
+{
+  const std::size_t n = m_pivot.size();
+  for (std::size_t j = 0; j < n; ++j)
+  {
+    std::swap(x[j], x[static_cast<std::size_t>(m_pivot[j])]);
+  }
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    double s = x[i];
+    for (std::size_t q = 0; q < i; ++q)
+    {
+      s -= m_lu[i * n + q] * x[q];
+    }
+    x[i] = s;
+  }
+  for (std::size_t i = n; i-- > 0;)
+  {
+    double s = x[i];
+    for (std::size_t q = i + 1; q < n; ++q)
+    {
+      s -= m_lu[i * n + q] * x[q];
+    }
+    x[i] = s / m_lu[i * n + i];
+  }
+}
+
+CmfdStats CmfdAccelerator::accelerate(std::vector<std::vector<double>> &flux, double k)
+{
+  CmfdStats stats;
+  const std::size_t G = static_cast<std::size_t>(m_system.groupCount);
+  const std::size_t n = static_cast<std::size_t>(unknowns());
+  if (!homogenize(flux))
+  {
+    return stats;
+  }
+
+  // q = F̂ U (cellán belül, csoportok között)
+  std::vector<double> q(n);
+  auto production = [&](const std::vector<double> &u) {
+    std::fill(q.begin(), q.end(), 0.0);
+    for (std::size_t f = 0; f < m_fissionRate.size(); ++f)
+    {
+      const GroupCoupling &coupling = m_system.fission[f];
+      for (std::size_t c = 0; c < static_cast<std::size_t>(m_coarse.cellCount); ++c)
+      {
+        const std::size_t from = c * G + static_cast<std::size_t>(coupling.from);
+        q[c * G + static_cast<std::size_t>(coupling.to)] += m_fissionRate[f][c] / m_cellFlux[from] * u[from];
+      }
+    }
+  };
+  auto column_dot = [](const std::vector<double> &column, const std::vector<double> &u) {
+    double s = 0.0;
+    for (std::size_t i = 0; i < u.size(); ++i)
+    {
+      s += column[i] * u[i];
+    }
+    return s;
+  };
+
+  // Wielandt-eltolt inverz iteráció: (M - F/ks) U' = (1/k - 1/ks) F U, kezdetben a finom fluxus cellaintegráljai
+  std::vector<double> u(m_cellFlux);
+  std::vector<double> next(n);
+  const double production0 = column_dot(m_productionColumn, u);
+  double kc = k;
+  double ks = k + m_options.shift;
+  if (!factorize(ks))
+  {
+    return stats;
+  }
+  int refactor = 0;
+  bool converged = false;
+  for (int it = 1; it <= m_options.maxIterations; ++it)
+  {
+    production(u);
+    const double invMu = 1.0 / kc - 1.0 / ks;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      next[i] = invMu * q[i];
+    }
+    lu_solve(next);
+    const double loss = column_dot(m_lossColumn, next);
+    const double prod = column_dot(m_productionColumn, next);
+    if (!(loss != 0.0) || !(prod != 0.0))
+    {
+      return stats;
+    }
+    const double kNew = prod / loss;
+    const double norm = production0 / prod;
+    double diff = 0.0;
+    double umax = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      next[i] *= norm;
+      diff = std::max(diff, std::fabs(next[i] - u[i]));
+      umax = std::max(umax, std::fabs(next[i]));
+    }
+    u.swap(next);
+    const double kChange = std::fabs(kNew - kc) / std::fabs(kNew);
+    kc = kNew;
+    stats.iterations = it;
+    if (kChange < m_options.tolerance && diff <= m_options.tolerance * umax)
+    {
+      converged = true;
+      break;
+    }
+    // Az eltolásnak a durva k fölött kell maradnia
+    if (kc > ks - 0.5 * m_options.shift && refactor < maxRefactor)
+    {
+      ++refactor;
+      ks = kc + m_options.shift;
+      if (!factorize(ks))
+      {
+        return stats;
+      }
+    }
+  }
+
+  // Skálázó tényezők: U' / U cellánként és csoportonként
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    u[i] /= m_cellFlux[i];
+  }
+  stats.keff = kc;
+  stats.minFactor = *std::min_element(u.begin(), u.end());
+  stats.maxFactor = *std::max_element(u.begin(), u.end());
+  if (!converged || !(stats.minFactor > 0.0) || !std::isfinite(kc))
+  {
+    return stats;
+  }
+
+  for (std::size_t g = 0; g < G; ++g)
+  {
+    std::vector<double> &phi = flux[g];
+    parallel_for(0, phi.size(), [&](std::size_t i) {
+      const int c = m_coarse.nodeCell[i];
+      if (c >= 0)
+      {
+        phi[i] *= u[static_cast<std::size_t>(c) * G + g];
+      }
+    });
+  }
+  stats.applied = true;
+  return stats;
+}
+
+std::size_t CmfdAccelerator::memory_bytes() const
+{
+  std::size_t bytes = m_pattern->memory_bytes() + (m_fineToCoarse.size() + m_pivot.size()) * sizeof(int) +
+                      (m_cellVolume.size() + m_cellFlux.size() + m_reaction.size() + m_loss.size() + m_lu.size() +
+                       m_lossColumn.size() + m_productionColumn.size()) * sizeof(double) +
+                      (m_coarse.nodeCell.size() + m_coarse.cellNodePtr.size() + m_coarse.cellNodes.size()) * sizeof(int);
+  for (const std::vector<double> &v : m_coupling)
+  {
+    bytes += v.size() * sizeof(double);
+  }
+  for (const std::vector<double> &v : m_exchange)
+  {
+    bytes += v.size() * sizeof(double);
+  }
+  for (const std::vector<double> &v : m_scatterRate)
+  {
+    bytes += v.size() * sizeof(double);
+  }
+  for (const std::vector<double> &v : m_fissionRate)
+  {
+    bytes += v.size() * sizeof(double);
+  }
+  return bytes;
+}
@@ -0,0 +1,120 @@
+#ifndef CMFD_HPP
+#define CMFD_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "sparse.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Durva hálós (CMFD) gyorsítás a hatványiterációhoz.
+//
+// A durva cellák a háló fizikai csoportjainak összefüggő komponenseiből állnak: pin módban a kis
+// komponensek (üzemanyag korong + burkolat gyűrű) egy pin cellába olvadnak, a nagy komponensek
+// (moderátor, reflektor) szabályos négyzetrács szerint darabolódnak. Minden csomópont pontosan egy
+// cellához tartozik (ahhoz, amelyikben a legnagyobb lumped térfogata van).
+//
+// A finom P1 egyenlet cellára összegzett mérlege (A szimmetrikus, r_i = sum_j A_ij):
+//   sum_{i in c} (A phi)_i = sum_{i in c} r_i phi_i + sum_{d != c} X_cd,  X_cd = sum_{i in c, j in d} A_ij (phi_j - phi_i).
+// A durva egyenlet a cellaátlag fluxusokra írt véges differencia csatolás (D~, a cellák távolságából)
+// nemlineáris D^ korrekcióval, ami az aktuális finom fluxusnál pontosan visszaadja X_cd-t; a reakció,
+// szórás és hasadás fluxussal súlyozottan homogenizált. A durva sajátérték feladat (cellák x csoportok,
+// sűrű LU + Wielandt-eltolt inverz iteráció) megoldása cellánkénti skálázást ad a finom fluxusra.
+
+class CmfdError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct CmfdOptions
+{
+  bool enabled = false;
+  std::string cells = "pin";  // pin (üzemanyag + burkolat egy cella) | region (fizikai csoport komponensenként)
+  double cellSize = 0.0;      // nagy komponensek darabolásának rácsállandója (0 = automatikus, a komponens méretekből)
+  int start = 1;              // ennyi sima külső iteráció után kapcsol be
+  double shift = 0.1;         // durva Wielandt eltolás: k_s = k + shift
+  double tolerance = 1e-9;    // durva sajátérték feladat konvergencia kritériuma
+  int maxIterations = 200;
+  int maxUnknowns = 4000;     // a sűrű durva mátrix korlátja (cellák x csoportok)
+};
+
+CmfdOptions read_cmfd_options(const SolverConfig &config);
+
+// Durva cellák és a csomópontok hozzárendelése
+struct CoarseMesh
+{
+  int cellCount = 0;
+  std::vector<int> nodeCell;    // csomópontonként a cella (-1 = nem tartozik háromszöghöz)
+  std::vector<int> cellNodePtr; // cellCount + 1
+  std::vector<int> cellNodes;   // cellánként a csomópontok
+  std::vector<double> cellArea; // a cellába sorolt háromszögek területe
+  std::vector<std::string> cellRegion; // a cella fizikai csoport(ok) neve(i), pl. "Fuel+Cladding"
+
+  int componentCount = 0;       // fizikai csoport komponensek száma
+  int mergedCells = 0;          // több komponensből összevont (pin) cellák
+  int splitCells = 0;           // nagy komponensek darabolásából keletkezett cellák
+  double cellSize = 0.0;        // a ténylegesen használt rácsállandó
+  double buildMs = 0.0;
+};
+
+CoarseMesh build_coarse_mesh(const Mesh &mesh, const DiffusionSystem &system, const CmfdOptions &options);
+
+// Egy gyorsító lépés statisztikája
+struct CmfdStats
+{
+  double keff = 0.0;
+  int iterations = 0;        // durva inverz iterációk
+  double minFactor = 0.0;    // a skálázó tényezők szélső értékei
+  double maxFactor = 0.0;
+  bool applied = false;      // false: a durva megoldás nem használható (nem pozitív / nem konvergált)
+};
+
+class CmfdAccelerator
+{
+public:
+  CmfdAccelerator(const Mesh &mesh, const DiffusionSystem &system, CoarseMesh coarse, const CmfdOptions &options);
+
+  // A finom fluxus átskálázása a durva sajátérték feladat megoldásával; k a jelenlegi becslés.
+  // Sikertelen durva megoldásnál a fluxus változatlan marad (stats.applied = false).
+  CmfdStats accelerate(std::vector<std::vector<double>> &flux, double k);
+
+  const CoarseMesh &coarse() const { return m_coarse; }
+  const CmfdOptions &options() const { return m_options; }
+  int unknowns() const { return m_coarse.cellCount * m_system.groupCount; }
+  std::size_t memory_bytes() const;
+
+private:
+  // Cellánkénti mérleg tagok a finom fluxusból és a durva veszteség operátor; false, ha egy cella fluxusa nem pozitív
+  bool homogenize(const std::vector<std::vector<double>> &flux);
+  // Sűrű B = M - F / ks felbontása; false, ha szinguláris
+  bool factorize(double ks);
+  void lu_solve(std::vector<double> &x) const;
+
+  const DiffusionSystem &m_system;
+  CoarseMesh m_coarse;
+  CmfdOptions m_options;
+
+  CsrPattern::CPtr m_pattern;                  // cella szomszédság
+  std::vector<int> m_fineToCoarse;             // finom nem nulla elem -> durva pozíció (csak cellák közti elemek)
+  std::vector<double> m_cellVolume;            // W_c
+  std::vector<std::vector<double>> m_coupling; // D~_g a durva mintázaton
+
+  // Homogenizált mennyiségek (ismeretlen index: cella * G + csoport)
+  std::vector<double> m_cellFlux;              // U = sum_{i in c} V_i phi_i
+  std::vector<double> m_reaction;              // sum_{i in c} r_i phi_i
+  std::vector<std::vector<double>> m_exchange; // X_cd csoportonként
+  std::vector<std::vector<double>> m_scatterRate; // a system.scatter sorrendjében, cellánként
+  std::vector<std::vector<double>> m_fissionRate; // a system.fission sorrendjében, cellánként
+
+  std::vector<double> m_loss;             // sűrű M (n x n)
+  std::vector<double> m_lu;               // B = M - F / ks LU alakja
+  std::vector<int> m_pivot;
+  std::vector<double> m_lossColumn;       // sum_i M[i][j]
+  std::vector<double> m_productionColumn; // sum_i F[i][j]
+};
+
+#endif // CMFD_HPP
@@ -61,6 +61,71 @@ bool ParserOutputConfig::getFlag(const std::string &name) const
   return false; // Ha nincs megadva, akkor false az alapértelmezett
 }
 
+// SolverConfig getterek implementációja
+int SolverConfig::getInt(const std::string &name, int defaultValue) const
+{
+  std::map<std::string, std::string>::const_iterator it = options.find(name);
+  if (it == options.end())
+  {
+    return defaultValue;
+  }
+  try
+  {
+    return std::stoi(it->second);
+  }
+  catch (const std::exception &ex)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Érvénytelen egész érték a(z) " << name << " beállításnál: \"" << it->second << "\"\n";
+    return defaultValue;
+  }
+}
+
+double SolverConfig::getDouble(const std::string &name, double defaultValue) const
+{
+  std::map<std::string, std::string>::const_iterator it = options.find(name);
+  if (it == options.end())
+  {
+    return defaultValue;
+  }
+  try
+  {
+    return std::stod(it->second);
+  }
+  catch (const std::exception &ex)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Érvénytelen szám érték a(z) " << name << " beállításnál: \"" << it->second << "\"\n";
+    return defaultValue;
+  }
+}
+
+std::string SolverConfig::getString(const std::string &name, const std::string &defaultValue) const
+{
+  std::map<std::string, std::string>::const_iterator it = options.find(name);
+  if (it == options.end())
+  {
+    return defaultValue;
+  }
+  return it->second;
+}
+
+bool SolverConfig::getBool(const std::string &name, bool defaultValue) const
+{
+  std::map<std::string, std::string>::const_iterator it = options.find(name);
+  if (it == options.end())
+  {
+    return defaultValue;
+  }
+  try
+  {
+    return parse_bool(it->second);
+  }
+  catch (const std::exception &ex)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] " << ex.what() << " (" << name << ")\n";
+    return defaultValue;
+  }
+}
+
 // ControlConfig::getEffectiveVerbosity implementáció
 int ControlConfig::getEffectiveVerbosity(const ParserOutputConfig &config) const
 {
@@ -117,15 +182,26 @@ void loadControl(const std::string &path, ControlConfig &config)
       currentSection = "ModelOutput";
       continue;
     }
+    if (cleaned == "$SolverOutput")
+    {
+      currentSection = "SolverOutput";
+      continue;
+    }
     if (cleaned == "$GlobalOutput")
     {
       currentSection = "GlobalOutput";
       continue;
     }
+    if (cleaned == "$Solver")
+    {
+      currentSection = "Solver";
+      continue;
+    }
 
     // Szekció végek felismerése
     if (cleaned == "$EndMeshOutput" || cleaned == "$EndXsOutput" ||
-        cleaned == "$EndModelOutput" || cleaned == "$EndGlobalOutput")
+        cleaned == "$EndModelOutput" || cleaned == "$EndSolverOutput" ||
+        cleaned == "$EndGlobalOutput" || cleaned == "$EndSolver")
     {
       currentSection.clear(); // Kilépünk a szekcióból
       continue;
@@ -145,8 +221,13 @@ void loadControl(const std::string &path, ControlConfig &config)
         continue;
       }
 
+      // Solver szekció: minden kulcs-érték pár eltárolódik, a modulok értelmezik
+      if (currentSection == "Solver")
+      {
+        fresh.solver.options[key] = value;
+      }
       // Global szekció kezelése
-      if (currentSection == "GlobalOutput")
+      else if (currentSection == "GlobalOutput")
       {
         if (key == "master_verbosity")
         {
@@ -170,7 +251,7 @@ void loadControl(const std::string &path, ControlConfig &config)
                     << ": Ismeretlen globális beállítás: \"" << key << "\"\n";
         }
       }
-      // Parser szekciók kezelése (MeshOutput, XsOutput, ModelOutput)
+      // Kimenet szekciók kezelése (MeshOutput, XsOutput, ModelOutput, SolverOutput)
       else
       {
         // Melyik parser konfigurációhoz tartozik ez a szekció?
@@ -187,6 +268,10 @@ void loadControl(const std::string &path, ControlConfig &config)
         {
           targetConfig = &fresh.modelOutput;
         }
+        else if (currentSection == "SolverOutput")
+        {
+          targetConfig = &fresh.solverOutput;
+        }
 
         if (targetConfig != nullptr)
         {
@@ -14,6 +14,19 @@ struct ParserOutputConfig
   bool getFlag(const std::string &name) const;
 };
 
+// Számítási (assembly, solver) beállítások a $Solver szekcióból.
+// Kulcs-érték párok, a modulok maguk kérdezik le a saját kulcsaikat alapértelmezett értékkel.
+struct SolverConfig
+{
+  std::map<std::string, std::string> options; // pl. "threads" -> "4"
+
+  // Helper: Érték lekérdezése; ha nincs megadva vagy nem értelmezhető, a default-ot adja vissza
+  int getInt(const std::string &name, int defaultValue) const;
+  double getDouble(const std::string &name, double defaultValue) const;
+  std::string getString(const std::string &name, const std::string &defaultValue) const;
+  bool getBool(const std::string &name, bool defaultValue) const;
+};
+
 // Teljes control konfiguráció (az egész programhoz)
 struct ControlConfig
 {
@@ -21,6 +34,10 @@ struct ControlConfig
   ParserOutputConfig meshOutput;
   ParserOutputConfig xsOutput;
   ParserOutputConfig modelOutput;
+  ParserOutputConfig solverOutput; // assembly + megoldók kimenete
+
+  // Számítási beállítások
+  SolverConfig solver;
 
   // Globális beállítások
   int masterVerbosity = -1;      // -1 = nincs beállítva, egyébként felülírja az összes parser verbosity-t
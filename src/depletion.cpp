@@ -0,0 +1,777 @@
+#include "depletion.hpp"
+#include "eigen.hpp"
+#include "inner_solver.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace
+{
+  constexpr double kAvogadro = 0.602214076;          // [1e24 / mol]: N [1 / (barn cm)] = rho N_A / M
+  constexpr double kBarn = 1e-24;                     // [cm^2]
+  constexpr double kMevToJoule = 1.602176634e-13;
+  constexpr double kSecondsPerDay = 86400.0;
+  constexpr double kHeavyMetalMass = 220.0;           // [g/mol] felett nehézfém (aktinida)
+  constexpr int kBlock = 32;                          // régiók egy CRAM blokkban (a vektorizált belső ciklus hossza)
+
+  // CRAM 16. rend, incomplete partial fraction (IPF) alak (Pusa, 2016):
+  //   y_0 = n0, y_j = y_{j-1} + 2 Re( alpha_j (dt A - theta_j I)^-1 y_{j-1} ), n(dt) = alpha_0 y_8
+  constexpr int kCramPoles = 8;
+  const double kCramAlpha0 = 2.124853710495224e-16;
+  const double kCramAlphaRe[kCramPoles] = {5.464930576870210e+3, 9.045112476907548e+1, 2.344818070467641e+2,
+                                           9.453304067358312e+1, 7.283792954673409e+2, 3.648229059594851e+1,
+                                           2.547321630156819e+1, 2.394538338734709e+1};
+  const double kCramAlphaIm[kCramPoles] = {-3.797983575308356e+4, -1.115537522430261e+3, -4.228020157070496e+2,
+                                           -2.951294291446048e+2, -1.205646080220011e+5, -1.155509621409682e+2,
+                                           -2.639500283021502e+1, -5.650522971778156e+0};
+  const double kCramThetaRe[kCramPoles] = {3.509103608414918, 5.948152268951177, -5.264971343442647,
+                                           1.419375897185666, 6.416177699099435, 4.993174737717997,
+                                           -1.413928462488886, -10.84391707869699};
+  const double kCramThetaIm[kCramPoles] = {8.436198985884374, 3.587457362018322, 16.22022147316793,
+                                           10.92536348449672, 1.194122393370139, 5.996881713603942,
+                                           13.49772569889275, 19.27744616718165};
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  double group_value(const std::vector<double> &values, int g)
+  {
+    return values.empty() ? 0.0 : values[static_cast<std::size_t>(g)];
+  }
+
+  // Egy kiégő régió: az elemei, a területe és az XS anyag, amiből a régió anyaga készül
+  struct Region
+  {
+    std::string name;
+    int baseMaterial = -1;
+    double area = 0.0;
+    std::vector<int> elements;
+  };
+
+  // A kiégő régiók, a kezdeti összetétel és a régió anyagokat tartalmazó könyvtár felépítése
+  class DepletionModel
+  {
+  public:
+    DepletionModel(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DepletionOptions &options)
+        : m_mesh(mesh), m_library(library), m_data(library.depletion)
+    {
+      const int n = static_cast<int>(m_data.nuclides.size());
+      m_geometry = compute_element_geometry(mesh);
+      m_elementMaterial = resolve_element_materials(mesh, library);
+
+      std::map<int, int> physRegion; // zone módban fizikai csoportonként egy régió
+      std::vector<double> density;   // régiónként a kezdeti sűrűség
+      for (const Material &assignment : model.materials)
+      {
+        const Mixture *mixture = model.findMixture(assignment.mixtureName);
+        const Zone *zone = model.findZone(assignment.zoneName);
+        if (mixture == nullptr || zone == nullptr)
+        {
+          continue;
+        }
+        bool burnable = false;
+        for (const MixtureComponent &component : mixture->components)
+        {
+          const int i = m_data.index(component.element);
+          burnable = burnable || (i >= 0 && m_data.nuclides[static_cast<std::size_t>(i)].fissile());
+        }
+        if (!burnable)
+        {
+          continue;
+        }
+
+        // Kezdeti atomsűrűségek: a keverék "molekulájának" tömege az atomszámokkal súlyozott moláris tömeg
+        std::vector<double> initial(static_cast<std::size_t>(n), 0.0);
+        double molarMass = 0.0;
+        for (const MixtureComponent &component : mixture->components)
+        {
+          const int i = m_data.index(component.element);
+          if (i < 0)
+          {
+            throw DepletionError("A(z) " + mixture->name + " keverék " + component.element +
+                                 " komponense nem szerepel a $Depletion blokkban.");
+          }
+          molarMass += component.atoms * m_data.nuclides[static_cast<std::size_t>(i)].mass;
+        }
+        if (!(molarMass > 0.0) || !(mixture->density > 0.0))
+        {
+          throw DepletionError("A(z) " + mixture->name + " keverék sűrűsége vagy összetétele nem fizikai.");
+        }
+        for (const MixtureComponent &component : mixture->components)
+        {
+          initial[static_cast<std::size_t>(m_data.index(component.element))] +=
+              mixture->density * kAvogadro / molarMass * component.atoms;
+        }
+
+        std::set<int> physIds;
+        for (const std::string &physName : zone->physicalGroups)
+        {
+          for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+          {
+            if (it->second == physName)
+            {
+              physIds.insert(it->first);
+            }
+          }
+        }
+        for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+        {
+          const int phys = mesh.tris[e].phys;
+          if (physIds.count(phys) == 0)
+          {
+            continue;
+          }
+          int r = -1;
+          if (options.regions == "zone")
+          {
+            std::map<int, int>::const_iterator it = physRegion.find(phys);
+            r = it == physRegion.end() ? -1 : it->second;
+          }
+          if (r < 0)
+          {
+            r = static_cast<int>(m_regions.size());
+            Region region;
+            region.name = zone->name + "/" + mesh.physNames.at(phys);
+            region.baseMaterial = m_elementMaterial[e];
+            m_regions.push_back(region);
+            density.insert(density.end(), initial.begin(), initial.end());
+            physRegion[phys] = r;
+          }
+          Region &region = m_regions[static_cast<std::size_t>(r)];
+          if (!region.elements.empty() && m_elementMaterial[static_cast<std::size_t>(region.elements[0])] != m_elementMaterial[e])
+          {
+            throw DepletionError("A(z) " + region.name + " régió elemei különböző XS anyagokhoz tartoznak.");
+          }
+          region.elements.push_back(static_cast<int>(e));
+          region.area += m_geometry[e].area;
+        }
+      }
+      if (m_regions.empty())
+      {
+        throw DepletionError("Nincs kiégő régió: egyik zóna keverékében sincs hasadó nuklid a $Depletion blokkból.");
+      }
+
+      // A kiégő elemek saját (régiónkénti) anyagot kapnak a könyvtár anyagai után
+      const int baseCount = static_cast<int>(library.materials.size());
+      for (std::size_t r = 0; r < m_regions.size(); ++r)
+      {
+        for (int e : m_regions[r].elements)
+        {
+          m_elementMaterial[static_cast<std::size_t>(e)] = baseCount + static_cast<int>(r);
+        }
+      }
+      m_initial = density;
+    }
+
+    int region_count() const { return static_cast<int>(m_regions.size()); }
+    const std::vector<Region> &regions() const { return m_regions; }
+    const std::vector<double> &initial_density() const { return m_initial; }
+    const std::vector<int> &element_material() const { return m_elementMaterial; }
+
+    // A könyvtár a régió anyagokkal (a kezdeti összetételtől való eltéréssel módosított másolatok)
+    XsLibrary library_for(const std::vector<double> &density) const
+    {
+      const int n = static_cast<int>(m_data.nuclides.size());
+      const int G = m_library.energyGroupCount;
+      XsLibrary changed = m_library;
+      changed.materials.reserve(m_library.materials.size() + m_regions.size());
+      for (std::size_t r = 0; r < m_regions.size(); ++r)
+      {
+        XsMaterial material = m_library.materials[static_cast<std::size_t>(m_regions[r].baseMaterial)];
+        material.name = m_library.materials[static_cast<std::size_t>(m_regions[r].baseMaterial)].name + "#" + std::to_string(r);
+        for (int i = 0; i < n; ++i)
+        {
+          const std::size_t k = r * static_cast<std::size_t>(n) + static_cast<std::size_t>(i);
+          const double delta = density[k] - m_initial[k];
+          if (delta == 0.0)
+          {
+            continue;
+          }
+          const XsNuclide &nuclide = m_data.nuclides[static_cast<std::size_t>(i)];
+          for (int g = 0; g < G; ++g)
+          {
+            const double capture = group_value(nuclide.sigma_c, g);
+            const double fission = group_value(nuclide.sigma_f, g);
+            material.sigma_a[static_cast<std::size_t>(g)] += delta * (capture + fission);
+            material.sigma_t[static_cast<std::size_t>(g)] += delta * (capture + fission);
+            material.nu_sigma_f[static_cast<std::size_t>(g)] += delta * group_value(nuclide.nu, g) * fission;
+          }
+        }
+        changed.materials.push_back(material);
+      }
+      compile_xs(changed);
+      return changed;
+    }
+
+    // Régiónkénti csoportfluxus (a csomóponti fluxus elemátlagainak területtel súlyozott átlaga)
+    std::vector<double> region_flux(const std::vector<std::vector<double>> &flux) const
+    {
+      const int G = static_cast<int>(flux.size());
+      std::vector<double> result(m_regions.size() * static_cast<std::size_t>(G), 0.0);
+      parallel_for(0, m_regions.size(), [&](std::size_t r) {
+        const Region &region = m_regions[r];
+        for (int e : region.elements)
+        {
+          const Mesh::Tri &t = m_mesh.tris[static_cast<std::size_t>(e)];
+          const double weight = m_geometry[static_cast<std::size_t>(e)].area / (3.0 * region.area);
+          for (int g = 0; g < G; ++g)
+          {
+            const std::vector<double> &phi = flux[static_cast<std::size_t>(g)];
+            result[r * static_cast<std::size_t>(G) + static_cast<std::size_t>(g)] +=
+                weight * (phi[static_cast<std::size_t>(t.a - 1)] + phi[static_cast<std::size_t>(t.b - 1)] +
+                          phi[static_cast<std::size_t>(t.c - 1)]);
+          }
+        }
+      }, 64);
+      return result;
+    }
+
+  private:
+    const Mesh &m_mesh;
+    const XsLibrary &m_library;
+    const XsDepletion &m_data;
+    std::vector<Region> m_regions;
+    std::vector<double> m_initial;        // [r * n + i]
+    std::vector<int> m_elementMaterial;
+    std::vector<ElementGeometry> m_geometry;
+  };
+}
+
+DepletionOptions read_depletion_options(const SolverConfig &config)
+{
+  DepletionOptions options;
+  const std::string steps = config.getString("depletion_steps", "");
+  if (!steps.empty())
+  {
+    options.steps.clear();
+    std::istringstream iss(steps);
+    std::string item;
+    while (std::getline(iss, item, ','))
+    {
+      try
+      {
+        options.steps.push_back(std::stod(item));
+      }
+      catch (const std::exception &)
+      {
+        throw DepletionError("Érvénytelen lépéshossz a depletion_steps beállításban: \"" + item + "\"");
+      }
+      if (!(options.steps.back() > 0.0))
+      {
+        throw DepletionError("A depletion_steps lépéshosszai pozitívak kell legyenek.");
+      }
+    }
+  }
+  options.power = config.getDouble("depletion_power", options.power);
+  options.fissionEnergy = config.getDouble("depletion_fission_energy", options.fissionEnergy);
+  options.regions = config.getString("depletion_regions", options.regions);
+  options.corrector = config.getBool("depletion_corrector", options.corrector);
+  if (options.regions != "element" && options.regions != "zone")
+  {
+    throw DepletionError("A depletion_regions értéke element vagy zone lehet.");
+  }
+  if (!(options.power > 0.0) || !(options.fissionEnergy > 0.0))
+  {
+    throw DepletionError("A depletion_power és a depletion_fission_energy pozitív kell legyen.");
+  }
+  return options;
+}
+
+CramSolver::CramSolver(const XsDepletion &data)
+{
+  m_n = static_cast<int>(data.nuclides.size());
+  const std::size_t n = static_cast<std::size_t>(m_n);
+
+  // A mátrix tagjai (sor, oszlop) szerint: diagonálison a teljes eltűnés, alatta/felette a keletkezés
+  struct Entry
+  {
+    int row, col, kind, nuclide;
+    double coef;
+  };
+  std::vector<Entry> entries;
+  for (int i = 0; i < m_n; ++i)
+  {
+    const XsNuclide &nuclide = data.nuclides[static_cast<std::size_t>(i)];
+    entries.push_back(Entry{i, i, 1, i, -1.0});
+    entries.push_back(Entry{i, i, 2, i, -1.0});
+    if (nuclide.lambda > 0.0)
+    {
+      entries.push_back(Entry{i, i, 0, i, -nuclide.lambda});
+      if (!nuclide.decayProduct.empty())
+      {
+        entries.push_back(Entry{data.index(nuclide.decayProduct), i, 0, i, nuclide.lambda});
+      }
+    }
+    if (!nuclide.captureProduct.empty())
+    {
+      entries.push_back(Entry{data.index(nuclide.captureProduct), i, 1, i, 1.0});
+    }
+    for (const std::pair<std::string, double> &y : nuclide.yields)
+    {
+      entries.push_back(Entry{data.index(y.first), i, 2, i, y.second});
+    }
+  }
+
+  // Szimbolikus LU pivotálás nélkül (a sorrend a fájlbeli), a feltöltéssel együtt
+  std::vector<char> pattern(n * n, 0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    pattern[i * n + i] = 1;
+  }
+  for (const Entry &entry : entries)
+  {
+    pattern[static_cast<std::size_t>(entry.row) * n + static_cast<std::size_t>(entry.col)] = 1;
+  }
+  for (std::size_t i = 0; i < n * n; ++i)
+  {
+    m_matrixNonzeros += pattern[i];
+  }
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    for (std::size_t i = k + 1; i < n; ++i)
+    {
+      if (!pattern[i * n + k])
+      {
+        continue;
+      }
+      for (std::size_t j = k + 1; j < n; ++j)
+      {
+        if (pattern[k * n + j])
+        {
+          pattern[i * n + j] = 1;
+        }
+      }
+    }
+  }
+  std::vector<int> slot(n * n, -1);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      if (pattern[i * n + j])
+      {
+        slot[i * n + j] = static_cast<int>(m_slotRow.size());
+        m_slotRow.push_back(static_cast<int>(i));
+        m_slotCol.push_back(static_cast<int>(j));
+      }
+    }
+  }
+
+  m_diag.resize(n);
+  m_lower.assign(n, std::vector<Link>());
+  m_upper.assign(n, std::vector<Link>());
+  m_upperCol.assign(n, std::vector<Link>());
+  m_update.assign(n, std::vector<int>());
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    m_diag[k] = slot[k * n + k];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (i > k && slot[i * n + k] >= 0)
+      {
+        m_lower[k].push_back(Link{slot[i * n + k], static_cast<int>(i)});
+      }
+      if (i < k && slot[i * n + k] >= 0)
+      {
+        m_upperCol[k].push_back(Link{slot[i * n + k], static_cast<int>(i)});
+      }
+      if (i > k && slot[k * n + i] >= 0)
+      {
+        m_upper[k].push_back(Link{slot[k * n + i], static_cast<int>(i)});
+      }
+    }
+    for (const Link &lower : m_lower[k])
+    {
+      for (const Link &upper : m_upper[k])
+      {
+        m_update[k].push_back(slot[static_cast<std::size_t>(lower.index) * n + static_cast<std::size_t>(upper.index)]);
+      }
+    }
+  }
+
+  for (const Entry &entry : entries)
+  {
+    m_terms.push_back(Term{slot[static_cast<std::size_t>(entry.row) * n + static_cast<std::size_t>(entry.col)], entry.kind,
+                           entry.nuclide, entry.coef});
+  }
+}
+
+void CramSolver::solve_block(const double *rates, double dt, double *density, int count, std::vector<double> &work) const
+{
+  const std::size_t B = kBlock;
+  const std::size_t S = m_slotRow.size();
+  const std::size_t n = static_cast<std::size_t>(m_n);
+  work.assign(3 * S * B + 5 * n * B, 0.0);
+  double *a = work.data();           // dt A, [slot * B + régió]
+  double *mr = a + S * B;            // dt A - theta I, majd az LU tényezők (valós / képzetes rész)
+  double *mi = mr + S * B;
+  double *invR = mi + S * B;         // az U diagonálisának inverze
+  double *invI = invR + n * B;
+  double *xr = invI + n * B;
+  double *xi = xr + n * B;
+  double *y = xi + n * B;
+
+  for (const Term &term : m_terms)
+  {
+    double *target = a + static_cast<std::size_t>(term.slot) * B;
+    for (int l = 0; l < count; ++l)
+    {
+      const double value = term.kind == 0 ? 1.0 : rates[static_cast<std::size_t>(l) * 2 * n + 2 * static_cast<std::size_t>(term.nuclide) +
+                                                         static_cast<std::size_t>(term.kind - 1)];
+      target[l] += dt * term.coef * value;
+    }
+  }
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (int l = 0; l < count; ++l)
+    {
+      y[i * B + static_cast<std::size_t>(l)] = density[static_cast<std::size_t>(l) * n + i];
+    }
+  }
+
+  // A blokkon kívüli sávok (l >= count) A = 0, y = 0 értékkel futnak (a diagonális -theta, nem szinguláris)
+  for (int p = 0; p < kCramPoles; ++p)
+  {
+    const double thetaR = kCramThetaRe[p];
+    const double thetaI = kCramThetaIm[p];
+    std::copy(a, a + S * B, mr);
+    std::fill(mi, mi + S * B, 0.0);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      double *dr = mr + static_cast<std::size_t>(m_diag[k]) * B;
+      double *di = mi + static_cast<std::size_t>(m_diag[k]) * B;
+      for (std::size_t l = 0; l < B; ++l)
+      {
+        dr[l] -= thetaR;
+        di[l] -= thetaI;
+      }
+    }
+
+    // LU (komplex, régiónként párhuzamos sávokban)
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      const double *dr = mr + static_cast<std::size_t>(m_diag[k]) * B;
+      const double *di = mi + static_cast<std::size_t>(m_diag[k]) * B;
+      double *ir = invR + k * B;
+      double *ii = invI + k * B;
+      for (std::size_t l = 0; l < B; ++l)
+      {
+        const double norm = dr[l] * dr[l] + di[l] * di[l];
+        ir[l] = dr[l] / norm;
+        ii[l] = -di[l] / norm;
+      }
+      for (const Link &lower : m_lower[k])
+      {
+        double *lr = mr + static_cast<std::size_t>(lower.slot) * B;
+        double *li = mi + static_cast<std::size_t>(lower.slot) * B;
+        for (std::size_t l = 0; l < B; ++l)
+        {
+          const double re = lr[l] * ir[l] - li[l] * ii[l];
+          const double im = lr[l] * ii[l] + li[l] * ir[l];
+          lr[l] = re;
+          li[l] = im;
+        }
+      }
+      const std::vector<int> &update = m_update[k];
+      const std::size_t upperCount = m_upper[k].size();
+      for (std::size_t s = 0; s < m_lower[k].size(); ++s)
+      {
+        const double *lr = mr + static_cast<std::size_t>(m_lower[k][s].slot) * B;
+        const double *li = mi + static_cast<std::size_t>(m_lower[k][s].slot) * B;
+        for (std::size_t u = 0; u < upperCount; ++u)
+        {
+          const double *ur = mr + static_cast<std::size_t>(m_upper[k][u].slot) * B;
+          const double *ui = mi + static_cast<std::size_t>(m_upper[k][u].slot) * B;
+          double *tr = mr + static_cast<std::size_t>(update[s * upperCount + u]) * B;
+          double *ti = mi + static_cast<std::size_t>(update[s * upperCount + u]) * B;
+          for (std::size_t l = 0; l < B; ++l)
+          {
+            tr[l] -= lr[l] * ur[l] - li[l] * ui[l];
+            ti[l] -= lr[l] * ui[l] + li[l] * ur[l];
+          }
+        }
+      }
+    }
+
+    // Előre (egység alsó háromszög) és vissza helyettesítés
+    std::copy(y, y + n * B, xr);
+    std::fill(xi, xi + n * B, 0.0);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      const double *pr = xr + k * B;
+      const double *pi = xi + k * B;
+      for (const Link &lower : m_lower[k])
+      {
+        const double *lr = mr + static_cast<std::size_t>(lower.slot) * B;
+        const double *li = mi + static_cast<std::size_t>(lower.slot) * B;
+        double *tr = xr + static_cast<std::size_t>(lower.index) * B;
+        double *ti = xi + static_cast<std::size_t>(lower.index) * B;
+        for (std::size_t l = 0; l < B; ++l)
+        {
+          tr[l] -= lr[l] * pr[l] - li[l] * pi[l];
+          ti[l] -= lr[l] * pi[l] + li[l] * pr[l];
+        }
+      }
+    }
+    for (std::size_t k = n; k-- > 0;)
+    {
+      double *pr = xr + k * B;
+      double *pi = xi + k * B;
+      const double *ir = invR + k * B;
+      const double *ii = invI + k * B;
+      for (std::size_t l = 0; l < B; ++l)
+      {
+        const double re = pr[l] * ir[l] - pi[l] * ii[l];
+        const double im = pr[l] * ii[l] + pi[l] * ir[l];
+        pr[l] = re;
+        pi[l] = im;
+      }
+      for (const Link &upper : m_upperCol[k])
+      {
+        const double *ur = mr + static_cast<std::size_t>(upper.slot) * B;
+        const double *ui = mi + static_cast<std::size_t>(upper.slot) * B;
+        double *tr = xr + static_cast<std::size_t>(upper.index) * B;
+        double *ti = xi + static_cast<std::size_t>(upper.index) * B;
+        for (std::size_t l = 0; l < B; ++l)
+        {
+          tr[l] -= ur[l] * pr[l] - ui[l] * pi[l];
+          ti[l] -= ur[l] * pi[l] + ui[l] * pr[l];
+        }
+      }
+    }
+
+    const double alphaR = kCramAlphaRe[p];
+    const double alphaI = kCramAlphaIm[p];
+    for (std::size_t i = 0; i < n * B; ++i)
+    {
+      y[i] += 2.0 * (alphaR * xr[i] - alphaI * xi[i]);
+    }
+  }
+
+  // A CRAM kerekítési hibájából adódó (kb. 1e-16 relatív) negatív sűrűségek nullázása
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (int l = 0; l < count; ++l)
+    {
+      density[static_cast<std::size_t>(l) * n + i] = std::max(0.0, kCramAlpha0 * y[i * B + static_cast<std::size_t>(l)]);
+    }
+  }
+}
+
+void CramSolver::deplete(const std::vector<double> &rates, double dt, std::vector<double> &density) const
+{
+  const std::size_t n = static_cast<std::size_t>(m_n);
+  const std::size_t regions = n == 0 ? 0 : density.size() / n;
+  if (rates.size() != 2 * n * regions)
+  {
+    throw DepletionError("A reakciógyakoriságok száma nem egyezik a régiók és nuklidok számával.");
+  }
+  const std::size_t blocks = (regions + kBlock - 1) / kBlock;
+  std::vector<std::vector<double>> work(static_cast<std::size_t>(thread_count()));
+  parallel_chunks(0, blocks, [&](int t, std::size_t begin, std::size_t end) {
+    for (std::size_t b = begin; b < end; ++b)
+    {
+      const std::size_t first = b * kBlock;
+      const int count = static_cast<int>(std::min<std::size_t>(kBlock, regions - first));
+      solve_block(rates.data() + first * 2 * n, dt, density.data() + first * n, count, work[static_cast<std::size_t>(t)]);
+    }
+  }, 2);
+}
+
+void run_depletion(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const SolverConfig &config,
+                   const DepletionOptions &options, DepletionResult &result)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const XsDepletion &data = library.depletion;
+  if (!data.present())
+  {
+    throw DepletionError("A keresztmetszet könyvtár nem tartalmaz $Depletion blokkot (nuklid adatok).");
+  }
+  const int n = static_cast<int>(data.nuclides.size());
+  const int G = library.energyGroupCount;
+
+  const DepletionModel depletion(mesh, library, model, options);
+  const CramSolver cram(data);
+  const std::vector<Region> &regions = depletion.regions();
+  const std::size_t R = regions.size();
+  const EigenOptions eigenOptions = read_eigen_options(config);
+
+  result = DepletionResult();
+  result.regionCount = static_cast<int>(R);
+  result.matrixNonzeros = cram.matrix_nonzeros();
+  result.luNonzeros = cram.lu_nonzeros();
+  for (const XsNuclide &nuclide : data.nuclides)
+  {
+    result.nuclides.push_back(nuclide.name);
+  }
+  for (std::size_t r = 0; r < R; ++r)
+  {
+    result.burnableElements += static_cast<int>(regions[r].elements.size());
+    result.volume += regions[r].area;
+    for (int i = 0; i < n; ++i)
+    {
+      const XsNuclide &nuclide = data.nuclides[static_cast<std::size_t>(i)];
+      if (nuclide.mass >= kHeavyMetalMass)
+      {
+        result.heavyMetalMass += regions[r].area * depletion.initial_density()[r * static_cast<std::size_t>(n) + static_cast<std::size_t>(i)] *
+                                 nuclide.mass / kAvogadro;
+      }
+    }
+  }
+  if (!(result.heavyMetalMass > 0.0))
+  {
+    throw DepletionError("A kiégő régiókban nincs nehézfém (a teljesítmény normáláshoz kell).");
+  }
+  const double targetPower = options.power * result.heavyMetalMass;                   // [W / cm]
+  const double fissionEnergy = options.fissionEnergy * kMevToJoule;                   // [J]
+
+  // Egy összetétel állapot: új XS, assembly és k-sajátérték, majd a teljesítményre normált reakciógyakoriságok
+  EigenResult eigen;
+  struct State
+  {
+    double keff = 0.0;
+    double scale = 0.0;
+    int outer = 0;
+    double eigenMs = 0.0;
+    std::vector<double> rates;
+  };
+  auto evaluate = [&](const std::vector<double> &density) {
+    std::chrono::steady_clock::time_point phase = std::chrono::steady_clock::now();
+    const XsLibrary changed = depletion.library_for(density);
+    DiffusionSystem system;
+    assemble_diffusion(mesh, changed, depletion.element_material(), system);
+    result.xsMs += elapsed_ms(phase);
+
+    phase = std::chrono::steady_clock::now();
+    GroupSolver::UPtr solver = make_group_solver(system, config, nullptr);
+    solve_eigenvalue(system, *solver, eigenOptions, eigen);
+    if (!eigen.converged)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] A kiégési lépés sajátérték számítása nem konvergált (k = " << eigen.keff << ").\n";
+    }
+    State state;
+    state.keff = eigen.keff;
+    state.outer = eigen.outerIterations;
+    state.eigenMs = elapsed_ms(phase);
+    result.eigenMs += state.eigenMs;
+
+    const std::vector<double> phi = depletion.region_flux(eigen.flux);
+    double power = 0.0;
+    for (std::size_t r = 0; r < R; ++r)
+    {
+      double fissions = 0.0;
+      for (int i = 0; i < n; ++i)
+      {
+        const XsNuclide &nuclide = data.nuclides[static_cast<std::size_t>(i)];
+        for (int g = 0; g < G; ++g)
+        {
+          fissions += density[r * static_cast<std::size_t>(n) + static_cast<std::size_t>(i)] * group_value(nuclide.sigma_f, g) *
+                      phi[r * static_cast<std::size_t>(G) + static_cast<std::size_t>(g)];
+        }
+      }
+      power += fissionEnergy * regions[r].area * fissions;
+    }
+    if (!(power > 0.0))
+    {
+      throw DepletionError("A kiégő régiókban nincs hasadás, a teljesítmény nem normálható.");
+    }
+    state.scale = targetPower / power;
+    state.rates.assign(R * 2 * static_cast<std::size_t>(n), 0.0);
+    for (std::size_t r = 0; r < R; ++r)
+    {
+      for (int i = 0; i < n; ++i)
+      {
+        const XsNuclide &nuclide = data.nuclides[static_cast<std::size_t>(i)];
+        double capture = 0.0, fission = 0.0;
+        for (int g = 0; g < G; ++g)
+        {
+          const double flux = state.scale * phi[r * static_cast<std::size_t>(G) + static_cast<std::size_t>(g)];
+          capture += group_value(nuclide.sigma_c, g) * kBarn * flux;
+          fission += group_value(nuclide.sigma_f, g) * kBarn * flux;
+        }
+        state.rates[(r * static_cast<std::size_t>(n) + static_cast<std::size_t>(i)) * 2] = capture;
+        state.rates[(r * static_cast<std::size_t>(n) + static_cast<std::size_t>(i)) * 2 + 1] = fission;
+      }
+    }
+    return state;
+  };
+  auto average = [&](const std::vector<double> &density) {
+    std::vector<double> mean(static_cast<std::size_t>(n), 0.0);
+    for (std::size_t r = 0; r < R; ++r)
+    {
+      for (int i = 0; i < n; ++i)
+      {
+        mean[static_cast<std::size_t>(i)] += regions[r].area * density[r * static_cast<std::size_t>(n) + static_cast<std::size_t>(i)] / result.volume;
+      }
+    }
+    return mean;
+  };
+  auto deplete = [&](const std::vector<double> &rates, double dt, std::vector<double> &density) {
+    const std::chrono::steady_clock::time_point phase = std::chrono::steady_clock::now();
+    cram.deplete(rates, dt, density);
+    result.cramSolves += static_cast<long>(R);
+    const double ms = elapsed_ms(phase);
+    result.cramMs += ms;
+    return ms;
+  };
+
+  std::vector<double> density = depletion.initial_density();
+  State current = evaluate(density);
+  DepletionStep initial;
+  initial.keff = current.keff;
+  initial.fluxScale = current.scale;
+  initial.density = average(density);
+  initial.outerIterations = current.outer;
+  initial.eigenMs = current.eigenMs;
+  result.steps.push_back(initial);
+
+  double days = 0.0;
+  for (double stepDays : options.steps)
+  {
+    const double dt = stepDays * kSecondsPerDay;
+    DepletionStep step;
+
+    // Prediktor: a lépés eleji reakciógyakoriságokkal a lépés végére
+    std::vector<double> predicted = density;
+    step.cramMs += deplete(current.rates, dt, predicted);
+    if (options.corrector)
+    {
+      // Korrektor: a lépés eleji és a becsült lépés végi gyakoriságok átlagával a lépés elejéről újra
+      const State end = evaluate(predicted);
+      step.predictorKeff = end.keff;
+      step.eigenMs += end.eigenMs;
+      step.outerIterations += end.outer;
+      std::vector<double> rates(current.rates.size());
+      for (std::size_t k = 0; k < rates.size(); ++k)
+      {
+        rates[k] = 0.5 * (current.rates[k] + end.rates[k]);
+      }
+      step.cramMs += deplete(rates, dt, density);
+    }
+    else
+    {
+      density = predicted;
+    }
+
+    current = evaluate(density);
+    days += stepDays;
+    step.days = days;
+    step.burnup = options.power * days / 1000.0;
+    step.keff = current.keff;
+    step.fluxScale = current.scale;
+    step.density = average(density);
+    step.outerIterations += current.outer;
+    step.eigenMs += current.eigenMs;
+    result.steps.push_back(step);
+  }
+  result.flux = eigen.flux;
+  result.totalMs = elapsed_ms(totalStart);
+}
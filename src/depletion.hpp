@@ -0,0 +1,128 @@
+#ifndef DEPLETION_HPP
+#define DEPLETION_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Kiégés számítás: régiónként a Bateman egyenletek (dN/dt = A(phi) N) megoldása Chebyshev racionális
+// approximációval (CRAM, 16. rend, IPF alak), prediktor–korrektor lépésekkel.
+//
+// Régiók: a model fájl azon zónái, amelyek keverékében hasadó nuklid van ($Depletion blokk); a régió egy
+// háromszög (depletion_regions element) vagy a zóna egy fizikai csoportja (zone). A régiók kezdeti
+// atomsűrűségei a keverék sűrűségéből, atomszámaiból és a nuklidok moláris tömegéből adódnak.
+//
+// Visszacsatolás: minden régió saját XS anyagot kap (a fizikai csoport anyagának másolata), amelyben
+//   sigma_a = sigma_t += sum_i (N_i - N_i0) (sigma_c + sigma_f)_i,  nu_sigma_f += sum_i (N_i - N_i0) nu_i sigma_f,i
+// így a kezdeti állapot pontosan a könyvtár anyaga, és a kiégett összetétel fájl nélkül, compile_xs és újra
+// assembly után kerül a diffúziós operátorba.
+//
+// CRAM: a mátrix szerkezete (lánc) minden régióban azonos, csak az értékek (reakciógyakoriságok) mások. A
+// szimbolikus LU (pivotálás nélkül, a feltöltéssel) egyszer készül el; a numerikus rész régió blokkokon fut
+// (a komplex értékek valós és képzetes része külön, régiónként folytonos tömbben, a legbelső ciklus a régiókon
+// megy végig, így vektorizálható), a blokkok szálak között oszlanak meg.
+
+class DepletionError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct DepletionOptions
+{
+  std::vector<double> steps = {1.0, 4.0, 25.0, 30.0, 60.0}; // lépéshosszak [nap]
+  double power = 38.0;               // fajlagos teljesítmény [W / g kezdeti nehézfém], állandó
+  double fissionEnergy = 200.0;      // hasadásonként felszabaduló energia [MeV]
+  std::string regions = "element";   // element | zone
+  bool corrector = true;             // prediktor–korrektor (false: csak prediktor)
+};
+
+// depletion_steps: vesszővel elválasztott lépéshosszak napban (pl. 1,4,25,30,60)
+DepletionOptions read_depletion_options(const SolverConfig &config);
+
+// Kötegelt CRAM megoldó egy kiégési láncra
+class CramSolver
+{
+public:
+  explicit CramSolver(const XsDepletion &data);
+
+  // rates[r * 2n + 2i + {0, 1}]: az i nuklid befogási és hasadási gyakorisága a régióban [1/s];
+  // density[r * n + i]: a lépés elején, kimenetként a lépés végén
+  void deplete(const std::vector<double> &rates, double dt, std::vector<double> &density) const;
+
+  int nuclide_count() const { return m_n; }
+  int matrix_nonzeros() const { return m_matrixNonzeros; }
+  int lu_nonzeros() const { return static_cast<int>(m_slotRow.size()); }
+
+private:
+  // A mátrix egy tagja: slot += coef * (1, befogási vagy hasadási gyakoriság)
+  struct Term
+  {
+    int slot = 0;
+    int kind = 0;     // 0 = állandó (bomlás), 1 = befogás, 2 = hasadás
+    int nuclide = 0;
+    double coef = 0.0;
+  };
+  struct Link
+  {
+    int slot = 0;
+    int index = 0;    // a másik sor / oszlop
+  };
+
+  void solve_block(const double *rates, double dt, double *density, int count, std::vector<double> &work) const;
+
+  int m_n = 0;
+  int m_matrixNonzeros = 0;
+  std::vector<int> m_slotRow, m_slotCol;  // a feltöltött LU minta pozíciói
+  std::vector<int> m_diag;                // soronként a diagonális slot
+  std::vector<std::vector<Link>> m_lower; // k -> (i > k, slot(i, k))
+  std::vector<std::vector<Link>> m_upper; // k -> (j > k, slot(k, j))
+  std::vector<std::vector<Link>> m_upperCol; // k -> (i < k, slot(i, k))
+  std::vector<std::vector<int>> m_update;    // [k][a * |upper| + b]: slot(i_a, j_b) a k-adik eliminációban
+  std::vector<Term> m_terms;
+};
+
+// Egy állapotpont (a lépések végén, plusz a kezdeti állapot)
+struct DepletionStep
+{
+  double days = 0.0;
+  double burnup = 0.0;               // [MWd / kg kezdeti nehézfém]
+  double keff = 0.0;
+  double predictorKeff = 0.0;        // a prediktor lépés végi k (korrektor esetén)
+  double fluxScale = 0.0;            // a normált (egységnyi produkció) fluxus szorzója a teljesítményhez
+  std::vector<double> density;       // nuklidonként a régiók térfogattal súlyozott átlaga [1 / (barn cm)]
+  int outerIterations = 0;
+  double eigenMs = 0.0;
+  double cramMs = 0.0;
+};
+
+struct DepletionResult
+{
+  std::vector<std::string> nuclides;
+  int regionCount = 0;
+  int burnableElements = 0;
+  double heavyMetalMass = 0.0;       // [g / cm] (egységnyi magasságra)
+  double volume = 0.0;               // a kiégő régiók területe [cm^2]
+  int matrixNonzeros = 0;
+  int luNonzeros = 0;
+  std::vector<DepletionStep> steps;  // a kezdeti állapottal együtt
+  std::vector<std::vector<double>> flux; // a végső (normált) fluxus
+  long cramSolves = 0;               // régió x CRAM megoldás
+  double totalMs = 0.0;
+  double eigenMs = 0.0;
+  double cramMs = 0.0;
+  double xsMs = 0.0;                 // a régió anyagok felépítése, compile_xs és assembly
+};
+
+// Kiégési lépések a kezdeti összetételből; minden állapotponthoz saját XS, assembly és k-sajátérték számítás
+// (a belső megoldó és a sajátérték beállításai a $Solver szekcióból)
+void run_depletion(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const SolverConfig &config,
+                   const DepletionOptions &options, DepletionResult &result);
+
+#endif // DEPLETION_HPP
@@ -0,0 +1,409 @@
+#include "eigen.hpp"
+#include "vector_ops.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  // Teljes produkció = sum_g integral q_g (a P1 terhelésvektor elemeinek összege)
+  double total_production(const std::vector<std::vector<double>> &source)
+  {
+    double total = 0.0;
+    for (const std::vector<double> &q : source)
+    {
+      total += sum(q);
+    }
+    return total;
+  }
+
+  void scale_all(double factor, std::vector<std::vector<double>> &vectors)
+  {
+    for (std::vector<double> &v : vectors)
+    {
+      scale(factor, v);
+    }
+  }
+
+  // ||a - b|| / ||a|| az összes csoporton együtt
+  double relative_difference(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b,
+                              double *absolute)
+  {
+    double diff = 0.0;
+    double norm = 0.0;
+    for (std::size_t g = 0; g < a.size(); ++g)
+    {
+      const std::vector<double> &x = a[g];
+      const std::vector<double> &y = b[g];
+      for (std::size_t i = 0; i < x.size(); ++i)
+      {
+        diff += (x[i] - y[i]) * (x[i] - y[i]);
+        norm += x[i] * x[i];
+      }
+    }
+    if (absolute != nullptr)
+    {
+      *absolute = std::sqrt(diff);
+    }
+    return norm > 0.0 ? std::sqrt(diff / norm) : 0.0;
+  }
+
+  // Mérleg alapú k becslés: k = sum(F phi) / sum((A - S) phi), azaz produkció / (szivárgás + abszorpció + kiszórás - beszórás).
+  // Nem függ attól, hogy a belső menetek mennyire oldották meg pontosan az eltolt egyenletet.
+  double balance_keff(const DiffusionSystem &system, const std::vector<std::vector<double>> &flux,
+                      const std::vector<std::vector<double>> &source, std::vector<double> &work)
+  {
+    double loss = 0.0;
+    for (std::size_t g = 0; g < flux.size(); ++g)
+    {
+      system.groupMatrix[g].multiply(flux[g], work);
+      for (const GroupCoupling &c : system.scatter)
+      {
+        if (static_cast<std::size_t>(c.to) == g)
+        {
+          c.matrix.multiply_add(-1.0, flux[static_cast<std::size_t>(c.from)], work);
+        }
+      }
+      loss += sum(work);
+    }
+    return total_production(source) / loss;
+  }
+
+  // Chebyshev extrapoláció együtthatói a ciklus p. lépésére (p >= 1), sigma = dominancia arány
+  void chebyshev_coefficients(int p, double sigma, double &alpha, double &beta)
+  {
+    if (p == 1)
+    {
+      alpha = 2.0 / (2.0 - sigma);
+      beta = 0.0;
+      return;
+    }
+    const double gamma = std::acosh(2.0 / sigma - 1.0);
+    alpha = 4.0 / sigma * std::cosh((p - 1) * gamma) / std::cosh(p * gamma);
+    beta = (1.0 - 0.5 * sigma) * alpha - 1.0;
+  }
+}
+
+EigenOptions read_eigen_options(const SolverConfig &config)
+{
+  EigenOptions options;
+  options.kTolerance = config.getDouble("k_tol", options.kTolerance);
+  options.sourceTolerance = config.getDouble("source_tol", options.sourceTolerance);
+  options.maxOuter = config.getInt("max_outer", options.maxOuter);
+  options.groupSweeps = config.getInt("group_sweeps", options.groupSweeps);
+  options.acceleration = config.getString("acceleration", options.acceleration);
+  options.chebyshevStart = config.getInt("chebyshev_start", options.chebyshevStart);
+  options.chebyshevCycle = config.getInt("chebyshev_cycle", options.chebyshevCycle);
+  options.dominanceRatio = config.getDouble("dominance_ratio", options.dominanceRatio);
+  options.wielandtShift = config.getDouble("wielandt_shift", options.wielandtShift);
+  options.wielandtSweeps = config.getInt("wielandt_sweeps", options.wielandtSweeps);
+  options.wielandtStart = config.getInt("wielandt_start", options.wielandtStart);
+
+  if (options.acceleration != "none" && options.acceleration != "chebyshev" && options.acceleration != "wielandt")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen gyorsítás: \"" << options.acceleration << "\", nincs gyorsítás.\n";
+    options.acceleration = "none";
+  }
+  if (options.groupSweeps < 1)
+  {
+    options.groupSweeps = 1;
+  }
+  if (options.wielandtSweeps < 1)
+  {
+    options.wielandtSweeps = 1;
+  }
+  if (options.chebyshevStart < 2)
+  {
+    options.chebyshevStart = 2;
+  }
+  return options;
+}
+
+void compute_fission_source(const DiffusionSystem &system, const std::vector<std::vector<double>> &flux,
+                            std::vector<std::vector<double>> &source)
+{
+  const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+  source.resize(static_cast<std::size_t>(system.groupCount));
+  for (std::vector<double> &q : source)
+  {
+    q.assign(N, 0.0);
+  }
+  for (const GroupCoupling &c : system.fission)
+  {
+    c.matrix.multiply_add(1.0, flux[static_cast<std::size_t>(c.from)], source[static_cast<std::size_t>(c.to)]);
+  }
+}
+
+void solve_eigenvalue(const DiffusionSystem &system, GroupSolver &solver, const EigenOptions &options, EigenResult &result,
+                      CmfdAccelerator *cmfd)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+
+  EigenResult fresh;
+  double k = result.keff > 0.0 ? result.keff : 1.0;
+
+  // Kezdőérték: előző megoldás (ha van), különben egyenletes fluxus
+  std::vector<std::vector<double>> &flux = fresh.flux;
+  if (result.flux.size() == G && !result.flux.empty() && result.flux[0].size() == N)
+  {
+    flux = result.flux;
+  }
+  else
+  {
+    flux.assign(G, std::vector<double>(N, 1.0));
+  }
+
+  std::vector<std::vector<double>> source;
+  compute_fission_source(system, flux, source);
+  double production = total_production(source);
+  if (production <= 0.0)
+  {
+    throw SolverError("A rendszerben nincs hasadóanyag, a k-sajátérték nem értelmezhető.");
+  }
+  scale_all(1.0 / production, flux);
+  scale_all(1.0 / production, source);
+
+  std::vector<std::vector<double>> newSource;
+  std::vector<std::vector<double>> latestSource;
+  std::vector<std::vector<double>> fluxOld;
+  std::vector<std::vector<double>> fluxOlder;
+  std::vector<double> rhs(N);
+
+  // Egy csoport jobb oldala: fissionPart + beszórás a többi csoportból (Gauss–Seidel: a legfrissebb fluxussal)
+  auto solve_group = [&](std::size_t g, const std::vector<double> &fissionPart, double fissionScale,
+                         const std::vector<double> *extraPart, double extraScale) {
+    parallel_for(0, N, [&](std::size_t i) { rhs[i] = fissionScale * fissionPart[i]; });
+    if (extraPart != nullptr)
+    {
+      axpy(extraScale, *extraPart, rhs);
+    }
+    for (const GroupCoupling &c : system.scatter)
+    {
+      if (static_cast<std::size_t>(c.to) == g)
+      {
+        c.matrix.multiply_add(1.0, flux[static_cast<std::size_t>(c.from)], rhs);
+      }
+    }
+    const std::chrono::steady_clock::time_point innerStart = std::chrono::steady_clock::now();
+    const InnerStats stats = solver.solve(static_cast<int>(g), rhs, flux[g]);
+    fresh.innerMs += elapsed_ms(innerStart);
+    fresh.innerIterations += stats.iterations;
+    ++fresh.innerSolves;
+  };
+
+  // A Gauss–Seidel menet i-edik csoportja: a beszórás forrása (direktnél a gyorsabb, adjungáltnál a termikusabb
+  // csoportok) így még ugyanabban a menetben frissül, nem késik egy külső iterációt
+  auto sweep_group = [&](std::size_t i) { return options.reverseSweep ? G - 1 - i : i; };
+
+  // Csatolt megoldónál az összes csoport egyszerre: (A - S) phi = fissionScale * fissionPart + extraScale * extraPart
+  std::vector<std::vector<double>> coupledRhs;
+  auto solve_coupled = [&](const std::vector<std::vector<double>> &fissionPart, double fissionScale,
+                           const std::vector<std::vector<double>> *extraPart, double extraScale) {
+    coupledRhs.resize(G);
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      coupledRhs[g].resize(N);
+      parallel_for(0, N, [&](std::size_t i) { coupledRhs[g][i] = fissionScale * fissionPart[g][i]; });
+      if (extraPart != nullptr)
+      {
+        axpy(extraScale, (*extraPart)[g], coupledRhs[g]);
+      }
+    }
+    const std::chrono::steady_clock::time_point innerStart = std::chrono::steady_clock::now();
+    const InnerStats stats = solver.solve_coupled(coupledRhs, flux);
+    fresh.innerMs += elapsed_ms(innerStart);
+    fresh.innerIterations += stats.iterations;
+    ++fresh.innerSolves;
+  };
+
+  // A durva hálós lépés minden iterációban átírja a fluxust, a Chebyshev lépések közötti különbségek így értelmetlenek
+  if (cmfd != nullptr && options.acceleration == "chebyshev")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] CMFD mellett a Chebyshev extrapoláció kikapcsol.\n";
+  }
+  const bool useChebyshev = options.acceleration == "chebyshev" && cmfd == nullptr;
+  const bool useWielandt = options.acceleration == "wielandt";
+  int plainSinceRestart = 0; // Chebyshev: sima iterációk a legutóbbi (újra)becslés óta
+  int chebyshevStep = 0;     // 0 = nincs aktív ciklus
+  double sigma = options.dominanceRatio;
+  double lastDiff = 0.0;
+  bool wielandtActive = false;
+  double lastKChange = 1.0;
+
+  for (int outer = 1; outer <= options.maxOuter; ++outer)
+  {
+    const std::chrono::steady_clock::time_point outerStart = std::chrono::steady_clock::now();
+    if (useChebyshev)
+    {
+      fluxOlder.swap(fluxOld);
+      fluxOld = flux;
+    }
+
+    double kNew = k;
+    // Wielandt csak megbízható k becslés után indul: a k_s = k + shift eltolásnak a valódi k fölött kell lennie
+    if (useWielandt && !wielandtActive && outer > options.wielandtStart && lastKChange < 0.5 * options.wielandtShift)
+    {
+      wielandtActive = true;
+    }
+    if (wielandtActive)
+    {
+      // (M - F/k_s) phi = (1/k - 1/k_s) F phi_old, a bal oldali hasadási tagot késleltetve, menetenként frissítve
+      const double ks = k + options.wielandtShift;
+      const double invMu = 1.0 / k - 1.0 / ks;
+      latestSource = source;
+      for (int sweep = 0; sweep < options.wielandtSweeps; ++sweep)
+      {
+        if (sweep > 0)
+        {
+          compute_fission_source(system, flux, latestSource);
+        }
+        if (solver.coupled())
+        {
+          solve_coupled(source, invMu, &latestSource, 1.0 / ks);
+          continue;
+        }
+        for (std::size_t i = 0; i < G; ++i)
+        {
+          const std::size_t g = sweep_group(i);
+          solve_group(g, source[g], invMu, &latestSource[g], 1.0 / ks);
+        }
+      }
+      compute_fission_source(system, flux, newSource);
+      const double newProduction = total_production(newSource);
+      kNew = balance_keff(system, flux, newSource, rhs);
+      scale_all(1.0 / newProduction, flux);
+      scale_all(1.0 / newProduction, newSource);
+    }
+    else
+    {
+      if (solver.coupled())
+      {
+        solve_coupled(source, 1.0 / k, nullptr, 0.0);
+      }
+      else
+      {
+        for (int sweep = 0; sweep < options.groupSweeps; ++sweep)
+        {
+          for (std::size_t i = 0; i < G; ++i)
+          {
+            const std::size_t g = sweep_group(i);
+            solve_group(g, source[g], 1.0 / k, nullptr, 0.0);
+          }
+        }
+      }
+      compute_fission_source(system, flux, newSource);
+      const double newProduction = total_production(newSource);
+      kNew = k * newProduction;
+      scale_all(1.0 / newProduction, flux);
+      scale_all(1.0 / newProduction, newSource);
+    }
+
+    // Durva hálós gyorsítás: a cellánkénti skálázás után a k a durva sajátérték
+    if (cmfd != nullptr && outer >= cmfd->options().start)
+    {
+      const std::chrono::steady_clock::time_point cmfdStart = std::chrono::steady_clock::now();
+      const CmfdStats stats = cmfd->accelerate(flux, kNew);
+      fresh.cmfdIterations += stats.iterations;
+      if (stats.applied)
+      {
+        ++fresh.cmfdSteps;
+        compute_fission_source(system, flux, newSource);
+        const double p = total_production(newSource);
+        scale_all(1.0 / p, flux);
+        scale_all(1.0 / p, newSource);
+        kNew = stats.keff;
+      }
+      fresh.cmfdMs += elapsed_ms(cmfdStart);
+    }
+
+    // Chebyshev extrapoláció a fluxuson
+    if (useChebyshev)
+    {
+      double absDiff = 0.0;
+      relative_difference(newSource, source, &absDiff);
+      if (chebyshevStep == 0)
+      {
+        ++plainSinceRestart;
+        // Dominancia arány becslése egymást követő sima iterációk különbségeiből
+        if (plainSinceRestart >= 2 && lastDiff > 0.0)
+        {
+          fresh.dominanceRatio = absDiff / lastDiff;
+        }
+        lastDiff = absDiff;
+        if (plainSinceRestart >= options.chebyshevStart)
+        {
+          if (options.dominanceRatio <= 0.0)
+          {
+            sigma = fresh.dominanceRatio;
+          }
+          if (sigma > 0.0 && sigma < 1.0)
+          {
+            chebyshevStep = 1;
+          }
+          else
+          {
+            plainSinceRestart = 0; // értelmetlen becslés: újrakezdjük a mérést
+          }
+        }
+      }
+      else
+      {
+        double alpha = 0.0;
+        double beta = 0.0;
+        chebyshev_coefficients(chebyshevStep, std::min(sigma, 0.995), alpha, beta);
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          std::vector<double> &phi = flux[g];
+          const std::vector<double> &old = fluxOld[g];
+          const std::vector<double> *older = fluxOlder.empty() ? nullptr : &fluxOlder[g];
+          parallel_for(0, N, [&](std::size_t i) {
+            const double momentum = older != nullptr ? old[i] - (*older)[i] : 0.0;
+            phi[i] = old[i] + alpha * (phi[i] - old[i]) + beta * momentum;
+          });
+        }
+        compute_fission_source(system, flux, newSource);
+        const double p = total_production(newSource);
+        scale_all(1.0 / p, flux);
+        scale_all(1.0 / p, newSource);
+
+        ++chebyshevStep;
+        if (chebyshevStep > options.chebyshevCycle)
+        {
+          // Ciklus vége: újra sima iterációk és dominancia arány becslés
+          chebyshevStep = 0;
+          plainSinceRestart = 0;
+          lastDiff = 0.0;
+        }
+      }
+    }
+
+    const double residual = relative_difference(newSource, source, nullptr);
+    const double kChange = std::fabs(kNew - k) / kNew;
+    source.swap(newSource);
+    k = kNew;
+    lastKChange = kChange;
+
+    fresh.outerIterations = outer;
+    fresh.kHistory.push_back(k);
+    fresh.sourceResidual.push_back(residual);
+    fresh.outerMs.push_back(elapsed_ms(outerStart));
+
+    if (outer > 1 && kChange < options.kTolerance && residual < options.sourceTolerance)
+    {
+      fresh.converged = true;
+      break;
+    }
+  }
+
+  fresh.keff = k;
+  fresh.totalMs = elapsed_ms(totalStart);
+  result = std::move(fresh);
+}
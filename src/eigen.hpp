@@ -0,0 +1,61 @@
+#ifndef EIGEN_HPP
+#define EIGEN_HPP
+
+#include "assembly.hpp"
+#include "cmfd.hpp"
+#include "control.hpp"
+#include "inner_solver.hpp"
+#include <string>
+#include <vector>
+
+// k-sajátérték (kritikussági) számítás beállításai ($Solver szekció)
+struct EigenOptions
+{
+  double kTolerance = 1e-6;      // |k_n - k_{n-1}| / k_n
+  double sourceTolerance = 1e-5; // ||s_n - s_{n-1}|| / ||s_n|| (normált hasadási forrás)
+  int maxOuter = 1000;
+  int groupSweeps = 1;           // Gauss–Seidel menetek a csoportokon külső iterációnként (felszórás)
+  bool reverseSweep = false;     // a csoportok bejárása termikustól gyors felé (adjungált: a csatolás iránya fordított)
+
+  std::string acceleration = "none"; // none | chebyshev | wielandt
+  int chebyshevStart = 5;            // ennyi sima iteráció után becsüljük a dominancia arányt
+  int chebyshevCycle = 8;            // Chebyshev ciklus hossza, utána újrabecslés
+  double dominanceRatio = 0.0;       // 0 = becslés a sima iterációkból
+  double wielandtShift = 0.05;       // k_s = k + shift
+  int wielandtSweeps = 3;            // belső menetek a késleltetett hasadási taggal
+  int wielandtStart = 3;             // ennyi sima iteráció után kapcsol be az eltolás
+};
+
+EigenOptions read_eigen_options(const SolverConfig &config);
+
+// Eredmény + teljesítmény statisztika
+struct EigenResult
+{
+  double keff = 0.0;
+  std::vector<std::vector<double>> flux; // flux[g][csomópont], egységnyi teljes produkcióra normálva
+  bool converged = false;
+  int outerIterations = 0;
+  long innerIterations = 0;       // összes belső (Krylov) iteráció
+  int innerSolves = 0;
+  double dominanceRatio = 0.0;    // becsült dominancia arány (sima iterációkból)
+  double totalMs = 0.0;
+  double innerMs = 0.0;           // ebből a belső megoldóban töltött idő
+  std::vector<double> outerMs;    // külső iterációnkénti idő
+  std::vector<double> kHistory;
+  std::vector<double> sourceResidual;
+  int cmfdSteps = 0;              // alkalmazott durva hálós lépések
+  long cmfdIterations = 0;        // durva inverz iterációk összesen
+  double cmfdMs = 0.0;
+};
+
+// Hasadási forrás: q[to] = sum_from F_{to<-from} phi[from]
+void compute_fission_source(const DiffusionSystem &system, const std::vector<std::vector<double>> &flux,
+                            std::vector<std::vector<double>> &source);
+
+// Hatványiteráció (külső hasadási forrás iteráció), opcionális Chebyshev vagy Wielandt gyorsítással.
+// Ha result.flux nem üres és megfelelő méretű, kezdőértékként használja (warm start).
+// cmfd != nullptr esetén minden külső iteráció után durva hálós átskálázás (a Chebyshev extrapoláció ilyenkor nem fut).
+void solve_eigenvalue(const DiffusionSystem &system, GroupSolver &solver, const EigenOptions &options, EigenResult &result,
+                      CmfdAccelerator *cmfd = nullptr);
+
+#endif // EIGEN_HPP
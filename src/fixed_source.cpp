@@ -0,0 +1,569 @@
+#include "fixed_source.hpp"
+#include "block_sparse.hpp"
+#include "eigen.hpp"
+#include "parallel.hpp"
+#include "perturbation.hpp"
+#include "vector_ops.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+  typedef std::vector<std::vector<double>> GroupVectors; // [g][csomópont]
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  double group_norm(const GroupVectors &a)
+  {
+    double s = 0.0;
+    for (const std::vector<double> &v : a)
+    {
+      s += dot(v, v);
+    }
+    return std::sqrt(s);
+  }
+
+  double group_sum(const GroupVectors &x)
+  {
+    double s = 0.0;
+    for (const std::vector<double> &v : x)
+    {
+      s += sum(v);
+    }
+    return s;
+  }
+
+  // r = Q + S phi + F phi - A phi (fission = false esetén F nélkül)
+  void residual(const DiffusionSystem &system, const GroupVectors &source, const GroupVectors &flux, bool fission,
+                GroupVectors &r)
+  {
+    r.resize(flux.size());
+    for (std::size_t g = 0; g < flux.size(); ++g)
+    {
+      system.groupMatrix[g].multiply(flux[g], r[g]);
+      const std::vector<double> &q = source[g];
+      std::vector<double> &rg = r[g];
+      parallel_for(0, rg.size(), [&](std::size_t i) { rg[i] = q[i] - rg[i]; });
+    }
+    for (const GroupCoupling &c : system.scatter)
+    {
+      c.matrix.multiply_add(1.0, flux[static_cast<std::size_t>(c.from)], r[static_cast<std::size_t>(c.to)]);
+    }
+    if (fission)
+    {
+      for (const GroupCoupling &c : system.fission)
+      {
+        c.matrix.multiply_add(1.0, flux[static_cast<std::size_t>(c.from)], r[static_cast<std::size_t>(c.to)]);
+      }
+    }
+  }
+
+  // Anyagonként a menet végtelen közegbeli iterációs mátrixának domináns sajátvektora (összege 1):
+  //   Gauss–Seidel: T = (D - L)^-1 (U + F),  csatolt megoldó: T = (D - L - U)^-1 F
+  // ahol D a removal, L / U a le- / felszórás, F = chi nuSigmaF^T. Ha T = 0 (nincs mit gyorsítani), egyenletes.
+  std::vector<double> material_spectrum(const XsCompiled &xs, int m, bool coupled, bool fission)
+  {
+    const std::size_t G = static_cast<std::size_t>(xs.groupCount);
+    const double *scatter = xs.scatter_of(m);
+    std::vector<double> lhs(G * G, 0.0), rhs(G * G, 0.0); // [to * G + from]
+    for (std::size_t to = 0; to < G; ++to)
+    {
+      lhs[to * G + to] = xs.sigma_r[xs.index(m, static_cast<int>(to))];
+      for (std::size_t from = 0; from < G; ++from)
+      {
+        if (from == to)
+        {
+          continue;
+        }
+        const double s = scatter[from * G + to];
+        if (from < to || coupled)
+        {
+          lhs[to * G + from] -= s;
+        }
+        else
+        {
+          rhs[to * G + from] += s;
+        }
+      }
+      if (fission)
+      {
+        for (std::size_t from = 0; from < G; ++from)
+        {
+          rhs[to * G + from] += xs.chi[xs.index(m, static_cast<int>(to))] * xs.nu_sigma_f[xs.index(m, static_cast<int>(from))];
+        }
+      }
+    }
+
+    // Hatványiteráció: y = lhs^-1 (rhs x), a G x G rendszer Gauss eliminációval (részleges főelem-kiválasztással)
+    std::vector<double> x(G, 1.0 / static_cast<double>(G)), y(G), a(G * G);
+    for (int it = 0; it < 200; ++it)
+    {
+      for (std::size_t i = 0; i < G; ++i)
+      {
+        y[i] = 0.0;
+        for (std::size_t j = 0; j < G; ++j)
+        {
+          y[i] += rhs[i * G + j] * x[j];
+        }
+      }
+      a = lhs;
+      for (std::size_t k = 0; k < G; ++k)
+      {
+        std::size_t pivot = k;
+        for (std::size_t i = k + 1; i < G; ++i)
+        {
+          if (std::fabs(a[i * G + k]) > std::fabs(a[pivot * G + k]))
+          {
+            pivot = i;
+          }
+        }
+        if (a[pivot * G + k] == 0.0)
+        {
+          return std::vector<double>(G, 1.0 / static_cast<double>(G));
+        }
+        if (pivot != k)
+        {
+          for (std::size_t j = 0; j < G; ++j)
+          {
+            std::swap(a[k * G + j], a[pivot * G + j]);
+          }
+          std::swap(y[k], y[pivot]);
+        }
+        for (std::size_t i = k + 1; i < G; ++i)
+        {
+          const double f = a[i * G + k] / a[k * G + k];
+          for (std::size_t j = k; j < G; ++j)
+          {
+            a[i * G + j] -= f * a[k * G + j];
+          }
+          y[i] -= f * y[k];
+        }
+      }
+      for (std::size_t k = G; k-- > 0;)
+      {
+        for (std::size_t j = k + 1; j < G; ++j)
+        {
+          y[k] -= a[k * G + j] * y[j];
+        }
+        y[k] /= a[k * G + k];
+      }
+      double total = 0.0;
+      for (double v : y)
+      {
+        total += std::fabs(v);
+      }
+      if (total == 0.0)
+      {
+        return std::vector<double>(G, 1.0 / static_cast<double>(G));
+      }
+      double change = 0.0;
+      for (std::size_t i = 0; i < G; ++i)
+      {
+        const double v = std::fabs(y[i]) / total;
+        change = std::max(change, std::fabs(v - x[i]));
+        x[i] = v;
+      }
+      if (change < 1e-12)
+      {
+        break;
+      }
+    }
+    return x;
+  }
+
+  // Kétrácsos gyorsítás: csomóponti spektrum (a szomszédos elemek anyagspektrumainak területtel súlyozott átlaga),
+  // az egycsoportos R (A - S - F) P mátrix a közös mintázaton, és a rá épített csatolt (BiCGSTAB + ILU(0)) megoldó
+  class TwoGridCorrection
+  {
+  public:
+    TwoGridCorrection(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system, bool coupled,
+                      const FixedSourceOptions &options)
+    {
+      const XsCompiled &xs = library.compiled;
+      const std::size_t G = static_cast<std::size_t>(system.groupCount);
+      const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+      std::vector<std::vector<double>> spectra(static_cast<std::size_t>(xs.materialCount));
+      for (int m = 0; m < xs.materialCount; ++m)
+      {
+        spectra[static_cast<std::size_t>(m)] = material_spectrum(xs, m, coupled, options.fission);
+      }
+      m_xi.assign(G, std::vector<double>(N, 0.0));
+      std::vector<double> weight(N, 0.0);
+      for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+      {
+        const std::vector<double> &spectrum = spectra[static_cast<std::size_t>(system.elementMaterial[e])];
+        const double area = system.geometry[e].area;
+        for (int node : {mesh.tris[e].a, mesh.tris[e].b, mesh.tris[e].c})
+        {
+          const std::size_t i = static_cast<std::size_t>(node - 1);
+          weight[i] += area;
+          for (std::size_t g = 0; g < G; ++g)
+          {
+            m_xi[g][i] += area * spectrum[g];
+          }
+        }
+      }
+      for (std::size_t i = 0; i < N; ++i)
+      {
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          m_xi[g][i] = weight[i] > 0.0 ? m_xi[g][i] / weight[i] : 1.0 / static_cast<double>(G);
+        }
+      }
+
+      // (R M P)(i, j) = sum_g A_g(i, j) xi_g(j) - sum_{csatolások} C(i, j) xi_from(j)
+      const CsrPattern &pattern = *system.pattern;
+      m_coarse.groupCount = 1;
+      m_coarse.nodeCount = system.nodeCount;
+      m_coarse.pattern = system.pattern;
+      m_coarse.groupMatrix.resize(1);
+      CsrMatrix &L = m_coarse.groupMatrix[0];
+      L.pattern = system.pattern;
+      L.values.assign(pattern.nnz(), 0.0);
+      parallel_for(0, N, [&](std::size_t i) {
+        for (int k = pattern.rowPtr[i]; k < pattern.rowPtr[i + 1]; ++k)
+        {
+          const std::size_t j = static_cast<std::size_t>(pattern.colIdx[static_cast<std::size_t>(k)]);
+          double v = 0.0;
+          for (std::size_t g = 0; g < G; ++g)
+          {
+            v += system.groupMatrix[g].values[static_cast<std::size_t>(k)] * m_xi[g][j];
+          }
+          for (const GroupCoupling &c : system.scatter)
+          {
+            v -= c.matrix.values[static_cast<std::size_t>(k)] * m_xi[static_cast<std::size_t>(c.from)][j];
+          }
+          if (options.fission)
+          {
+            for (const GroupCoupling &c : system.fission)
+            {
+              v -= c.matrix.values[static_cast<std::size_t>(k)] * m_xi[static_cast<std::size_t>(c.from)][j];
+            }
+          }
+          L.values[static_cast<std::size_t>(k)] = v;
+        }
+      });
+
+      InnerOptions inner;
+      inner.tolerance = options.coarseTolerance;
+      inner.maxIterations = options.coarseMaxIterations;
+      inner.blockPreconditioner = "bilu0";
+      m_solver.reset(new CoupledSolver(m_coarse, inner));
+      m_rhs.assign(1, std::vector<double>(N, 0.0));
+      m_correction.assign(1, std::vector<double>(N, 0.0));
+    }
+
+    // phi_g += xi_g * eps, ahol (R M P) eps = sum_g r_g
+    int apply(const GroupVectors &r, GroupVectors &flux)
+    {
+      const std::size_t G = flux.size();
+      std::vector<double> &b = m_rhs[0];
+      std::vector<double> &eps = m_correction[0];
+      parallel_for(0, b.size(), [&](std::size_t i) {
+        double s = 0.0;
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          s += r[g][i];
+        }
+        b[i] = s;
+      });
+      std::fill(eps.begin(), eps.end(), 0.0);
+      const InnerStats stats = m_solver->solve_coupled(m_rhs, m_correction);
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        const std::vector<double> &xi = m_xi[g];
+        std::vector<double> &phi = flux[g];
+        parallel_for(0, phi.size(), [&](std::size_t i) { phi[i] += xi[i] * eps[i]; });
+      }
+      return stats.iterations;
+    }
+
+  private:
+    GroupVectors m_xi;        // [g][csomópont], csomópontonként összege 1
+    DiffusionSystem m_coarse; // egycsoportos rendszer a közös mintázaton
+    GroupSolver::UPtr m_solver;
+    GroupVectors m_rhs, m_correction;
+  };
+}
+
+void load_sources(const std::string &path, std::vector<ZoneSource> &sources)
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    throw FixedSourceError("Nem sikerült megnyitni a forrás fájlt: " + path);
+  }
+  std::vector<ZoneSource> fresh;
+  std::string line;
+  std::size_t lineNo = 0;
+  while (std::getline(in, line))
+  {
+    ++lineNo;
+    const std::size_t hashPos = line.find('#');
+    std::istringstream iss(hashPos == std::string::npos ? line : line.substr(0, hashPos));
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token)
+    {
+      tokens.push_back(token);
+    }
+    if (tokens.empty())
+    {
+      continue;
+    }
+    if (tokens.size() != 3)
+    {
+      throw FixedSourceParseError(lineNo, "Hibás mezőszám (zóna csoport erősség).");
+    }
+    ZoneSource s;
+    s.target = tokens[0];
+    if (tokens[1] != "*")
+    {
+      std::istringstream group(tokens[1]);
+      int g = 0;
+      char extra = '\0';
+      if (!(group >> g) || (group >> extra) || g < 1)
+      {
+        throw FixedSourceParseError(lineNo, "Érvénytelen csoport: \"" + tokens[1] + "\" (1-bázisú szám vagy '*').");
+      }
+      s.group = g - 1;
+    }
+    std::istringstream strength(tokens[2]);
+    char extra = '\0';
+    if (!(strength >> s.strength) || (strength >> extra) || s.strength < 0.0)
+    {
+      throw FixedSourceParseError(lineNo, "Érvénytelen (negatív vagy nem szám) forrás erősség: \"" + tokens[2] + "\"");
+    }
+    fresh.push_back(s);
+  }
+  if (fresh.empty())
+  {
+    throw FixedSourceError("A forrás fájl nem tartalmaz forrást: " + path);
+  }
+  sources = std::move(fresh);
+}
+
+void build_source_vector(const Mesh &mesh, const ModelLibrary &model, const DiffusionSystem &system,
+                         const std::vector<ZoneSource> &sources, std::vector<std::vector<double>> &source)
+{
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+
+  // Fizikai csoport id -> csoportonkénti forrás sűrűség
+  std::map<int, std::vector<double>> density;
+  for (const ZoneSource &s : sources)
+  {
+    if (s.group >= static_cast<int>(G))
+    {
+      throw FixedSourceError("A(z) \"" + s.target + "\" forrás csoportja nem létezik.");
+    }
+    std::vector<std::string> groupNames;
+    try
+    {
+      groupNames = target_physical_groups(mesh, model, s.target);
+    }
+    catch (const PerturbationError &ex)
+    {
+      throw FixedSourceError(ex.what());
+    }
+    for (const std::string &name : groupNames)
+    {
+      for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+      {
+        if (it->second != name)
+        {
+          continue;
+        }
+        std::vector<double> &q = density[it->first];
+        q.resize(G, 0.0);
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          if (s.group < 0 || static_cast<std::size_t>(s.group) == g)
+          {
+            q[g] += s.strength;
+          }
+        }
+      }
+    }
+  }
+
+  source.assign(G, std::vector<double>(N, 0.0));
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    const std::map<int, std::vector<double>>::const_iterator it = density.find(mesh.tris[e].phys);
+    if (it == density.end())
+    {
+      continue;
+    }
+    const double third = system.geometry[e].area / 3.0;
+    for (int node : {mesh.tris[e].a, mesh.tris[e].b, mesh.tris[e].c})
+    {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        source[g][static_cast<std::size_t>(node - 1)] += it->second[g] * third;
+      }
+    }
+  }
+  if (group_sum(source) <= 0.0)
+  {
+    throw FixedSourceError("A forrás a hálón nulla (a forrás zónák egyetlen háromszöget sem tartalmaznak?).");
+  }
+}
+
+FixedSourceOptions read_fixed_source_options(const SolverConfig &config)
+{
+  FixedSourceOptions options;
+  options.tolerance = config.getDouble("fixed_tol", options.tolerance);
+  options.maxIterations = config.getInt("fixed_max_iter", options.maxIterations);
+  options.fission = config.getBool("fixed_fission", options.fission);
+  options.acceleration = config.getString("fixed_acceleration", options.acceleration);
+  options.coarseTolerance = config.getDouble("fixed_coarse_tol", options.coarseTolerance);
+  options.coarseMaxIterations = config.getInt("fixed_coarse_max_iter", options.coarseMaxIterations);
+  if (options.acceleration != "tg" && options.acceleration != "none")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen fix forrás gyorsítás: \"" << options.acceleration << "\", tg-t használok.\n";
+    options.acceleration = "tg";
+  }
+  return options;
+}
+
+void solve_fixed_source(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system, GroupSolver &solver,
+                        const std::vector<std::vector<double>> &source, const FixedSourceOptions &options,
+                        FixedSourceResult &result)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+
+  FixedSourceResult fresh;
+  GroupVectors &flux = fresh.flux;
+  if (result.flux.size() == G && !result.flux.empty() && result.flux[0].size() == N)
+  {
+    flux = result.flux;
+  }
+  else
+  {
+    flux.assign(G, std::vector<double>(N, 0.0));
+  }
+  fresh.sourceTotal = group_sum(source);
+  const double sourceNorm = group_norm(source);
+
+  std::unique_ptr<TwoGridCorrection> twoGrid;
+  if (options.acceleration == "tg")
+  {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    twoGrid.reset(new TwoGridCorrection(mesh, library, system, solver.coupled(), options));
+    fresh.coarseMs += elapsed_ms(start);
+  }
+
+  GroupVectors fission, r, rhsAll(G, std::vector<double>(N, 0.0));
+  std::vector<double> rhs(N);
+  int growing = 0;
+  for (int iteration = 1; iteration <= options.maxIterations; ++iteration)
+  {
+    // Egy menet: a hasadás (és csatolatlan megoldónál a felszórás) az előző iterációból
+    if (options.fission)
+    {
+      compute_fission_source(system, flux, fission);
+    }
+    const std::chrono::steady_clock::time_point innerStart = std::chrono::steady_clock::now();
+    if (solver.coupled())
+    {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        rhsAll[g] = source[g];
+        if (options.fission)
+        {
+          axpy(1.0, fission[g], rhsAll[g]);
+        }
+      }
+      const InnerStats stats = solver.solve_coupled(rhsAll, flux);
+      fresh.innerIterations += stats.iterations;
+      ++fresh.innerSolves;
+    }
+    else
+    {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        rhs = source[g];
+        if (options.fission)
+        {
+          axpy(1.0, fission[g], rhs);
+        }
+        for (const GroupCoupling &c : system.scatter)
+        {
+          if (static_cast<std::size_t>(c.to) == g)
+          {
+            c.matrix.multiply_add(1.0, flux[static_cast<std::size_t>(c.from)], rhs);
+          }
+        }
+        const InnerStats stats = solver.solve(static_cast<int>(g), rhs, flux[g]);
+        fresh.innerIterations += stats.iterations;
+        ++fresh.innerSolves;
+      }
+    }
+    fresh.innerMs += elapsed_ms(innerStart);
+
+    residual(system, source, flux, options.fission, r);
+    const double res = group_norm(r) / sourceNorm;
+    fresh.residualHistory.push_back(res);
+    fresh.iterations = iteration;
+    fresh.residual = res;
+    if (res <= options.tolerance)
+    {
+      fresh.converged = true;
+      break;
+    }
+
+    // Szuperkritikus rendszerben a gyorsítatlan menetek divergálnak
+    const std::size_t h = fresh.residualHistory.size();
+    growing = h >= 2 && res > fresh.residualHistory[h - 2] ? growing + 1 : 0;
+    if (growing >= 5 && res > fresh.residualHistory[0])
+    {
+      throw FixedSourceError("A fix forrás iteráció divergál (a reziduum menetenként " +
+                             std::to_string(res / fresh.residualHistory[h - 2]) +
+                             "-szorosára nő): a rendszer nem szubkritikus.");
+    }
+
+    if (twoGrid)
+    {
+      const std::chrono::steady_clock::time_point coarseStart = std::chrono::steady_clock::now();
+      fresh.coarseIterations += twoGrid->apply(r, flux);
+      fresh.coarseMs += elapsed_ms(coarseStart);
+    }
+  }
+
+  // Átlagos csökkenés az utolsó (legfeljebb 5) menetben
+  const std::size_t h = fresh.residualHistory.size();
+  if (h >= 2)
+  {
+    const std::size_t span = std::min<std::size_t>(5, h - 1);
+    const double first = fresh.residualHistory[h - 1 - span];
+    if (first > 0.0 && fresh.residualHistory[h - 1] > 0.0)
+    {
+      fresh.convergenceRate = std::pow(fresh.residualHistory[h - 1] / first, 1.0 / static_cast<double>(span));
+    }
+  }
+
+  compute_fission_source(system, flux, fission);
+  fresh.production = options.fission ? group_sum(fission) : 0.0;
+  if (fresh.production < 0.0 || group_sum(flux) <= 0.0)
+  {
+    throw FixedSourceError("A fix forrás megoldás nem pozitív: a rendszer nem szubkritikus (k >= 1), "
+                           "a feladatnak nincs fizikai megoldása.");
+  }
+  fresh.multiplication = (fresh.sourceTotal + fresh.production) / fresh.sourceTotal;
+  fresh.kSource = fresh.production / (fresh.sourceTotal + fresh.production);
+  fresh.totalMs = elapsed_ms(totalStart);
+  result = std::move(fresh);
+}
@@ -0,0 +1,103 @@
+#ifndef FIXED_SOURCE_HPP
+#define FIXED_SOURCE_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "inner_solver.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Fix (külső) forrású, szubkritikus számítás: (A - S - F) phi = Q.
+//
+// A megoldás ugyanazt a felépített operátort és belső megoldót használja, mint a sajátérték számítás, csak a
+// jobb oldal más: a zónánként és csoportonként megadott forrás erősség a P1 súlyfüggvényekkel integrálva.
+// Egy iteráció egy Gauss–Seidel menet a csoportokon (a beszórás és a hasadás az előző iterációból), csatolt
+// belső megoldónál egy csatolt megoldás (ott csak a hasadás késik).
+//
+// Felszórásnál és erősen sokszorozó közegben (k közel 1) a menetek lassan konvergálnak: a hiba lassú része
+// térben sima, energiában pedig az anyag végtelen közegbeli iterációs mátrixának domináns sajátvektorát követi.
+// A kétrácsos (Adams–Morel típusú) gyorsítás ezért minden menet után a reziduumot energiában összegzi, egy
+// egycsoportos korrekciós feladatot old meg (a csoportonkénti mátrixok a spektrummal súlyozva, ugyanazon a
+// mintázaton), és a korrekciót a spektrummal visszaosztja a csoportokra.
+
+class FixedSourceError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class FixedSourceParseError : public FixedSourceError
+{
+public:
+  FixedSourceParseError(std::size_t line, const std::string &message)
+      : FixedSourceError(message), m_line(line)
+  {
+  }
+
+  std::size_t line() const noexcept { return m_line; }
+
+private:
+  std::size_t m_line = 0;
+};
+
+// Egy zóna (vagy fizikai csoport) térfogati forrása egy csoportban [n / cm^3 / s]
+struct ZoneSource
+{
+  std::string target; // Model zóna neve, vagy közvetlenül a háló fizikai csoport neve
+  int group = -1;     // 0-bázisú csoport, -1 = minden csoport
+  double strength = 0.0;
+};
+
+// Forrás lista beolvasása. Soronként (üres sor és # komment megengedett):
+//   zóna csoport erősség
+// A csoport 1-bázisú, '*' = minden csoport; ugyanarra a helyre eső források összeadódnak.
+void load_sources(const std::string &path, std::vector<ZoneSource> &sources);
+
+// A forrás vektor: Q[g][i] = sum_e q_g(e) * terület(e) / 3 az i csomópontot tartalmazó forrás elemekre
+void build_source_vector(const Mesh &mesh, const ModelLibrary &model, const DiffusionSystem &system,
+                         const std::vector<ZoneSource> &sources, std::vector<std::vector<double>> &source);
+
+struct FixedSourceOptions
+{
+  double tolerance = 1e-6;          // ||Q - (A - S - F) phi|| / ||Q||
+  int maxIterations = 500;
+  bool fission = true;              // off: nem sokszorozó számítás (a hasadás kimarad)
+  std::string acceleration = "tg";  // tg (kétrácsos egycsoportos korrekció) | none
+  double coarseTolerance = 1e-3;    // az egycsoportos korrekciós feladat relatív reziduuma
+  int coarseMaxIterations = 200;
+};
+
+FixedSourceOptions read_fixed_source_options(const SolverConfig &config);
+
+struct FixedSourceResult
+{
+  std::vector<std::vector<double>> flux; // flux[g][csomópont]
+  bool converged = false;
+  int iterations = 0;
+  long innerIterations = 0;
+  int innerSolves = 0;
+  long coarseIterations = 0;
+  double residual = 0.0;             // a végső relatív reziduum
+  double convergenceRate = 0.0;      // az utolsó menetek átlagos reziduum csökkenése menetenként
+  std::vector<double> residualHistory;
+  double sourceTotal = 0.0;          // sum Q
+  double production = 0.0;           // sum F phi (teljes hasadási neutron keltés)
+  double multiplication = 0.0;       // (Q + F phi) / Q
+  double kSource = 0.0;              // F phi / (Q + F phi), forrás-sokszorozási tényező
+  double totalMs = 0.0;
+  double innerMs = 0.0;
+  double coarseMs = 0.0;             // spektrumok, egycsoportos mátrix és a korrekciós megoldások
+};
+
+// Fix forrású megoldás. Ha result.flux nem üres és megfelelő méretű, kezdőértékként használja.
+// Szuperkritikus rendszernél (a menetek divergálnak, vagy a gyorsított megoldás nem pozitív) FixedSourceError.
+void solve_fixed_source(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system, GroupSolver &solver,
+                        const std::vector<std::vector<double>> &source, const FixedSourceOptions &options,
+                        FixedSourceResult &result);
+
+#endif // FIXED_SOURCE_HPP
@@ -0,0 +1,620 @@
+#include "heat.hpp"
+#include "eigen.hpp"
+#include "inner_solver.hpp"
+#include "parallel.hpp"
+#include "vector_ops.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  // Fizikai csoport ID-k a csoport neve alapján
+  std::vector<int> phys_ids(const Mesh &mesh, const std::string &name)
+  {
+    std::vector<int> ids;
+    for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+    {
+      if (it->second == name)
+      {
+        ids.push_back(it->first);
+      }
+    }
+    return ids;
+  }
+
+  // Kis sűrű rendszer megoldása Gauss eliminációval (részleges főelem kiválasztással); az Anderson lépéshez
+  std::vector<double> solve_dense(std::vector<double> A, std::vector<double> b)
+  {
+    const std::size_t n = b.size();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      std::size_t pivot = k;
+      for (std::size_t i = k + 1; i < n; ++i)
+      {
+        if (std::fabs(A[i * n + k]) > std::fabs(A[pivot * n + k]))
+        {
+          pivot = i;
+        }
+      }
+      if (pivot != k)
+      {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+          std::swap(A[k * n + j], A[pivot * n + j]);
+        }
+        std::swap(b[k], b[pivot]);
+      }
+      if (A[k * n + k] == 0.0)
+      {
+        return std::vector<double>(n, 0.0);
+      }
+      for (std::size_t i = k + 1; i < n; ++i)
+      {
+        const double factor = A[i * n + k] / A[k * n + k];
+        for (std::size_t j = k; j < n; ++j)
+        {
+          A[i * n + j] -= factor * A[k * n + j];
+        }
+        b[i] -= factor * b[k];
+      }
+    }
+    std::vector<double> x(n, 0.0);
+    for (std::size_t k = n; k-- > 0;)
+    {
+      double s = b[k];
+      for (std::size_t j = k + 1; j < n; ++j)
+      {
+        s -= A[k * n + j] * x[j];
+      }
+      x[k] = s / A[k * n + k];
+    }
+    return x;
+  }
+}
+
+HeatOptions read_heat_options(const SolverConfig &config)
+{
+  HeatOptions options;
+  options.power = config.getDouble("heat_power", options.power);
+  options.boundary = config.getString("heat_boundary", options.boundary);
+  options.htc = config.getDouble("heat_htc", options.htc);
+  options.coolantTemperature = config.getDouble("heat_coolant_temp", options.coolantTemperature);
+  options.meshUnit = config.getString("heat_mesh_unit", options.meshUnit);
+  if (options.meshUnit == "cm")
+  {
+    options.lengthScale = 1.0;
+  }
+  else if (options.meshUnit == "mm")
+  {
+    options.lengthScale = 0.1;
+  }
+  else
+  {
+    throw HeatError("A heat_mesh_unit értéke cm vagy mm lehet.");
+  }
+  options.tolerance = config.getDouble("heat_tol", options.tolerance);
+  options.maxIterations = config.getInt("heat_max_iter", options.maxIterations);
+  if (!(options.power > 0.0) || !(options.htc > 0.0) || !(options.coolantTemperature > 0.0))
+  {
+    throw HeatError("A heat_power, heat_htc és heat_coolant_temp pozitív kell legyen.");
+  }
+  if (!(options.tolerance > 0.0) || options.maxIterations < 1)
+  {
+    throw HeatError("A heat_tol pozitív, a heat_max_iter legalább 1 kell legyen.");
+  }
+  return options;
+}
+
+FeedbackOptions read_feedback_options(const SolverConfig &config)
+{
+  FeedbackOptions options;
+  options.coupling = config.getString("feedback_coupling", options.coupling);
+  options.relax = config.getDouble("feedback_relax", options.relax);
+  options.depth = config.getInt("feedback_depth", options.depth);
+  options.tolerance = config.getDouble("feedback_tol", options.tolerance);
+  options.maxIterations = config.getInt("feedback_max_iter", options.maxIterations);
+  if (options.coupling != "picard" && options.coupling != "anderson")
+  {
+    throw HeatError("A feedback_coupling értéke picard vagy anderson lehet.");
+  }
+  if (!(options.relax > 0.0) || options.relax > 1.0)
+  {
+    throw HeatError("A feedback_relax a (0, 1] tartományba kell essen.");
+  }
+  if (options.depth < 1 || !(options.tolerance > 0.0) || options.maxIterations < 1)
+  {
+    throw HeatError("A feedback_depth és feedback_max_iter legalább 1, a feedback_tol pozitív kell legyen.");
+  }
+  return options;
+}
+
+HeatConduction::HeatConduction(const Mesh &mesh, const ModelLibrary &model, const std::vector<ElementGeometry> &geometry,
+                               const HeatOptions &options)
+    : m_mesh(mesh), m_geometry(geometry), m_options(options)
+{
+  // Fizikai csoportonként a hővezetési tényező (a $Thermal blokkból, a zóna keverékén keresztül)
+  std::map<int, double> physConductivity;
+  for (const Material &assignment : model.materials)
+  {
+    const Mixture *mixture = model.findMixture(assignment.mixtureName);
+    const Zone *zone = model.findZone(assignment.zoneName);
+    if (mixture == nullptr || zone == nullptr || !(mixture->conductivity > 0.0))
+    {
+      continue;
+    }
+    for (const std::string &physName : zone->physicalGroups)
+    {
+      for (int id : phys_ids(mesh, physName))
+      {
+        physConductivity[id] = mixture->conductivity;
+      }
+    }
+  }
+  if (physConductivity.empty())
+  {
+    throw HeatError("Nincs hővezetési tartomány: egyik zóna keverékéhez sincs megadva hővezetési tényező ($Thermal).");
+  }
+
+  // Helyi csomópont számozás a tartomány háromszögein
+  std::vector<int> globalToLocal(mesh.nodes.size(), -1);
+  std::vector<double> conductivity(mesh.tris.size(), 0.0);
+  m_local.assign(mesh.tris.size() * 3, -1);
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    std::map<int, double>::const_iterator it = physConductivity.find(t.phys);
+    if (it == physConductivity.end())
+    {
+      continue;
+    }
+    conductivity[e] = it->second;
+    const int nodes[3] = {t.a, t.b, t.c};
+    for (int i = 0; i < 3; ++i)
+    {
+      int &local = globalToLocal[static_cast<std::size_t>(nodes[i])];
+      if (local < 0)
+      {
+        local = m_nodeCount++;
+      }
+      m_local[e * 3 + static_cast<std::size_t>(i)] = local;
+    }
+    ++m_elementCount;
+  }
+
+  std::vector<std::vector<int>> rowColumns(static_cast<std::size_t>(m_nodeCount));
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    if (!contains(static_cast<int>(e)))
+    {
+      continue;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        rowColumns[static_cast<std::size_t>(m_local[e * 3 + static_cast<std::size_t>(i)])].push_back(m_local[e * 3 + static_cast<std::size_t>(j)]);
+      }
+    }
+  }
+  m_matrix.pattern = build_csr_pattern(rowColumns);
+  m_matrix.values.assign(m_matrix.pattern->nnz(), 0.0);
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    if (!contains(static_cast<int>(e)))
+    {
+      continue;
+    }
+    const ElementGeometry &geo = geometry[e];
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        const int pos = m_matrix.pattern->find(m_local[e * 3 + static_cast<std::size_t>(i)], m_local[e * 3 + static_cast<std::size_t>(j)]);
+        m_matrix.values[static_cast<std::size_t>(pos)] += conductivity[e] * geo.area * (geo.b[i] * geo.b[j] + geo.c[i] * geo.c[j]);
+      }
+    }
+  }
+
+  // Konvektív perem: h L / 6 [2 1; 1 2] a mátrixban, h T_hűtő L / 2 a jobb oldalon
+  const std::vector<int> boundaryIds = phys_ids(mesh, options.boundary);
+  if (boundaryIds.empty())
+  {
+    throw HeatError("A hálóban nincs " + options.boundary + " nevű fizikai csoport (heat_boundary).");
+  }
+  m_boundaryLoad.assign(static_cast<std::size_t>(m_nodeCount), 0.0);
+  for (const Mesh::Line &line : mesh.lines)
+  {
+    if (std::find(boundaryIds.begin(), boundaryIds.end(), line.phys) == boundaryIds.end())
+    {
+      continue;
+    }
+    const int nodes[2] = {globalToLocal[static_cast<std::size_t>(line.a)], globalToLocal[static_cast<std::size_t>(line.b)]};
+    if (nodes[0] < 0 || nodes[1] < 0)
+    {
+      continue;
+    }
+    const Mesh::Node &pa = mesh.nodes[static_cast<std::size_t>(line.a)];
+    const Mesh::Node &pb = mesh.nodes[static_cast<std::size_t>(line.b)];
+    const double length = options.lengthScale * std::sqrt((pb.x - pa.x) * (pb.x - pa.x) + (pb.y - pa.y) * (pb.y - pa.y));
+    for (int i = 0; i < 2; ++i)
+    {
+      for (int j = 0; j < 2; ++j)
+      {
+        const int pos = m_matrix.pattern->find(nodes[i], nodes[j]);
+        if (pos < 0)
+        {
+          throw HeatError("A(z) " + options.boundary + " peremél csomópontjai nem szomszédosak a hővezetési tartományban.");
+        }
+        m_matrix.values[static_cast<std::size_t>(pos)] += options.htc * length / 6.0 * (i == j ? 2.0 : 1.0);
+      }
+      m_boundaryLoad[static_cast<std::size_t>(nodes[i])] += options.htc * options.coolantTemperature * length / 2.0;
+    }
+    ++m_boundaryLines;
+    m_boundaryLength += length;
+  }
+  if (m_boundaryLines == 0)
+  {
+    throw HeatError("A(z) " + options.boundary + " peremnek nincs éle a hővezetési tartományon (konvektív perem nélkül a "
+                    "hőmérséklet nem határozott).");
+  }
+  m_preconditioner = make_preconditioner("ic0", m_matrix, 1.0);
+}
+
+HeatSolveStats HeatConduction::solve(const std::vector<double> &elementSource, std::vector<double> &temperature) const
+{
+  const std::size_t n = static_cast<std::size_t>(m_nodeCount);
+  if (temperature.size() != n)
+  {
+    temperature.assign(n, m_options.coolantTemperature);
+  }
+  std::vector<double> rhs = m_boundaryLoad;
+  for (std::size_t e = 0; e < m_mesh.tris.size(); ++e)
+  {
+    if (!contains(static_cast<int>(e)))
+    {
+      continue;
+    }
+    // A terület cm^2-ben (a merevségi tag k * A * grad grad mértékváltásra invariáns, nem kell skálázni)
+    const double load = elementSource[e] * m_geometry[e].area * m_options.lengthScale * m_options.lengthScale / 3.0;
+    for (int i = 0; i < 3; ++i)
+    {
+      rhs[static_cast<std::size_t>(m_local[e * 3 + static_cast<std::size_t>(i)])] += load;
+    }
+  }
+
+  // PCG a megadott kezdőértékből
+  HeatSolveStats stats;
+  const double rhsNorm = norm2(rhs);
+  std::vector<double> r(n), z(n), p(n), q(n);
+  m_matrix.multiply(temperature, r);
+  xpay(rhs, -1.0, r);
+  stats.residual = rhsNorm > 0.0 ? norm2(r) / rhsNorm : 0.0;
+  if (stats.residual <= m_options.tolerance)
+  {
+    stats.converged = true;
+    return stats;
+  }
+  m_preconditioner->apply(r, z);
+  p = z;
+  double rz = dot(r, z);
+  for (int it = 1; it <= m_options.maxIterations; ++it)
+  {
+    m_matrix.multiply(p, q);
+    const double alpha = rz / dot(p, q);
+    axpy(alpha, p, temperature);
+    axpy(-alpha, q, r);
+    stats.iterations = it;
+    stats.residual = norm2(r) / rhsNorm;
+    if (stats.residual <= m_options.tolerance)
+    {
+      stats.converged = true;
+      break;
+    }
+    m_preconditioner->apply(r, z);
+    const double rzNew = dot(r, z);
+    xpay(z, rzNew / rz, p);
+    rz = rzNew;
+  }
+  return stats;
+}
+
+std::vector<double> HeatConduction::element_temperature(const std::vector<double> &temperature) const
+{
+  std::vector<double> result(m_mesh.tris.size(), m_options.coolantTemperature);
+  for (std::size_t e = 0; e < m_mesh.tris.size(); ++e)
+  {
+    if (contains(static_cast<int>(e)))
+    {
+      result[e] = (temperature[static_cast<std::size_t>(m_local[e * 3])] + temperature[static_cast<std::size_t>(m_local[e * 3 + 1])] +
+                   temperature[static_cast<std::size_t>(m_local[e * 3 + 2])]) / 3.0;
+    }
+  }
+  return result;
+}
+
+void run_feedback(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const SolverConfig &config,
+                  const HeatOptions &heatOptions, const FeedbackOptions &feedbackOptions, FeedbackResult &result)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  if (library.feedback.empty())
+  {
+    throw HeatError("A keresztmetszet könyvtár nem tartalmaz $Feedback blokkot (hőmérséklet visszacsatolás).");
+  }
+  result = FeedbackResult();
+  const int G = library.energyGroupCount;
+  const std::vector<ElementGeometry> geometry = compute_element_geometry(mesh);
+  const HeatConduction heat(mesh, model, geometry, heatOptions);
+  const std::vector<int> baseMaterial = resolve_element_materials(mesh, library);
+  result.heatNodes = heat.node_count();
+  result.heatElements = heat.element_count();
+  result.boundaryLines = heat.boundary_line_count();
+
+  // A visszacsatolt elemek saját anyagot kapnak a könyvtár anyagai után
+  std::vector<int> feedbackElements;
+  std::vector<int> elementMaterial = baseMaterial;
+  int outside = 0;
+  double feedbackArea = 0.0;
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    if (library.find_feedback(library.materials[static_cast<std::size_t>(baseMaterial[e])].name) == nullptr)
+    {
+      continue;
+    }
+    if (!heat.contains(static_cast<int>(e)))
+    {
+      ++outside;
+      continue;
+    }
+    elementMaterial[e] = static_cast<int>(library.materials.size() + feedbackElements.size());
+    feedbackElements.push_back(static_cast<int>(e));
+    feedbackArea += geometry[e].area;
+  }
+  if (outside > 0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] " << outside << " visszacsatolt anyagú elem a hővezetési tartományon kívül esik, "
+              << "ezek a referencia hőmérsékleten maradnak.\n";
+  }
+  if (feedbackElements.empty())
+  {
+    throw HeatError("A $Feedback blokk egyik anyaga sincs a hővezetési tartományban.");
+  }
+  result.feedbackElements = static_cast<int>(feedbackElements.size());
+
+  // A hasadóanyagos elemeknek a hővezetési tartományban kell lenniük (ott keletkezik a hő)
+  double sourceArea = 0.0;
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    const XsMaterial &material = library.materials[static_cast<std::size_t>(baseMaterial[e])];
+    if (std::all_of(material.nu_sigma_f.begin(), material.nu_sigma_f.end(), [](double v) { return v == 0.0; }))
+    {
+      continue;
+    }
+    if (!heat.contains(static_cast<int>(e)))
+    {
+      throw HeatError("A(z) " + material.name + " hasadóanyagos elem nincs a hővezetési tartományban (hiányzó $Thermal adat).");
+    }
+    sourceArea += geometry[e].area;
+  }
+  if (!(sourceArea > 0.0))
+  {
+    throw HeatError("Nincs hasadóanyagos elem, a hőforrás nem számítható.");
+  }
+  result.setupMs = elapsed_ms(totalStart);
+
+  const EigenOptions eigenOptions = read_eigen_options(config);
+  EigenResult eigen;
+  std::vector<double> heatTemperature;   // a hővezetés warm start mezője
+
+  // A fixpont leképezés: T -> XS(T) -> k, phi -> q -> T'
+  auto evaluate = [&](const std::vector<double> &temperature, FeedbackIteration &iteration) {
+    std::chrono::steady_clock::time_point phase = std::chrono::steady_clock::now();
+    const std::vector<double> elementTemperature = heat.element_temperature(temperature);
+    XsLibrary changed = library;
+    changed.materials.reserve(library.materials.size() + feedbackElements.size());
+    for (int e : feedbackElements)
+    {
+      const XsMaterial &base = library.materials[static_cast<std::size_t>(baseMaterial[static_cast<std::size_t>(e)])];
+      XsMaterial material = base;
+      material.name = base.name + "#" + std::to_string(e);
+      apply_temperature(material, *library.find_feedback(base.name), elementTemperature[static_cast<std::size_t>(e)]);
+      changed.materials.push_back(material);
+    }
+    compile_xs(changed);
+    DiffusionSystem system;
+    assemble_diffusion(mesh, changed, elementMaterial, system);
+    result.xsMs += elapsed_ms(phase);
+
+    phase = std::chrono::steady_clock::now();
+    GroupSolver::UPtr solver = make_group_solver(system, config, nullptr);
+    solve_eigenvalue(system, *solver, eigenOptions, eigen);
+    if (!eigen.converged)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] A csatolási iteráció sajátérték számítása nem konvergált (k = " << eigen.keff << ").\n";
+    }
+    iteration.keff = eigen.keff;
+    iteration.outerIterations = eigen.outerIterations;
+    iteration.eigenMs = elapsed_ms(phase);
+    result.eigenMs += iteration.eigenMs;
+
+    // Hőforrás: nu sigma_f phi elemenként (a csomóponti fluxus elemátlagával), a heat_power átlagra normálva
+    phase = std::chrono::steady_clock::now();
+    std::vector<double> source(mesh.tris.size(), 0.0);
+    parallel_for(0, mesh.tris.size(), [&](std::size_t e) {
+      const Mesh::Tri &t = mesh.tris[e];
+      const XsMaterial &material = changed.materials[static_cast<std::size_t>(elementMaterial[e])];
+      for (int g = 0; g < G; ++g)
+      {
+        const std::vector<double> &phi = eigen.flux[static_cast<std::size_t>(g)];
+        source[e] += material.nu_sigma_f[static_cast<std::size_t>(g)] *
+                     (phi[static_cast<std::size_t>(t.a - 1)] + phi[static_cast<std::size_t>(t.b - 1)] + phi[static_cast<std::size_t>(t.c - 1)]) / 3.0;
+      }
+    }, 256);
+    double total = 0.0;
+    for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+    {
+      total += source[e] * geometry[e].area;
+    }
+    if (!(total > 0.0))
+    {
+      throw HeatError("A fluxusból számolt hőforrás nem pozitív.");
+    }
+    scale(heatOptions.power * sourceArea / total, source);
+
+    const HeatSolveStats stats = heat.solve(source, heatTemperature);
+    if (!stats.converged)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] A hővezetés PCG nem konvergált (reziduum " << stats.residual << ").\n";
+    }
+    iteration.heatIterations = stats.iterations;
+    iteration.heatMs = elapsed_ms(phase);
+    result.heatMs += iteration.heatMs;
+    return heatTemperature;
+  };
+
+  // Fixpont iteráció a csomóponti hőmérsékleten; Anderson: a legutóbbi depth lépés különbségeiből
+  // min |f - dF gamma| (regularizált normálegyenlettel), x = x + beta f - (dX + beta dF) gamma
+  const std::size_t n = static_cast<std::size_t>(heat.node_count());
+  const double beta = feedbackOptions.relax;
+  std::vector<double> x(n, heatOptions.coolantTemperature);
+  std::deque<std::vector<double>> historyX, historyF;
+  for (int it = 0; it < feedbackOptions.maxIterations; ++it)
+  {
+    FeedbackIteration iteration;
+    const std::vector<double> g = evaluate(x, iteration);
+    std::vector<double> f = g;
+    axpy(-1.0, x, f);
+    for (double v : f)
+    {
+      iteration.change = std::max(iteration.change, std::fabs(v));
+    }
+    const std::vector<double> elementTemperature = heat.element_temperature(g);
+    for (int e : feedbackElements)
+    {
+      const double t = elementTemperature[static_cast<std::size_t>(e)];
+      iteration.fuelAverage += geometry[static_cast<std::size_t>(e)].area * t / feedbackArea;
+      iteration.fuelMax = std::max(iteration.fuelMax, t);
+      // A $Feedback illesztésen kívüli hőmérséklet visszacsatolása extrapolált (és jellemzően egység- vagy
+      // teljesítményhiba jele), ezért leállunk
+      const std::string &name = library.materials[static_cast<std::size_t>(baseMaterial[static_cast<std::size_t>(e)])].name;
+      const XsFeedback &feedback = *library.find_feedback(name);
+      if (t < feedback.minTemperature || t > feedback.maxTemperature)
+      {
+        std::ostringstream oss;
+        oss << "A(z) " << name << " hőmérséklete (" << std::fixed << std::setprecision(0) << t
+            << " K) kívül esik a $Feedback érvényességi tartományán (" << feedback.minTemperature << " - "
+            << feedback.maxTemperature << " K, t_range). Ellenőrizd a heat_mesh_unit, heat_power és heat_htc "
+            << "értékét.";
+        throw HeatError(oss.str());
+      }
+    }
+    result.history.push_back(iteration);
+    if (it == 0)
+    {
+      result.keffInitial = iteration.keff;
+    }
+    result.keff = iteration.keff;
+    result.temperature = g;
+    if (iteration.change <= feedbackOptions.tolerance)
+    {
+      result.converged = true;
+      break;
+    }
+
+    std::vector<double> next = x;
+    axpy(beta, f, next);
+    if (feedbackOptions.coupling == "anderson")
+    {
+      historyX.push_back(x);
+      historyF.push_back(f);
+      if (historyX.size() > static_cast<std::size_t>(feedbackOptions.depth) + 1)
+      {
+        historyX.pop_front();
+        historyF.pop_front();
+      }
+      const std::size_t m = historyX.size() - 1;
+      if (m > 0)
+      {
+        std::vector<std::vector<double>> dX(m), dF(m);
+        for (std::size_t j = 0; j < m; ++j)
+        {
+          dX[j] = historyX[j + 1];
+          axpy(-1.0, historyX[j], dX[j]);
+          dF[j] = historyF[j + 1];
+          axpy(-1.0, historyF[j], dF[j]);
+        }
+        std::vector<double> normal(m * m), rhs(m);
+        double trace = 0.0;
+        for (std::size_t a = 0; a < m; ++a)
+        {
+          for (std::size_t b = 0; b < m; ++b)
+          {
+            normal[a * m + b] = dot(dF[a], dF[b]);
+          }
+          rhs[a] = dot(dF[a], f);
+          trace += normal[a * m + a];
+        }
+        for (std::size_t a = 0; a < m; ++a)
+        {
+          normal[a * m + a] += 1e-10 * trace;
+        }
+        const std::vector<double> gamma = solve_dense(normal, rhs);
+        for (std::size_t j = 0; j < m; ++j)
+        {
+          axpy(-gamma[j], dX[j], next);
+          axpy(-beta * gamma[j], dF[j], next);
+        }
+      }
+    }
+    x = next;
+  }
+  if (!result.converged)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A csatolt számítás " << feedbackOptions.maxIterations << " iteráció alatt nem konvergált.\n";
+  }
+  result.flux = eigen.flux;
+
+  // Fizikai csoportonkénti hőmérséklet statisztika (elemátlagok)
+  const std::vector<double> elementTemperature = heat.element_temperature(result.temperature);
+  std::map<int, std::size_t> regionIndex;
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    if (!heat.contains(static_cast<int>(e)))
+    {
+      continue;
+    }
+    const int phys = mesh.tris[e].phys;
+    std::map<int, std::size_t>::const_iterator it = regionIndex.find(phys);
+    if (it == regionIndex.end())
+    {
+      it = regionIndex.insert(std::make_pair(phys, result.regions.size())).first;
+      FeedbackRegion region;
+      std::map<int, std::string>::const_iterator name = mesh.physNames.find(phys);
+      region.name = name == mesh.physNames.end() ? std::to_string(phys) : name->second;
+      region.minimum = elementTemperature[e];
+      region.maximum = elementTemperature[e];
+      result.regions.push_back(region);
+    }
+    FeedbackRegion &region = result.regions[it->second];
+    region.area += geometry[e].area;
+    region.average += geometry[e].area * elementTemperature[e];
+    region.minimum = std::min(region.minimum, elementTemperature[e]);
+    region.maximum = std::max(region.maximum, elementTemperature[e]);
+  }
+  for (FeedbackRegion &region : result.regions)
+  {
+    region.average /= region.area;
+  }
+  result.totalMs = elapsed_ms(totalStart);
+}
@@ -0,0 +1,151 @@
+#ifndef HEAT_HPP
+#define HEAT_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "precond.hpp"
+#include "xs.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Hővezetés a fűtőelem pálcában és hőmérséklet visszacsatolás a keresztmetszetekre.
+//
+// Hővezetés: -div(k grad T) = q a model fájl azon zónáinak háromszögein, amelyek keverékéhez a $Thermal blokk
+// hővezetési tényezőt ad (pl. Fuel, Cladding). Ugyanaz a P1 végeselem, mint a diffúziónál (az elemgeometria
+// közös); a heat_boundary nevű peremvonalakon (alapból Clad-Moderator) konvektív (Robin) perem:
+//   -k dT/dn = h (T - T_hűtő).
+// A háló koordinátái a heat_mesh_unit egységben értendők (a pálca geometria mm-ben készül), a hőforrás és a
+// hőátadási tényező cm-es egységben; a 2D merevségi mátrix mértékváltásra invariáns, a térfogati forrás a terület,
+// a perem tag az élhossz szerint skálázódik. A tartomány többi külső éle szimmetria (zérus fluxus); a rés hőellenállását elhanyagoljuk (a burkolat és a
+// fűtőanyag közös csomópontokon csatlakozik). A rendszer szimmetrikus pozitív definit: IC(0) PCG, mindig az
+// előző hőmérséklet mezőből indítva.
+//
+// Visszacsatolás: a hőmérséklet a $Feedback blokk anyagainál elemenként saját XS anyagot ad (a könyvtár
+// anyagának hőmérsékletre korrigált másolata), ebből assembly és k-sajátérték (az előző fluxusból indítva),
+// a fluxusból a hőforrás (nu sigma_f phi, a heat_power átlagra normálva), abból új hőmérséklet. A csatolás
+// fixpont iteráció a csomóponti hőmérsékleten: Picard (relaxációval) vagy Anderson gyorsítás.
+
+class HeatError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct HeatOptions
+{
+  double power = 300.0;                      // átlagos hőforrás sűrűség a hasadóanyagos elemekben [W / cm^3]
+  std::string boundary = "Clad-Moderator";   // a konvektív perem fizikai csoportja
+  double htc = 3.0;                          // hőátadási tényező [W / (cm^2 K)]
+  double coolantTemperature = 560.0;         // hűtőközeg hőmérséklete [K]
+  std::string meshUnit = "cm";               // a háló koordinátáinak egysége: cm | mm
+  double lengthScale = 1.0;                  // cm / hálóegység (meshUnit-ból)
+  double tolerance = 1e-10;                  // PCG relatív reziduum
+  int maxIterations = 2000;
+};
+
+HeatOptions read_heat_options(const SolverConfig &config);
+
+struct HeatSolveStats
+{
+  int iterations = 0;
+  double residual = 0.0;
+  bool converged = false;
+};
+
+class HeatConduction
+{
+public:
+  // A tartomány, a merevségi mátrix (a Robin peremmel együtt) és az IC(0) prekondicionáló itt készül el
+  HeatConduction(const Mesh &mesh, const ModelLibrary &model, const std::vector<ElementGeometry> &geometry,
+                 const HeatOptions &options);
+
+  // elementSource: háromszögenként a hőforrás sűrűség [W / cm^3] (a tartományon kívüli elemeké nem számít);
+  // temperature: a tartomány csomópontjain (node_count() hosszú), bemenetként a kezdőérték
+  HeatSolveStats solve(const std::vector<double> &elementSource, std::vector<double> &temperature) const;
+
+  // Háromszögenként az átlagos hőmérséklet (a tartományon kívül a hűtőközeg hőmérséklete)
+  std::vector<double> element_temperature(const std::vector<double> &temperature) const;
+
+  bool contains(int element) const { return m_local[static_cast<std::size_t>(element) * 3] >= 0; }
+  int node_count() const { return m_nodeCount; }
+  int element_count() const { return m_elementCount; }
+  int boundary_line_count() const { return m_boundaryLines; }
+  double boundary_length() const { return m_boundaryLength; } // [cm]
+  double coolant_temperature() const { return m_options.coolantTemperature; }
+
+private:
+  const Mesh &m_mesh;
+  const std::vector<ElementGeometry> &m_geometry;
+  HeatOptions m_options;
+  int m_nodeCount = 0;
+  int m_elementCount = 0;
+  int m_boundaryLines = 0;
+  double m_boundaryLength = 0.0;
+  std::vector<int> m_local;                  // háromszögenként 3 helyi csomópont index (-1: nincs a tartományban)
+  CsrMatrix m_matrix;
+  std::vector<double> m_boundaryLoad;        // h T_hűtő L / 2 a peremcsomópontokon
+  Preconditioner::UPtr m_preconditioner;
+};
+
+struct FeedbackOptions
+{
+  std::string coupling = "anderson";         // picard | anderson
+  double relax = 1.0;                        // relaxáció (Picard: T = T + relax (G(T) - T); Andersonnál keverés)
+  int depth = 3;                             // Anderson: a felhasznált korábbi iterációk száma
+  double tolerance = 0.1;                    // a csomóponti hőmérséklet változásának maximuma [K]
+  int maxIterations = 30;
+};
+
+FeedbackOptions read_feedback_options(const SolverConfig &config);
+
+// Egy csatolási iteráció
+struct FeedbackIteration
+{
+  double keff = 0.0;
+  double change = 0.0;                       // max |G(T) - T| [K]
+  double fuelAverage = 0.0;                  // a visszacsatolt elemek területtel súlyozott átlaghőmérséklete
+  double fuelMax = 0.0;
+  int outerIterations = 0;
+  int heatIterations = 0;
+  double eigenMs = 0.0;
+  double heatMs = 0.0;
+};
+
+// Fizikai csoportonkénti hőmérséklet statisztika a hővezetési tartományban
+struct FeedbackRegion
+{
+  std::string name;
+  double area = 0.0;
+  double average = 0.0;
+  double minimum = 0.0;
+  double maximum = 0.0;
+};
+
+struct FeedbackResult
+{
+  bool converged = false;
+  double keff = 0.0;                         // a végső hőmérséklet mezővel
+  double keffInitial = 0.0;                  // a kezdő (egyenletes, hűtőközeg) hőmérséklettel
+  int heatNodes = 0;
+  int heatElements = 0;
+  int boundaryLines = 0;
+  int feedbackElements = 0;
+  std::vector<FeedbackIteration> history;
+  std::vector<FeedbackRegion> regions;
+  std::vector<double> temperature;           // a hővezetési tartomány csomópontjain
+  std::vector<std::vector<double>> flux;     // a végső (normált) fluxus
+  double totalMs = 0.0;
+  double setupMs = 0.0;
+  double xsMs = 0.0;
+  double eigenMs = 0.0;
+  double heatMs = 0.0;
+};
+
+// Csatolt neutronika–hővezetés számítás (a belső megoldó és a sajátérték beállításai a $Solver szekcióból)
+void run_feedback(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const SolverConfig &config,
+                  const HeatOptions &heatOptions, const FeedbackOptions &feedbackOptions, FeedbackResult &result);
+
+#endif // HEAT_HPP
@@ -0,0 +1,401 @@
+#include "homogenization.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  const double kPi = 3.14159265358979323846;
+
+  std::uint64_t edge_key(int a, int b)
+  {
+    return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | static_cast<std::uint64_t>(std::max(a, b));
+  }
+
+  // Végtelen közeg: (Sigma_t - S^T) phi = chi, k_inf = nu_sigma_f . phi (a hasadási operátor egyrangú)
+  double infinite_multiplication(const XsMaterial &material)
+  {
+    const std::size_t G = material.sigma_t.size();
+    std::vector<double> A(G * G, 0.0), x(material.chi);
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      A[g * G + g] += material.sigma_t[g];
+      for (std::size_t from = 0; from < G; ++from)
+      {
+        A[g * G + from] -= material.scatter[from][g];
+      }
+    }
+    for (std::size_t k = 0; k < G; ++k)
+    {
+      std::size_t pivot = k;
+      for (std::size_t i = k + 1; i < G; ++i)
+      {
+        if (std::fabs(A[i * G + k]) > std::fabs(A[pivot * G + k]))
+        {
+          pivot = i;
+        }
+      }
+      if (A[pivot * G + k] == 0.0)
+      {
+        return 0.0;
+      }
+      for (std::size_t j = 0; j < G; ++j)
+      {
+        std::swap(A[k * G + j], A[pivot * G + j]);
+      }
+      std::swap(x[k], x[pivot]);
+      for (std::size_t i = k + 1; i < G; ++i)
+      {
+        const double factor = A[i * G + k] / A[k * G + k];
+        for (std::size_t j = k; j < G; ++j)
+        {
+          A[i * G + j] -= factor * A[k * G + j];
+        }
+        x[i] -= factor * x[k];
+      }
+    }
+    double k = 0.0;
+    for (std::size_t i = G; i-- > 0;)
+    {
+      for (std::size_t j = i + 1; j < G; ++j)
+      {
+        x[i] -= A[i * G + j] * x[j];
+      }
+      x[i] /= A[i * G + i];
+      k += material.nu_sigma_f[i] * x[i];
+    }
+    return k;
+  }
+}
+
+HomogenizationOptions read_homogenization_options(const SolverConfig &config)
+{
+  HomogenizationOptions options;
+  options.enabled = config.getBool("homogenize", options.enabled);
+  options.regions = config.getString("homogenize_regions", options.regions);
+  options.boundary = config.getString("homogenize_boundary", options.boundary);
+  options.file = config.getString("homogenize_file", options.file);
+  if (options.regions != "assembly" && options.regions != "zone")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen homogenize_regions: \"" << options.regions << "\", assembly használata.\n";
+    options.regions = "assembly";
+  }
+  return options;
+}
+
+void homogenize(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &system,
+                const std::vector<std::vector<double>> &flux, const HomogenizationOptions &options,
+                HomogenizationResult &result)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const XsCompiled &xs = library.compiled;
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t T = mesh.tris.size();
+  result = HomogenizationResult();
+
+  // 1) Régiók: a teljes háló, vagy zónánként a fizikai csoportjaik háromszögei
+  std::vector<std::string> names;
+  std::vector<std::vector<int>> regionElements;
+  if (options.regions == "assembly")
+  {
+    names.push_back("Assembly");
+    regionElements.push_back(std::vector<int>(T));
+    for (std::size_t e = 0; e < T; ++e)
+    {
+      regionElements[0][e] = static_cast<int>(e);
+    }
+  }
+  else
+  {
+    for (const Zone &zone : model.zones)
+    {
+      std::vector<int> elements;
+      for (std::size_t e = 0; e < T; ++e)
+      {
+        const std::map<int, std::string>::const_iterator name = mesh.physNames.find(mesh.tris[e].phys);
+        if (name != mesh.physNames.end() &&
+            std::find(zone.physicalGroups.begin(), zone.physicalGroups.end(), name->second) != zone.physicalGroups.end())
+        {
+          elements.push_back(static_cast<int>(e));
+        }
+      }
+      if (elements.empty())
+      {
+        std::cerr << "[FIGYELMEZTETÉS] A(z) " << zone.name << " zónának nincs háromszöge, kimarad a homogenizálásból.\n";
+        continue;
+      }
+      names.push_back(zone.name);
+      regionElements.push_back(elements);
+    }
+    if (names.empty())
+    {
+      throw HomogenizationError("A model fájl egyik zónájának sincs háromszöge a hálóban.");
+    }
+  }
+
+  // 2) Elemenkénti integrálok: [fluxus G | sigma_t phi G | sigma_a phi G | nu_sigma_f phi G | chi P G | szórás G*G]
+  const std::size_t K = 5 * G + G * G;
+  std::vector<double> integrals(T * K, 0.0);
+  parallel_for(0, T, [&](std::size_t e) {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int m = system.elementMaterial[e];
+    double *row = &integrals[e * K];
+    double production = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      const std::vector<double> &phi = flux[g];
+      const double value = system.geometry[e].area *
+                           (phi[static_cast<std::size_t>(t.a - 1)] + phi[static_cast<std::size_t>(t.b - 1)] + phi[static_cast<std::size_t>(t.c - 1)]) / 3.0;
+      const std::size_t k = xs.index(m, static_cast<int>(g));
+      row[g] = value;
+      row[G + g] = xs.sigma_t[k] * value;
+      row[2 * G + g] = xs.sigma_a[k] * value;
+      row[3 * G + g] = xs.nu_sigma_f[k] * value;
+      production += xs.nu_sigma_f[k] * value;
+      const double *scatter = xs.scatter_of(m);
+      for (std::size_t to = 0; to < G; ++to)
+      {
+        row[5 * G + g * G + to] = scatter[g * G + to] * value;
+      }
+    }
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      row[4 * G + g] = xs.chi[xs.index(m, static_cast<int>(g))] * production;
+    }
+  }, 1024);
+
+  // Peremvonalak: a hozzájuk tartozó háromszög (a kifelé mutató normálishoz)
+  std::vector<int> boundaryIds;
+  for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+  {
+    if (it->second == options.boundary)
+    {
+      boundaryIds.push_back(it->first);
+    }
+  }
+  if (boundaryIds.empty())
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A hálóban nincs " << options.boundary << " nevű fizikai csoport, ADF nem számolható.\n";
+  }
+  std::unordered_map<std::uint64_t, std::vector<int>> edgeElements;
+  std::vector<int> boundaryLines;
+  for (std::size_t l = 0; l < mesh.lines.size(); ++l)
+  {
+    if (std::find(boundaryIds.begin(), boundaryIds.end(), mesh.lines[l].phys) != boundaryIds.end())
+    {
+      boundaryLines.push_back(static_cast<int>(l));
+      edgeElements[edge_key(mesh.lines[l].a, mesh.lines[l].b)];
+    }
+  }
+  if (!boundaryLines.empty())
+  {
+    for (std::size_t e = 0; e < T; ++e)
+    {
+      const Mesh::Tri &t = mesh.tris[e];
+      const int nodes[3] = {t.a, t.b, t.c};
+      for (int k = 0; k < 3; ++k)
+      {
+        const std::unordered_map<std::uint64_t, std::vector<int>>::iterator it = edgeElements.find(edge_key(nodes[k], nodes[(k + 1) % 3]));
+        if (it != edgeElements.end())
+        {
+          it->second.push_back(static_cast<int>(e));
+        }
+      }
+    }
+  }
+
+  // 3) Régiónként: összegzés rögzített sorrendben, homogenizált anyag, k_inf és ADF
+  result.regions.resize(names.size());
+  parallel_for(0, names.size(), [&](std::size_t r) {
+    HomogenizedRegion &region = result.regions[r];
+    std::vector<double> sum(K, 0.0);
+    std::vector<char> member(T, 0);
+    for (int e : regionElements[r])
+    {
+      const double *row = &integrals[static_cast<std::size_t>(e) * K];
+      for (std::size_t k = 0; k < K; ++k)
+      {
+        sum[k] += row[k];
+      }
+      region.area += system.geometry[static_cast<std::size_t>(e)].area;
+      member[static_cast<std::size_t>(e)] = 1;
+    }
+    region.elements = static_cast<int>(regionElements[r].size());
+
+    XsMaterial &material = region.material;
+    material.name = names[r];
+    material.sigma_t.assign(G, 0.0);
+    material.sigma_a.assign(G, 0.0);
+    material.nu_sigma_f.assign(G, 0.0);
+    material.chi.assign(G, 0.0);
+    material.scatter.assign(G, std::vector<double>(G, 0.0));
+    region.flux.assign(G, 0.0);
+    double production = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      production += sum[4 * G + g];
+    }
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      const double phi = sum[g];
+      region.flux[g] = phi / region.area;
+      if (phi > 0.0)
+      {
+        material.sigma_t[g] = sum[G + g] / phi;
+        material.sigma_a[g] = sum[2 * G + g] / phi;
+        material.nu_sigma_f[g] = sum[3 * G + g] / phi;
+        for (std::size_t to = 0; to < G; ++to)
+        {
+          material.scatter[g][to] = sum[5 * G + g * G + to] / phi;
+        }
+      }
+      material.chi[g] = production > 0.0 ? sum[4 * G + g] / production : 0.0;
+    }
+    region.kInfinity = production > 0.0 ? infinite_multiplication(material) : 0.0;
+
+    // ADF: a régió háromszögeihez tartozó peremvonalak, oldalanként a normális iránya szerint (1 fokra kerekítve)
+    std::map<int, DiscontinuityFactors> sides;
+    region.total.angle = -1.0;
+    region.total.adf.assign(G, 0.0);
+    for (int l : boundaryLines)
+    {
+      const Mesh::Line &line = mesh.lines[static_cast<std::size_t>(l)];
+      int owner = -1;
+      for (int e : edgeElements.at(edge_key(line.a, line.b)))
+      {
+        owner = member[static_cast<std::size_t>(e)] ? e : owner;
+      }
+      if (owner < 0)
+      {
+        continue;
+      }
+      const Mesh::Node &pa = mesh.nodes[static_cast<std::size_t>(line.a)];
+      const Mesh::Node &pb = mesh.nodes[static_cast<std::size_t>(line.b)];
+      const Mesh::Tri &t = mesh.tris[static_cast<std::size_t>(owner)];
+      const int third = t.a != line.a && t.a != line.b ? t.a : (t.b != line.a && t.b != line.b ? t.b : t.c);
+      const Mesh::Node &pc = mesh.nodes[static_cast<std::size_t>(third)];
+      double nx = pb.y - pa.y, ny = pa.x - pb.x;
+      if (nx * (pa.x - pc.x) + ny * (pa.y - pc.y) < 0.0)
+      {
+        nx = -nx;
+        ny = -ny;
+      }
+      int angle = static_cast<int>(std::lround(std::atan2(ny, nx) * 180.0 / kPi));
+      angle = (angle % 360 + 360) % 360;
+      const double length = std::hypot(pb.x - pa.x, pb.y - pa.y);
+      DiscontinuityFactors &side = sides[angle];
+      side.angle = angle;
+      side.adf.resize(G, 0.0);
+      side.length += length;
+      region.total.length += length;
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        const double surface = 0.5 * length * (flux[g][static_cast<std::size_t>(line.a - 1)] + flux[g][static_cast<std::size_t>(line.b - 1)]);
+        side.adf[g] += surface;
+        region.total.adf[g] += surface;
+      }
+    }
+    auto normalize = [&](DiscontinuityFactors &factors) {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        factors.adf[g] = region.flux[g] > 0.0 ? factors.adf[g] / (factors.length * region.flux[g]) : 0.0;
+      }
+    };
+    if (region.total.length > 0.0)
+    {
+      normalize(region.total);
+      // Íves peremnél (sok különböző normális) csak a teljes peremre adunk tényezőt
+      if (sides.size() <= 12)
+      {
+        for (std::map<int, DiscontinuityFactors>::iterator it = sides.begin(); it != sides.end(); ++it)
+        {
+          normalize(it->second);
+          region.sides.push_back(it->second);
+        }
+      }
+    }
+  }, 1);
+  result.ms = elapsed_ms(start);
+}
+
+void write_homogenized_library(const std::string &path, const XsLibrary &library, const HomogenizationResult &result)
+{
+  std::ofstream out(path);
+  if (!out)
+  {
+    throw HomogenizationError("Nem sikerült megnyitni a homogenizált könyvtár fájlt: " + path);
+  }
+  const std::size_t G = static_cast<std::size_t>(library.energyGroupCount);
+  out << "# Homogenizált keresztmetszetek (fluxus-térfogat súlyozás a finom hálós megoldásból)\n";
+  out << "# Forrás könyvtár: " << library.title << "\n\n";
+  out << "$XsInfo\nHomogenized " << library.title << "\n$EndXsInfo\n\n";
+  out << "$EnergyGroups\n" << G << "\n";
+  for (std::size_t g = 0; g < G; ++g)
+  {
+    out << (g < library.energyGroupNames.size() ? library.energyGroupNames[g] : "G" + std::to_string(g + 1)) << "\n";
+  }
+  out << "$EndEnergyGroups\n\n";
+  out << std::scientific << std::setprecision(8);
+  out << "$Materials\n" << result.regions.size() << "\n";
+  auto write_row = [&](const std::string &key, const std::vector<double> &values) {
+    out << key;
+    for (double v : values)
+    {
+      out << " " << v;
+    }
+    out << "\n";
+  };
+  for (const HomogenizedRegion &region : result.regions)
+  {
+    out << "\n# " << region.material.name << ": terület " << region.area << " cm^2, k_inf " << region.kInfinity << "\n";
+    if (region.total.length > 0.0)
+    {
+      out << "# ADF (teljes perem)";
+      for (double v : region.total.adf)
+      {
+        out << " " << v;
+      }
+      out << "\n";
+      for (const DiscontinuityFactors &side : region.sides)
+      {
+        out << "# ADF (normális " << std::fixed << std::setprecision(0) << side.angle << " fok)" << std::scientific
+            << std::setprecision(8);
+        for (double v : side.adf)
+        {
+          out << " " << v;
+        }
+        out << "\n";
+      }
+    }
+    const XsMaterial &material = region.material;
+    out << material.name << "\n";
+    write_row("sigma_t", material.sigma_t);
+    write_row("sigma_a", material.sigma_a);
+    write_row("nu_sigma_f", material.nu_sigma_f);
+    write_row("chi", material.chi);
+    out << "$Scatter\n";
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      for (std::size_t to = 0; to < G; ++to)
+      {
+        out << (to > 0 ? " " : "") << material.scatter[g][to];
+      }
+      out << "\n";
+    }
+    out << "$EndScatter\n";
+  }
+  out << "\n$EndMaterials\n";
+}
@@ -0,0 +1,73 @@
+#ifndef HOMOGENIZATION_HPP
+#define HOMOGENIZATION_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "xs.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Térbeli homogenizálás a finom hálós sajátérték megoldásból (a teljes kazetta vagy a model fájl zónái szerint),
+// a durva (teljes zónás) kódok bemenetéhez.
+//
+// Fluxus-térfogat súlyozás: Sigma_x,g = int Sigma_x phi_g / int phi_g (sigma_t, sigma_a, nu_sigma_f, szórás
+// g -> g'), a chi a hasadási produkcióval súlyozott. Az elemintegrálok párhuzamosan, elemenként készülnek; a
+// régiónkénti összegek rögzített elemsorrendben, régiónként egy szálon, így az eredmény a szálszámtól független.
+//
+// Diszkontinuitási tényezők (ADF): a homogenize_boundary vonalain (alapból Outer-Boundary) a felületi átlagfluxus
+// és a régió átlagfluxusának hányadosa, oldalanként (a vonalak kifelé mutató normálisa szerint csoportosítva) és
+// a teljes peremre. A homogén megoldást laposnak vesszük (végtelen rács / tükrös perem közelítés).
+
+class HomogenizationError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct HomogenizationOptions
+{
+  bool enabled = false;
+  std::string regions = "assembly";        // assembly (a teljes háló egy anyag) | zone (a model fájl zónái)
+  std::string boundary = "Outer-Boundary"; // az ADF-ek peremvonalai
+  std::string file;                        // XS könyvtár formátumú kimenet (üres = nincs)
+};
+
+HomogenizationOptions read_homogenization_options(const SolverConfig &config);
+
+// Egy oldal (azonos normálisú peremvonalak) diszkontinuitási tényezői
+struct DiscontinuityFactors
+{
+  double angle = 0.0;             // a kifelé mutató normális iránya [fok] (a teljes peremnél -1)
+  double length = 0.0;
+  std::vector<double> adf;        // csoportonként
+};
+
+struct HomogenizedRegion
+{
+  XsMaterial material;            // a homogenizált anyag (a régió nevével)
+  double area = 0.0;
+  int elements = 0;
+  std::vector<double> flux;       // csoportonként az átlagfluxus
+  double kInfinity = 0.0;         // a homogén anyag végtelen közeg sokszorozási tényezője
+  std::vector<DiscontinuityFactors> sides;
+  DiscontinuityFactors total;     // a régió teljes peremén (length = 0, ha nincs perem)
+};
+
+struct HomogenizationResult
+{
+  std::vector<HomogenizedRegion> regions;
+  double ms = 0.0;
+};
+
+void homogenize(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &system,
+                const std::vector<std::vector<double>> &flux, const HomogenizationOptions &options,
+                HomogenizationResult &result);
+
+// A homogenizált anyagok kiírása load_xs által olvasható formátumban ($XsInfo, $EnergyGroups, $Materials);
+// a diszkontinuitási tényezők megjegyzés sorokban kerülnek az anyagok elé
+void write_homogenized_library(const std::string &path, const XsLibrary &library, const HomogenizationResult &result);
+
+#endif // HOMOGENIZATION_HPP
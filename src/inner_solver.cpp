@@ -0,0 +1,584 @@
+#include "inner_solver.hpp"
+#include "matrix_free.hpp"
+#include "vector_ops.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+InnerOptions read_inner_options(const SolverConfig &config)
+{
+  InnerOptions options;
+  options.tolerance = config.getDouble("inner_tol", options.tolerance);
+  options.maxIterations = config.getInt("inner_max_iter", options.maxIterations);
+  options.preconditioner = config.getString("preconditioner", options.preconditioner);
+  options.ssorOmega = config.getDouble("ssor_omega", options.ssorOmega);
+  options.spmv = config.getString("spmv", options.spmv);
+  options.precision = config.getString("precision", options.precision);
+  options.refinement = config.getBool("refinement", options.refinement);
+  options.refinementTol = config.getDouble("refinement_tol", options.refinementTol);
+  options.refinementMax = config.getInt("refinement_max", options.refinementMax);
+  if (options.precision != "double" && options.precision != "single")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen pontosság: \"" << options.precision << "\", double-t használok.\n";
+    options.precision = "double";
+  }
+  if (options.refinementTol <= 0.0 || options.refinementTol >= 1.0 || options.refinementMax < 1)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Hibás iteratív finomítás beállítás, az alapértékeket használom.\n";
+    options.refinementTol = InnerOptions().refinementTol;
+    options.refinementMax = InnerOptions().refinementMax;
+  }
+  options.amg.strength = config.getDouble("amg_strength", options.amg.strength);
+  options.amg.sweeps = config.getInt("amg_sweeps", options.amg.sweeps);
+  options.amg.coarseSize = config.getInt("amg_coarse_size", options.amg.coarseSize);
+  options.amg.maxLevels = config.getInt("amg_max_levels", options.amg.maxLevels);
+  if (options.spmv != "sell" && options.spmv != "csr" && options.spmv != "matrix_free")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen spmv formátum: \"" << options.spmv << "\", sell-t használok.\n";
+    options.spmv = "sell";
+  }
+  if (options.ssorOmega <= 0.0 || options.ssorOmega >= 2.0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Az ssor_omega a (0, 2) intervallumban kell legyen, 1.0-t használok.\n";
+    options.ssorOmega = 1.0;
+  }
+  options.blockPreconditioner = config.getString("block_preconditioner", options.blockPreconditioner);
+  options.cholesky.ordering = config.getString("direct_ordering", options.cholesky.ordering);
+  options.cholesky.leafSize = config.getInt("nd_leaf_size", options.cholesky.leafSize);
+  options.cholesky.relax = config.getInt("supernode_relax", options.cholesky.relax);
+  if (options.cholesky.ordering != "nd" && options.cholesky.ordering != "natural")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen rendezés: \"" << options.cholesky.ordering << "\", nd-t használok.\n";
+    options.cholesky.ordering = "nd";
+  }
+  if (options.amg.sweeps < 1 || options.amg.maxLevels < 1 || options.amg.strength < 0.0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Hibás AMG beállítás, az alapértékeket használom.\n";
+    options.amg = AmgOptions();
+  }
+  return options;
+}
+
+PcgSolver::PcgSolver(const DiffusionSystem &system, const InnerOptions &options, const MatrixFreeOperator *matrixFree)
+    : m_system(system), m_options(options), m_matrixFree(matrixFree)
+{
+  if (m_options.spmv == "matrix_free" && m_matrixFree == nullptr)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Nincs mátrixmentes operátor, sell-t használok.\n";
+    m_options.spmv = "sell";
+  }
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (const CsrMatrix &A : system.groupMatrix)
+  {
+    m_precond.push_back(make_preconditioner(options.preconditioner, A, options.ssorOmega, options.amg));
+    if (m_options.precision == "single")
+    {
+      // A double reziduumhoz az assembly CSR mátrixa elég, double SELL másolat nem kell
+      m_sellFloat.push_back(build_sell<float>(A));
+    }
+    else if (m_options.spmv == "sell")
+    {
+      m_sell.push_back(build_sell<double>(A));
+    }
+  }
+  const std::size_t n = static_cast<std::size_t>(system.nodeCount);
+  m_r.resize(n);
+  m_z.resize(n);
+  m_p.resize(n);
+  m_q.resize(n);
+  if (!m_sellFloat.empty())
+  {
+    m_residual.resize(n);
+    m_correction.resize(n);
+  }
+  const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+  m_setupMs = d.count();
+}
+
+void PcgSolver::multiply(int group, const std::vector<double> &x, std::vector<double> &y) const
+{
+  if (m_options.spmv == "matrix_free")
+  {
+    m_matrixFree->multiply(group, x, y);
+  }
+  else if (!m_sell.empty())
+  {
+    sell_multiply(m_sell[static_cast<std::size_t>(group)], x, y);
+  }
+  else
+  {
+    m_system.groupMatrix[static_cast<std::size_t>(group)].multiply(x, y);
+  }
+}
+
+std::size_t PcgSolver::setup_memory_bytes() const
+{
+  std::size_t bytes = 0;
+  for (const Preconditioner::UPtr &p : m_precond)
+  {
+    bytes += p->memory_bytes();
+  }
+  for (const SellMatrix<double> &s : m_sell)
+  {
+    bytes += s.memory_bytes();
+  }
+  for (const SellMatrix<float> &s : m_sellFloat)
+  {
+    bytes += s.memory_bytes();
+  }
+  if (m_options.spmv == "matrix_free")
+  {
+    bytes += m_matrixFree->memory_bytes();
+  }
+  return bytes;
+}
+
+std::vector<std::string> PcgSolver::setup_details() const
+{
+  std::vector<std::string> details;
+  for (const Preconditioner::UPtr &p : m_precond)
+  {
+    details.push_back(p->details());
+  }
+  return details;
+}
+
+InnerStats PcgSolver::solve(int group, const std::vector<double> &b, std::vector<double> &x)
+{
+  if (m_sellFloat.empty())
+  {
+    return pcg(group, b, x, m_options.tolerance, false);
+  }
+  if (!m_options.refinement)
+  {
+    return pcg(group, b, x, m_options.tolerance, true);
+  }
+
+  // Iteratív finomítás: r = b - A x (double), A d = r float SpMV-s PCG-vel, x += d
+  InnerStats stats;
+  const double bNorm = norm2(b);
+  if (bNorm == 0.0)
+  {
+    x.assign(b.size(), 0.0);
+    stats.converged = true;
+    return stats;
+  }
+  const CsrMatrix &A = m_system.groupMatrix[static_cast<std::size_t>(group)];
+  for (int step = 0; step <= m_options.refinementMax; ++step)
+  {
+    A.multiply(x, m_residual);
+    parallel_for(0, b.size(), [&](std::size_t i) { m_residual[i] = b[i] - m_residual[i]; });
+    stats.residual = norm2(m_residual) / bNorm;
+    if (stats.residual <= m_options.tolerance || step == m_options.refinementMax)
+    {
+      break;
+    }
+    // Ha egy korrekció elég a célhoz, nem kell a refinement_tol-nál pontosabban megoldani
+    const double correctionTol = std::min(0.5, std::max(m_options.refinementTol, 0.5 * m_options.tolerance / stats.residual));
+    std::fill(m_correction.begin(), m_correction.end(), 0.0);
+    const InnerStats correction = pcg(group, m_residual, m_correction, correctionTol, true);
+    stats.iterations += correction.iterations;
+    axpy(1.0, m_correction, x);
+  }
+  stats.converged = stats.residual <= m_options.tolerance;
+  return stats;
+}
+
+InnerStats PcgSolver::pcg(int group, const std::vector<double> &b, std::vector<double> &x, double tolerance, bool singlePrecision)
+{
+  const Preconditioner &M = *m_precond[static_cast<std::size_t>(group)];
+  const auto spmv = [&](const std::vector<double> &in, std::vector<double> &out) {
+    if (singlePrecision)
+    {
+      sell_multiply(m_sellFloat[static_cast<std::size_t>(group)], in, out);
+    }
+    else
+    {
+      multiply(group, in, out);
+    }
+  };
+  const std::size_t n = b.size();
+  InnerStats stats;
+  InnerHistory history;
+  history.group = group;
+
+  const double bNorm = norm2(b);
+  if (bNorm == 0.0)
+  {
+    x.assign(n, 0.0);
+    stats.converged = true;
+    return stats;
+  }
+
+  // r = b - A x
+  spmv(x, m_r);
+  parallel_for(0, n, [&](std::size_t i) { m_r[i] = b[i] - m_r[i]; });
+  M.apply(m_r, m_z);
+  m_p = m_z;
+  double rz = dot(m_r, m_z);
+  double rNorm = norm2(m_r);
+  if (m_keepHistory)
+  {
+    history.residuals.push_back(rNorm / bNorm);
+  }
+
+  while (rNorm / bNorm > tolerance && stats.iterations < m_options.maxIterations)
+  {
+    spmv(m_p, m_q);
+    const double pq = dot(m_p, m_q);
+    if (pq <= 0.0)
+    {
+      break; // nem pozitív definit irány: a mátrix vagy a prekondicionáló hibás
+    }
+    const double alpha = rz / pq;
+    axpy(alpha, m_p, x);
+    axpy(-alpha, m_q, m_r);
+    M.apply(m_r, m_z);
+    const double rzNew = dot(m_r, m_z);
+    xpay(m_z, rzNew / rz, m_p);
+    rz = rzNew;
+    rNorm = norm2(m_r);
+    ++stats.iterations;
+    if (m_keepHistory)
+    {
+      history.residuals.push_back(rNorm / bNorm);
+    }
+  }
+
+  stats.residual = rNorm / bNorm;
+  stats.converged = stats.residual <= tolerance;
+  if (m_keepHistory)
+  {
+    m_history.push_back(history);
+  }
+  return stats;
+}
+
+InnerStats PcgSolver::solve_block(int group, const std::vector<std::vector<double>> &b, std::vector<std::vector<double>> &x)
+{
+  if (!m_sellFloat.empty() || m_options.spmv == "matrix_free" || m_keepHistory || b.size() < 2)
+  {
+    return GroupSolver::solve_block(group, b, x);
+  }
+  const Preconditioner &M = *m_precond[static_cast<std::size_t>(group)];
+  const CsrMatrix &A = m_system.groupMatrix[static_cast<std::size_t>(group)];
+  const std::size_t count = b.size();
+  const std::size_t n = static_cast<std::size_t>(m_system.nodeCount);
+  m_blockR.resize(count);
+  m_blockZ.resize(count);
+  m_blockP.resize(count);
+  m_blockQ.resize(count);
+  std::vector<double> bNorm(count), rz(count), rNorm(count);
+  std::vector<int> all, active;
+  for (std::size_t c = 0; c < count; ++c)
+  {
+    all.push_back(static_cast<int>(c));
+  }
+
+  // r = b - A x minden vektorra egy blokkolt szorzással
+  A.multiply_block(x, m_blockR, all);
+  for (std::size_t c = 0; c < count; ++c)
+  {
+    std::vector<double> &r = m_blockR[c];
+    parallel_for(0, n, [&](std::size_t i) { r[i] = b[c][i] - r[i]; });
+    bNorm[c] = norm2(b[c]);
+    if (bNorm[c] == 0.0)
+    {
+      x[c].assign(n, 0.0);
+      continue;
+    }
+    M.apply(r, m_blockZ[c]);
+    m_blockP[c] = m_blockZ[c];
+    rz[c] = dot(r, m_blockZ[c]);
+    rNorm[c] = norm2(r);
+    if (rNorm[c] / bNorm[c] > m_options.tolerance)
+    {
+      active.push_back(static_cast<int>(c));
+    }
+  }
+
+  InnerStats stats;
+  int step = 0;
+  while (!active.empty() && step < m_options.maxIterations)
+  {
+    A.multiply_block(m_blockP, m_blockQ, active);
+    std::vector<int> next;
+    for (int ci : active)
+    {
+      const std::size_t c = static_cast<std::size_t>(ci);
+      const double pq = dot(m_blockP[c], m_blockQ[c]);
+      if (pq <= 0.0)
+      {
+        continue; // nem pozitív definit irány: ez a vektor kiesik (a reziduuma marad)
+      }
+      const double alpha = rz[c] / pq;
+      axpy(alpha, m_blockP[c], x[c]);
+      axpy(-alpha, m_blockQ[c], m_blockR[c]);
+      M.apply(m_blockR[c], m_blockZ[c]);
+      const double rzNew = dot(m_blockR[c], m_blockZ[c]);
+      xpay(m_blockZ[c], rzNew / rz[c], m_blockP[c]);
+      rz[c] = rzNew;
+      rNorm[c] = norm2(m_blockR[c]);
+      ++stats.iterations;
+      if (rNorm[c] / bNorm[c] > m_options.tolerance)
+      {
+        next.push_back(ci);
+      }
+    }
+    active.swap(next);
+    ++step;
+  }
+
+  for (std::size_t c = 0; c < count; ++c)
+  {
+    if (bNorm[c] > 0.0)
+    {
+      stats.residual = std::max(stats.residual, rNorm[c] / bNorm[c]);
+    }
+  }
+  stats.converged = stats.residual <= m_options.tolerance;
+  return stats;
+}
+
+DirectSolver::DirectSolver(const DiffusionSystem &system, const InnerOptions &options, CholeskySymbolic::CPtr symbolic)
+    : m_system(system), m_options(options), m_symbolic(symbolic)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (!m_symbolic)
+  {
+    m_symbolic = analyze_cholesky(*system.pattern, options.cholesky);
+  }
+  for (const CsrMatrix &A : system.groupMatrix)
+  {
+    try
+    {
+      m_factor.push_back(std::unique_ptr<CholeskyFactor>(new CholeskyFactor(A, m_symbolic)));
+    }
+    catch (const CholeskyError &ex)
+    {
+      throw SolverError(std::string("Cholesky faktorizáció: ") + ex.what());
+    }
+  }
+  m_r.resize(static_cast<std::size_t>(system.nodeCount));
+  const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+  m_setupMs = d.count();
+}
+
+InnerStats DirectSolver::solve(int group, const std::vector<double> &b, std::vector<double> &x)
+{
+  InnerStats stats;
+  m_factor[static_cast<std::size_t>(group)]->solve(b, x);
+  stats.iterations = 1;
+
+  // Ellenőrző reziduum (egy SpMV), hogy a direkt és az iteratív út összevethető legyen
+  const double bNorm = norm2(b);
+  m_system.groupMatrix[static_cast<std::size_t>(group)].multiply(x, m_r);
+  parallel_for(0, m_r.size(), [&](std::size_t i) { m_r[i] = b[i] - m_r[i]; });
+  stats.residual = bNorm > 0.0 ? norm2(m_r) / bNorm : 0.0;
+  stats.converged = true;
+  if (m_keepHistory)
+  {
+    InnerHistory history;
+    history.group = group;
+    history.residuals.push_back(1.0);
+    history.residuals.push_back(stats.residual);
+    m_history.push_back(history);
+  }
+  return stats;
+}
+
+std::size_t DirectSolver::setup_memory_bytes() const
+{
+  std::size_t bytes = m_symbolic->memory_bytes();
+  for (const std::unique_ptr<CholeskyFactor> &f : m_factor)
+  {
+    bytes += f->memory_bytes();
+  }
+  return bytes;
+}
+
+std::vector<std::string> DirectSolver::setup_details() const
+{
+  std::vector<std::string> details;
+  const CholeskySymbolic &sym = *m_symbolic;
+  for (const std::unique_ptr<CholeskyFactor> &f : m_factor)
+  {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    out << "Cholesky nnz(L) = " << sym.factor_nnz() << " (kitöltés "
+        << static_cast<double>(sym.factor_nnz()) / static_cast<double>(std::max<std::size_t>(sym.lowerNnzA, 1))
+        << "x), " << sym.supernode_count() << " szupernódus, " << sym.levelPtr.size() - 1 << " fa szint, "
+        << static_cast<double>(f->memory_bytes()) / (1024.0 * 1024.0) << " MB, analízis " << sym.analyzeMs
+        << " ms, faktorizálás " << f->factor_ms() << " ms (" << sym.flops * 1e-6 << " Mflop)";
+    details.push_back(out.str());
+  }
+  return details;
+}
+
+CoupledSolver::CoupledSolver(const DiffusionSystem &system, const InnerOptions &options)
+    : m_options(options), m_groupCount(system.groupCount)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  m_matrix = build_block_system(system);
+  try
+  {
+    m_precond = make_block_preconditioner(options.blockPreconditioner, m_matrix);
+  }
+  catch (const BlockSparseError &ex)
+  {
+    throw SolverError(std::string("Blokk prekondicionáló: ") + ex.what());
+  }
+  const std::size_t n = static_cast<std::size_t>(system.nodeCount) * static_cast<std::size_t>(system.groupCount);
+  for (std::vector<double> *v : {&m_b, &m_x, &m_r, &m_rHat, &m_p, &m_v, &m_s, &m_t, &m_pHat, &m_sHat})
+  {
+    v->assign(n, 0.0);
+  }
+  const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+  m_setupMs = d.count();
+}
+
+InnerStats CoupledSolver::solve(int, const std::vector<double> &, std::vector<double> &)
+{
+  throw SolverError("A csatolt megoldó csak az összes csoportot együtt tudja megoldani (solve_coupled).");
+}
+
+InnerStats CoupledSolver::solve_coupled(const std::vector<std::vector<double>> &b, std::vector<std::vector<double>> &x)
+{
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t N = b.empty() ? 0 : b[0].size();
+  // Csoportonkénti vektorok -> interleaved (csomópont-major)
+  parallel_for(0, N, [&](std::size_t i) {
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      m_b[i * G + g] = b[g][i];
+      m_x[i * G + g] = x[g][i];
+    }
+  });
+
+  InnerStats stats;
+  InnerHistory history;
+  history.group = -1;
+  const double bNorm = norm2(m_b);
+  if (bNorm == 0.0)
+  {
+    for (std::vector<double> &v : x)
+    {
+      std::fill(v.begin(), v.end(), 0.0);
+    }
+    stats.converged = true;
+    return stats;
+  }
+
+  // Jobbról prekondicionált BiCGSTAB
+  m_matrix.multiply(m_x, m_r);
+  parallel_for(0, m_r.size(), [&](std::size_t i) { m_r[i] = m_b[i] - m_r[i]; });
+  m_rHat = m_r;
+  std::fill(m_p.begin(), m_p.end(), 0.0);
+  std::fill(m_v.begin(), m_v.end(), 0.0);
+  double rho = 1.0, alpha = 1.0, omega = 1.0;
+  double rNorm = norm2(m_r);
+  if (m_keepHistory)
+  {
+    history.residuals.push_back(rNorm / bNorm);
+  }
+  while (rNorm / bNorm > m_options.tolerance && stats.iterations < m_options.maxIterations)
+  {
+    const double rhoNew = dot(m_rHat, m_r);
+    if (rhoNew == 0.0 || omega == 0.0)
+    {
+      break; // a módszer elakadt
+    }
+    const double beta = (rhoNew / rho) * (alpha / omega);
+    rho = rhoNew;
+    parallel_for(0, m_p.size(), [&](std::size_t i) { m_p[i] = m_r[i] + beta * (m_p[i] - omega * m_v[i]); });
+    m_precond->apply(m_p, m_pHat);
+    m_matrix.multiply(m_pHat, m_v);
+    alpha = rho / dot(m_rHat, m_v);
+    parallel_for(0, m_s.size(), [&](std::size_t i) { m_s[i] = m_r[i] - alpha * m_v[i]; });
+    ++stats.iterations;
+    if (norm2(m_s) / bNorm <= m_options.tolerance)
+    {
+      axpy(alpha, m_pHat, m_x);
+      rNorm = norm2(m_s);
+      m_r.swap(m_s);
+      if (m_keepHistory)
+      {
+        history.residuals.push_back(rNorm / bNorm);
+      }
+      break;
+    }
+    m_precond->apply(m_s, m_sHat);
+    m_matrix.multiply(m_sHat, m_t);
+    const double tt = dot(m_t, m_t);
+    omega = tt > 0.0 ? dot(m_t, m_s) / tt : 0.0;
+    parallel_for(0, m_x.size(), [&](std::size_t i) {
+      m_x[i] += alpha * m_pHat[i] + omega * m_sHat[i];
+      m_r[i] = m_s[i] - omega * m_t[i];
+    });
+    rNorm = norm2(m_r);
+    if (m_keepHistory)
+    {
+      history.residuals.push_back(rNorm / bNorm);
+    }
+  }
+
+  parallel_for(0, N, [&](std::size_t i) {
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      x[g][i] = m_x[i * G + g];
+    }
+  });
+  stats.residual = rNorm / bNorm;
+  stats.converged = stats.residual <= m_options.tolerance;
+  if (m_keepHistory)
+  {
+    m_history.push_back(history);
+  }
+  return stats;
+}
+
+GroupSolver::UPtr make_group_solver(const DiffusionSystem &system, const SolverConfig &config,
+                                    const MatrixFreeOperator *matrixFree, CholeskySymbolic::CPtr symbolic)
+{
+  const InnerOptions options = read_inner_options(config);
+  const std::string type = config.getString("inner_solver", "pcg");
+  GroupSolver::UPtr solver;
+  if (type == "direct" || type == "cholesky")
+  {
+    solver.reset(new DirectSolver(system, options, symbolic));
+  }
+  else if (type == "coupled")
+  {
+    solver.reset(new CoupledSolver(system, options));
+  }
+  else
+  {
+    if (type != "pcg" && type != "cg")
+    {
+      std::cerr << "[FIGYELMEZTETÉS] Ismeretlen belső megoldó: \"" << type << "\", pcg-t használok.\n";
+    }
+    solver.reset(new PcgSolver(system, options, matrixFree));
+  }
+  solver->keep_history(config.getBool("inner_history", false));
+  return solver;
+}
+
+void write_inner_history(const std::string &path, const std::vector<InnerHistory> &history)
+{
+  std::ofstream out(path);
+  if (!out)
+  {
+    throw SolverError("Nem sikerült megnyitni a reziduum történet fájlt: " + path);
+  }
+  out << "solve,group,iteration,residual\n";
+  for (std::size_t s = 0; s < history.size(); ++s)
+  {
+    for (std::size_t it = 0; it < history[s].residuals.size(); ++it)
+    {
+      out << s << "," << history[s].group << "," << it << "," << history[s].residuals[it] << "\n";
+    }
+  }
+}
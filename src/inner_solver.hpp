@@ -0,0 +1,205 @@
+#ifndef INNER_SOLVER_HPP
+#define INNER_SOLVER_HPP
+
+#include "assembly.hpp"
+#include "block_sparse.hpp"
+#include "cholesky.hpp"
+#include "control.hpp"
+#include "precond.hpp"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class MatrixFreeOperator;
+
+class SolverError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+// Egy belső (csoportonkénti) lineáris megoldás statisztikája
+struct InnerStats
+{
+  int iterations = 0;
+  double residual = 0.0; // relatív reziduum a végén
+  bool converged = false;
+};
+
+// Egy belső megoldás reziduum története (a belső tolerancia hangolásához)
+struct InnerHistory
+{
+  int group = 0;
+  std::vector<double> residuals; // relatív reziduum iterációnként (0. = kezdő)
+};
+
+// Csoportonkénti megoldó: A_g x = b. Az x bemenetként a kezdőérték (warm start az előző külső iterációból).
+// A külső (sajátérték, fix forrás, stb.) iterációk csak ezen az interfészen keresztül látják a belső megoldót,
+// így a különböző belső megoldók (Krylov, direkt, ...) cserélhetők.
+class GroupSolver
+{
+public:
+  typedef std::unique_ptr<GroupSolver> UPtr;
+
+  virtual ~GroupSolver() {}
+  virtual std::string name() const = 0;
+  virtual InnerStats solve(int group, const std::vector<double> &b, std::vector<double> &x) = 0;
+  // Több jobb oldal ugyanarra a csoportra (x[c] a kezdőérték). Az iterációszám a vektoronkénti iterációk
+  // összege, a reziduum a legnagyobb. Az alapértelmezés egyenként old meg; a PCG blokkolt SpMV-vel viszi
+  // együtt a rendszereket (a mátrix egy menetben szolgálja ki az összes vektort).
+  virtual InnerStats solve_block(int group, const std::vector<std::vector<double>> &b, std::vector<std::vector<double>> &x)
+  {
+    InnerStats total;
+    total.converged = true;
+    for (std::size_t c = 0; c < b.size(); ++c)
+    {
+      const InnerStats stats = solve(group, b[c], x[c]);
+      total.iterations += stats.iterations;
+      total.residual = std::max(total.residual, stats.residual);
+      total.converged = total.converged && stats.converged;
+    }
+    return total;
+  }
+  // Előre felépített adatok (prekondicionáló, faktor, ...) memóriaigénye
+  virtual std::size_t setup_memory_bytes() const { return 0; }
+  virtual double setup_ms() const { return 0.0; }
+  // Csatolt megoldó: minden csoport egyszerre, (A - S) x = b a szórási csatolással együtt.
+  // Ha coupled() igaz, a külső iteráció a solve_coupled-ot hívja a csoportonkénti Gauss–Seidel helyett.
+  virtual bool coupled() const { return false; }
+  virtual InnerStats solve_coupled(const std::vector<std::vector<double>> &b, std::vector<std::vector<double>> &x)
+  {
+    (void)b;
+    (void)x;
+    throw SolverError("A(z) " + name() + " megoldó nem támogatja a csatolt megoldást.");
+  }
+  // Csoportonkénti előkészítési részletek (pl. AMG hierarchia), soronként egy csoport
+  virtual std::vector<std::string> setup_details() const { return std::vector<std::string>(); }
+
+  // Reziduum történetek (csak ha be van kapcsolva: inner_history on)
+  const std::vector<InnerHistory> &history() const { return m_history; }
+  void keep_history(bool enabled) { m_keepHistory = enabled; }
+
+protected:
+  std::vector<InnerHistory> m_history;
+  bool m_keepHistory = false;
+};
+
+// Belső megoldó beállítások ($Solver szekció)
+struct InnerOptions
+{
+  double tolerance = 1e-8; // relatív reziduum: ||b - Ax|| / ||b||
+  int maxIterations = 1000;
+  std::string preconditioner = "ic0"; // jacobi | ic0 | ilu0 | ssor | amg | none
+  double ssorOmega = 1.2;
+  AmgOptions amg;
+  CholeskyOptions cholesky; // direkt megoldó (inner_solver direct)
+  std::string blockPreconditioner = "bilu0"; // csatolt megoldó: bjacobi | bilu0
+  std::string spmv = "sell"; // sell (SIMD szeletek) | csr | matrix_free (elemenkénti, CSR értékek nélkül)
+  std::string precision = "double"; // double | single (float SELL tárolás, double összegzés)
+  bool refinement = true;           // single: iteratív finomítás double reziduummal a teljes pontosságig
+  double refinementTol = 1e-4;      // egy float korrekciós megoldás relatív toleranciája
+  int refinementMax = 10;           // finomító lépések maximális száma
+};
+
+InnerOptions read_inner_options(const SolverConfig &config);
+
+// Prekondicionált konjugált gradiens a csoport mátrixokra.
+// precision == single esetén a Krylov iteráció SpMV-je float SELL mátrixszal fut (fele akkora
+// memóriaforgalom, double összegzés); iteratív finomításnál a reziduumot a double CSR mátrix adja,
+// és a float korrekciós megoldások addig ismétlődnek, amíg a double reziduum el nem éri az inner_tol-t.
+// A prekondicionálók és a SELL mátrixok a konstruktorban egyszer épülnek fel, és minden
+// külső iterációban újra felhasználódnak. spmv == matrix_free esetén az A_g x szorzást a
+// kapott mátrixmentes operátor végzi (a prekondicionálók továbbra is az összeállított mátrixból épülnek).
+class PcgSolver : public GroupSolver
+{
+public:
+  PcgSolver(const DiffusionSystem &system, const InnerOptions &options, const MatrixFreeOperator *matrixFree = nullptr);
+  std::string name() const override
+  {
+    return "pcg+" + m_options.preconditioner + (m_sellFloat.empty() ? "" : (m_options.refinement ? "+f32/ir" : "+f32"));
+  }
+  InnerStats solve(int group, const std::vector<double> &b, std::vector<double> &x) override;
+  // Lépésenként együtt haladó PCG-k blokkolt CSR SpMV-vel (double pontosság, összeállított mátrix esetén;
+  // egyébként, és reziduum történet gyűjtésekor, vektoronként old meg)
+  InnerStats solve_block(int group, const std::vector<std::vector<double>> &b, std::vector<std::vector<double>> &x) override;
+  std::size_t setup_memory_bytes() const override;
+  double setup_ms() const override { return m_setupMs; }
+  std::vector<std::string> setup_details() const override;
+
+private:
+  void multiply(int group, const std::vector<double> &x, std::vector<double> &y) const;
+  // Egy PCG megoldás adott relatív toleranciára; singlePrecision: float SELL SpMV
+  InnerStats pcg(int group, const std::vector<double> &b, std::vector<double> &x, double tolerance, bool singlePrecision);
+
+  const DiffusionSystem &m_system;
+  InnerOptions m_options;
+  std::vector<Preconditioner::UPtr> m_precond; // csoportonként
+  std::vector<SellMatrix<double>> m_sell;      // csoportonként (ha spmv == sell)
+  std::vector<SellMatrix<float>> m_sellFloat;  // csoportonként (ha precision == single)
+  const MatrixFreeOperator *m_matrixFree;      // ha spmv == matrix_free
+  std::vector<double> m_r, m_z, m_p, m_q;      // munkavektorok (egyszer foglalva)
+  std::vector<double> m_residual, m_correction; // iteratív finomítás munkavektorai
+  std::vector<std::vector<double>> m_blockR, m_blockZ, m_blockP, m_blockQ; // blokkolt PCG munkavektorai
+  double m_setupMs = 0.0;
+};
+
+// Direkt megoldó: csoportonként egyszer faktorizált ritka Cholesky, a külső iterációkban csak
+// előre-hátra helyettesítés. A szimbolikus analízis (rendezés, szupernódusok) a közös mintázat miatt
+// minden csoportra közös.
+class DirectSolver : public GroupSolver
+{
+public:
+  // symbolic: egy azonos mintázatra már elkészült szimbolikus analízis (üres = itt készül)
+  DirectSolver(const DiffusionSystem &system, const InnerOptions &options,
+               CholeskySymbolic::CPtr symbolic = CholeskySymbolic::CPtr());
+  std::string name() const override { return "cholesky+" + m_options.cholesky.ordering; }
+  InnerStats solve(int group, const std::vector<double> &b, std::vector<double> &x) override;
+  std::size_t setup_memory_bytes() const override;
+  double setup_ms() const override { return m_setupMs; }
+  std::vector<std::string> setup_details() const override;
+
+private:
+  const DiffusionSystem &m_system;
+  InnerOptions m_options;
+  CholeskySymbolic::CPtr m_symbolic;
+  std::vector<std::unique_ptr<CholeskyFactor>> m_factor; // csoportonként
+  std::vector<double> m_r;
+  double m_setupMs = 0.0;
+};
+
+// Csatolt többcsoportos megoldó: blokk-CSR (A - S) mátrix, BiCGSTAB blokk-Jacobi vagy blokk ILU(0)
+// prekondicionálással. Erős felszórásnál a csoportonkénti Gauss–Seidel helyett egyben oldja meg az
+// energiacsatolást. A csoportonkénti solve() a blokk diagonális (A_g) részt nem kezeli külön, csak a
+// csatolt interfész használható.
+class CoupledSolver : public GroupSolver
+{
+public:
+  CoupledSolver(const DiffusionSystem &system, const InnerOptions &options);
+  std::string name() const override { return "bicgstab+" + m_precond->name(); }
+  InnerStats solve(int group, const std::vector<double> &b, std::vector<double> &x) override;
+  bool coupled() const override { return true; }
+  InnerStats solve_coupled(const std::vector<std::vector<double>> &b, std::vector<std::vector<double>> &x) override;
+  std::size_t setup_memory_bytes() const override { return m_matrix.memory_bytes() + m_precond->memory_bytes(); }
+  double setup_ms() const override { return m_setupMs; }
+
+private:
+  InnerOptions m_options;
+  int m_groupCount = 0;
+  BlockCsrMatrix m_matrix;
+  BlockPreconditioner::UPtr m_precond;
+  std::vector<double> m_b, m_x, m_r, m_rHat, m_p, m_v, m_s, m_t, m_pHat, m_sHat; // interleaved munkavektorok
+  double m_setupMs = 0.0;
+};
+
+// Megoldó létrehozása a beállítások alapján (matrixFree: opcionális mátrixmentes operátor; symbolic: a direkt
+// megoldónak átadott, közös mintázatú rendszerekre újrahasznosítható szimbolikus Cholesky analízis)
+GroupSolver::UPtr make_group_solver(const DiffusionSystem &system, const SolverConfig &config,
+                                    const MatrixFreeOperator *matrixFree = nullptr,
+                                    CholeskySymbolic::CPtr symbolic = CholeskySymbolic::CPtr());
+
+// Reziduum történetek kiírása CSV-be (megoldás, csoport, iteráció, reziduum)
+void write_inner_history(const std::string &path, const std::vector<InnerHistory> &history);
+
+#endif // INNER_SOLVER_HPP
@@ -0,0 +1,657 @@
+#include "kinetics.hpp"
+#include "inner_solver.hpp"
+#include "vector_ops.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+  typedef std::vector<std::vector<double>> GroupVectors; // [g][csomópont]
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  double group_dot(const GroupVectors &a, const GroupVectors &b)
+  {
+    double s = 0.0;
+    for (std::size_t g = 0; g < a.size(); ++g)
+    {
+      s += dot(a[g], b[g]);
+    }
+    return s;
+  }
+
+  double group_norm(const GroupVectors &a)
+  {
+    return std::sqrt(group_dot(a, a));
+  }
+
+  void group_axpy(double alpha, const GroupVectors &x, GroupVectors &y)
+  {
+    for (std::size_t g = 0; g < x.size(); ++g)
+    {
+      axpy(alpha, x[g], y[g]);
+    }
+  }
+
+  void group_scale(double alpha, GroupVectors &x)
+  {
+    for (std::vector<double> &v : x)
+    {
+      scale(alpha, v);
+    }
+  }
+
+  double group_sum(const GroupVectors &x)
+  {
+    double s = 0.0;
+    for (const std::vector<double> &v : x)
+    {
+      s += sum(v);
+    }
+    return s;
+  }
+
+  // A lépéshossztól függő rész: B = diag(V / (v theta dt)) + (A - S) és a rá épített belső megoldó
+  struct StepOperator
+  {
+    double dt = 0.0;
+    DiffusionSystem system; // csak a megoldók által használt részek: mintázat, eltolt A_g, szórás, térfogatok
+    GroupVectors shift;     // [g][i] = V_i / (v_g theta dt)
+    GroupSolver::UPtr solver;
+    double buildMs = 0.0;
+    long lastUse = 0;
+  };
+
+  class Transient
+  {
+  public:
+    Transient(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &system,
+              const SolverConfig &config, const EigenResult &steady, const KineticsOptions &options, KineticsResult &result)
+        : m_mesh(mesh), m_library(library), m_model(model), m_system(system), m_config(config), m_options(options),
+          m_result(result), m_kinetics(library.kinetics), m_k0(steady.keff)
+    {
+      // A lépésoperátorok belső megoldói: pontatlan (prekondicionáló) megoldás, reziduum történet nélkül,
+      // összeállított mátrixszal (a mátrixmentes operátor az eltolást nem ismeri)
+      m_config.options["inner_tol"] = std::to_string(options.innerTol);
+      m_config.options["inner_history"] = "off";
+      if (m_config.getString("spmv", "sell") == "matrix_free")
+      {
+        m_config.options["spmv"] = "sell";
+      }
+      m_flux = steady.flux;
+      compute_fission_source(m_system, m_flux, m_fission);
+      m_precursors.resize(m_kinetics.beta.size());
+      for (std::size_t j = 0; j < m_precursors.size(); ++j)
+      {
+        m_precursors[j] = m_fission;
+        group_scale(m_kinetics.beta[j] / (m_kinetics.lambda[j] * m_k0), m_precursors[j]);
+      }
+      m_initialPower = group_sum(m_fission) / m_k0;
+    }
+
+    double time() const { return m_time; }
+    const GroupVectors &flux() const { return m_flux; }
+
+    // Egy lépés dt-vel. Ha a becsült lokális hiba a tolerancián belül van (vagy acceptAlways), az állapot továbblép.
+    KineticsStep step(double dt, bool acceptAlways)
+    {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      KineticsStep info;
+      info.dt = dt;
+      StepOperator &op = step_operator(dt, info);
+      const std::size_t G = m_flux.size();
+      const double theta = m_options.theta;
+
+      // Anyamag kiküszöbölés együtthatói: c^{n+1} = a_j c^n + b_j (theta F phi^{n+1} + (1 - theta) F phi^n) / k0
+      const std::size_t J = m_precursors.size();
+      std::vector<double> a(J), b(J);
+      double delayedGain = 0.0;
+      for (std::size_t j = 0; j < J; ++j)
+      {
+        const double lambda = m_kinetics.lambda[j];
+        a[j] = (1.0 - (1.0 - theta) * lambda * dt) / (1.0 + theta * lambda * dt);
+        b[j] = dt * m_kinetics.beta[j] / (1.0 + theta * lambda * dt);
+        delayedGain += lambda * b[j];
+      }
+      const double coefficient = (1.0 - m_kinetics.beta_total()) + theta * delayedGain;
+
+      // rhs = shift phi^n + (1 - theta) / theta R^n + sum_j lambda_j a_j c_j^n + (1 - theta) sum_j lambda_j b_j F phi^n / k0
+      GroupVectors rhs(G);
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        rhs[g].resize(m_flux[g].size());
+        const std::vector<double> &s = op.shift[g];
+        const std::vector<double> &phi = m_flux[g];
+        std::vector<double> &r = rhs[g];
+        parallel_for(0, r.size(), [&](std::size_t i) { r[i] = s[i] * phi[i]; });
+      }
+      for (std::size_t j = 0; j < J; ++j)
+      {
+        group_axpy(m_kinetics.lambda[j] * a[j], m_precursors[j], rhs);
+      }
+      if (theta < 1.0)
+      {
+        GroupVectors current;
+        loss(system(), m_flux, current); // (A - S) phi^n
+        group_scale(-1.0, current);
+        group_axpy((1.0 - m_kinetics.beta_total()) / m_k0, m_fission, current);
+        for (std::size_t j = 0; j < J; ++j)
+        {
+          group_axpy(m_kinetics.lambda[j], m_precursors[j], current);
+        }
+        group_axpy((1.0 - theta) / theta, current, rhs);
+        group_axpy((1.0 - theta) * delayedGain / m_k0, m_fission, rhs);
+      }
+
+      // Kezdőérték és hibabecslés: lineáris extrapoláció az előző két állapotból
+      GroupVectors next = m_flux;
+      if (m_hasHistory)
+      {
+        GroupVectors slope = m_flux;
+        group_axpy(-1.0, m_previous, slope);
+        group_axpy(dt / m_previousDt, slope, next);
+      }
+      const GroupVectors predicted = next;
+      info.krylovIterations = fgmres(op, coefficient, rhs, next, info.innerIterations);
+
+      GroupVectors fission;
+      compute_fission_source(system(), next, fission);
+      if (m_hasHistory)
+      {
+        GroupVectors diff = next;
+        group_axpy(-1.0, predicted, diff);
+        const double norm = group_norm(next);
+        info.error = norm > 0.0 ? dt / (dt + m_previousDt) * group_norm(diff) / norm : 0.0;
+      }
+      info.accepted = acceptAlways || info.error <= m_options.tolerance;
+      if (info.accepted)
+      {
+        for (std::size_t j = 0; j < J; ++j)
+        {
+          group_scale(a[j], m_precursors[j]);
+          group_axpy(b[j] * theta / m_k0, fission, m_precursors[j]);
+          group_axpy(b[j] * (1.0 - theta) / m_k0, m_fission, m_precursors[j]);
+        }
+        m_previous.swap(m_flux);
+        m_flux.swap(next);
+        m_fission.swap(fission);
+        m_previousDt = dt;
+        m_hasHistory = true;
+        m_time += dt;
+        info.power = group_sum(m_fission) / m_k0 / m_initialPower;
+      }
+      else
+      {
+        info.power = group_sum(fission) / m_k0 / m_initialPower;
+      }
+      info.time = info.accepted ? m_time : m_time + dt;
+      info.ms = elapsed_ms(start);
+      m_result.solveMs += info.ms - info.buildMs;
+      return info;
+    }
+
+    // Keresztmetszet változás: új könyvtár és assembly, a lépésoperátorok érvénytelenek, az extrapoláció újraindul
+    void apply(const XsPerturbation &change)
+    {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      m_changedLibrary = perturbed_library(m_mesh, m_systemPtr == nullptr ? m_library : m_changedLibrary, m_model, change);
+      DiffusionSystem changed;
+      assemble_diffusion(m_mesh, m_changedLibrary, changed);
+      m_ownSystem.reset(new DiffusionSystem(std::move(changed)));
+      m_systemPtr = m_ownSystem.get();
+      m_cache.clear();
+      compute_fission_source(system(), m_flux, m_fission);
+      m_hasHistory = false;
+      m_result.assemblyMs += elapsed_ms(start);
+    }
+
+  private:
+    const DiffusionSystem &system() const { return m_systemPtr != nullptr ? *m_systemPtr : m_system; }
+
+    // y = (A - S) x
+    void loss(const DiffusionSystem &s, const GroupVectors &x, GroupVectors &y) const
+    {
+      y.resize(x.size());
+      for (std::size_t g = 0; g < x.size(); ++g)
+      {
+        s.groupMatrix[g].multiply(x[g], y[g]);
+      }
+      for (const GroupCoupling &c : s.scatter)
+      {
+        c.matrix.multiply_add(-1.0, x[static_cast<std::size_t>(c.from)], y[static_cast<std::size_t>(c.to)]);
+      }
+    }
+
+    // y = B x - coefficient * F x / k0
+    void apply_operator(const StepOperator &op, double coefficient, const GroupVectors &x, GroupVectors &y)
+    {
+      loss(op.system, x, y);
+      compute_fission_source(system(), x, m_work);
+      group_axpy(-coefficient / m_k0, m_work, y);
+    }
+
+    // z ~ B^-1 v: csatolt megoldóval egyben, egyébként egy előre Gauss–Seidel menet a csoportokon
+    void precondition(StepOperator &op, const GroupVectors &v, GroupVectors &z, long &innerIterations)
+    {
+      const std::size_t G = v.size();
+      z.assign(G, std::vector<double>(v[0].size(), 0.0));
+      if (op.solver->coupled())
+      {
+        innerIterations += op.solver->solve_coupled(v, z).iterations;
+        return;
+      }
+      std::vector<double> rhs;
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        rhs = v[g];
+        for (const GroupCoupling &c : op.system.scatter)
+        {
+          if (static_cast<std::size_t>(c.to) == g && static_cast<std::size_t>(c.from) < g)
+          {
+            c.matrix.multiply_add(1.0, z[static_cast<std::size_t>(c.from)], rhs);
+          }
+        }
+        innerIterations += op.solver->solve(static_cast<int>(g), rhs, z[g]).iterations;
+      }
+    }
+
+    // Jobbról prekondicionált, flexibilis GMRES (a prekondicionáló pontatlan belső megoldás)
+    int fgmres(StepOperator &op, double coefficient, const GroupVectors &b, GroupVectors &x, long &innerIterations)
+    {
+      const double bNorm = group_norm(b);
+      if (bNorm == 0.0)
+      {
+        for (std::vector<double> &v : x)
+        {
+          std::fill(v.begin(), v.end(), 0.0);
+        }
+        return 0;
+      }
+      const int m = std::max(1, m_options.restart);
+      GroupVectors r;
+      apply_operator(op, coefficient, x, r);
+      for (std::size_t g = 0; g < r.size(); ++g)
+      {
+        parallel_for(0, r[g].size(), [&](std::size_t i) { r[g][i] = b[g][i] - r[g][i]; });
+      }
+      double beta = group_norm(r);
+      int iterations = 0;
+      std::vector<GroupVectors> V(static_cast<std::size_t>(m) + 1), Z(static_cast<std::size_t>(m));
+      std::vector<double> H(static_cast<std::size_t>((m + 1) * m), 0.0), cs(static_cast<std::size_t>(m)),
+          sn(static_cast<std::size_t>(m)), e(static_cast<std::size_t>(m) + 1);
+      const auto h = [&](int i, int j) -> double & { return H[static_cast<std::size_t>(i * m + j)]; };
+      while (beta / bNorm > m_options.solverTol && iterations < m_options.maxIterations)
+      {
+        V[0] = r;
+        group_scale(1.0 / beta, V[0]);
+        std::fill(e.begin(), e.end(), 0.0);
+        e[0] = beta;
+        int columns = 0;
+        for (int j = 0; j < m && iterations < m_options.maxIterations; ++j)
+        {
+          precondition(op, V[static_cast<std::size_t>(j)], Z[static_cast<std::size_t>(j)], innerIterations);
+          GroupVectors &w = V[static_cast<std::size_t>(j) + 1];
+          apply_operator(op, coefficient, Z[static_cast<std::size_t>(j)], w);
+          ++iterations;
+          for (int i = 0; i <= j; ++i)
+          {
+            h(i, j) = group_dot(w, V[static_cast<std::size_t>(i)]);
+            group_axpy(-h(i, j), V[static_cast<std::size_t>(i)], w);
+          }
+          h(j + 1, j) = group_norm(w);
+          if (h(j + 1, j) > 0.0)
+          {
+            group_scale(1.0 / h(j + 1, j), w);
+          }
+          // Givens forgatások
+          for (int i = 0; i < j; ++i)
+          {
+            const double t = cs[static_cast<std::size_t>(i)] * h(i, j) + sn[static_cast<std::size_t>(i)] * h(i + 1, j);
+            h(i + 1, j) = -sn[static_cast<std::size_t>(i)] * h(i, j) + cs[static_cast<std::size_t>(i)] * h(i + 1, j);
+            h(i, j) = t;
+          }
+          const double rho = std::hypot(h(j, j), h(j + 1, j));
+          cs[static_cast<std::size_t>(j)] = rho > 0.0 ? h(j, j) / rho : 1.0;
+          sn[static_cast<std::size_t>(j)] = rho > 0.0 ? h(j + 1, j) / rho : 0.0;
+          h(j, j) = rho;
+          h(j + 1, j) = 0.0;
+          e[static_cast<std::size_t>(j) + 1] = -sn[static_cast<std::size_t>(j)] * e[static_cast<std::size_t>(j)];
+          e[static_cast<std::size_t>(j)] *= cs[static_cast<std::size_t>(j)];
+          columns = j + 1;
+          if (std::fabs(e[static_cast<std::size_t>(j) + 1]) / bNorm <= m_options.solverTol || rho == 0.0)
+          {
+            break;
+          }
+        }
+        // x += Z y, H y = e (felső háromszög)
+        std::vector<double> y(static_cast<std::size_t>(columns), 0.0);
+        for (int i = columns - 1; i >= 0; --i)
+        {
+          double s = e[static_cast<std::size_t>(i)];
+          for (int k = i + 1; k < columns; ++k)
+          {
+            s -= h(i, k) * y[static_cast<std::size_t>(k)];
+          }
+          y[static_cast<std::size_t>(i)] = h(i, i) != 0.0 ? s / h(i, i) : 0.0;
+        }
+        for (int i = 0; i < columns; ++i)
+        {
+          group_axpy(y[static_cast<std::size_t>(i)], Z[static_cast<std::size_t>(i)], x);
+        }
+        // Valódi reziduum az újraindításhoz (és a leállási feltételhez)
+        apply_operator(op, coefficient, x, r);
+        for (std::size_t g = 0; g < r.size(); ++g)
+        {
+          parallel_for(0, r[g].size(), [&](std::size_t i) { r[g][i] = b[g][i] - r[g][i]; });
+        }
+        beta = group_norm(r);
+      }
+      if (beta / bNorm > m_options.solverTol)
+      {
+        std::cerr << "[FIGYELMEZTETÉS] Tranziens lépés (t = " << m_time << " s): az FGMRES nem konvergált, reziduum "
+                  << beta / bNorm << "\n";
+      }
+      return iterations;
+    }
+
+    // Lépésoperátor a gyorsítótárból, vagy új felépítése (a legrégebben használt kiesik)
+    StepOperator &step_operator(double dt, KineticsStep &info)
+    {
+      ++m_clock;
+      for (const std::unique_ptr<StepOperator> &op : m_cache)
+      {
+        if (std::fabs(op->dt - dt) <= 1e-12 * dt)
+        {
+          op->lastUse = m_clock;
+          ++m_result.cacheHits;
+          return *op;
+        }
+      }
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      const DiffusionSystem &base = system();
+      std::unique_ptr<StepOperator> op(new StepOperator());
+      op->dt = dt;
+      op->system.groupCount = base.groupCount;
+      op->system.nodeCount = base.nodeCount;
+      op->system.pattern = base.pattern;
+      op->system.groupMatrix = base.groupMatrix;
+      op->system.scatter = base.scatter;
+      op->system.nodeVolume = base.nodeVolume;
+      const std::vector<int> diagonal = base.pattern->diagonal_positions();
+      op->shift.resize(static_cast<std::size_t>(base.groupCount));
+      for (std::size_t g = 0; g < op->shift.size(); ++g)
+      {
+        const double factor = 1.0 / (m_kinetics.velocity[g] * m_options.theta * dt);
+        std::vector<double> &shift = op->shift[g];
+        std::vector<double> &values = op->system.groupMatrix[g].values;
+        shift.resize(base.nodeVolume.size());
+        for (std::size_t i = 0; i < shift.size(); ++i)
+        {
+          shift[i] = factor * base.nodeVolume[i];
+          values[static_cast<std::size_t>(diagonal[i])] += shift[i];
+        }
+      }
+      op->solver = make_group_solver(op->system, m_config, nullptr);
+      op->buildMs = elapsed_ms(start);
+      op->lastUse = m_clock;
+      info.rebuilt = true;
+      info.buildMs = op->buildMs;
+      ++m_result.solverBuilds;
+      m_result.buildMs += op->buildMs;
+
+      if (static_cast<int>(m_cache.size()) >= std::max(1, m_options.cacheSize))
+      {
+        std::vector<std::unique_ptr<StepOperator>>::iterator oldest = m_cache.begin();
+        for (std::vector<std::unique_ptr<StepOperator>>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+        {
+          if ((*it)->lastUse < (*oldest)->lastUse)
+          {
+            oldest = it;
+          }
+        }
+        m_cache.erase(oldest);
+      }
+      m_cache.push_back(std::move(op));
+      return *m_cache.back();
+    }
+
+    const Mesh &m_mesh;
+    const XsLibrary &m_library;
+    const ModelLibrary &m_model;
+    const DiffusionSystem &m_system;
+    SolverConfig m_config;
+    const KineticsOptions &m_options;
+    KineticsResult &m_result;
+    XsKinetics m_kinetics;
+    double m_k0 = 1.0;
+    double m_initialPower = 1.0;
+
+    XsLibrary m_changedLibrary;                 // az események utáni könyvtár
+    std::unique_ptr<DiffusionSystem> m_ownSystem;
+    const DiffusionSystem *m_systemPtr = nullptr; // nullptr: az eredeti assembly
+
+    double m_time = 0.0;
+    GroupVectors m_flux, m_previous, m_fission, m_work;
+    std::vector<GroupVectors> m_precursors;     // családonként, csoportonként
+    double m_previousDt = 0.0;
+    bool m_hasHistory = false;
+
+    std::vector<std::unique_ptr<StepOperator>> m_cache;
+    long m_clock = 0;
+  };
+}
+
+void load_kinetics_events(const std::string &path, std::vector<KineticsEvent> &events)
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    throw KineticsError("Nem sikerült megnyitni az esemény fájlt: " + path);
+  }
+  std::vector<KineticsEvent> fresh;
+  std::string line;
+  std::size_t lineNo = 0;
+  while (std::getline(in, line))
+  {
+    ++lineNo;
+    const std::size_t hashPos = line.find('#');
+    std::istringstream iss(hashPos == std::string::npos ? line : line.substr(0, hashPos));
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token)
+    {
+      tokens.push_back(token);
+    }
+    if (tokens.empty())
+    {
+      continue;
+    }
+    KineticsEvent event;
+    std::istringstream time(tokens[0]);
+    char extra = '\0';
+    if (!(time >> event.time) || (time >> extra) || event.time < 0.0)
+    {
+      throw KineticsParseError(lineNo, "Érvénytelen időpont: \"" + tokens[0] + "\"");
+    }
+    try
+    {
+      event.change = parse_perturbation(std::vector<std::string>(tokens.begin() + 1, tokens.end()), lineNo);
+    }
+    catch (const PerturbationParseError &ex)
+    {
+      throw KineticsParseError(lineNo, ex.what());
+    }
+    fresh.push_back(event);
+  }
+  std::stable_sort(fresh.begin(), fresh.end(),
+                   [](const KineticsEvent &a, const KineticsEvent &b) { return a.time < b.time; });
+  events = std::move(fresh);
+}
+
+KineticsOptions read_kinetics_options(const SolverConfig &config)
+{
+  KineticsOptions options;
+  options.endTime = config.getDouble("transient_end", options.endTime);
+  options.dt = config.getDouble("transient_dt", options.dt);
+  options.theta = config.getDouble("transient_theta", options.theta);
+  options.adaptive = config.getBool("transient_adaptive", options.adaptive);
+  options.tolerance = config.getDouble("transient_tol", options.tolerance);
+  options.dtMin = config.getDouble("transient_dt_min", options.dtMin);
+  options.dtMax = config.getDouble("transient_dt_max", options.dtMax);
+  options.maxSteps = config.getInt("transient_max_steps", options.maxSteps);
+  options.solverTol = config.getDouble("transient_solver_tol", options.solverTol);
+  options.restart = config.getInt("transient_restart", options.restart);
+  options.maxIterations = config.getInt("transient_max_iter", options.maxIterations);
+  options.innerTol = config.getDouble("transient_inner_tol", options.innerTol);
+  options.cacheSize = config.getInt("transient_cache", options.cacheSize);
+  if (options.theta < 0.5 || options.theta > 1.0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A transient_theta 0.5 és 1 között lehet (stabilitás), 1-et használok.\n";
+    options.theta = 1.0;
+  }
+  if (options.dt <= 0.0 || options.endTime <= 0.0)
+  {
+    throw KineticsError("A transient_dt és a transient_end pozitív kell legyen.");
+  }
+  options.dtMin = std::min(options.dtMin, options.dt);
+  options.dtMax = std::max(options.dtMax, options.dt);
+  return options;
+}
+
+void solve_kinetics(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &system,
+                    const SolverConfig &config, const EigenResult &steady, const std::vector<KineticsEvent> &events,
+                    const KineticsOptions &options, KineticsResult &result)
+{
+  if (!library.kinetics.present())
+  {
+    throw KineticsError("A keresztmetszet könyvtár nem tartalmaz $Kinetics blokkot (késő neutron adatok).");
+  }
+  if (static_cast<int>(library.kinetics.velocity.size()) != system.groupCount)
+  {
+    throw KineticsError("A $Kinetics sebességeinek száma nem egyezik a csoportszámmal.");
+  }
+  if (steady.flux.size() != static_cast<std::size_t>(system.groupCount) || steady.keff <= 0.0)
+  {
+    throw KineticsError("Hiányzó stacionárius kiinduló állapot.");
+  }
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  result = KineticsResult();
+  Transient transient(mesh, library, model, system, config, steady, options, result);
+  result.peakPower = 1.0;
+
+  // Az eljárás rendje: elsőrendű (implicit Euler) vagy másodrendű (Crank–Nicolson) lokális hiba;
+  // a lépésköz duplázása ennyiszeresére növeli a hibát
+  const double growthFactor = options.theta == 0.5 ? 8.0 : 4.0;
+  const double timeEps = 1e-12 * options.endTime;
+  std::size_t nextEvent = 0;
+  // A t = 0-s események a kiinduló állapot után, az első lépés előtt
+  while (nextEvent < events.size() && events[nextEvent].time <= timeEps)
+  {
+    transient.apply(events[nextEvent++].change);
+    ++result.events;
+  }
+
+  double dt = options.dt;
+  int goodSteps = 0;
+  while (transient.time() < options.endTime - timeEps &&
+         result.accepted + result.rejected < options.maxSteps)
+  {
+    const double stop = nextEvent < events.size() ? std::min(options.endTime, events[nextEvent].time) : options.endTime;
+    double stepDt = dt;
+    bool clipped = false;
+    if (transient.time() + stepDt > stop - 1e-9 * stepDt)
+    {
+      stepDt = stop - transient.time();
+      clipped = true;
+    }
+    const bool forced = !options.adaptive || stepDt <= options.dtMin * (1.0 + 1e-9);
+    KineticsStep info = transient.step(stepDt, forced);
+    result.krylovIterations += info.krylovIterations;
+    result.innerIterations += info.innerIterations;
+    if (!info.accepted)
+    {
+      ++result.rejected;
+      result.steps.push_back(info);
+      dt = std::max(options.dtMin, stepDt * 0.5);
+      goodSteps = 0;
+      continue;
+    }
+    ++result.accepted;
+    if (info.power > result.peakPower)
+    {
+      result.peakPower = info.power;
+      result.peakTime = info.time;
+    }
+
+    // Lépésköz növelés: ha két egymás utáni lépés hibája a duplázás után is a tolerancián belül maradna
+    if (options.adaptive && !clipped)
+    {
+      if (info.error * growthFactor < 0.8 * options.tolerance)
+      {
+        if (++goodSteps >= 2 && dt * 2.0 <= options.dtMax * (1.0 + 1e-9))
+        {
+          dt *= 2.0;
+          goodSteps = 0;
+        }
+      }
+      else
+      {
+        goodSteps = 0;
+      }
+    }
+
+    // Események a lépés végén: új keresztmetszetek, a lépésköz a kezdőértékre áll vissza
+    while (nextEvent < events.size() && events[nextEvent].time <= transient.time() + timeEps)
+    {
+      transient.apply(events[nextEvent++].change);
+      ++result.events;
+      info.event = true;
+      dt = options.dt;
+      goodSteps = 0;
+    }
+    result.steps.push_back(info);
+  }
+  if (transient.time() < options.endTime - timeEps)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A tranziens a lépésszám korlát miatt t = " << transient.time() << " s-nál leállt.\n";
+  }
+  result.finalTime = transient.time();
+  result.finalPower = 1.0;
+  for (std::vector<KineticsStep>::const_reverse_iterator it = result.steps.rbegin(); it != result.steps.rend(); ++it)
+  {
+    if (it->accepted)
+    {
+      result.finalPower = it->power;
+      break;
+    }
+  }
+  result.flux = transient.flux();
+  result.totalMs = elapsed_ms(start);
+}
+
+void write_kinetics_history(const std::string &path, const KineticsResult &result)
+{
+  std::ofstream out(path);
+  if (!out)
+  {
+    throw KineticsError("Nem sikerült megnyitni a tranziens napló fájlt: " + path);
+  }
+  out << "step,time,dt,power,error,accepted,event,krylov_iterations,inner_iterations,rebuilt,build_ms,ms\n";
+  out.precision(10);
+  for (std::size_t s = 0; s < result.steps.size(); ++s)
+  {
+    const KineticsStep &step = result.steps[s];
+    out << s + 1 << "," << step.time << "," << step.dt << "," << step.power << "," << step.error << ","
+        << (step.accepted ? 1 : 0) << "," << (step.event ? 1 : 0) << "," << step.krylovIterations << ","
+        << step.innerIterations << "," << (step.rebuilt ? 1 : 0) << "," << step.buildMs << "," << step.ms << "\n";
+  }
+}
@@ -0,0 +1,131 @@
+#ifndef KINETICS_HPP
+#define KINETICS_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "eigen.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "perturbation.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Időfüggő diffúzió késő neutron anyamagokkal (theta-módszer).
+//
+//   (1/v_g) dphi_g/dt = -(A - S) phi + (1 - beta) F phi / k0 + sum_j lambda_j c_j
+//   dc_j/dt          = beta_j F phi / k0 - lambda_j c_j
+//
+// A kiinduló állapot a stacionárius sajátérték megoldás; a hasadás k0-lal osztva kritikus. Az anyamag
+// vektorok csoportonként a késő neutronok kibocsátását tárolják a végeselem súlyfüggvényekkel vett
+// integrálként (c_j[g] ~ int chi_g C_j w_i), így a lineáris, helyi anyamag egyenlet pontosan ugyanazt a
+// F operátort használja, mint a hasadás, és nem kell tömegmátrixot invertálni.
+//
+// Egy lépésben az anyamagok kiküszöbölése után a
+//   B phi - c F phi / k0 = rhs,  B = diag(V / (v theta dt)) + (A - S),  c = (1 - beta) + theta sum_j lambda_j b_j
+// rendszert FGMRES oldja meg, a B csoportonkénti (vagy csatolt) megoldásával prekondicionálva. B csak dt-től
+// függ: az eltolt csoport mátrixok és a rájuk épített belső megoldó (prekondicionáló, Cholesky faktor)
+// lépéshosszonként egyszer épül fel, és egy kis gyorsítótárból újrahasználódik. Az adaptív lépésköz ezért
+// a kezdő dt kettő hatványszorosain mozog. Keresztmetszet változás (esemény) csak az esemény időpontjában
+// jár új assembly-vel.
+
+class KineticsError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class KineticsParseError : public KineticsError
+{
+public:
+  KineticsParseError(std::size_t line, const std::string &message)
+      : KineticsError(message), m_line(line)
+  {
+  }
+
+  std::size_t line() const noexcept { return m_line; }
+
+private:
+  std::size_t m_line = 0;
+};
+
+// Egy időpontban bekövetkező (lépcsős) keresztmetszet változás
+struct KineticsEvent
+{
+  double time = 0.0;
+  XsPerturbation change;
+};
+
+// Esemény lista beolvasása. Soronként (üres sor és # komment megengedett):
+//   idő név zóna mennyiség csoport [cél_csoport] rel|abs érték
+// ugyanazzal a perturbáció formátummal, mint a perturbation_file; időrendbe rendezve.
+void load_kinetics_events(const std::string &path, std::vector<KineticsEvent> &events);
+
+struct KineticsOptions
+{
+  double endTime = 1.0;      // [s]
+  double dt = 1e-3;          // kezdő lépésköz (eseményenként ide áll vissza)
+  double theta = 1.0;        // 1 = implicit Euler, 0.5 = Crank–Nicolson
+  bool adaptive = true;
+  double tolerance = 1e-3;   // becsült lokális relatív hiba lépésenként
+  double dtMin = 1e-6;
+  double dtMax = 0.1;
+  int maxSteps = 100000;     // elfogadott + elutasított lépések
+  double solverTol = 1e-8;   // FGMRES relatív reziduum
+  int restart = 30;          // FGMRES újraindítási hossz
+  int maxIterations = 300;
+  double innerTol = 1e-4;    // a prekondicionáló belső megoldásainak toleranciája
+  int cacheSize = 3;         // egyszerre megtartott lépéshosszonkénti operátorok
+};
+
+KineticsOptions read_kinetics_options(const SolverConfig &config);
+
+// Egy (elfogadott vagy elutasított) lépés
+struct KineticsStep
+{
+  double time = 0.0;         // a lépés végének ideje
+  double dt = 0.0;
+  double power = 0.0;        // relatív teljesítmény (teljes hasadási produkció / kezdeti)
+  double error = 0.0;        // becsült lokális hiba
+  int krylovIterations = 0;
+  long innerIterations = 0;
+  bool accepted = true;
+  bool rebuilt = false;      // új lépéshosszhoz épült operátor (nem a gyorsítótárból jött)
+  bool event = false;        // a lépés végén esemény (keresztmetszet változás) következett
+  double ms = 0.0;           // a lépés teljes ideje (az esetleges felépítéssel együtt)
+  double buildMs = 0.0;
+};
+
+struct KineticsResult
+{
+  std::vector<KineticsStep> steps;
+  double finalTime = 0.0;
+  double finalPower = 0.0;
+  double peakPower = 0.0;
+  double peakTime = 0.0;
+  int accepted = 0;
+  int rejected = 0;
+  int solverBuilds = 0;      // lépéshosszonkénti operátor felépítések
+  int cacheHits = 0;
+  int events = 0;
+  long krylovIterations = 0;
+  long innerIterations = 0;
+  double totalMs = 0.0;
+  double buildMs = 0.0;
+  double assemblyMs = 0.0;   // események miatti újra-assembly
+  double solveMs = 0.0;
+  std::vector<std::vector<double>> flux; // a végső fluxus
+};
+
+// Tranziens a stacionárius megoldásból (steady.keff, steady.flux). A config a belső megoldó beállításait adja
+// (a lépésoperátorok ugyanazzal a make_group_solver-rel épülnek).
+void solve_kinetics(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model, const DiffusionSystem &system,
+                    const SolverConfig &config, const EigenResult &steady, const std::vector<KineticsEvent> &events,
+                    const KineticsOptions &options, KineticsResult &result);
+
+// Lépésenkénti napló CSV-be
+void write_kinetics_history(const std::string &path, const KineticsResult &result);
+
+#endif // KINETICS_HPP
@@ -1,7 +1,29 @@
 #include "mesh.hpp"
 #include "xs.hpp"
+#include "xs_kernels.hpp"
 #include "model.hpp"
 #include "control.hpp"
+#include "assembly.hpp"
+#include "batch.hpp"
+#include "cmfd.hpp"
+#include "depletion.hpp"
+#include "eigen.hpp"
+#include "fixed_source.hpp"
+#include "heat.hpp"
+#include "homogenization.hpp"
+#include "inner_solver.hpp"
+#include "kinetics.hpp"
+#include "matrix_free.hpp"
+#include "moc.hpp"
+#include "monte_carlo.hpp"
+#include "modes.hpp"
+#include "perturbation.hpp"
+#include "pin_power.hpp"
+#include "server.hpp"
+#include "sn.hpp"
+#include "startup.hpp"
+#include "parallel.hpp"
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <map>
@@ -51,6 +73,21 @@ static void print_group_values(const std::string &label, const std::vector<doubl
   std::cout << "\n";
 }
 
+// XS konzisztencia hiba bitjeinek szöveges leírása
+static std::string describe_xs_flags(unsigned char flags)
+{
+  std::string text;
+  if (flags & XS_FLAG_BALANCE)
+    text += " sigma_a+sum(sigma_s)>sigma_t";
+  if (flags & XS_FLAG_NEGATIVE)
+    text += " negatív érték";
+  if (flags & XS_FLAG_TRANSPORT)
+    text += " sigma_tr<=0";
+  if (flags & XS_FLAG_CHI)
+    text += " sum(chi)!=1";
+  return text;
+}
+
 static std::map<int, XsMaterial::SPtr> build_phys_xs_map(const Mesh &mesh, const XsLibrary &library)
 {
   std::map<int, XsMaterial::SPtr> mapping;
@@ -105,13 +142,20 @@ int main(int argc, char **argv)
   ControlConfig control;
   loadControl(controlPath, control);
 
-  // Mesh parsing időmérés kezdés
-  auto meshStart = std::chrono::steady_clock::now();
+  // Szálak száma (0 = hardware_concurrency); az indítási fázisok is már ezen a készleten futnak
+  set_thread_count(control.solver.getInt("threads", 0));
 
+  // Bemenetek: háló, XS és model beolvasás párhuzamosan, utána XS fordítás és háló–XS keresztellenőrzés.
+  // A hibák a megszokott sorrendben (háló, XS, model) és üzenettel jelennek meg.
   Mesh M;
+  XsLibrary xsLibrary;
+  ModelLibrary modelLibrary;
+  InputLoading loading;
+  load_inputs(meshPath, xsPath, modelPath, M, xsLibrary, modelLibrary, loading);
+
   try
   {
-    load_msh2(meshPath, M);
+    loading.rethrow(loading.meshStage);
   }
   catch (const MeshParseError &ex)
   {
@@ -129,9 +173,8 @@ int main(int argc, char **argv)
     return 1;
   }
 
-  // Mesh parsing időmérés vége
-  auto meshEnd = std::chrono::steady_clock::now();
-  auto meshDuration = std::chrono::duration_cast<std::chrono::milliseconds>(meshEnd - meshStart);
+  // Mesh parsing idő (a beolvasási fázisból)
+  const std::chrono::milliseconds meshDuration(static_cast<long long>(loading.graph.stage(loading.meshStage).ms));
 
   // Mesh verbosity lekérdezése
   const int meshVerbosity = control.getEffectiveVerbosity(control.meshOutput);
@@ -275,21 +318,25 @@ int main(int argc, char **argv)
     std::cout << "  Elemek: " << nodeCount << " nodes, " << M.tris.size() << " triangles, " << M.lines.size() << " lines\n";
   }
 
-  // XS parsing időmérés kezdés
-  auto xsStart = std::chrono::steady_clock::now();
-
-  XsLibrary xsLibrary;
   try
   {
-    load_xs(xsPath, xsLibrary);
+    loading.rethrow(loading.xsStage);
+    loading.rethrow(loading.compileStage);
 
-    // XS parsing időmérés vége
-    auto xsEnd = std::chrono::steady_clock::now();
-    auto xsDuration = std::chrono::duration_cast<std::chrono::milliseconds>(xsEnd - xsStart);
+    // XS parsing idő (a beolvasási fázisból)
+    const std::chrono::milliseconds xsDuration(static_cast<long long>(loading.graph.stage(loading.xsStage).ms));
 
     // XS verbosity lekérdezése
     const int xsVerbosity = control.getEffectiveVerbosity(control.xsOutput);
 
+    // Nem fizikai keresztmetszetek jelzése (compile_xs már ellenőrizte, verbosity-től függetlenül kiírjuk)
+    for (const XsConsistencyIssue &issue : xsLibrary.compiled.issues)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] Nem fizikai keresztmetszet: "
+                << xsLibrary.materials[static_cast<std::size_t>(issue.material)].name
+                << " (csoport " << issue.group + 1 << "):" << describe_xs_flags(issue.flags) << "\n";
+    }
+
     // HA XS verbosity >= 1, akkor kezdünk kiírni dolgokat
     if (xsVerbosity >= 1 && xsVerbosity <= 4)
     {
@@ -336,6 +383,14 @@ int main(int argc, char **argv)
           print_group_values("nu_sigma_f", mat.nu_sigma_f);
           print_group_values("chi", mat.chi);
 
+          // Verbosity >= 3: származtatott csoportállandók
+          if (xsVerbosity >= 3)
+          {
+            print_group_values("D", mat.diffusion);
+            print_group_values("sigma_r", mat.sigma_r);
+            print_group_values("sigma_s_out", mat.sigma_s_out);
+          }
+
           // Verbosity >= 3 VAGY scatter_matrix flag: Scatter mátrix
           if (xsVerbosity >= 3 || control.xsOutput.getFlag("scatter_matrix"))
           {
@@ -369,6 +424,35 @@ int main(int argc, char **argv)
         }
       }
 
+      // Késő neutron adatok (verbosity >= 2)
+      if (xsVerbosity >= 2 && xsLibrary.kinetics.present())
+      {
+        std::cout << "\n  Késő neutron családok: " << xsLibrary.kinetics.family_count() << ", beta = "
+                  << std::setprecision(6) << xsLibrary.kinetics.beta_total() << std::defaultfloat << "\n";
+      }
+
+      // Kiégési nuklidok (verbosity >= 2)
+      if (xsVerbosity >= 2 && xsLibrary.depletion.present())
+      {
+        std::cout << "\n  Kiégési nuklidok: " << xsLibrary.depletion.nuclides.size() << " (";
+        for (std::size_t i = 0; i < xsLibrary.depletion.nuclides.size(); ++i)
+        {
+          std::cout << (i > 0 ? " " : "") << xsLibrary.depletion.nuclides[i].name;
+        }
+        std::cout << ")\n";
+      }
+
+      // Hőmérséklet visszacsatolás (verbosity >= 2)
+      if (xsVerbosity >= 2 && !xsLibrary.feedback.empty())
+      {
+        std::cout << "\n  Hőmérséklet visszacsatolás: " << xsLibrary.feedback.size() << " anyag (";
+        for (std::size_t i = 0; i < xsLibrary.feedback.size(); ++i)
+        {
+          std::cout << (i > 0 ? " " : "") << xsLibrary.feedback[i].material << "@" << xsLibrary.feedback[i].referenceTemperature << "K";
+        }
+        std::cout << ")\n";
+      }
+
       // Verbosity >= 2: Fizikai csoport → anyag hozzárendelés
       std::map<int, XsMaterial::SPtr> physToXs = build_phys_xs_map(M, xsLibrary);
       if (xsVerbosity >= 2 && !physToXs.empty())
@@ -435,6 +519,8 @@ int main(int argc, char **argv)
         std::cout << "  Fájl méret: " << std::fixed << std::setprecision(2) << getFileSizeMB(xsPath) << " MB\n";
         std::cout << "  Anyagok száma: " << xsLibrary.materials.size() << "\n";
         std::cout << "  Peremfeltételek száma: " << xsLibrary.boundaries.size() << "\n";
+        std::cout << "  XS kernelek: " << (xs_kernels::is_specialized(xsLibrary.energyGroupCount) ? "fix G specializáció" : "generikus")
+                  << " (G=" << xsLibrary.energyGroupCount << "; MOC forrás, blokk mátrixok)\n";
       }
     } // XS verbosity >= 1 && <= 4 vége
 
@@ -463,17 +549,12 @@ int main(int argc, char **argv)
     return 1;
   }
 
-  // Model parsing időmérés kezdés
-  auto modelStart = std::chrono::steady_clock::now();
-
-  ModelLibrary modelLibrary;
   try
   {
-    loadModel(modelPath, modelLibrary);
+    loading.rethrow(loading.modelStage);
 
-    // Model parsing időmérés vége
-    auto modelEnd = std::chrono::steady_clock::now();
-    auto modelDuration = std::chrono::duration_cast<std::chrono::milliseconds>(modelEnd - modelStart);
+    // Model parsing idő (a beolvasási fázisból)
+    const std::chrono::milliseconds modelDuration(static_cast<long long>(loading.graph.stage(loading.modelStage).ms));
 
     // Model verbosity lekérdezése
     const int modelVerbosity = control.getEffectiveVerbosity(control.modelOutput);
@@ -536,6 +617,10 @@ int main(int argc, char **argv)
           const Mixture &mixture = modelLibrary.mixtures[i];
           std::cout << "    [Mixture: " << mixture.name << "]\n";
           std::cout << "      density: " << mixture.density << " g/cm³\n";
+          if (mixture.conductivity > 0.0)
+          {
+            std::cout << "      conductivity: " << mixture.conductivity << " W/(cm K)\n";
+          }
 
           // Verbosity >= 3 VAGY mixture_details flag: Komponensek részletesen
           if (modelVerbosity >= 3 || control.modelOutput.getFlag("mixture_details"))
@@ -665,6 +750,1343 @@ int main(int argc, char **argv)
     return 1;
   }
 
+  const int solverVerbosity = control.getEffectiveVerbosity(control.solverOutput);
+  if (solverVerbosity >= 4)
+  {
+    std::cout << "\n[DEBUG] Indítási fázisok (" << thread_count() << " szál):\n";
+    std::cout << "  " << std::left << std::setw(22) << "Fázis" << std::right << std::setw(12) << "Kezdés [ms]"
+              << std::setw(11) << "Idő [ms]" << std::setw(7) << "Szál" << "\n";
+    for (const StageGraph::Stage &stage : loading.graph.stages())
+    {
+      // setw bájtot számol: az ékezetes nevek szélessége a karakterszámhoz igazítva
+      const std::size_t extraBytes = static_cast<std::size_t>(
+          std::count_if(stage.name.begin(), stage.name.end(), [](char ch) { return (ch & 0xC0) == 0x80; }));
+      std::cout << "  " << std::left << std::setw(static_cast<int>(22 + extraBytes)) << stage.name << std::right
+                << std::fixed << std::setprecision(2) << std::setw(12) << stage.startMs << std::setw(11) << stage.ms
+                << std::setw(7) << stage.thread << std::defaultfloat << "\n";
+    }
+    std::cout << "  Falióra idő: " << std::fixed << std::setprecision(2) << loading.graph.wall_ms()
+              << " ms (fázisok összesen " << loading.graph.serial_ms() << " ms, kritikus út "
+              << loading.graph.critical_path_ms() << " ms)\n" << std::defaultfloat;
+  }
+
+  // --- Diffúziós operátor felépítése ---
+  DiffusionSystem diffusion;
+  try
+  {
+    loading.rethrow(loading.validateStage);
+    assemble_diffusion(M, xsLibrary, loading.elementMaterial, diffusion);
+  }
+  catch (const AssemblyError &ex)
+  {
+    std::cerr << "Assembly hiba: " << ex.what() << "\n";
+    return 1;
+  }
+
+  if (solverVerbosity >= 1)
+  {
+    std::cout << "\n[4] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    std::cout << "      DIFFUSION ASSEMBLY\n";
+    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    if (solverVerbosity <= 4)
+    {
+      std::cout << "[OK] P1 operátor felépítve:\n";
+      std::cout << "  Ismeretlenek csoportonként: " << diffusion.nodeCount << "\n";
+      std::cout << "  Nem nulla elemek (közös mintázat): " << diffusion.pattern->nnz() << "\n";
+      std::cout << "  Csoport mátrixok: " << diffusion.groupMatrix.size()
+                << ", szórási csatolások: " << diffusion.scatter.size()
+                << ", hasadási csatolások: " << diffusion.fission.size() << "\n";
+      std::cout << "  Vákuum (Marshak) perem élek: " << diffusion.vacuumLines.size() << "\n";
+    }
+    if (solverVerbosity >= 2)
+    {
+      std::cout << "  Elem színek: " << diffusion.coloring.color_count() << ", szálak: " << thread_count() << "\n";
+    }
+    if (solverVerbosity >= 4)
+    {
+      std::cout << "\n[DEBUG] Assembly fázisok:\n";
+      std::cout << std::fixed << std::setprecision(2);
+      std::cout << "  Geometria + anyagok: " << diffusion.timings.geometryMs << " ms\n";
+      std::cout << "  CSR mintázat: " << diffusion.timings.patternMs << " ms\n";
+      std::cout << "  Színezés: " << diffusion.timings.coloringMs << " ms\n";
+      std::cout << "  Numerikus összegzés: " << diffusion.timings.numericMs << " ms\n";
+      std::cout << "  Perem (Marshak): " << diffusion.timings.boundaryMs << " ms\n";
+      std::cout << "  Összesen: " << diffusion.timings.totalMs << " ms\n";
+      std::cout << "  Memória: " << static_cast<double>(diffusion.memory_bytes()) / (1024.0 * 1024.0) << " MB\n";
+      std::cout << std::defaultfloat;
+    }
+  }
+
+  // --- Számítás a választott módban ---
+  const std::string mode = control.solver.getString("mode", "eigenvalue");
+
+  // Mátrixmentes operátor csak ha kell (spmv matrix_free vagy benchmark)
+  std::unique_ptr<MatrixFreeOperator> matrixFree;
+  if (mode == "benchmark" || control.solver.getString("spmv", "sell") == "matrix_free")
+  {
+    matrixFree.reset(new MatrixFreeOperator(M, xsLibrary, diffusion));
+  }
+
+  if (mode == "eigenvalue")
+  {
+    EigenResult eigen;
+    try
+    {
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const EigenOptions eigenOptions = read_eigen_options(control.solver);
+
+      // Durva hálós gyorsítás (cmfd on): pin cellák a fizikai csoportok komponenseiből
+      const CmfdOptions cmfdOptions = read_cmfd_options(control.solver);
+      std::unique_ptr<CmfdAccelerator> cmfd;
+      if (cmfdOptions.enabled)
+      {
+        try
+        {
+          cmfd.reset(new CmfdAccelerator(M, diffusion, build_coarse_mesh(M, diffusion, cmfdOptions), cmfdOptions));
+        }
+        catch (const CmfdError &ex)
+        {
+          std::cerr << "[FIGYELMEZTETÉS] CMFD kikapcsolva: " << ex.what() << "\n";
+        }
+      }
+      solve_eigenvalue(diffusion, *inner, eigenOptions, eigen, cmfd.get());
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      K-EIGENVALUE (" << eigenOptions.acceleration << ", " << inner->name() << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << (eigen.converged ? "[OK] " : "[FIGYELMEZTETÉS] Nem konvergált! ")
+                  << "k-eff = " << std::fixed << std::setprecision(6) << eigen.keff << std::defaultfloat << "\n";
+        std::cout << "  Külső iterációk: " << eigen.outerIterations << "\n";
+        std::cout << "  Belső iterációk összesen: " << eigen.innerIterations << " (" << eigen.innerSolves << " megoldás)\n";
+        if (eigen.dominanceRatio > 0.0)
+        {
+          std::cout << "  Becsült dominancia arány: " << eigen.dominanceRatio << "\n";
+        }
+        if (cmfd)
+        {
+          const CoarseMesh &coarse = cmfd->coarse();
+          std::cout << "  CMFD: " << coarse.cellCount << " durva cella (" << coarse.mergedCells << " összevont pin, "
+                    << coarse.splitCells << " rácscella, rácsállandó " << std::fixed << std::setprecision(2)
+                    << coarse.cellSize << std::defaultfloat << "), " << eigen.cmfdSteps << " lépés, "
+                    << eigen.cmfdIterations << " durva iteráció\n";
+        }
+      }
+
+      // Vegyes pontosság: ugyanaz a számítás teljes double úton, gyorsulás és k-eff eltérés
+      if (control.solver.getString("precision", "double") == "single" && control.solver.getBool("precision_compare", false))
+      {
+        SolverConfig doubleConfig = control.solver;
+        doubleConfig.options["precision"] = "double";
+        GroupSolver::UPtr reference = make_group_solver(diffusion, doubleConfig, matrixFree.get());
+        EigenResult referenceEigen;
+        solve_eigenvalue(diffusion, *reference, eigenOptions, referenceEigen, cmfd.get());
+        if (solverVerbosity >= 1)
+        {
+          std::cout << "  Vegyes pontosság összevetés (referencia: " << reference->name() << "):\n";
+          std::cout << "    k-eff (double): " << std::fixed << std::setprecision(6) << referenceEigen.keff
+                    << ", eltérés: " << std::setprecision(3) << (eigen.keff - referenceEigen.keff) * 1e5 << " pcm\n";
+          std::cout << std::setprecision(2) << "    Belső megoldó idő: " << eigen.innerMs << " ms (single) / "
+                    << referenceEigen.innerMs << " ms (double), gyorsulás: "
+                    << (eigen.innerMs > 0.0 ? referenceEigen.innerMs / eigen.innerMs : 0.0) << "x\n";
+          std::cout << "    Belső iterációk: " << eigen.innerIterations << " / " << referenceEigen.innerIterations << "\n";
+          std::cout << "    Előkészített adatok: " << static_cast<double>(inner->setup_memory_bytes()) / (1024.0 * 1024.0)
+                    << " MB / " << static_cast<double>(reference->setup_memory_bytes()) / (1024.0 * 1024.0) << " MB\n";
+          std::cout << std::defaultfloat;
+        }
+      }
+      if (solverVerbosity >= 3)
+      {
+        std::cout << "  Iterációk (k, forrás reziduum):\n";
+        for (std::size_t i = 0; i < eigen.kHistory.size(); ++i)
+        {
+          std::cout << "    " << i + 1 << ": " << std::setprecision(8) << eigen.kHistory[i] << "  "
+                    << std::scientific << std::setprecision(3) << eigen.sourceResidual[i] << std::defaultfloat << "\n";
+        }
+      }
+      // Belső reziduum történetek (inner_history on esetén)
+      const std::string historyPath = control.solver.getString("inner_history_file", "");
+      if (!historyPath.empty() && !inner->history().empty())
+      {
+        write_inner_history(historyPath, inner->history());
+      }
+      if (solverVerbosity >= 3 && !inner->history().empty())
+      {
+        std::cout << "  Belső megoldások (csoport: iterációk, végső reziduum):\n";
+        for (std::size_t s = 0; s < inner->history().size(); ++s)
+        {
+          const InnerHistory &h = inner->history()[s];
+          std::cout << "    " << s + 1 << ". " << (h.group >= 0 ? "g" + std::to_string(h.group + 1) : std::string("csatolt"))
+                    << ": " << h.residuals.size() - 1 << " it, "
+                    << std::scientific << std::setprecision(3) << h.residuals.back() << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Sajátérték számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Belső megoldó előkészítés: " << inner->setup_ms() << " ms, "
+                  << static_cast<double>(inner->setup_memory_bytes()) / (1024.0 * 1024.0) << " MB\n";
+        const std::vector<std::string> details = inner->setup_details();
+        for (std::size_t g = 0; g < details.size(); ++g)
+        {
+          if (!details[g].empty())
+          {
+            std::cout << "    g" << g + 1 << ": " << details[g] << "\n";
+          }
+        }
+        std::cout << "  Összesen: " << eigen.totalMs << " ms\n";
+        std::cout << "  Belső megoldó: " << eigen.innerMs << " ms\n";
+        if (cmfd)
+        {
+          const CoarseMesh &coarse = cmfd->coarse();
+          std::cout << "  CMFD: " << eigen.cmfdMs << " ms (cellák felépítése " << coarse.buildMs << " ms, "
+                    << coarse.componentCount << " fizikai komponens, " << cmfd->unknowns() << " durva ismeretlen, "
+                    << static_cast<double>(cmfd->memory_bytes()) / (1024.0 * 1024.0) << " MB)\n";
+        }
+        std::cout << "  Külső iterációnként átlag: "
+                  << (eigen.outerIterations > 0 ? eigen.totalMs / eigen.outerIterations : 0.0) << " ms\n";
+        std::cout << std::defaultfloat;
+      }
+
+      // Pin teljesítmények és reakciógyakoriságok (pin_power on)
+      const PinPowerOptions pinOptions = read_pin_power_options(control.solver);
+      if (pinOptions.enabled)
+      {
+        try
+        {
+          const PinLattice lattice = identify_pins(M, pinOptions);
+          PinPowerResult pinPower;
+          tally_pins(M, xsLibrary, diffusion, lattice, eigen.flux, pinPower);
+          if (solverVerbosity >= 1)
+          {
+            std::cout << "  Pin teljesítmények (" << pinOptions.group << "): " << lattice.pins.size() << " pin, rácsállandó "
+                      << std::fixed << std::setprecision(3) << lattice.pitch << " cm, elforgatás " << std::setprecision(1)
+                      << lattice.rotation << " fok, legnagyobb eltérés a rácsponttól " << std::setprecision(3)
+                      << lattice.maxOffset << " cm\n";
+            if (pinPower.peakPin >= 0)
+            {
+              const Pin &peak = lattice.pins[static_cast<std::size_t>(pinPower.peakPin)];
+              std::cout << "  Csúcstényező: " << std::setprecision(4) << pinPower.peaking << " (" << pinPower.peakPin + 1
+                        << ". pin, q = " << peak.q << ", r = " << peak.r << ", gyűrű " << peak.ring
+                        << "), legkisebb: " << pinPower.minimum << "\n";
+            }
+            // Hatszögtérkép: soronként a relatív teljesítmények, a rácspozíció szerint behúzva
+            if (lattice.pitch > 0.0)
+            {
+              const int width = 6;
+              int minOffset = 0;
+              for (std::size_t p = 0; p < lattice.pins.size(); ++p)
+              {
+                minOffset = p == 0 ? 2 * lattice.pins[p].q + lattice.pins[p].r
+                                   : std::min(minOffset, 2 * lattice.pins[p].q + lattice.pins[p].r);
+              }
+              std::cout << std::setprecision(3);
+              for (std::size_t p = 0; p < lattice.pins.size(); ++p)
+              {
+                const Pin &pin = lattice.pins[p];
+                int column = 0;
+                if (p == 0 || lattice.pins[p - 1].r != pin.r)
+                {
+                  std::cout << (p == 0 ? "  " : "\n  ");
+                  column = (2 * pin.q + pin.r - minOffset) * width / 2;
+                }
+                else
+                {
+                  column = (pin.q - lattice.pins[p - 1].q - 1) * width;
+                }
+                std::cout << std::string(static_cast<std::size_t>(column), ' ') << std::setw(width) << pinPower.power[p];
+              }
+              std::cout << "\n";
+            }
+            std::cout << std::defaultfloat;
+          }
+          if (solverVerbosity >= 2)
+          {
+            std::cout << "  " << std::left << std::setw(16) << "Fiz. csoport" << std::right << std::setw(13) << "Terület";
+            for (int g = 0; g < diffusion.groupCount; ++g)
+            {
+              std::cout << std::setw(13) << "fluxus g" + std::to_string(g + 1);
+            }
+            std::cout << std::setw(14) << "abszorpció" << std::setw(14) << "produkció" << "\n";
+            for (const ReactionTally &region : pinPower.regions)
+            {
+              std::cout << "  " << std::left << std::setw(16) << region.name << std::right << std::fixed << std::setprecision(4)
+                        << std::setw(12) << region.area << std::scientific << std::setprecision(4);
+              for (double value : region.flux)
+              {
+                std::cout << std::setw(13) << value;
+              }
+              std::cout << std::setw(13) << region.absorption << std::setw(13) << region.fission << std::defaultfloat << "\n";
+            }
+          }
+          if (solverVerbosity >= 3)
+          {
+            std::cout << "  " << std::setw(5) << "Pin" << std::setw(5) << "q" << std::setw(5) << "r" << std::setw(9) << "gyűrű"
+                      << std::setw(11) << "x" << std::setw(11) << "y" << std::setw(11) << "P / P_átl" << std::setw(14)
+                      << "abszorpció" << "\n";
+            for (std::size_t p = 0; p < lattice.pins.size(); ++p)
+            {
+              const Pin &pin = lattice.pins[p];
+              std::cout << "  " << std::setw(5) << p + 1 << std::setw(5) << pin.q << std::setw(5) << pin.r << std::setw(7)
+                        << pin.ring << std::fixed << std::setprecision(3) << std::setw(11) << pin.x << std::setw(11) << pin.y
+                        << std::setprecision(4) << std::setw(10) << pinPower.power[p] << std::scientific
+                        << std::setprecision(4) << std::setw(13) << pinPower.pins[p].absorption << std::defaultfloat << "\n";
+            }
+          }
+          if (solverVerbosity >= 4)
+          {
+            std::cout << "  Pin felismerés: " << std::fixed << std::setprecision(2) << lattice.buildMs << " ms, tally: "
+                      << pinPower.tallyMs << " ms\n" << std::defaultfloat;
+          }
+        }
+        catch (const PinPowerError &ex)
+        {
+          std::cerr << "Pin teljesítmény hiba: " << ex.what() << "\n";
+          return 1;
+        }
+      }
+
+      // Homogenizált csoportállandók és diszkontinuitási tényezők (homogenize on)
+      const HomogenizationOptions homogenizationOptions = read_homogenization_options(control.solver);
+      if (homogenizationOptions.enabled)
+      {
+        try
+        {
+          HomogenizationResult homogenized;
+          homogenize(M, xsLibrary, modelLibrary, diffusion, eigen.flux, homogenizationOptions, homogenized);
+          if (!homogenizationOptions.file.empty())
+          {
+            write_homogenized_library(homogenizationOptions.file, xsLibrary, homogenized);
+          }
+          if (solverVerbosity >= 1)
+          {
+            std::cout << "  Homogenizálás (" << homogenizationOptions.regions << "): " << homogenized.regions.size()
+                      << " régió, " << std::fixed << std::setprecision(2) << homogenized.ms << " ms"
+                      << (homogenizationOptions.file.empty() ? std::string() : ", kiírva: " + homogenizationOptions.file)
+                      << "\n" << std::defaultfloat;
+            for (const HomogenizedRegion &region : homogenized.regions)
+            {
+              const XsMaterial &material = region.material;
+              std::cout << "  " << material.name << " (" << region.elements << " elem, " << std::fixed << std::setprecision(4)
+                        << region.area << " cm^2), k_inf = " << std::setprecision(6) << region.kInfinity << "\n";
+              std::cout << "    " << std::setw(4) << "g" << std::setw(13) << "fluxus" << std::setw(13) << "sigma_t"
+                        << std::setw(13) << "sigma_a" << std::setw(13) << "nu_sigma_f" << std::setw(13) << "chi"
+                        << std::setw(13) << "ADF" << "\n";
+              for (std::size_t g = 0; g < material.sigma_t.size(); ++g)
+              {
+                std::cout << "    " << std::setw(4) << g + 1 << std::scientific << std::setprecision(5) << std::setw(13)
+                          << region.flux[g] << std::setw(13) << material.sigma_t[g] << std::setw(13) << material.sigma_a[g]
+                          << std::setw(13) << material.nu_sigma_f[g] << std::setw(13) << material.chi[g] << std::fixed
+                          << std::setprecision(5) << std::setw(13);
+                if (region.total.length > 0.0)
+                {
+                  std::cout << region.total.adf[g];
+                }
+                else
+                {
+                  std::cout << "-";
+                }
+                std::cout << std::defaultfloat << "\n";
+              }
+              if (solverVerbosity >= 2)
+              {
+                for (const DiscontinuityFactors &side : region.sides)
+                {
+                  std::cout << "    ADF oldal (normális " << std::fixed << std::setprecision(0) << side.angle << " fok, "
+                            << std::setprecision(3) << side.length << " cm):" << std::setprecision(5);
+                  for (double value : side.adf)
+                  {
+                    std::cout << " " << value;
+                  }
+                  std::cout << std::defaultfloat << "\n";
+                }
+              }
+            }
+          }
+        }
+        catch (const HomogenizationError &ex)
+        {
+          std::cerr << "Homogenizálás hiba: " << ex.what() << "\n";
+          return 1;
+        }
+      }
+
+      // Adjungált számítás és perturbációk (adjoint on, vagy perturbation_file megadásával)
+      const std::string perturbationPath = control.solver.getString("perturbation_file", "");
+      if (control.solver.getBool("adjoint", false) || !perturbationPath.empty())
+      {
+        const DiffusionSystem adjointSystem = make_adjoint_system(diffusion);
+        // A csoport mátrixok azonosak, így a csoportonkénti megoldó (és előkészítése) újrahasználható;
+        // a csatolt megoldó a szórási blokkokat is tartalmazza, annak új felépítés kell
+        GroupSolver::UPtr adjointInner;
+        if (inner->coupled())
+        {
+          adjointInner = make_group_solver(adjointSystem, control.solver, matrixFree.get());
+        }
+        GroupSolver &adjointSolver = adjointInner ? *adjointInner : *inner;
+        std::unique_ptr<CmfdAccelerator> adjointCmfd;
+        if (cmfd)
+        {
+          adjointCmfd.reset(new CmfdAccelerator(M, adjointSystem, cmfd->coarse(), cmfdOptions));
+        }
+        EigenOptions adjointOptions = eigenOptions;
+        adjointOptions.reverseSweep = true;
+        EigenResult adjoint;
+        adjoint.keff = eigen.keff;
+        solve_eigenvalue(adjointSystem, adjointSolver, adjointOptions, adjoint, adjointCmfd.get());
+
+        if (solverVerbosity >= 1)
+        {
+          std::cout << "\n[6] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+          std::cout << "      ADJOINT / PERTURBATION\n";
+          std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+          std::cout << (adjoint.converged ? "[OK] " : "[FIGYELMEZTETÉS] Nem konvergált! ")
+                    << "k-eff (adjungált) = " << std::fixed << std::setprecision(6) << adjoint.keff
+                    << ", eltérés a direkttől: " << std::setprecision(3) << (adjoint.keff - eigen.keff) * 1e5 << " pcm\n"
+                    << std::defaultfloat;
+          std::cout << "  Külső iterációk: " << adjoint.outerIterations << ", belső iterációk: " << adjoint.innerIterations
+                    << ", idő: " << std::fixed << std::setprecision(2) << adjoint.totalMs << " ms\n" << std::defaultfloat;
+        }
+
+        if (!perturbationPath.empty())
+        {
+          try
+          {
+            std::vector<XsPerturbation> perturbations;
+            load_perturbations(perturbationPath, perturbations);
+            // Nem konvergált adjungálttal a súlyozott integrálok (és így a drho értékek) tetszőlegesen rosszak lehetnek
+            if (!adjoint.converged)
+            {
+              throw PerturbationError("Az adjungált számítás nem konvergált (" + std::to_string(adjoint.outerIterations) +
+                                      " külső iteráció), a perturbációs hatások nem számolhatók. Növeld a max_outer "
+                                      "vagy a group_sweeps értékét, vagy válts gyorsítást (acceleration).");
+            }
+            const PerturbationIntegrals integrals = compute_perturbation_integrals(M, diffusion, eigen.flux, adjoint.flux);
+            const std::vector<PerturbationResult> results =
+                evaluate_perturbations(M, xsLibrary, modelLibrary, integrals, eigen.keff, perturbations);
+
+            // Ellenőrzés: perturbált könyvtárral új direkt számítás (warm start), pontos drho = 1/k - 1/k'
+            const bool check = control.solver.getBool("perturbation_check", false);
+            std::vector<double> exact(results.size(), 0.0);
+            if (check)
+            {
+              for (std::size_t p = 0; p < perturbations.size(); ++p)
+              {
+                const XsLibrary changed = perturbed_library(M, xsLibrary, modelLibrary, perturbations[p]);
+                DiffusionSystem changedSystem;
+                assemble_diffusion(M, changed, changedSystem);
+                GroupSolver::UPtr changedInner = make_group_solver(changedSystem, control.solver, nullptr);
+                EigenResult changedEigen;
+                changedEigen.keff = eigen.keff;
+                changedEigen.flux = eigen.flux;
+                solve_eigenvalue(changedSystem, *changedInner, eigenOptions, changedEigen);
+                exact[p] = 1.0 / eigen.keff - 1.0 / changedEigen.keff;
+              }
+            }
+
+            if (solverVerbosity >= 1)
+            {
+              std::cout << "  Perturbációk: " << results.size() << " (" << integrals.physIds.size()
+                        << " régió integráljai egy elemenkénti menetben, " << std::fixed << std::setprecision(2)
+                        << integrals.computeMs << " ms)\n";
+              std::cout << "  " << std::left << std::setw(19) << "Név" << std::setw(19) << "Zóna" << std::setw(13) << "Mennyiség"
+                        << std::right << std::setw(14) << "drho [pcm]";
+              if (check)
+              {
+                std::cout << std::setw(14) << "pontos [pcm]" << std::setw(16) << "eltérés";
+              }
+              std::cout << "\n";
+              for (std::size_t p = 0; p < results.size(); ++p)
+              {
+                std::cout << "  " << std::left << std::setw(18) << results[p].name << std::setw(18) << perturbations[p].target
+                          << std::setw(12) << perturbations[p].quantity << std::right << std::fixed << std::setprecision(3)
+                          << std::setw(14) << results[p].deltaRho * 1e5;
+                if (check)
+                {
+                  std::cout << std::setw(14) << exact[p] * 1e5 << std::setw(14) << (results[p].deltaRho - exact[p]) * 1e5;
+                }
+                std::cout << "\n";
+              }
+              std::cout << std::defaultfloat;
+            }
+          }
+          catch (const PerturbationParseError &ex)
+          {
+            std::cerr << "Perturbáció beolvasási hiba (sor " << ex.line() << "): " << ex.what() << "\n";
+            return 1;
+          }
+          catch (const PerturbationError &ex)
+          {
+            std::cerr << "Perturbáció hiba: " << ex.what() << "\n";
+            return 1;
+          }
+        }
+      }
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "modes")
+  {
+    // Magasabb lambda-módusok (blokk Krylov–Schur), ugyanazzal a belső megoldóval
+    try
+    {
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const ModeOptions modeOptions = read_mode_options(control.solver);
+      ModeResult modes;
+      solve_modes(diffusion, *inner, modeOptions, modes);
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      LAMBDA-MÓDUSOK (Krylov–Schur, blokk " << modeOptions.block << ", " << inner->name() << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << (modes.converged ? "[OK] " : "[FIGYELMEZTETÉS] Nem konvergált! ") << modes.modes.size()
+                  << " módus, " << modes.restarts << " újraindítás, bázis " << modes.basisSize << "\n";
+        std::cout << "  " << std::setw(4) << "#" << std::setw(14) << "k" << std::setw(12) << "Im k" << std::setw(13)
+                  << "k_i / k_1" << std::setw(13) << "Reziduum" << std::setw(13) << "Becslés" << "\n";
+        for (std::size_t i = 0; i < modes.modes.size(); ++i)
+        {
+          const EigenMode &m = modes.modes[i];
+          std::cout << "  " << std::setw(4) << i + 1 << std::fixed << std::setprecision(8) << std::setw(14) << m.k
+                    << std::setprecision(5) << std::setw(12) << m.kImag << std::setprecision(6) << std::setw(13)
+                    << m.k / modes.modes[0].k << std::scientific << std::setprecision(3) << std::setw(13) << m.residual
+                    << std::setw(13) << m.estimate << std::defaultfloat << (m.converged ? "" : "  (nem konvergált)") << "\n";
+        }
+        std::cout << "  Operátor alkalmazások: " << modes.applications << " vektor, " << modes.blockApplications
+                  << " blokk; belső iterációk: " << modes.innerIterations << " (" << modes.innerSolves << " megoldás)\n";
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Módus számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Belső megoldó előkészítés: " << inner->setup_ms() << " ms\n";
+        std::cout << "  Összesen: " << modes.totalMs << " ms\n";
+        std::cout << "  Operátor (belső megoldó + hasadási forrás): " << modes.operatorMs << " ms\n";
+        std::cout << "  Ortogonalizálás: " << modes.orthogonalizeMs << " ms\n";
+        std::cout << "  Projektált feladat + újraindítás: " << modes.restartMs << " ms\n";
+        std::cout << "  Reziduum ellenőrzés: " << modes.residualMs << " ms\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const ModeError &ex)
+    {
+      std::cerr << "Módus számítás hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "kinetics")
+  {
+    // Tranziens a stacionárius megoldásból: késő neutron anyamagok, theta-módszer, adaptív lépésköz
+    try
+    {
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const EigenOptions eigenOptions = read_eigen_options(control.solver);
+      EigenResult steady;
+      solve_eigenvalue(diffusion, *inner, eigenOptions, steady);
+      if (!steady.converged)
+      {
+        std::cerr << "[FIGYELMEZTETÉS] A kiinduló sajátérték számítás nem konvergált.\n";
+      }
+
+      const KineticsOptions kineticsOptions = read_kinetics_options(control.solver);
+      std::vector<KineticsEvent> events;
+      const std::string eventPath = control.solver.getString("transient_file", "");
+      if (!eventPath.empty())
+      {
+        load_kinetics_events(eventPath, events);
+      }
+      KineticsResult transient;
+      solve_kinetics(M, xsLibrary, modelLibrary, diffusion, control.solver, steady, events, kineticsOptions, transient);
+      const std::string outputPath = control.solver.getString("transient_output", "");
+      if (!outputPath.empty())
+      {
+        write_kinetics_history(outputPath, transient);
+      }
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      TRANZIENS (theta = " << kineticsOptions.theta << ", " << inner->name() << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "[OK] Kiinduló állapot: k-eff = " << std::fixed << std::setprecision(6) << steady.keff
+                  << ", késő neutron hányad = " << xsLibrary.kinetics.beta_total() << " ("
+                  << xsLibrary.kinetics.family_count() << " család)\n";
+        std::cout << "  Események: " << transient.events << ", lépések: " << transient.accepted << " elfogadott, "
+                  << transient.rejected << " elutasított, t = " << std::setprecision(4) << transient.finalTime << " s\n";
+        std::cout << "  Relatív teljesítmény: végén " << std::setprecision(5) << transient.finalPower << ", csúcs "
+                  << transient.peakPower << " (t = " << std::setprecision(4) << transient.peakTime << " s)\n";
+        std::cout << "  Lépésoperátorok: " << transient.solverBuilds << " felépítés, " << transient.cacheHits
+                  << " újrahasználat; FGMRES iterációk: " << transient.krylovIterations << ", belső iterációk: "
+                  << transient.innerIterations << "\n";
+        std::cout << std::defaultfloat;
+
+        // Lépésenkénti táblázat: verbosity >= 3 esetén minden lépés, egyébként legfeljebb kb. 20 sor
+        const std::size_t stride = solverVerbosity >= 3 ? 1 : std::max<std::size_t>(1, transient.steps.size() / 20);
+        std::cout << "  " << std::setw(6) << "Lépés" << std::setw(13) << "t [s]" << std::setw(12) << "dt [s]"
+                  << std::setw(13) << "P / P0" << std::setw(11) << "Hiba" << std::setw(8) << "Kryl." << std::setw(10)
+                  << "ms" << "\n";
+        for (std::size_t i = 0; i < transient.steps.size(); ++i)
+        {
+          const KineticsStep &step = transient.steps[i];
+          if (i % stride != 0 && i + 1 != transient.steps.size() && !step.event && step.accepted)
+          {
+            continue;
+          }
+          std::cout << "  " << std::setw(5) << i + 1 << std::fixed << std::setprecision(6) << std::setw(13) << step.time
+                    << std::scientific << std::setprecision(2) << std::setw(12) << step.dt << std::fixed
+                    << std::setprecision(6) << std::setw(13) << step.power << std::scientific << std::setprecision(2)
+                    << std::setw(11) << step.error << std::setw(8) << step.krylovIterations << std::fixed
+                    << std::setprecision(2) << std::setw(10) << step.ms << std::defaultfloat
+                    << (step.accepted ? "" : "  elutasítva") << (step.event ? "  esemény" : "")
+                    << (step.rebuilt ? "  új operátor" : "") << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Tranziens időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Kiinduló sajátérték: " << steady.totalMs << " ms\n";
+        std::cout << "  Tranziens összesen: " << transient.totalMs << " ms\n";
+        std::cout << "  Lépések megoldása: " << transient.solveMs << " ms ("
+                  << (transient.accepted + transient.rejected > 0 ? transient.solveMs / (transient.accepted + transient.rejected) : 0.0)
+                  << " ms / lépés)\n";
+        std::cout << "  Lépésoperátor felépítés: " << transient.buildMs << " ms\n";
+        std::cout << "  Események újra-assembly: " << transient.assemblyMs << " ms\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const KineticsParseError &ex)
+    {
+      std::cerr << "Esemény fájl beolvasási hiba (sor " << ex.line() << "): " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const KineticsError &ex)
+    {
+      std::cerr << "Tranziens hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const PerturbationError &ex)
+    {
+      std::cerr << "Tranziens esemény hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "fixed_source")
+  {
+    // Külső forrású (szubkritikus) számítás ugyanazzal az operátorral és belső megoldóval
+    try
+    {
+      const std::string sourcePath = control.solver.getString("source_file", "");
+      if (sourcePath.empty())
+      {
+        throw FixedSourceError("A fix forrású számításhoz meg kell adni a source_file kulcsot.");
+      }
+      std::vector<ZoneSource> sources;
+      load_sources(sourcePath, sources);
+      std::vector<std::vector<double>> source;
+      build_source_vector(M, modelLibrary, diffusion, sources, source);
+
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const FixedSourceOptions fixedOptions = read_fixed_source_options(control.solver);
+      FixedSourceResult fixed;
+      solve_fixed_source(M, xsLibrary, diffusion, *inner, source, fixedOptions, fixed);
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      FIX FORRÁS (gyorsítás " << fixedOptions.acceleration << ", " << inner->name() << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << (fixed.converged ? "[OK] Konvergált " : "[FIGYELMEZTETÉS] Nem konvergált! ") << fixed.iterations
+                  << " menet, reziduum " << std::scientific << std::setprecision(3) << fixed.residual
+                  << ", átlagos csökkenés menetenként " << std::fixed << std::setprecision(4) << fixed.convergenceRate
+                  << "\n";
+        std::cout << "  Forrás: " << std::scientific << std::setprecision(5) << fixed.sourceTotal
+                  << ", hasadási keltés: " << fixed.production << std::fixed << std::setprecision(5)
+                  << ", sokszorozás: " << fixed.multiplication << ", k_s = " << fixed.kSource << "\n";
+        std::cout << "  Belső iterációk: " << fixed.innerIterations << " (" << fixed.innerSolves << " megoldás)";
+        if (fixedOptions.acceleration == "tg")
+        {
+          std::cout << ", egycsoportos korrekció: " << fixed.coarseIterations << " iteráció";
+        }
+        std::cout << std::defaultfloat << "\n";
+      }
+      if (solverVerbosity >= 3)
+      {
+        for (std::size_t i = 0; i < fixed.residualHistory.size(); ++i)
+        {
+          std::cout << "  Menet " << std::setw(4) << i + 1 << ": reziduum = " << std::scientific << std::setprecision(4)
+                    << fixed.residualHistory[i] << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Fix forrás számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Belső megoldó előkészítés: " << inner->setup_ms() << " ms\n";
+        std::cout << "  Összesen: " << fixed.totalMs << " ms\n";
+        std::cout << "  Belső megoldó: " << fixed.innerMs << " ms\n";
+        std::cout << "  Kétrácsos gyorsítás (spektrum, egycsoportos mátrix, korrekciók): " << fixed.coarseMs << " ms\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const FixedSourceParseError &ex)
+    {
+      std::cerr << "Forrás fájl beolvasási hiba (sor " << ex.line() << "): " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const FixedSourceError &ex)
+    {
+      std::cerr << "Fix forrás hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "sn")
+  {
+    // Diszkrét ordináta transzport referencia (DFEM SN), összevetve a diffúziós megoldással
+    try
+    {
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const EigenOptions eigenOptions = read_eigen_options(control.solver);
+      EigenResult reference;
+      solve_eigenvalue(diffusion, *inner, eigenOptions, reference);
+
+      const SnOptions snOptions = read_sn_options(control.solver);
+      SnTransport transport(M, xsLibrary, diffusion, control.solver, snOptions);
+      SnResult sn;
+      transport.solve(snOptions, sn);
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      SN TRANSZPORT (DFEM, " << transport.direction_count() << " irány, "
+                  << (snOptions.dsa ? "DSA" : "DSA nélkül") << ", párhuzamosítás: " << transport.parallel_mode() << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << (sn.converged ? "[OK] " : "[FIGYELMEZTETÉS] Nem konvergált! ") << "k-eff (SN) = " << std::fixed
+                  << std::setprecision(6) << sn.keff << ", diffúzió: " << reference.keff << ", eltérés: "
+                  << std::setprecision(1) << (1.0 / reference.keff - 1.0 / sn.keff) * 1e5 << " pcm\n";
+        std::cout << "  Külső iterációk: " << sn.outerIterations << ", csoport söprések: " << sn.sweeps
+                  << ", DSA megoldások: " << sn.dsaSolves << " (" << sn.dsaIterations << " iteráció)\n";
+        std::cout << "  Söprési ütemterv: átlagosan " << std::setprecision(1) << transport.average_levels()
+                  << " hullámfront irányonként, legszélesebb " << transport.max_level_width() << " elem, késleltetett élek: "
+                  << transport.lagged_edges() << "; peremek: " << transport.vacuum_edges() << " vákuum, "
+                  << transport.reflective_edges() << " tükröző él\n";
+        std::cout << std::defaultfloat;
+
+        // Fizikai csoportonkénti átlagfluxus (egységnyi produkcióra), transzport / diffúzió
+        const std::vector<SnRegionComparison> regions = compare_region_flux(M, diffusion, sn, reference.flux);
+        std::cout << "  " << std::left << std::setw(16) << "Régió" << std::right << std::setw(6) << "Csop."
+                  << std::setw(14) << "SN" << std::setw(14) << "Diffúzió" << std::setw(11) << "SN / D" << "\n";
+        for (const SnRegionComparison &r : regions)
+        {
+          for (std::size_t g = 0; g < r.transport.size(); ++g)
+          {
+            std::cout << "  " << std::left << std::setw(16) << (g == 0 ? r.name : "") << std::right << std::setw(6)
+                      << g + 1 << std::scientific << std::setprecision(5) << std::setw(14) << r.transport[g]
+                      << std::setw(14) << r.diffusion[g] << std::fixed << std::setprecision(4) << std::setw(11)
+                      << (r.diffusion[g] != 0.0 ? r.transport[g] / r.diffusion[g] : 0.0) << std::defaultfloat << "\n";
+          }
+        }
+      }
+      if (solverVerbosity >= 3)
+      {
+        for (std::size_t i = 0; i < sn.kHistory.size(); ++i)
+        {
+          std::cout << "  SN külső " << std::setw(4) << i + 1 << ": k = " << std::fixed << std::setprecision(8)
+                    << sn.kHistory[i] << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] SN számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Diffúziós referencia: " << reference.totalMs << " ms\n";
+        std::cout << "  Előkészítés (szomszédság, kvadratúra, söprési ütemterv, DSA megoldó): " << transport.setup_ms()
+                  << " ms\n";
+        std::cout << "  SN összesen: " << sn.totalMs << " ms\n";
+        std::cout << "  Söprések: " << sn.sweepMs << " ms (" << (sn.sweeps > 0 ? sn.sweepMs / sn.sweeps : 0.0)
+                  << " ms / söprés)\n";
+        std::cout << "  DSA: " << sn.dsaMs << " ms\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const SnError &ex)
+    {
+      std::cerr << "SN transzport hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "moc")
+  {
+    // Karakterisztikák módszere: a sugárkészlet (vagy a gyorsítótára) a hálóhoz tartozik, az XS-től független
+    try
+    {
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const EigenOptions eigenOptions = read_eigen_options(control.solver);
+      EigenResult reference;
+      solve_eigenvalue(diffusion, *inner, eigenOptions, reference);
+
+      const MocTrackOptions trackOptions = read_moc_track_options(control.solver);
+      const MocOptions mocOptions = read_moc_options(control.solver);
+      const MocTracking tracking(M, trackOptions);
+      if (tracking.missed_regions() > 0)
+      {
+        std::cerr << "[FIGYELMEZTETÉS] " << tracking.missed_regions()
+                  << " háromszögön nem halad át sugár (a moc_spacing csökkentése javít rajta).\n";
+      }
+      MocResult moc;
+      moc.flux = element_average_flux(M, reference.flux);
+      moc.keff = reference.keff;
+      solve_moc(M, tracking, xsLibrary, diffusion, mocOptions, moc);
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      MOC TRANSZPORT (" << 2 * tracking.azimuth_count() << " azimut x " << mocOptions.polar
+                  << " polár, exp: " << mocOptions.exponential << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << (moc.converged ? "[OK] " : "[FIGYELMEZTETÉS] Nem konvergált! ") << "k-eff (MOC) = " << std::fixed
+                  << std::setprecision(6) << moc.keff << ", diffúzió: " << reference.keff << ", eltérés: "
+                  << std::setprecision(1) << (1.0 / reference.keff - 1.0 / moc.keff) * 1e5 << " pcm\n";
+        std::cout << "  Söprések: " << moc.iterations << "\n";
+        std::cout << "  Sugarak: " << tracking.track_count() << ", szegmensek: " << tracking.segment_count() << " ("
+                  << std::setprecision(2) << tracking.memory_bytes() / (1024.0 * 1024.0) << " MB), "
+                  << (tracking.loaded_from_cache() ? "gyorsítótárból" : "sugárkövetés") << ", max térfogat korrekció: "
+                  << std::setprecision(3) << 100.0 * tracking.max_volume_correction() << " %\n";
+        if (mocOptions.exponential == "table")
+        {
+          std::cout << "  Exponenciális táblázat mért max hibája: " << std::scientific << std::setprecision(2)
+                    << moc.expMaxError << "\n";
+        }
+        std::cout << std::defaultfloat;
+
+        const std::vector<SnRegionComparison> regions = compare_region_flux(M, diffusion, moc, reference.flux);
+        std::cout << "  " << std::left << std::setw(16) << "Régió" << std::right << std::setw(6) << "Csop."
+                  << std::setw(14) << "MOC" << std::setw(14) << "Diffúzió" << std::setw(11) << "MOC / D" << "\n";
+        for (const SnRegionComparison &r : regions)
+        {
+          for (std::size_t g = 0; g < r.transport.size(); ++g)
+          {
+            std::cout << "  " << std::left << std::setw(16) << (g == 0 ? r.name : "") << std::right << std::setw(6)
+                      << g + 1 << std::scientific << std::setprecision(5) << std::setw(14) << r.transport[g]
+                      << std::setw(14) << r.diffusion[g] << std::fixed << std::setprecision(4) << std::setw(11)
+                      << (r.diffusion[g] != 0.0 ? r.transport[g] / r.diffusion[g] : 0.0) << std::defaultfloat << "\n";
+          }
+        }
+      }
+      if (solverVerbosity >= 3)
+      {
+        for (std::size_t i = 0; i < moc.kHistory.size(); ++i)
+        {
+          std::cout << "  MOC söprés " << std::setw(4) << i + 1 << ": k = " << std::fixed << std::setprecision(8)
+                    << moc.kHistory[i] << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] MOC számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Diffúziós referencia: " << reference.totalMs << " ms\n";
+        std::cout << "  Sugárkövetés" << (tracking.loaded_from_cache() ? " (gyorsítótár betöltés)" : "") << ": "
+                  << tracking.trace_ms() << " ms\n";
+        std::cout << "  MOC összesen: " << moc.totalMs << " ms\n";
+        std::cout << "  Söprések: " << moc.sweepMs << " ms ("
+                  << (moc.iterations > 0 ? moc.sweepMs / moc.iterations : 0.0) << " ms / söprés, "
+                  << std::setprecision(1)
+                  << (moc.sweepMs > 0.0 ? 2e-3 * static_cast<double>(tracking.segment_count()) * moc.iterations / moc.sweepMs : 0.0)
+                  << " M szegmens / s)\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const MocError &ex)
+    {
+      std::cerr << "MOC transzport hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "monte_carlo")
+  {
+    // Monte Carlo referencia a pontos háromszög geometrián, összevetve a diffúziós megoldással
+    try
+    {
+      GroupSolver::UPtr inner = make_group_solver(diffusion, control.solver, matrixFree.get());
+      const EigenOptions eigenOptions = read_eigen_options(control.solver);
+      EigenResult reference;
+      solve_eigenvalue(diffusion, *inner, eigenOptions, reference);
+
+      const MonteCarloOptions mcOptions = read_monte_carlo_options(control.solver);
+      const MonteCarlo monteCarlo(M, xsLibrary, diffusion);
+      MonteCarloResult mc;
+      monteCarlo.run(mcOptions, mc);
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      MONTE CARLO (delta követés, " << mcOptions.particles << " részecske x "
+                  << mcOptions.batches - mcOptions.inactive << " aktív ciklus, " << thread_count() << " szál)\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "[OK] k-eff (MC, ütközési) = " << std::fixed << std::setprecision(6) << mc.keff << " +/- "
+                  << std::setprecision(1) << mc.keffStd / mc.keff * 1e5 << " pcm, abszorpciós: " << std::setprecision(6)
+                  << mc.keffAbsorption << " +/- " << std::setprecision(1)
+                  << mc.keffAbsorptionStd / mc.keffAbsorption * 1e5 << " pcm\n";
+        std::cout << "  Diffúzió: " << std::setprecision(6) << reference.keff << ", eltérés: " << std::setprecision(1)
+                  << (1.0 / reference.keff - 1.0 / mc.keff) * 1e5 << " pcm\n";
+        std::cout << "  Teljesítmény: " << std::setprecision(0) << mc.particlesPerSecond << " részecske / s, "
+                  << mc.collisionsPerSecond << " ütközés / s (valódi: " << std::setprecision(1)
+                  << (mc.collisions > 0 ? 100.0 * static_cast<double>(mc.realCollisions) / static_cast<double>(mc.collisions) : 0.0)
+                  << " %), kiszökött: " << mc.leaked << ", elveszett: " << mc.lost << "\n";
+        std::cout << std::defaultfloat;
+        if (mc.lost > 0)
+        {
+          std::cerr << "[FIGYELMEZTETÉS] " << mc.lost << " részecske geometriai hiba miatt elveszett.\n";
+        }
+
+        const std::vector<SnRegionComparison> regions = compare_region_flux(M, diffusion, mc, reference.flux);
+        std::cout << "  " << std::left << std::setw(16) << "Régió" << std::right << std::setw(6) << "Csop."
+                  << std::setw(14) << "MC" << std::setw(10) << "rel. hiba" << std::setw(14) << "Diffúzió"
+                  << std::setw(11) << "MC / D" << "\n";
+        for (std::size_t i = 0; i < regions.size(); ++i)
+        {
+          const SnRegionComparison &r = regions[i];
+          for (std::size_t g = 0; g < r.transport.size(); ++g)
+          {
+            std::cout << "  " << std::left << std::setw(16) << (g == 0 ? r.name : "") << std::right << std::setw(6)
+                      << g + 1 << std::scientific << std::setprecision(5) << std::setw(14) << r.transport[g]
+                      << std::fixed << std::setprecision(2) << std::setw(9) << 100.0 * mc.regions[i].relativeError[g]
+                      << "%" << std::scientific << std::setprecision(5) << std::setw(14) << r.diffusion[g] << std::fixed
+                      << std::setprecision(4) << std::setw(11)
+                      << (r.diffusion[g] != 0.0 ? r.transport[g] / r.diffusion[g] : 0.0) << std::defaultfloat << "\n";
+          }
+        }
+      }
+      if (solverVerbosity >= 3)
+      {
+        // Az entrópia az inaktív ciklusokban mutatja a forrás beállását (ha még változik, kevés az inaktív ciklus)
+        std::cout << "  Forrás entrópia rács: " << mc.entropyGridX << " x " << mc.entropyGridY << " cella\n";
+        for (std::size_t i = 0; i < mc.batchK.size(); ++i)
+        {
+          const bool inactive = static_cast<int>(i) < mcOptions.inactive;
+          std::cout << "  MC ciklus " << std::setw(4) << i + 1 << (inactive ? " (inaktív)" : "") << ": k = " << std::fixed
+                    << std::setprecision(6) << mc.batchK[i];
+          if (inactive)
+          {
+            std::cout << ", forrás entrópia = " << std::setprecision(4) << mc.batchEntropy[i];
+          }
+          std::cout << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Monte Carlo számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Diffúziós referencia: " << reference.totalMs << " ms\n";
+        std::cout << "  Előkészítés (anyag táblák, majoráns, keresőrács): " << monteCarlo.setup_ms() << " ms\n";
+        std::cout << "  MC összesen: " << mc.totalMs << " ms (aktív ciklusok: " << mc.activeMs << " ms)\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const MonteCarloError &ex)
+    {
+      std::cerr << "Monte Carlo hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "depletion")
+  {
+    // Kiégés: régiónként CRAM, prediktor–korrektor lépések, az összetétel visszacsatolva a keresztmetszetekbe
+    try
+    {
+      const DepletionOptions depletionOptions = read_depletion_options(control.solver);
+      DepletionResult burnup;
+      run_depletion(M, xsLibrary, modelLibrary, control.solver, depletionOptions, burnup);
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      KIÉGÉS (CRAM-16, " << (depletionOptions.corrector ? "prediktor–korrektor" : "prediktor")
+                  << ", " << thread_count() << " szál)\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "[OK] Kiégő régiók: " << burnup.regionCount << " (" << burnup.burnableElements << " elem, "
+                  << std::fixed << std::setprecision(4) << burnup.volume << " cm^2), nuklidok: " << burnup.nuclides.size()
+                  << ", mátrix / LU nem nulla: " << burnup.matrixNonzeros << " / " << burnup.luNonzeros << "\n";
+        std::cout << "  Nehézfém: " << std::scientific << std::setprecision(4) << burnup.heavyMetalMass
+                  << " g/cm, fajlagos teljesítmény: " << std::fixed << std::setprecision(2) << depletionOptions.power
+                  << " W/g\n";
+        std::cout << "  " << std::setw(5) << "Lépés" << std::setw(11) << "t [nap]" << std::setw(14) << "MWd/kgHM"
+                  << std::setw(12) << "k-eff" << std::setw(12) << "k (pred.)" << std::setw(12) << "rho [pcm]"
+                  << std::setw(15) << "fluxus szorzó" << "\n";
+        for (std::size_t i = 0; i < burnup.steps.size(); ++i)
+        {
+          const DepletionStep &step = burnup.steps[i];
+          std::cout << "  " << std::setw(5) << i << std::fixed << std::setprecision(2) << std::setw(11) << step.days
+                    << std::setprecision(4) << std::setw(14) << step.burnup << std::setprecision(6) << std::setw(12)
+                    << step.keff << std::setw(12);
+          if (i > 0 && depletionOptions.corrector)
+          {
+            std::cout << step.predictorKeff;
+          }
+          else
+          {
+            std::cout << "-";
+          }
+          std::cout << std::setprecision(1) << std::setw(12) << (1.0 - 1.0 / step.keff) * 1e5 << std::scientific
+                    << std::setprecision(3) << std::setw(15) << step.fluxScale << std::defaultfloat << "\n";
+        }
+
+        // Átlagos összetétel a kezdeti és a végső állapotban
+        const DepletionStep &first = burnup.steps.front();
+        const DepletionStep &last = burnup.steps.back();
+        std::cout << "  " << std::left << std::setw(10) << "Nuklid" << std::right << std::setw(14) << "N0 [1/bcm]"
+                  << std::setw(14) << "N [1/bcm]" << std::setw(12) << "N / N0" << "\n";
+        for (std::size_t i = 0; i < burnup.nuclides.size(); ++i)
+        {
+          std::cout << "  " << std::left << std::setw(10) << burnup.nuclides[i] << std::right << std::scientific
+                    << std::setprecision(4) << std::setw(14) << first.density[i] << std::setw(14) << last.density[i]
+                    << std::fixed << std::setprecision(4) << std::setw(12);
+          if (first.density[i] > 0.0)
+          {
+            std::cout << last.density[i] / first.density[i];
+          }
+          else
+          {
+            std::cout << "-";
+          }
+          std::cout << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 3)
+      {
+        for (std::size_t i = 0; i < burnup.steps.size(); ++i)
+        {
+          std::cout << "  Állapot " << std::setw(3) << i << ":";
+          for (std::size_t j = 0; j < burnup.nuclides.size(); ++j)
+          {
+            std::cout << " " << burnup.nuclides[j] << "=" << std::scientific << std::setprecision(3)
+                      << burnup.steps[i].density[j];
+          }
+          std::cout << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Kiégés időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Összesen: " << burnup.totalMs << " ms\n";
+        std::cout << "  Régió anyagok + assembly: " << burnup.xsMs << " ms\n";
+        std::cout << "  Sajátérték számítások: " << burnup.eigenMs << " ms\n";
+        std::cout << "  CRAM: " << burnup.cramMs << " ms (" << burnup.cramSolves << " régió megoldás, "
+                  << std::setprecision(0)
+                  << (burnup.cramMs > 0.0 ? static_cast<double>(burnup.cramSolves) / (burnup.cramMs * 1e-3) : 0.0)
+                  << " régió / s)\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const DepletionError &ex)
+    {
+      std::cerr << "Kiégés hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const AssemblyError &ex)
+    {
+      std::cerr << "Kiégés assembly hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "feedback")
+  {
+    // Csatolt neutronika–hővezetés: hőmérséklet visszacsatolás a keresztmetszetekre (Picard / Anderson)
+    try
+    {
+      const HeatOptions heatOptions = read_heat_options(control.solver);
+      const FeedbackOptions feedbackOptions = read_feedback_options(control.solver);
+      FeedbackResult coupled;
+      run_feedback(M, xsLibrary, modelLibrary, control.solver, heatOptions, feedbackOptions, coupled);
+
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      HŐMÉRSÉKLET VISSZACSATOLÁS (" << feedbackOptions.coupling << ", " << thread_count() << " szál)\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "[OK] Hővezetési tartomány: " << coupled.heatElements << " elem, " << coupled.heatNodes
+                  << " csomópont, konvektív perem (" << heatOptions.boundary << "): " << coupled.boundaryLines
+                  << " él, visszacsatolt elemek: " << coupled.feedbackElements << "\n";
+        std::cout << "  Hőforrás: " << std::fixed << std::setprecision(1) << heatOptions.power << " W/cm^3, h = "
+                  << std::setprecision(3) << heatOptions.htc << " W/(cm^2 K), T_hűtő = " << std::setprecision(1)
+                  << heatOptions.coolantTemperature << " K, háló egysége: " << heatOptions.meshUnit << "\n";
+        std::cout << "  " << std::setw(5) << "Iter" << std::setw(12) << "k-eff" << std::setw(14) << "max dT [K]"
+                  << std::setw(14) << "T_átl [K]" << std::setw(14) << "T_max [K]" << std::setw(8) << "külső"
+                  << std::setw(8) << "PCG" << "\n";
+        for (std::size_t i = 0; i < coupled.history.size(); ++i)
+        {
+          const FeedbackIteration &it = coupled.history[i];
+          std::cout << "  " << std::setw(5) << i + 1 << std::fixed << std::setprecision(6) << std::setw(12) << it.keff
+                    << std::scientific << std::setprecision(3) << std::setw(14) << it.change << std::fixed
+                    << std::setprecision(2) << std::setw(14) << it.fuelAverage << std::setw(14) << it.fuelMax
+                    << std::setw(8) << it.outerIterations << std::setw(8) << it.heatIterations << std::defaultfloat << "\n";
+        }
+        std::cout << (coupled.converged ? "[OK] Konvergált: " : "[!] Nem konvergált: ") << coupled.history.size()
+                  << " iteráció, k = " << std::fixed << std::setprecision(6) << coupled.keff << " (kezdő hőmérséklettel "
+                  << coupled.keffInitial << ", visszacsatolás: " << std::setprecision(1)
+                  << (1.0 / coupled.keffInitial - 1.0 / coupled.keff) * 1e5 << " pcm)\n" << std::defaultfloat;
+      }
+      if (solverVerbosity >= 2)
+      {
+        std::cout << "  " << std::left << std::setw(16) << "Régió" << std::right << std::setw(12) << "Terület"
+                  << std::setw(12) << "T_átl [K]" << std::setw(12) << "T_min [K]" << std::setw(12) << "T_max [K]" << "\n";
+        for (const FeedbackRegion &region : coupled.regions)
+        {
+          std::cout << "  " << std::left << std::setw(16) << region.name << std::right << std::fixed << std::setprecision(4)
+                    << std::setw(12) << region.area << std::setprecision(2) << std::setw(12) << region.average
+                    << std::setw(12) << region.minimum << std::setw(12) << region.maximum << std::defaultfloat << "\n";
+        }
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Csatolt számítás időigénye:\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Összesen: " << coupled.totalMs << " ms\n";
+        std::cout << "  Előkészítés (geometria, hővezetési mátrix, IC(0)): " << coupled.setupMs << " ms\n";
+        std::cout << "  XS + assembly: " << coupled.xsMs << " ms\n";
+        std::cout << "  Sajátérték számítások: " << coupled.eigenMs << " ms\n";
+        std::cout << "  Hővezetés (forrás + PCG): " << coupled.heatMs << " ms\n";
+        std::cout << std::defaultfloat;
+      }
+    }
+    catch (const HeatError &ex)
+    {
+      std::cerr << "Hővezetés hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const AssemblyError &ex)
+    {
+      std::cerr << "Visszacsatolás assembly hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "batch")
+  {
+    // Paraméteres esetsorozat közös hálóval és operátor szerkezettel, esetek között párhuzamosan
+    try
+    {
+      const BatchOptions batchOptions = read_batch_options(control.solver);
+      std::vector<BatchCase> cases;
+      load_batch_cases(batchOptions.file, cases);
+      BatchResult batch;
+      run_batch(M, xsLibrary, modelLibrary, diffusion, control.solver, cases, batchOptions, batch);
+      if (!batchOptions.csv.empty())
+      {
+        write_batch_summary(batchOptions.csv, batch);
+      }
+
+      int failed = 0;
+      double caseMs = 0.0;
+      double assemblyMs = 0.0;
+      for (const BatchCaseResult &c : batch.cases)
+      {
+        failed += c.ok ? 0 : 1;
+        caseMs += c.totalMs;
+        assemblyMs += c.assemblyMs;
+      }
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      BATCH (" << batch.cases.size() << " eset, " << batch.workers << " munkás, " << batch.solverName
+                  << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "[OK] Referencia (módosítatlan) k-eff = " << std::fixed << std::setprecision(6) << batch.keffReference
+                  << std::defaultfloat << " (" << batch.referenceOuter << " külső iteráció)\n";
+        const bool pins = std::any_of(batch.cases.begin(), batch.cases.end(),
+                                      [](const BatchCaseResult &c) { return c.peaking > 0.0; });
+        std::cout << "  " << std::left << std::setw(20) << "Eset" << std::right << std::setw(12) << "k-eff"
+                  << std::setw(13) << "drho [pcm]" << std::setw(9) << "külső";
+        if (pins)
+        {
+          std::cout << std::setw(10) << "Fq pin";
+        }
+        std::cout << std::setw(11) << "munkás" << std::setw(13) << "idő [ms]" << "\n";
+        for (const BatchCaseResult &c : batch.cases)
+        {
+          std::cout << "  " << std::left << std::setw(20) << c.name << std::right;
+          if (!c.ok)
+          {
+            std::cout << "  [HIBA] " << c.error << "\n";
+            continue;
+          }
+          std::cout << std::fixed << std::setprecision(6) << std::setw(12) << c.keff << std::setprecision(1)
+                    << std::setw(13) << c.deltaRho * 1e5 << std::setw(8) << c.outerIterations;
+          if (pins)
+          {
+            std::cout << std::setprecision(4) << std::setw(10) << c.peaking;
+          }
+          std::cout << std::setw(10) << (std::to_string(c.worker) + (c.stolen ? "*" : "")) << std::setprecision(2)
+                    << std::setw(12) << c.totalMs << std::defaultfloat << (c.converged ? "" : "  [nem konvergált]") << "\n";
+        }
+        // Az esetidők összege / falióra idő csak az átlagos egyidejűség: időosztásnál (kevés mag) az esetenkénti
+        // idők is megnyúlnak, így ez nem gyorsulás a soros futáshoz képest
+        std::cout << "  Falióra idő: " << std::fixed << std::setprecision(2) << batch.wallMs << " ms (esetek összesen "
+                  << caseMs << " ms, átlagos egyidejűség " << (batch.wallMs > 0.0 ? caseMs / batch.wallMs : 0.0)
+                  << "), lopott esetek: "
+                  << batch.steals << " (*)\n" << std::defaultfloat;
+        if (failed > 0)
+        {
+          std::cout << "[FIGYELMEZTETÉS] " << failed << " eset hibával leállt.\n";
+        }
+      }
+      if (solverVerbosity >= 2)
+      {
+        std::cout << "  Közös szerkezet (geometria, mintázat, színezés): " << std::fixed << std::setprecision(2)
+                  << diffusion.timings.geometryMs + diffusion.timings.patternMs + diffusion.timings.coloringMs
+                  << " ms egyszer; esetenkénti összegzés (egy szálon) átlagosan "
+                  << (batch.cases.empty() ? 0.0 : assemblyMs / static_cast<double>(batch.cases.size())) << " ms (a teljes párhuzamos assembly: "
+                  << diffusion.timings.totalMs << " ms)\n" << std::defaultfloat;
+      }
+      if (solverVerbosity >= 4)
+      {
+        std::cout << "\n[DEBUG] Esetenkénti fázisok [ms]:\n";
+        std::cout << "  " << std::left << std::setw(20) << "Eset" << std::right << std::setw(10) << "XS" << std::setw(10)
+                  << "assembly" << std::setw(11) << "megoldó" << std::setw(15) << "sajátérték" << std::setw(11) << "belső"
+                  << "\n";
+        for (const BatchCaseResult &c : batch.cases)
+        {
+          std::cout << "  " << std::left << std::setw(20) << c.name << std::right << std::fixed << std::setprecision(2)
+                    << std::setw(10) << c.xsMs << std::setw(10) << c.assemblyMs << std::setw(10) << c.setupMs
+                    << std::setw(12) << c.eigenMs << std::setw(10) << c.innerIterations << std::defaultfloat << "\n";
+        }
+        std::cout << "  Referencia + közös előkészítés: " << std::fixed << std::setprecision(2) << batch.referenceMs
+                  << " ms\n" << std::defaultfloat;
+      }
+    }
+    catch (const BatchParseError &ex)
+    {
+      std::cerr << "Esetlista hiba (sor " << ex.line() << "): " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const BatchError &ex)
+    {
+      std::cerr << "Batch hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "server")
+  {
+    // Rezidens mód: a beolvasott bemenetek és a felépített operátor a memóriában maradnak, a kérések soronként jönnek
+    try
+    {
+      const ServerOptions serverOptions = read_server_options(control.solver);
+      // A pin teljesítmények a válasz részei, ha a control fájl külön nem kapcsolja ki
+      SolverConfig serverConfig = control.solver;
+      serverConfig.options.insert(std::make_pair(std::string("pin_power"), std::string("on")));
+      const BatchSession session(M, xsLibrary, modelLibrary, diffusion, serverConfig,
+                                 control.solver.getBool("batch_warm_start", true));
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "      SZERVER (" << session.solver_name() << ")\n";
+        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+        std::cout << "[OK] Referencia k-eff = " << std::fixed << std::setprecision(6) << session.reference().keff
+                  << ", pinek: " << session.pin_count() << ", előkészítés: " << std::setprecision(2) << session.setup_ms()
+                  << " ms" << std::defaultfloat << "\n";
+        std::cout << "  Kérések: " << (serverOptions.socket.empty() ? std::string("standard bemenet")
+                                                                      : "socket " + serverOptions.socket)
+                  << " (solve | pins | reference | status | quit | shutdown)\n" << std::flush;
+      }
+      ServerStats serverStats;
+      run_server(session, serverOptions, serverStats);
+      if (solverVerbosity >= 1)
+      {
+        std::cout << "[OK] Szerver leállt: " << serverStats.requests << " kérés, " << serverStats.solved << " megoldás ("
+                  << std::fixed << std::setprecision(2) << serverStats.solveMs << " ms), " << serverStats.cached
+                  << " tárolt eredmény, " << serverStats.failed << " hiba, " << serverStats.connections << " kapcsolat\n"
+                  << std::defaultfloat;
+      }
+    }
+    catch (const ServerError &ex)
+    {
+      std::cerr << "Szerver hiba: " << ex.what() << "\n";
+      return 1;
+    }
+    catch (const SolverError &ex)
+    {
+      std::cerr << "Megoldó hiba: " << ex.what() << "\n";
+      return 1;
+    }
+  }
+  else if (mode == "benchmark")
+  {
+    // Operátor alkalmazás összevetése: CSR, SELL-C, mátrixmentes
+    const int repeat = control.solver.getInt("benchmark_repeat", 50);
+    const std::vector<OperatorBenchmarkRow> rows = benchmark_operators(diffusion, *matrixFree, repeat);
+    std::cout << "\n[5] ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    std::cout << "      OPERATOR BENCHMARK (" << repeat << " ismétlés, " << thread_count() << " szál)\n";
+    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    std::cout << "  Mátrixmentes kötegek: " << matrixFree->batch_count() << " (" << MatrixFreeOperator::W
+              << " lane), kitöltés: " << std::fixed << std::setprecision(1) << 100.0 * matrixFree->padding_ratio()
+              << " %, előkészítés: " << std::setprecision(2) << matrixFree->setup_ms() << " ms\n";
+    std::cout << "  " << std::left << std::setw(14) << "Formátum" << std::right << std::setw(12) << "Memória MB"
+              << std::setw(14) << "ms / A*x" << std::setw(16) << "Mcsomópont/s" << std::setw(16) << "Rel. eltérés" << "\n";
+    for (const OperatorBenchmarkRow &row : rows)
+    {
+      const double throughput = row.msPerApply > 0.0 ? diffusion.nodeCount / (row.msPerApply * 1000.0) : 0.0;
+      std::cout << "  " << std::left << std::setw(14) << row.format << std::right << std::fixed << std::setprecision(3)
+                << std::setw(12) << static_cast<double>(row.bytes) / (1024.0 * 1024.0) << std::setw(14) << row.msPerApply
+                << std::setw(15) << std::setprecision(1) << throughput << std::setw(15) << std::scientific
+                << std::setprecision(2) << row.maxRelError << std::defaultfloat << "\n";
+    }
+  }
+  else if (mode != "none")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen számítási mód: \"" << mode << "\"\n";
+  }
+
   // Ha bármelyik parser verbosity >= 1, akkor "Kész" üzenet szeparátorral
   if (control.getEffectiveVerbosity(control.meshOutput) >= 1 ||
       control.getEffectiveVerbosity(control.xsOutput) >= 1 ||
@@ -0,0 +1,268 @@
+#include "matrix_free.hpp"
+#include "parallel.hpp"
+#include "sparse.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  // Kötegek párhuzamosításának küszöbe: egy köteg W elem munkája
+  const std::size_t batchGrain = 64;
+}
+
+MatrixFreeOperator::MatrixFreeOperator(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const XsCompiled &xs = library.compiled;
+  m_rows = system.nodeCount;
+  m_groupCount = system.groupCount;
+  m_diffusion = xs.diffusion;
+  m_removal = xs.sigma_r;
+
+  // Színenként anyag szerint rendezett elemlista, anyagváltásnál új köteg
+  const ElementColoring &coloring = system.coloring;
+  m_colorBatchPtr.assign(1, 0);
+  for (int color = 0; color < coloring.color_count(); ++color)
+  {
+    std::vector<int> elements(coloring.order.begin() + coloring.colorPtr[static_cast<std::size_t>(color)],
+                              coloring.order.begin() + coloring.colorPtr[static_cast<std::size_t>(color) + 1]);
+    std::stable_sort(elements.begin(), elements.end(), [&](int a, int b) {
+      return system.elementMaterial[static_cast<std::size_t>(a)] < system.elementMaterial[static_cast<std::size_t>(b)];
+    });
+
+    std::size_t i = 0;
+    while (i < elements.size())
+    {
+      const int material = system.elementMaterial[static_cast<std::size_t>(elements[i])];
+      const std::size_t b = m_batchMaterial.size();
+      m_batchMaterial.push_back(material);
+      m_nodes.resize((b + 1) * 3 * W, 0);
+      m_stiff.resize((b + 1) * 6 * W, 0.0);
+      m_mass.resize((b + 1) * W, 0.0);
+
+      int lane = 0;
+      for (; lane < W && i < elements.size(); ++lane, ++i)
+      {
+        const std::size_t e = static_cast<std::size_t>(elements[i]);
+        if (system.elementMaterial[e] != material)
+        {
+          break;
+        }
+        const Mesh::Tri &t = mesh.tris[e];
+        const ElementGeometry &geo = system.geometry[e];
+        const int nodes[3] = {t.a - 1, t.b - 1, t.c - 1};
+        for (int k = 0; k < 3; ++k)
+        {
+          m_nodes[(b * 3 + static_cast<std::size_t>(k)) * W + static_cast<std::size_t>(lane)] = nodes[k];
+        }
+        const int pairs[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}};
+        for (int q = 0; q < 6; ++q)
+        {
+          const int u = pairs[q][0];
+          const int v = pairs[q][1];
+          m_stiff[(b * 6 + static_cast<std::size_t>(q)) * W + static_cast<std::size_t>(lane)] =
+              geo.area * (geo.b[u] * geo.b[v] + geo.c[u] * geo.c[v]);
+        }
+        m_mass[b * W + static_cast<std::size_t>(lane)] = geo.area / 12.0;
+      }
+      // Kitöltő lane-ek: az első lane csomópontjai nulla együtthatóval (a köteg soros scatter-e miatt biztonságos)
+      for (; lane < W; ++lane)
+      {
+        for (int k = 0; k < 3; ++k)
+        {
+          m_nodes[(b * 3 + static_cast<std::size_t>(k)) * W + static_cast<std::size_t>(lane)] =
+              m_nodes[(b * 3 + static_cast<std::size_t>(k)) * W];
+        }
+      }
+    }
+    m_colorBatchPtr.push_back(static_cast<int>(m_batchMaterial.size()));
+  }
+
+  for (int l : system.vacuumLines)
+  {
+    const Mesh::Line &line = mesh.lines[static_cast<std::size_t>(l)];
+    const Mesh::Node &pa = mesh.nodes[static_cast<std::size_t>(line.a)];
+    const Mesh::Node &pb = mesh.nodes[static_cast<std::size_t>(line.b)];
+    const double length = std::sqrt((pb.x - pa.x) * (pb.x - pa.x) + (pb.y - pa.y) * (pb.y - pa.y));
+    m_vacuumNodes.push_back(line.a - 1);
+    m_vacuumNodes.push_back(line.b - 1);
+    m_vacuumCoeff.push_back(0.5 * length / 6.0);
+  }
+
+  std::vector<char> touched(static_cast<std::size_t>(m_rows), 0);
+  for (const Mesh::Tri &t : mesh.tris)
+  {
+    touched[static_cast<std::size_t>(t.a - 1)] = 1;
+    touched[static_cast<std::size_t>(t.b - 1)] = 1;
+    touched[static_cast<std::size_t>(t.c - 1)] = 1;
+  }
+  for (int i = 0; i < m_rows; ++i)
+  {
+    if (!touched[static_cast<std::size_t>(i)])
+    {
+      m_isolated.push_back(i);
+    }
+  }
+  m_setupMs = elapsed_ms(start);
+}
+
+double MatrixFreeOperator::padding_ratio() const
+{
+  std::size_t empty = 0;
+  for (double m : m_mass)
+  {
+    empty += m == 0.0 ? 1 : 0;
+  }
+  return m_mass.empty() ? 0.0 : static_cast<double>(empty) / static_cast<double>(m_mass.size());
+}
+
+void MatrixFreeOperator::multiply(int group, const std::vector<double> &x, std::vector<double> &y) const
+{
+  const std::size_t n = static_cast<std::size_t>(m_rows);
+  y.resize(n);
+  parallel_for(0, n, [&](std::size_t i) { y[i] = 0.0; });
+  const double *xv = x.data();
+  double *yv = y.data();
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t g = static_cast<std::size_t>(group);
+
+  for (std::size_t color = 0; color + 1 < m_colorBatchPtr.size(); ++color)
+  {
+    parallel_for(
+        static_cast<std::size_t>(m_colorBatchPtr[color]), static_cast<std::size_t>(m_colorBatchPtr[color + 1]),
+        [&](std::size_t b) {
+          const std::size_t mat = static_cast<std::size_t>(m_batchMaterial[b]);
+          const double D = m_diffusion[mat * G + g];
+          const double sr = m_removal[mat * G + g];
+          const int *n0 = &m_nodes[(b * 3 + 0) * W];
+          const int *n1 = &m_nodes[(b * 3 + 1) * W];
+          const int *n2 = &m_nodes[(b * 3 + 2) * W];
+          const double *s = &m_stiff[b * 6 * W];
+          const double *ms = &m_mass[b * W];
+
+          double x0[W], x1[W], x2[W], y0[W], y1[W], y2[W];
+          for (int lane = 0; lane < W; ++lane)
+          {
+            x0[lane] = xv[n0[lane]];
+            x1[lane] = xv[n1[lane]];
+            x2[lane] = xv[n2[lane]];
+          }
+          // Lokális 3x3: D * K_e + sigma_r * M_e, ahol M_e = area/12 * [2 1 1; 1 2 1; 1 1 2]
+          for (int lane = 0; lane < W; ++lane)
+          {
+            const double m = sr * ms[lane];
+            const double msum = m * (x0[lane] + x1[lane] + x2[lane]);
+            const double k00 = D * s[0 * W + lane], k11 = D * s[1 * W + lane], k22 = D * s[2 * W + lane];
+            const double k01 = D * s[3 * W + lane], k02 = D * s[4 * W + lane], k12 = D * s[5 * W + lane];
+            y0[lane] = k00 * x0[lane] + k01 * x1[lane] + k02 * x2[lane] + msum + m * x0[lane];
+            y1[lane] = k01 * x0[lane] + k11 * x1[lane] + k12 * x2[lane] + msum + m * x1[lane];
+            y2[lane] = k02 * x0[lane] + k12 * x1[lane] + k22 * x2[lane] + msum + m * x2[lane];
+          }
+          for (int lane = 0; lane < W; ++lane)
+          {
+            yv[n0[lane]] += y0[lane];
+            yv[n1[lane]] += y1[lane];
+            yv[n2[lane]] += y2[lane];
+          }
+        },
+        batchGrain);
+  }
+
+  // Marshak perem és izolált csomópontok (kevés elem, sorosan)
+  for (std::size_t l = 0; l < m_vacuumCoeff.size(); ++l)
+  {
+    const std::size_t a = static_cast<std::size_t>(m_vacuumNodes[2 * l]);
+    const std::size_t b = static_cast<std::size_t>(m_vacuumNodes[2 * l + 1]);
+    const double c = m_vacuumCoeff[l];
+    yv[a] += c * (2.0 * xv[a] + xv[b]);
+    yv[b] += c * (xv[a] + 2.0 * xv[b]);
+  }
+  for (int i : m_isolated)
+  {
+    yv[i] += xv[i];
+  }
+}
+
+std::size_t MatrixFreeOperator::memory_bytes() const
+{
+  return (m_colorBatchPtr.size() + m_batchMaterial.size() + m_nodes.size() + m_vacuumNodes.size() + m_isolated.size()) * sizeof(int) +
+         (m_stiff.size() + m_mass.size() + m_diffusion.size() + m_removal.size() + m_vacuumCoeff.size()) * sizeof(double);
+}
+
+std::vector<OperatorBenchmarkRow> benchmark_operators(const DiffusionSystem &system, const MatrixFreeOperator &matrixFree,
+                                                      int repeat)
+{
+  const std::size_t n = static_cast<std::size_t>(system.nodeCount);
+  const int G = system.groupCount;
+  repeat = std::max(repeat, 1);
+
+  std::vector<SellMatrix<double>> sell;
+  for (const CsrMatrix &A : system.groupMatrix)
+  {
+    sell.push_back(build_sell<double>(A));
+  }
+
+  std::vector<double> x(n), reference(n), y(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    x[i] = 1.0 + 0.25 * std::sin(static_cast<double>(i) * 0.37);
+  }
+
+  std::vector<OperatorBenchmarkRow> rows(3);
+  rows[0].format = "csr";
+  rows[1].format = "sell";
+  rows[2].format = "matrix-free";
+  rows[0].bytes = system.pattern->memory_bytes();
+  for (int g = 0; g < G; ++g)
+  {
+    rows[0].bytes += system.groupMatrix[static_cast<std::size_t>(g)].memory_bytes();
+    rows[1].bytes += sell[static_cast<std::size_t>(g)].memory_bytes();
+  }
+  rows[2].bytes = matrixFree.memory_bytes();
+
+  for (int g = 0; g < G; ++g)
+  {
+    const CsrMatrix &A = system.groupMatrix[static_cast<std::size_t>(g)];
+    A.multiply(x, reference);
+    double refMax = 0.0;
+    for (double v : reference)
+    {
+      refMax = std::max(refMax, std::fabs(v));
+    }
+
+    for (std::size_t f = 0; f < rows.size(); ++f)
+    {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (int r = 0; r < repeat; ++r)
+      {
+        if (f == 0)
+        {
+          A.multiply(x, y);
+        }
+        else if (f == 1)
+        {
+          sell_multiply(sell[static_cast<std::size_t>(g)], x, y);
+        }
+        else
+        {
+          matrixFree.multiply(g, x, y);
+        }
+      }
+      rows[f].msPerApply += elapsed_ms(start) / static_cast<double>(repeat) / static_cast<double>(G);
+      double diff = 0.0;
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        diff = std::max(diff, std::fabs(y[i] - reference[i]));
+      }
+      rows[f].maxRelError = std::max(rows[f].maxRelError, refMax > 0.0 ? diff / refMax : diff);
+    }
+  }
+  return rows;
+}
@@ -0,0 +1,65 @@
+#ifndef MATRIX_FREE_HPP
+#define MATRIX_FREE_HPP
+
+#include "assembly.hpp"
+#include "mesh.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Mátrixmentes (elemenkénti) P1 diffúziós operátor: y = A_g x közvetlenül a háromszögekből,
+// a cache-elt geometriából és az elemek anyagindexéből, CSR értéktömbök nélkül.
+//
+// Az elemek színenként, azon belül anyag szerint rendezve W széles kötegekbe (batch) kerülnek,
+// SoA elrendezésben: egy kötegben minden elem azonos anyagú, így a D_g és sigma_r,g skalár,
+// a lane-enkénti ciklusok vektorizálhatók. Egy színen belül a kötegek csomópont-diszjunktak,
+// ezért párhuzamosan, zárolás nélkül írhatók vissza (scatter). A geometriai adatok
+// csoportfüggetlenek, csoportonként csak az anyagi együtthatók táblája különbözik.
+class MatrixFreeOperator
+{
+public:
+  static const int W = 8; // köteg szélesség (lane-ek száma)
+
+  MatrixFreeOperator(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system);
+
+  int rows() const { return m_rows; }
+  int group_count() const { return m_groupCount; }
+  std::size_t batch_count() const { return m_batchMaterial.size(); }
+  double padding_ratio() const; // kitöltő (üres) lane-ek aránya
+  double setup_ms() const { return m_setupMs; }
+
+  // y = A_g x
+  void multiply(int group, const std::vector<double> &x, std::vector<double> &y) const;
+
+  std::size_t memory_bytes() const;
+
+private:
+  int m_rows = 0;
+  int m_groupCount = 0;
+  std::vector<int> m_colorBatchPtr;  // színenként a kötegek kezdete (colorCount + 1)
+  std::vector<int> m_batchMaterial;  // kötegenként az anyagindex
+  std::vector<int> m_nodes;          // [b][3][W] ismeretlen indexek
+  std::vector<double> m_stiff;       // [b][6][W] area * grad N_i . grad N_j (00, 11, 22, 01, 02, 12)
+  std::vector<double> m_mass;        // [b][W] area / 12 (kitöltő lane-en 0)
+  std::vector<double> m_diffusion;   // [m * G + g]
+  std::vector<double> m_removal;     // [m * G + g]
+  std::vector<int> m_vacuumNodes;    // vákuum élenként 2 ismeretlen index
+  std::vector<double> m_vacuumCoeff; // vákuum élenként 0.5 * L / 6
+  std::vector<int> m_isolated;       // háromszöghöz nem tartozó ismeretlenek (egységnyi diagonális)
+  double m_setupMs = 0.0;
+};
+
+// SpMV benchmark: CSR, SELL-C és mátrixmentes alkalmazás összevetése csoportonként
+struct OperatorBenchmarkRow
+{
+  std::string format;
+  std::size_t bytes = 0;      // az operátor tárolásának memóriaigénye (minden csoportra)
+  double msPerApply = 0.0;    // egy A_g x átlagos ideje (a csoportokra átlagolva)
+  double maxRelError = 0.0;   // eltérés a CSR eredményhez képest (max |dy| / max |y|)
+};
+
+std::vector<OperatorBenchmarkRow> benchmark_operators(const DiffusionSystem &system, const MatrixFreeOperator &matrixFree,
+                                                      int repeat);
+
+#endif // MATRIX_FREE_HPP
@@ -0,0 +1,1092 @@
+#include "moc.hpp"
+#include "parallel.hpp"
+#include "xs_kernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace
+{
+  const double PI = 3.14159265358979323846;
+  const char CACHE_MAGIC[8] = {'S', 'Z', 'M', 'O', 'C', 'T', 'R', 'K'};
+  const std::uint32_t CACHE_VERSION = 1;
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  std::pair<int, int> edge_key(int a, int b)
+  {
+    return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+  }
+
+  // FNV-1a a csomópont koordinátákon és a háromszögek csúcsain: a gyorsítótár csak ugyanahhoz a hálóhoz töltődik be
+  std::uint64_t mesh_fingerprint(const Mesh &mesh)
+  {
+    std::uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void *data, std::size_t bytes) {
+      const unsigned char *p = static_cast<const unsigned char *>(data);
+      for (std::size_t i = 0; i < bytes; ++i)
+      {
+        h ^= p[i];
+        h *= 1099511628211ull;
+      }
+    };
+    for (const Mesh::Node &n : mesh.nodes)
+    {
+      mix(&n.x, sizeof(double));
+      mix(&n.y, sizeof(double));
+    }
+    for (const Mesh::Tri &t : mesh.tris)
+    {
+      mix(&t.a, sizeof(int));
+      mix(&t.b, sizeof(int));
+      mix(&t.c, sizeof(int));
+    }
+    return h;
+  }
+
+  template <typename T>
+  void write_vector(std::ofstream &out, const std::vector<T> &v)
+  {
+    const std::uint64_t n = v.size();
+    out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+    if (n > 0)
+    {
+      out.write(reinterpret_cast<const char *>(v.data()), static_cast<std::streamsize>(n * sizeof(T)));
+    }
+  }
+
+  template <typename T>
+  bool read_vector(std::ifstream &in, std::vector<T> &v)
+  {
+    std::uint64_t n = 0;
+    if (!in.read(reinterpret_cast<char *>(&n), sizeof(n)) || n > (std::uint64_t(1) << 34) / sizeof(T))
+    {
+      return false;
+    }
+    v.resize(static_cast<std::size_t>(n));
+    return n == 0 || static_cast<bool>(in.read(reinterpret_cast<char *>(v.data()), static_cast<std::streamsize>(n * sizeof(T))));
+  }
+
+  // Egy sugár és egy háromszög közös szakasza a sugár paraméterével (t a kezdőponttól mért hossz)
+  struct Interval
+  {
+    double tIn = 0.0, tOut = 0.0;
+    int region = -1;
+    int entryEdge = -1, exitEdge = -1; // helyi él index (a szemközti csúcs)
+  };
+
+  // 1 - exp(-tau): pontosan, illetve egyenközű táblázatból lineáris interpolációval (húr együtthatók párban)
+  struct ExactExp
+  {
+    double operator()(double tau) const { return 1.0 - std::exp(-tau); }
+  };
+
+  struct TableExp
+  {
+    const double *coef = nullptr; // [2 i] tengelymetszet, [2 i + 1] meredekség
+    double invStep = 0.0;
+    double tauMax = 0.0;
+    int last = 0;
+
+    double operator()(double tau) const
+    {
+      const double t = std::min(tau, tauMax);
+      const int i = std::min(static_cast<int>(t * invStep), last);
+      return coef[2 * i] + coef[2 * i + 1] * t;
+    }
+  };
+
+  // A söpréshez szükséges, iterációnként változatlan adatok
+  struct SweepData
+  {
+    const MocTracking *tracking = nullptr;
+    std::size_t GP = 0;
+    std::size_t P = 0;
+    const double *sigmaOverSin = nullptr; // [e * GP + g * P + p] = sigma_t / sin theta_p
+    const double *polarWeight = nullptr;  // [p] = w_p sin theta_p
+    const int *forwardOut = nullptr;      // sugaranként a tükrözött folytatás (-1: vákuum / nincs)
+    const int *backwardOut = nullptr;
+  };
+
+  template <typename Exp>
+  void sweep_tracks(const SweepData &data, const Exp &expo, const std::vector<double> &sourceOverSigma,
+                    const std::vector<double> &boundaryOld, std::vector<double> &boundaryNew,
+                    std::vector<std::vector<double>> &tallies)
+  {
+    const MocTracking &tracking = *data.tracking;
+    const std::vector<MocTracking::Track> &tracks = tracking.tracks();
+    const std::vector<std::size_t> &ptr = tracking.track_ptr();
+    const MocSegment *segments = tracking.segments().data();
+    const std::size_t GP = data.GP, P = data.P;
+
+    parallel_chunks(
+        0, tracks.size(),
+        [&](int thread, std::size_t begin, std::size_t end) {
+          double *tally = tallies[static_cast<std::size_t>(thread)].data();
+          std::vector<double> psi(GP), weight(GP);
+          for (std::size_t t = begin; t < end; ++t)
+          {
+            const int a = tracks[t].azimuth;
+            const double wa = tracking.azimuth_weight(a) * tracking.azimuth_spacing(a);
+            for (std::size_t gp = 0; gp < GP; ++gp)
+            {
+              weight[gp] = wa * data.polarWeight[gp % P];
+            }
+
+            // Egy szegmens: a csoport x polár index mentén folytonos, független műveletek
+            auto segment = [&](const MocSegment &s) {
+              if (s.region < 0)
+              {
+                std::fill(psi.begin(), psi.end(), 0.0);
+                return;
+              }
+              const std::size_t base = static_cast<std::size_t>(s.region) * GP;
+              const double *sos = data.sigmaOverSin + base;
+              const double *q = sourceOverSigma.data() + base;
+              double *acc = tally + base;
+              const double length = s.length;
+              for (std::size_t gp = 0; gp < GP; ++gp)
+              {
+                const double delta = (psi[gp] - q[gp]) * expo(sos[gp] * length);
+                psi[gp] -= delta;
+                acc[gp] += weight[gp] * delta;
+              }
+            };
+
+            std::copy(boundaryOld.begin() + static_cast<std::ptrdiff_t>(2 * t * GP),
+                      boundaryOld.begin() + static_cast<std::ptrdiff_t>((2 * t + 1) * GP), psi.begin());
+            for (std::size_t i = ptr[t]; i < ptr[t + 1]; ++i)
+            {
+              segment(segments[i]);
+            }
+            if (data.forwardOut[t] >= 0)
+            {
+              std::copy(psi.begin(), psi.end(),
+                        boundaryNew.begin() + static_cast<std::ptrdiff_t>(static_cast<std::size_t>(data.forwardOut[t]) * GP));
+            }
+
+            std::copy(boundaryOld.begin() + static_cast<std::ptrdiff_t>((2 * t + 1) * GP),
+                      boundaryOld.begin() + static_cast<std::ptrdiff_t>((2 * t + 2) * GP), psi.begin());
+            for (std::size_t i = ptr[t + 1]; i > ptr[t]; --i)
+            {
+              segment(segments[i - 1]);
+            }
+            if (data.backwardOut[t] >= 0)
+            {
+              std::copy(psi.begin(), psi.end(),
+                        boundaryNew.begin() + static_cast<std::ptrdiff_t>(static_cast<std::size_t>(data.backwardOut[t]) * GP));
+            }
+          }
+        },
+        64);
+  }
+}
+
+MocTrackOptions read_moc_track_options(const SolverConfig &config)
+{
+  MocTrackOptions options;
+  options.azimuthal = config.getInt("moc_azimuthal", options.azimuthal);
+  options.spacing = config.getDouble("moc_spacing", options.spacing);
+  options.cache = config.getString("moc_track_cache", options.cache);
+  if (options.azimuthal < 4 || options.azimuthal % 4 != 0)
+  {
+    throw MocError("A moc_azimuthal néggyel osztható és legalább 4 kell legyen.");
+  }
+  if (!(options.spacing > 0.0))
+  {
+    throw MocError("A moc_spacing pozitív kell legyen.");
+  }
+  return options;
+}
+
+MocOptions read_moc_options(const SolverConfig &config)
+{
+  MocOptions options;
+  options.polar = config.getInt("moc_polar", options.polar);
+  options.exponential = config.getString("moc_exp", options.exponential);
+  options.expTolerance = config.getDouble("moc_exp_tol", options.expTolerance);
+  options.kTolerance = config.getDouble("moc_k_tol", options.kTolerance);
+  options.sourceTolerance = config.getDouble("moc_source_tol", options.sourceTolerance);
+  options.maxIterations = config.getInt("moc_max_iter", options.maxIterations);
+  if (options.polar < 1)
+  {
+    throw MocError("A moc_polar legalább 1 kell legyen.");
+  }
+  if (options.exponential != "table" && options.exponential != "exact")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen moc_exp: \"" << options.exponential << "\", table-t használok.\n";
+    options.exponential = "table";
+  }
+  if (!(options.expTolerance > 0.0 && options.expTolerance < 0.1))
+  {
+    throw MocError("A moc_exp_tol 0 és 0.1 közé kell essen.");
+  }
+  return options;
+}
+
+MocTracking::MocTracking(const Mesh &mesh, const MocTrackOptions &options)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (mesh.tris.empty())
+  {
+    throw MocError("A hálóban nincs háromszög.");
+  }
+  const std::uint64_t fingerprint = mesh_fingerprint(mesh);
+  if (!options.cache.empty() && load(options.cache, fingerprint, options))
+  {
+    m_fromCache = true;
+  }
+  else
+  {
+    trace(mesh, options);
+    if (!options.cache.empty())
+    {
+      save(options.cache, fingerprint, options);
+    }
+  }
+  m_traceMs = elapsed_ms(start);
+}
+
+void MocTracking::trace(const Mesh &mesh, const MocTrackOptions &options)
+{
+  const std::size_t E = mesh.tris.size();
+
+  // --- Háromszögek: csúcsok, kifelé mutató él normálisok (n . x <= c belül), külső élek ---
+  std::vector<double> normal(6 * E), offset(3 * E), area(E);
+  std::vector<int> outerOf(3 * E, -1);
+  double xmin = std::numeric_limits<double>::max(), ymin = xmin;
+  double xmax = -xmin, ymax = -xmin;
+  std::map<std::pair<int, int>, int> edgeCount;
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int ids[3] = {t.a, t.b, t.c};
+    const Mesh::Node *v[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      v[k] = &mesh.nodes[static_cast<std::size_t>(ids[k])];
+      xmin = std::min(xmin, v[k]->x);
+      xmax = std::max(xmax, v[k]->x);
+      ymin = std::min(ymin, v[k]->y);
+      ymax = std::max(ymax, v[k]->y);
+    }
+    area[e] = 0.5 * std::fabs((v[1]->x - v[0]->x) * (v[2]->y - v[0]->y) - (v[2]->x - v[0]->x) * (v[1]->y - v[0]->y));
+    for (int k = 0; k < 3; ++k)
+    {
+      const Mesh::Node &p = *v[(k + 1) % 3];
+      const Mesh::Node &q = *v[(k + 2) % 3];
+      const Mesh::Node &r = *v[k];
+      double nx = q.y - p.y, ny = -(q.x - p.x);
+      if (nx * (r.x - p.x) + ny * (r.y - p.y) > 0.0)
+      {
+        nx = -nx;
+        ny = -ny;
+      }
+      normal[6 * e + 2 * static_cast<std::size_t>(k)] = nx;
+      normal[6 * e + 2 * static_cast<std::size_t>(k) + 1] = ny;
+      offset[3 * e + static_cast<std::size_t>(k)] = nx * p.x + ny * p.y;
+      ++edgeCount[edge_key(ids[(k + 1) % 3] - 1, ids[(k + 2) % 3] - 1)];
+    }
+  }
+  std::map<std::pair<int, int>, int> outerId;
+  for (const std::pair<const std::pair<int, int>, int> &it : edgeCount)
+  {
+    if (it.second == 1)
+    {
+      outerId[it.first] = static_cast<int>(m_outerEdges.size() / 2);
+      m_outerEdges.push_back(it.first.first);
+      m_outerEdges.push_back(it.first.second);
+    }
+  }
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int ids[3] = {t.a - 1, t.b - 1, t.c - 1};
+    for (int k = 0; k < 3; ++k)
+    {
+      const std::map<std::pair<int, int>, int>::const_iterator it = outerId.find(edge_key(ids[(k + 1) % 3], ids[(k + 2) % 3]));
+      if (it != outerId.end())
+      {
+        outerOf[3 * e + static_cast<std::size_t>(k)] = it->second;
+      }
+    }
+  }
+  const double W = xmax - xmin, H = ymax - ymin;
+  if (!(W > 0.0 && H > 0.0))
+  {
+    throw MocError("A háló befoglaló téglalapja elfajult.");
+  }
+
+  // --- Rács a háromszögek gyors kereséséhez (befoglaló dobozuk szerint) ---
+  const double cell = std::sqrt(W * H / static_cast<double>(E));
+  const int gx = std::max(1, std::min(4096, static_cast<int>(std::ceil(W / cell))));
+  const int gy = std::max(1, std::min(4096, static_cast<int>(std::ceil(H / cell))));
+  const double cw = W / gx, ch = H / gy;
+  std::vector<int> binPtr(static_cast<std::size_t>(gx) * gy + 1, 0), bins;
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    std::vector<int> fill;
+    if (pass == 1)
+    {
+      for (std::size_t i = 1; i < binPtr.size(); ++i)
+      {
+        binPtr[i] += binPtr[i - 1];
+      }
+      bins.resize(static_cast<std::size_t>(binPtr.back()));
+      fill.assign(binPtr.begin(), binPtr.end() - 1);
+    }
+    for (std::size_t e = 0; e < E; ++e)
+    {
+      const Mesh::Tri &t = mesh.tris[e];
+      const Mesh::Node &a = mesh.nodes[static_cast<std::size_t>(t.a)];
+      const Mesh::Node &b = mesh.nodes[static_cast<std::size_t>(t.b)];
+      const Mesh::Node &c = mesh.nodes[static_cast<std::size_t>(t.c)];
+      const int x0 = std::max(0, std::min(gx - 1, static_cast<int>((std::min({a.x, b.x, c.x}) - xmin) / cw)));
+      const int x1 = std::max(0, std::min(gx - 1, static_cast<int>((std::max({a.x, b.x, c.x}) - xmin) / cw)));
+      const int y0 = std::max(0, std::min(gy - 1, static_cast<int>((std::min({a.y, b.y, c.y}) - ymin) / ch)));
+      const int y1 = std::max(0, std::min(gy - 1, static_cast<int>((std::max({a.y, b.y, c.y}) - ymin) / ch)));
+      for (int iy = y0; iy <= y1; ++iy)
+      {
+        for (int ix = x0; ix <= x1; ++ix)
+        {
+          const std::size_t bin = static_cast<std::size_t>(iy) * static_cast<std::size_t>(gx) + static_cast<std::size_t>(ix);
+          if (pass == 0)
+          {
+            ++binPtr[bin + 1];
+          }
+          else
+          {
+            bins[static_cast<std::size_t>(fill[bin]++)] = static_cast<int>(e);
+          }
+        }
+      }
+    }
+  }
+
+  // --- Ciklikus sugárkészlet: irányonként nx sugár az alsó, ny az oldalsó peremről ---
+  const int half = options.azimuthal / 2, quarter = options.azimuthal / 4;
+  m_phi.assign(static_cast<std::size_t>(half), 0.0);
+  m_spacing.assign(static_cast<std::size_t>(half), 0.0);
+  m_weight.assign(static_cast<std::size_t>(half), 0.0);
+  std::vector<int> countX(static_cast<std::size_t>(half)), countY(static_cast<std::size_t>(half));
+  for (int a = 0; a < quarter; ++a)
+  {
+    const double desired = PI / half * (a + 0.5);
+    const int nx = static_cast<int>(W / options.spacing * std::fabs(std::sin(desired))) + 1;
+    const int ny = static_cast<int>(H / options.spacing * std::fabs(std::cos(desired))) + 1;
+    const double phi = std::atan((H * nx) / (W * ny));
+    const std::size_t ua = static_cast<std::size_t>(a), mirror = static_cast<std::size_t>(half - 1 - a);
+    m_phi[ua] = phi;
+    m_phi[mirror] = PI - phi;
+    m_spacing[ua] = m_spacing[mirror] = W / nx * std::sin(phi);
+    countX[ua] = countX[mirror] = nx;
+    countY[ua] = countY[mirror] = ny;
+  }
+  for (int a = 0; a < quarter; ++a)
+  {
+    const std::size_t ua = static_cast<std::size_t>(a);
+    const double lower = a == 0 ? 0.0 : 0.5 * (m_phi[ua - 1] + m_phi[ua]);
+    const double upper = a == quarter - 1 ? 0.5 * PI : 0.5 * (m_phi[ua] + m_phi[ua + 1]);
+    m_weight[ua] = m_weight[static_cast<std::size_t>(half - 1 - a)] = (upper - lower) / (2.0 * PI);
+  }
+
+  struct Line
+  {
+    double sx, sy, ex, ey, length;
+  };
+  std::vector<Line> lines;
+  for (int a = 0; a < half; ++a)
+  {
+    const std::size_t ua = static_cast<std::size_t>(a);
+    const double c = std::cos(m_phi[ua]), s = std::sin(m_phi[ua]);
+    const double dx = W / countX[ua], dy = H / countY[ua];
+    std::vector<std::pair<double, double>> starts;
+    for (int i = 0; i < countX[ua]; ++i)
+    {
+      starts.push_back(std::make_pair(xmin + dx * (i + 0.5), ymin));
+    }
+    for (int j = 0; j < countY[ua]; ++j)
+    {
+      starts.push_back(std::make_pair(c > 0.0 ? xmin : xmax, ymin + dy * (j + 0.5)));
+    }
+    for (const std::pair<double, double> &p : starts)
+    {
+      const double tx = c > 0.0 ? (xmax - p.first) / c : (xmin - p.first) / c;
+      const double ty = (ymax - p.second) / s;
+      const double length = std::min(tx, ty);
+      Track track;
+      track.azimuth = a;
+      m_tracks.push_back(track);
+      lines.push_back(Line{p.first, p.second, p.first + length * c, p.second + length * s, length});
+    }
+  }
+  const std::size_t T = m_tracks.size();
+
+  // --- Sugárkövetés: a rács celláin végighaladva (DDA) a jelölt háromszögekkel vett közös szakaszok ---
+  const double scale = W + H;
+  const double tinyLength = 1e-12 * scale, gapTolerance = 1e-8 * scale;
+  std::vector<std::vector<MocSegment>> perTrack(T);
+  std::vector<std::set<int>> crossings(static_cast<std::size_t>(thread_count()));
+  parallel_chunks(
+      0, T,
+      [&](int thread, std::size_t begin, std::size_t end) {
+        std::vector<std::size_t> stamp(E, std::numeric_limits<std::size_t>::max());
+        std::vector<Interval> hits;
+        for (std::size_t t = begin; t < end; ++t)
+        {
+          const Line &line = lines[t];
+          const double c = std::cos(m_phi[static_cast<std::size_t>(m_tracks[t].azimuth)]);
+          const double s = std::sin(m_phi[static_cast<std::size_t>(m_tracks[t].azimuth)]);
+          hits.clear();
+
+          const double px = line.sx - xmin, py = line.sy - ymin;
+          int ix = std::max(0, std::min(gx - 1, static_cast<int>(px / cw)));
+          int iy = std::max(0, std::min(gy - 1, static_cast<int>(py / ch)));
+          const int stepX = c > 0.0 ? 1 : -1;
+          double tMaxX = c > 0.0 ? ((ix + 1) * cw - px) / c : (ix * cw - px) / c;
+          double tMaxY = ((iy + 1) * ch - py) / s;
+          const double tDeltaX = cw / std::fabs(c), tDeltaY = ch / s;
+          while (true)
+          {
+            const std::size_t bin = static_cast<std::size_t>(iy) * static_cast<std::size_t>(gx) + static_cast<std::size_t>(ix);
+            for (int k = binPtr[bin]; k < binPtr[bin + 1]; ++k)
+            {
+              const std::size_t e = static_cast<std::size_t>(bins[static_cast<std::size_t>(k)]);
+              if (stamp[e] == t)
+              {
+                continue;
+              }
+              stamp[e] = t;
+              // Cyrus–Beck vágás a három félsíkkal
+              Interval iv;
+              iv.tIn = -std::numeric_limits<double>::max();
+              iv.tOut = std::numeric_limits<double>::max();
+              bool empty = false;
+              for (int j = 0; j < 3 && !empty; ++j)
+              {
+                const double nx = normal[6 * e + 2 * static_cast<std::size_t>(j)];
+                const double ny = normal[6 * e + 2 * static_cast<std::size_t>(j) + 1];
+                const double den = nx * c + ny * s;
+                const double num = offset[3 * e + static_cast<std::size_t>(j)] - (nx * line.sx + ny * line.sy);
+                if (den == 0.0)
+                {
+                  empty = num < 0.0;
+                }
+                else if (den > 0.0)
+                {
+                  const double bound = num / den;
+                  if (bound < iv.tOut)
+                  {
+                    iv.tOut = bound;
+                    iv.exitEdge = j;
+                  }
+                }
+                else
+                {
+                  const double bound = num / den;
+                  if (bound > iv.tIn)
+                  {
+                    iv.tIn = bound;
+                    iv.entryEdge = j;
+                  }
+                }
+              }
+              // A peremen belépő / kilépő sugárnál a határoló él a peremél marad, a szakasz a sugárra vágva
+              iv.tIn = std::max(iv.tIn, 0.0);
+              iv.tOut = std::min(iv.tOut, line.length);
+              if (!empty && iv.tOut - iv.tIn > tinyLength)
+              {
+                iv.region = static_cast<int>(e);
+                hits.push_back(iv);
+              }
+            }
+            if (tMaxX < tMaxY)
+            {
+              if (tMaxX > line.length || (ix += stepX) < 0 || ix >= gx)
+              {
+                break;
+              }
+              tMaxX += tDeltaX;
+            }
+            else
+            {
+              if (tMaxY > line.length || ++iy >= gy)
+              {
+                break;
+              }
+              tMaxY += tDeltaY;
+            }
+          }
+
+          std::sort(hits.begin(), hits.end(), [](const Interval &x, const Interval &y) { return x.tIn < y.tIn; });
+          std::vector<MocSegment> &out = perTrack[t];
+          Track &track = m_tracks[t];
+          auto outer = [&](const Interval &iv, int local) {
+            return local < 0 ? -1 : outerOf[3 * static_cast<std::size_t>(iv.region) + static_cast<std::size_t>(local)];
+          };
+          auto record = [&](int edge) {
+            if (edge >= 0)
+            {
+              crossings[static_cast<std::size_t>(thread)].insert(edge);
+            }
+          };
+          for (std::size_t i = 0; i < hits.size(); ++i)
+          {
+            const Interval &iv = hits[i];
+            if (i == 0)
+            {
+              if (iv.tIn < gapTolerance)
+              {
+                track.startEdge = outer(iv, iv.entryEdge);
+              }
+              else
+              {
+                record(outer(iv, iv.entryEdge));
+              }
+            }
+            else if (iv.tIn - hits[i - 1].tOut > gapTolerance)
+            {
+              record(outer(hits[i - 1], hits[i - 1].exitEdge));
+              record(outer(iv, iv.entryEdge));
+              out.push_back(MocSegment{-1, 0.0f});
+            }
+            out.push_back(MocSegment{iv.region, static_cast<float>(iv.tOut - iv.tIn)});
+          }
+          if (!hits.empty())
+          {
+            if (hits.back().tOut > line.length - gapTolerance)
+            {
+              track.endEdge = outer(hits.back(), hits.back().exitEdge);
+            }
+            else
+            {
+              record(outer(hits.back(), hits.back().exitEdge));
+            }
+          }
+        }
+      },
+      16);
+
+  std::set<int> interior;
+  for (const std::set<int> &c : crossings)
+  {
+    interior.insert(c.begin(), c.end());
+  }
+  m_interiorCrossings.assign(interior.begin(), interior.end());
+
+  // --- Térfogat korrekció: régiónként a sugarakkal becsült terület a pontos területre skálázva ---
+  std::vector<double> tracked(E, 0.0);
+  for (std::size_t t = 0; t < T; ++t)
+  {
+    const std::size_t a = static_cast<std::size_t>(m_tracks[t].azimuth);
+    const double w = 2.0 * m_weight[a] * m_spacing[a];
+    for (const MocSegment &s : perTrack[t])
+    {
+      if (s.region >= 0)
+      {
+        tracked[static_cast<std::size_t>(s.region)] += w * s.length;
+      }
+    }
+  }
+  std::vector<float> correction(E, 1.0f);
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    if (tracked[e] <= 0.0)
+    {
+      ++m_missedRegions;
+      continue;
+    }
+    correction[e] = static_cast<float>(area[e] / tracked[e]);
+    m_maxCorrection = std::max(m_maxCorrection, std::fabs(tracked[e] / area[e] - 1.0));
+  }
+  m_trackPtr.assign(T + 1, 0);
+  for (std::size_t t = 0; t < T; ++t)
+  {
+    m_trackPtr[t + 1] = m_trackPtr[t] + perTrack[t].size();
+  }
+  m_segments.reserve(m_trackPtr.back());
+  for (std::size_t t = 0; t < T; ++t)
+  {
+    for (MocSegment s : perTrack[t])
+    {
+      if (s.region >= 0)
+      {
+        s.length *= correction[static_cast<std::size_t>(s.region)];
+      }
+      m_segments.push_back(s);
+    }
+    std::vector<MocSegment>().swap(perTrack[t]);
+  }
+
+  // --- Ciklikus kapcsolatok: a perem pontjában a tükrözött irányú sugár kezdete (előre) vagy vége (hátra) ---
+  auto perimeter = [&](double x, double y) {
+    const double dBottom = std::fabs(y - ymin), dRight = std::fabs(x - xmax);
+    const double dTop = std::fabs(y - ymax), dLeft = std::fabs(x - xmin);
+    const double m = std::min({dBottom, dRight, dTop, dLeft});
+    if (m == dBottom)
+    {
+      return x - xmin;
+    }
+    if (m == dRight)
+    {
+      return W + (y - ymin);
+    }
+    if (m == dTop)
+    {
+      return W + H + (xmax - x);
+    }
+    return 2.0 * W + H + (ymax - y);
+  };
+  std::vector<std::vector<std::pair<double, int>>> startsOf(static_cast<std::size_t>(half));
+  std::vector<std::vector<std::pair<double, int>>> endsOf(static_cast<std::size_t>(half));
+  for (std::size_t t = 0; t < T; ++t)
+  {
+    const std::size_t a = static_cast<std::size_t>(m_tracks[t].azimuth);
+    startsOf[a].push_back(std::make_pair(perimeter(lines[t].sx, lines[t].sy), static_cast<int>(t)));
+    endsOf[a].push_back(std::make_pair(perimeter(lines[t].ex, lines[t].ey), static_cast<int>(t)));
+  }
+  for (int a = 0; a < half; ++a)
+  {
+    std::sort(startsOf[static_cast<std::size_t>(a)].begin(), startsOf[static_cast<std::size_t>(a)].end());
+    std::sort(endsOf[static_cast<std::size_t>(a)].begin(), endsOf[static_cast<std::size_t>(a)].end());
+  }
+  auto find = [&](const std::vector<std::pair<double, int>> &list, double x, double y) {
+    const double key = perimeter(x, y);
+    const std::vector<std::pair<double, int>>::const_iterator it =
+        std::lower_bound(list.begin(), list.end(), std::make_pair(key - 1e-6 * scale, -1));
+    return it != list.end() && std::fabs(it->first - key) < 1e-6 * scale ? it->second : -1;
+  };
+  const double sideTolerance = 1e-9 * scale;
+  for (std::size_t t = 0; t < T; ++t)
+  {
+    Track &track = m_tracks[t];
+    const std::size_t mirror = static_cast<std::size_t>(half - 1 - track.azimuth);
+    const Line &line = lines[t];
+    // Előre: a felső peremen a tükrözött irány a tükörsugár hátrafelé, az oldalsón előre
+    if (std::fabs(line.ey - ymax) <= sideTolerance)
+    {
+      const int other = find(endsOf[mirror], line.ex, line.ey);
+      track.linkForward = other < 0 ? -1 : 2 * other + 1;
+    }
+    else
+    {
+      const int other = find(startsOf[mirror], line.ex, line.ey);
+      track.linkForward = other < 0 ? -1 : 2 * other;
+    }
+    // Hátra (a kezdőpontban): az alsó peremen a tükörsugár előre, az oldalsón hátrafelé
+    if (std::fabs(line.sy - ymin) <= sideTolerance)
+    {
+      const int other = find(startsOf[mirror], line.sx, line.sy);
+      track.linkBackward = other < 0 ? -1 : 2 * other;
+    }
+    else
+    {
+      const int other = find(endsOf[mirror], line.sx, line.sy);
+      track.linkBackward = other < 0 ? -1 : 2 * other + 1;
+    }
+  }
+}
+
+bool MocTracking::load(const std::string &path, std::uint64_t fingerprint, const MocTrackOptions &options)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+  {
+    return false;
+  }
+  char magic[8] = {};
+  std::uint32_t version = 0;
+  std::uint64_t stored = 0;
+  std::int32_t azimuthal = 0;
+  double spacing = 0.0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char *>(&version), sizeof(version));
+  in.read(reinterpret_cast<char *>(&stored), sizeof(stored));
+  in.read(reinterpret_cast<char *>(&azimuthal), sizeof(azimuthal));
+  in.read(reinterpret_cast<char *>(&spacing), sizeof(spacing));
+  if (!in || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || version != CACHE_VERSION || stored != fingerprint ||
+      azimuthal != options.azimuthal || spacing != options.spacing)
+  {
+    return false;
+  }
+  std::int32_t missed = 0;
+  std::vector<std::uint64_t> ptr;
+  const bool ok = read_vector(in, m_phi) && read_vector(in, m_spacing) && read_vector(in, m_weight) &&
+                  read_vector(in, m_tracks) && read_vector(in, ptr) && read_vector(in, m_segments) &&
+                  read_vector(in, m_outerEdges) && read_vector(in, m_interiorCrossings) &&
+                  in.read(reinterpret_cast<char *>(&missed), sizeof(missed)) &&
+                  in.read(reinterpret_cast<char *>(&m_maxCorrection), sizeof(m_maxCorrection));
+  if (!ok || ptr.size() != m_tracks.size() + 1 || ptr.back() != m_segments.size())
+  {
+    m_phi.clear();
+    m_spacing.clear();
+    m_weight.clear();
+    m_tracks.clear();
+    m_segments.clear();
+    m_outerEdges.clear();
+    m_interiorCrossings.clear();
+    m_maxCorrection = 0.0;
+    return false;
+  }
+  m_trackPtr.assign(ptr.begin(), ptr.end());
+  m_missedRegions = missed;
+  return true;
+}
+
+void MocTracking::save(const std::string &path, std::uint64_t fingerprint, const MocTrackOptions &options) const
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A sugár gyorsítótár nem írható: " << path << "\n";
+    return;
+  }
+  const std::int32_t azimuthal = options.azimuthal;
+  const std::int32_t missed = m_missedRegions;
+  out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  out.write(reinterpret_cast<const char *>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+  out.write(reinterpret_cast<const char *>(&fingerprint), sizeof(fingerprint));
+  out.write(reinterpret_cast<const char *>(&azimuthal), sizeof(azimuthal));
+  out.write(reinterpret_cast<const char *>(&options.spacing), sizeof(options.spacing));
+  write_vector(out, m_phi);
+  write_vector(out, m_spacing);
+  write_vector(out, m_weight);
+  write_vector(out, m_tracks);
+  write_vector(out, std::vector<std::uint64_t>(m_trackPtr.begin(), m_trackPtr.end()));
+  write_vector(out, m_segments);
+  write_vector(out, m_outerEdges);
+  write_vector(out, m_interiorCrossings);
+  out.write(reinterpret_cast<const char *>(&missed), sizeof(missed));
+  out.write(reinterpret_cast<const char *>(&m_maxCorrection), sizeof(m_maxCorrection));
+  if (!out)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A sugár gyorsítótár írása sikertelen: " << path << "\n";
+  }
+}
+
+std::size_t MocTracking::memory_bytes() const
+{
+  return m_segments.size() * sizeof(MocSegment) + m_tracks.size() * sizeof(Track) +
+         m_trackPtr.size() * sizeof(std::size_t);
+}
+
+void solve_moc(const Mesh &mesh, const MocTracking &tracking, const XsLibrary &library, const DiffusionSystem &system,
+               const MocOptions &options, MocResult &result)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const XsCompiled &xs = library.compiled;
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t E = system.elementMaterial.size();
+  const std::size_t T = tracking.track_count();
+
+  // Polár kvadratúra: sin theta (a síkbeli hossz osztója) és w_p sin theta (a fluxus részösszeg súlya)
+  std::vector<double> polarCos, polarWeight;
+  gauss_legendre_half(options.polar, polarCos, polarWeight);
+  const std::size_t P = polarCos.size(), GP = G * P;
+  std::vector<double> invSin(P), tallyWeight(P);
+  for (std::size_t p = 0; p < P; ++p)
+  {
+    const double sinTheta = std::sqrt(1.0 - polarCos[p] * polarCos[p]);
+    invSin[p] = 1.0 / sinTheta;
+    tallyWeight[p] = polarWeight[p] * sinTheta;
+  }
+
+  MocResult fresh;
+
+  // Exponenciális táblázat: h = sqrt(8 tol) lépésköz mellett a húr hibája legfeljebb tol; tau_max = -ln(tol) felett 1
+  std::vector<double> table;
+  TableExp tableExp;
+  if (options.exponential == "table")
+  {
+    const double step = std::sqrt(8.0 * options.expTolerance);
+    tableExp.tauMax = -std::log(options.expTolerance);
+    tableExp.last = static_cast<int>(std::ceil(tableExp.tauMax / step));
+    tableExp.invStep = 1.0 / step;
+    table.resize(2 * static_cast<std::size_t>(tableExp.last + 1));
+    for (int i = 0; i <= tableExp.last; ++i)
+    {
+      const double a = i * step, b = a + step;
+      const double fa = 1.0 - std::exp(-a), fb = 1.0 - std::exp(-b);
+      const double slope = (fb - fa) / step;
+      table[2 * static_cast<std::size_t>(i)] = fa - slope * a;
+      table[2 * static_cast<std::size_t>(i) + 1] = slope;
+    }
+    tableExp.coef = table.data();
+    const ExactExp exact;
+    for (int i = 0; i <= 20 * tableExp.last + 100; ++i)
+    {
+      const double tau = i * step / 20.0;
+      fresh.expMaxError = std::max(fresh.expMaxError, std::fabs(tableExp(tau) - exact(tau)));
+    }
+  }
+
+  // Régiónkénti adatok: sigma_t / sin theta a csoport x polár indexen, és mely háromszögeken halad át sugár
+  std::vector<double> sigmaT(E * G), sigmaOverSin(E * GP), area(E);
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    const std::size_t m = static_cast<std::size_t>(system.elementMaterial[e]);
+    area[e] = system.geometry[e].area;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      const double st = xs.sigma_t[m * G + g];
+      if (!(st > 0.0))
+      {
+        throw MocError("A MOC pozitív teljes hatáskeresztmetszetet igényel (üreg régió nem támogatott).");
+      }
+      sigmaT[e * G + g] = st;
+      for (std::size_t p = 0; p < P; ++p)
+      {
+        sigmaOverSin[e * GP + g * P + p] = st * invSin[p];
+      }
+    }
+  }
+  std::vector<char> hit(E, 0);
+  for (const MocSegment &s : tracking.segments())
+  {
+    if (s.region >= 0 && static_cast<std::size_t>(s.region) < E)
+    {
+      hit[static_cast<std::size_t>(s.region)] = 1;
+    }
+  }
+
+  // Perem: a vákuum 1D elemek élei nyelnek, minden más külső él tükröz (mint a diffúzió természetes pereme)
+  std::set<std::pair<int, int>> vacuum;
+  for (int l : system.vacuumLines)
+  {
+    const Mesh::Line &line = mesh.lines[static_cast<std::size_t>(l)];
+    vacuum.insert(edge_key(line.a - 1, line.b - 1));
+  }
+  const std::vector<int> &outerEdges = tracking.outer_edges();
+  std::vector<char> reflective(outerEdges.size() / 2, 0);
+  for (std::size_t i = 0; i < reflective.size(); ++i)
+  {
+    reflective[i] = vacuum.count(edge_key(outerEdges[2 * i], outerEdges[2 * i + 1])) == 0 ? 1 : 0;
+  }
+  std::size_t interiorReflective = 0;
+  for (int edge : tracking.interior_crossings())
+  {
+    interiorReflective += reflective[static_cast<std::size_t>(edge)] != 0 ? 1 : 0;
+  }
+  if (interiorReflective > 0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] " << interiorReflective
+              << " tükröző külső él nem a befoglaló téglalap peremén van; a sugarak ott vákuumként kezelik.\n";
+  }
+  std::vector<int> forwardOut(T, -1), backwardOut(T, -1);
+  for (std::size_t t = 0; t < T; ++t)
+  {
+    const MocTracking::Track &track = tracking.tracks()[t];
+    if (track.linkForward >= 0 && track.endEdge >= 0 && reflective[static_cast<std::size_t>(track.endEdge)] != 0)
+    {
+      forwardOut[t] = track.linkForward;
+    }
+    if (track.linkBackward >= 0 && track.startEdge >= 0 && reflective[static_cast<std::size_t>(track.startEdge)] != 0)
+    {
+      backwardOut[t] = track.linkBackward;
+    }
+  }
+
+  SweepData data;
+  data.tracking = &tracking;
+  data.GP = GP;
+  data.P = P;
+  data.sigmaOverSin = sigmaOverSin.data();
+  data.polarWeight = tallyWeight.data();
+  data.forwardOut = forwardOut.data();
+  data.backwardOut = backwardOut.data();
+
+  // Kezdőérték és normálás egységnyi produkcióra
+  std::vector<std::vector<double>> &flux = fresh.flux;
+  if (result.flux.size() == G && !result.flux.empty() && result.flux[0].size() == E)
+  {
+    flux = result.flux;
+  }
+  else
+  {
+    flux.assign(G, std::vector<double>(E, 1.0));
+  }
+  double k = result.keff > 0.0 ? result.keff : 1.0;
+  auto fission_density = [&](std::vector<double> &f) {
+    f.assign(E, 0.0);
+    double production = 0.0;
+    for (std::size_t e = 0; e < E; ++e)
+    {
+      const std::size_t m = static_cast<std::size_t>(system.elementMaterial[e]);
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        f[e] += xs.nu_sigma_f[m * G + g] * flux[g][e];
+      }
+      production += area[e] * f[e];
+    }
+    return production;
+  };
+  std::vector<double> fission, fissionNew;
+  double production = fission_density(fission);
+  if (production <= 0.0)
+  {
+    throw MocError("A rendszerben nincs hasadóanyag, a k-sajátérték nem értelmezhető.");
+  }
+  for (std::vector<double> &v : flux)
+  {
+    for (double &x : v)
+    {
+      x /= production;
+    }
+  }
+  for (double &x : fission)
+  {
+    x /= production;
+  }
+
+  std::vector<double> source(E * G), sourceOverSigma(E * GP);
+  std::vector<double> boundaryOld(2 * T * GP, 0.0), boundaryNew(2 * T * GP, 0.0);
+  std::vector<std::vector<double>> tallies(static_cast<std::size_t>(thread_count()), std::vector<double>(E * GP));
+  for (int iteration = 1; iteration <= options.maxIterations; ++iteration)
+  {
+    // Izotrop forrás: hasadás / k + szórás (a saját csoportba is), régiónként sík. A G x G rész a csoportszámra
+    // specializált XS kernelekkel (a régió fluxusa egy lokális tömbbe gyűjtve)
+    xs_kernels::dispatch_groups(static_cast<int>(G), [&](auto fixed) {
+      constexpr int FG = decltype(fixed)::value;
+      parallel_chunks(0, E, [&](int, std::size_t begin, std::size_t end) {
+        typename xs_kernels::Groups<FG>::Vec phi = xs_kernels::Groups<FG>::make(static_cast<int>(G));
+        typename xs_kernels::Groups<FG>::Vec scattered = xs_kernels::Groups<FG>::make(static_cast<int>(G));
+        typename xs_kernels::Groups<FG>::Vec fissioned = xs_kernels::Groups<FG>::make(static_cast<int>(G));
+        for (std::size_t e = begin; e < end; ++e)
+        {
+          const int m = system.elementMaterial[e];
+          for (std::size_t g = 0; g < G; ++g)
+          {
+            phi[g] = flux[g][e];
+          }
+          xs_kernels::scatter_source<FG>(static_cast<int>(G), xs.scatter_of(m), &phi[0], &scattered[0]);
+          xs_kernels::fission_source<FG>(static_cast<int>(G), xs.nu_sigma_f.data() + xs.index(m, 0),
+                                         xs.chi.data() + xs.index(m, 0), &phi[0], 1.0 / k, &fissioned[0]);
+          for (std::size_t g = 0; g < G; ++g)
+          {
+            const double q = fissioned[g] + scattered[g];
+            source[e * G + g] = q;
+            const double qs = q / sigmaT[e * G + g];
+            for (std::size_t p = 0; p < P; ++p)
+            {
+              sourceOverSigma[e * GP + g * P + p] = qs;
+            }
+          }
+        }
+      });
+    });
+
+    const std::chrono::steady_clock::time_point sweepStart = std::chrono::steady_clock::now();
+    for (std::vector<double> &tally : tallies)
+    {
+      std::fill(tally.begin(), tally.end(), 0.0);
+    }
+    if (options.exponential == "table")
+    {
+      sweep_tracks(data, tableExp, sourceOverSigma, boundaryOld, boundaryNew, tallies);
+    }
+    else
+    {
+      sweep_tracks(data, ExactExp(), sourceOverSigma, boundaryOld, boundaryNew, tallies);
+    }
+    boundaryOld.swap(boundaryNew);
+    fresh.sweepMs += elapsed_ms(sweepStart);
+
+    // phi = q / sigma_t + sum w delta psi / (sigma_t A); sugár nélküli régióban a végtelen közeg értéke
+    parallel_for(0, E, [&](std::size_t e) {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        double sum = 0.0;
+        if (hit[e] != 0)
+        {
+          for (const std::vector<double> &tally : tallies)
+          {
+            for (std::size_t p = 0; p < P; ++p)
+            {
+              sum += tally[e * GP + g * P + p];
+            }
+          }
+        }
+        flux[g][e] = (source[e * G + g] + sum / area[e]) / sigmaT[e * G + g];
+      }
+    });
+
+    production = fission_density(fissionNew);
+    const double kNew = k * production;
+    for (std::vector<double> &v : flux)
+    {
+      for (double &x : v)
+      {
+        x /= production;
+      }
+    }
+    for (double &x : boundaryOld)
+    {
+      x /= production;
+    }
+    double sourceChange = 0.0, sourceMax = 0.0;
+    for (std::size_t e = 0; e < E; ++e)
+    {
+      fissionNew[e] /= production;
+      sourceChange = std::max(sourceChange, std::fabs(fissionNew[e] - fission[e]));
+      sourceMax = std::max(sourceMax, std::fabs(fissionNew[e]));
+    }
+    fission.swap(fissionNew);
+    const double kChange = std::fabs(kNew - k) / kNew;
+    k = kNew;
+    fresh.kHistory.push_back(k);
+    fresh.iterations = iteration;
+    if (kChange < options.kTolerance && sourceMax > 0.0 && sourceChange / sourceMax < options.sourceTolerance)
+    {
+      fresh.converged = true;
+      break;
+    }
+  }
+  fresh.keff = k;
+  fresh.totalMs = elapsed_ms(totalStart);
+  result = std::move(fresh);
+}
+
+std::vector<std::vector<double>> element_average_flux(const Mesh &mesh, const std::vector<std::vector<double>> &nodal)
+{
+  std::vector<std::vector<double>> out(nodal.size(), std::vector<double>(mesh.tris.size(), 0.0));
+  for (std::size_t g = 0; g < nodal.size(); ++g)
+  {
+    for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+    {
+      const Mesh::Tri &t = mesh.tris[e];
+      out[g][e] = (nodal[g][static_cast<std::size_t>(t.a - 1)] + nodal[g][static_cast<std::size_t>(t.b - 1)] +
+                   nodal[g][static_cast<std::size_t>(t.c - 1)]) /
+                  3.0;
+    }
+  }
+  return out;
+}
+
+std::vector<SnRegionComparison> compare_region_flux(const Mesh &mesh, const DiffusionSystem &system,
+                                                    const MocResult &transport,
+                                                    const std::vector<std::vector<double>> &diffusionFlux)
+{
+  // A sík fluxus a háromszög mindhárom csúcsára, így az SN összevetése változatlanul használható
+  SnResult asNodal;
+  asNodal.flux.resize(transport.flux.size());
+  for (std::size_t g = 0; g < transport.flux.size(); ++g)
+  {
+    asNodal.flux[g].resize(3 * transport.flux[g].size());
+    for (std::size_t e = 0; e < transport.flux[g].size(); ++e)
+    {
+      asNodal.flux[g][3 * e] = asNodal.flux[g][3 * e + 1] = asNodal.flux[g][3 * e + 2] = transport.flux[g][e];
+    }
+  }
+  return compare_region_flux(mesh, system, asNodal, diffusionFlux);
+}
@@ -0,0 +1,143 @@
+#ifndef MOC_HPP
+#define MOC_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "sn.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Karakterisztikák módszere (MOC) a háromszöghálón, háromszögenként sík (konstans) forrással.
+//
+// Sugárkövetés: a háló befoglaló téglalapjára ciklikus (moduláris) sugárkészlet kerül: irányonként a sugárköz és
+// a szög úgy korrigálódik, hogy minden sugár vége a peremen pontosan egy tükrözött irányú sugár kezdete legyen.
+// Minden sugár egyszer fut át a hálón; a metszett háromszögek (régió, hossz) szegmensei egyetlen összefüggő
+// tömbben tárolódnak, sugaranként egy eltolással. A háló peremén kilépő, majd visszalépő sugárban egy jelölő
+// szegmens nullázza a szög fluxust (vákuum); a szegmens hosszakat régiónként a pontos terület korrigálja.
+// A sugárkészlet csak a hálótól és a sugár paraméterektől függ, így egy felépítése (vagy a gyorsítótár fájlból
+// betöltése) után minden iteráció és minden számítás (más XS, más forrás) ugyanazt használja.
+//
+// Söprés: sugaranként előre és hátra, minden csoport és polárszög egyszerre (a szegmensenkénti belső ciklus
+// a csoport x polár indexen folytonos), az exponenciális tag táblázatból (lineáris interpoláció) vagy pontosan.
+//   psi_ki = psi_be - (psi_be - q / sigma_t) (1 - exp(-sigma_t l / sin theta))
+// A tükröző peremen a kimenő szög fluxus a kapcsolt sugár következő söprésbeli bejövő értéke. A sugarak
+// szálak között oszlanak meg, a régiónkénti részösszegek szálanként gyűlnek.
+
+class MocError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct MocTrackOptions
+{
+  int azimuthal = 32;       // azimutszögek 2 pi-n (néggyel osztható), a ciklikus korrekció előtt
+  double spacing = 0.05;    // kívánt sugárköz [cm]
+  std::string cache;        // gyorsítótár fájl (üres = nincs): ha egyező hálóhoz és paraméterekhez tartozik, betölti
+};
+
+MocTrackOptions read_moc_track_options(const SolverConfig &config);
+
+struct MocSegment
+{
+  int region = -1;          // háromszög index; -1 = a sugár itt kilép a hálóból (a szög fluxus nullázódik)
+  float length = 0.0f;      // [cm], a síkbeli hossz (térfogat korrigált)
+};
+
+class MocTracking
+{
+public:
+  // Betöltés a gyorsítótárból, vagy sugárkövetés (és a gyorsítótár kiírása, ha meg van adva)
+  MocTracking(const Mesh &mesh, const MocTrackOptions &options);
+
+  struct Track
+  {
+    int azimuth = 0;        // 0 <= azimuth < azimuthal / 2, a haladási irány [0, pi)-ben
+    int startEdge = -1;     // a kezdőpont külső éle (ha a befoglaló téglalap peremén a hálóba lép), különben -1
+    int endEdge = -1;       // a végpont külső éle
+    int linkForward = -1;   // az előre söprés vége ide folytatódik tükrözéskor: 2 * sugár + (0 előre, 1 hátra)
+    int linkBackward = -1;  // a hátra söprés (a kezdőpont) folytatása
+  };
+
+  std::size_t track_count() const { return m_tracks.size(); }
+  std::size_t segment_count() const { return m_segments.size(); }
+  int azimuth_count() const { return static_cast<int>(m_phi.size()); }
+  const std::vector<Track> &tracks() const { return m_tracks; }
+  const std::vector<std::size_t> &track_ptr() const { return m_trackPtr; }
+  const std::vector<MocSegment> &segments() const { return m_segments; }
+  double azimuth_angle(int a) const { return m_phi[static_cast<std::size_t>(a)]; }
+  double azimuth_spacing(int a) const { return m_spacing[static_cast<std::size_t>(a)]; }
+  double azimuth_weight(int a) const { return m_weight[static_cast<std::size_t>(a)]; } // sum = 1/2 ([0, pi))
+
+  // Külső élek (csak egy háromszöghöz tartozó élek) 0-bázisú csomópont párjai: [2 * él], [2 * él + 1]
+  const std::vector<int> &outer_edges() const { return m_outerEdges; }
+  // A hálón belül (nem a befoglaló téglalap peremén) keresztezett külső élek; ezek vákuumként viselkednek
+  const std::vector<int> &interior_crossings() const { return m_interiorCrossings; }
+
+  int missed_regions() const { return m_missedRegions; }   // szegmens nélküli háromszögek
+  double max_volume_correction() const { return m_maxCorrection; } // max |sugár terület / pontos - 1|
+  bool loaded_from_cache() const { return m_fromCache; }
+  double trace_ms() const { return m_traceMs; }
+  std::size_t memory_bytes() const;
+
+private:
+  void trace(const Mesh &mesh, const MocTrackOptions &options);
+  bool load(const std::string &path, std::uint64_t fingerprint, const MocTrackOptions &options);
+  void save(const std::string &path, std::uint64_t fingerprint, const MocTrackOptions &options) const;
+
+  std::vector<double> m_phi, m_spacing, m_weight; // azimutonként
+  std::vector<Track> m_tracks;
+  std::vector<std::size_t> m_trackPtr;            // sugaranként az első szegmens (track_count + 1)
+  std::vector<MocSegment> m_segments;
+  std::vector<int> m_outerEdges;
+  std::vector<int> m_interiorCrossings;
+  int m_missedRegions = 0;
+  double m_maxCorrection = 0.0;
+  bool m_fromCache = false;
+  double m_traceMs = 0.0;
+};
+
+struct MocOptions
+{
+  int polar = 3;                     // Gauss–Legendre polárszögek a felső félgömbön
+  std::string exponential = "table"; // table (lineáris interpoláció) | exact
+  double expTolerance = 1e-6;        // a táblázat abszolút hibája
+  double kTolerance = 1e-6;
+  double sourceTolerance = 1e-5;     // a normált hasadási forrás relatív változása (max norma)
+  int maxIterations = 2000;          // söprések (minden söprés után új k)
+};
+
+MocOptions read_moc_options(const SolverConfig &config);
+
+struct MocResult
+{
+  double keff = 0.0;
+  bool converged = false;
+  int iterations = 0;
+  // flux[g][e]: háromszögenkénti átlagfluxus, egységnyi teljes produkcióra normálva
+  std::vector<std::vector<double>> flux;
+  std::vector<double> kHistory;
+  double expMaxError = 0.0;          // a táblázat mért maximális hibája (exact esetén 0)
+  double totalMs = 0.0;
+  double sweepMs = 0.0;
+};
+
+// k-sajátérték: söprésenként új forrás (hasadás / k + szórás) és új k. Ha result.flux megfelelő méretű (és
+// result.keff > 0), kezdőértékként használja.
+void solve_moc(const Mesh &mesh, const MocTracking &tracking, const XsLibrary &library, const DiffusionSystem &system,
+               const MocOptions &options, MocResult &result);
+
+// Csomóponti (diffúziós) fluxusból háromszögenkénti átlag, a MOC kezdőértékéhez
+std::vector<std::vector<double>> element_average_flux(const Mesh &mesh, const std::vector<std::vector<double>> &nodal);
+
+// Fizikai csoportonkénti átlagfluxus összevetés a diffúziós megoldással (mint az SN-nél)
+std::vector<SnRegionComparison> compare_region_flux(const Mesh &mesh, const DiffusionSystem &system,
+                                                    const MocResult &transport,
+                                                    const std::vector<std::vector<double>> &diffusionFlux);
+
+#endif // MOC_HPP
@@ -463,6 +463,72 @@ void loadModel(const std::string &path, ModelLibrary &model)
       }
       continue;
     }
+
+    // --- 6) Thermal (keverékenkénti hővezetési tényező, opcionális) ---
+    if (cleaned == "$Thermal")
+    {
+      const std::size_t thermalCount = read_count(input, lineNo, "$Thermal");
+      for (std::size_t i = 0; i < thermalCount; ++i)
+      {
+        if (!std::getline(input, line))
+        {
+          throw_at_line(lineNo + 1, "$Thermal blokk vége előtt elfogyott a fájl.");
+        }
+        ++lineNo;
+        std::string thermalLine = strip_comment(line);
+        trim_inplace(thermalLine);
+        if (thermalLine.empty())
+        {
+          throw_at_line(lineNo, "$Thermal sor üres.");
+        }
+
+        // Formátum: MixtureName conductivity
+        std::istringstream iss(thermalLine);
+        std::string mixtureName;
+        double conductivity = 0.0;
+        if (!(iss >> mixtureName >> conductivity))
+        {
+          throw_at_line(lineNo, "Nem tudom kiolvasni a mixture nevet és a hővezetési tényezőt ebből a sorból: \"" + thermalLine + "\"");
+        }
+        std::string extra;
+        if (iss >> extra)
+        {
+          throw_at_line(lineNo, "Túl sok adat a thermal sorban: \"" + thermalLine + "\"");
+        }
+        if (conductivity <= 0.0)
+        {
+          throw_at_line(lineNo, "A hővezetési tényezőnek pozitívnak kell lennie: " + std::to_string(conductivity));
+        }
+
+        Mixture *mixture = nullptr;
+        for (Mixture &candidate : fresh.mixtures)
+        {
+          if (candidate.name == mixtureName)
+          {
+            mixture = &candidate;
+          }
+        }
+        if (mixture == nullptr)
+        {
+          throw_at_line(lineNo, "Ismeretlen mixture: \"" + mixtureName + "\" (a $Thermal blokk a $Mixtures után jöhet)");
+        }
+        mixture->conductivity = conductivity;
+      }
+
+      // Blokk lezárása kötelező: $EndThermal
+      if (!std::getline(input, line))
+      {
+        throw_at_line(lineNo + 1, "Hiányzik a $EndThermal sor.");
+      }
+      ++lineNo;
+      std::string endLine = strip_comment(line);
+      trim_inplace(endLine);
+      if (endLine != "$EndThermal")
+      {
+        throw_at_line(lineNo, "A $Thermal blokkot $EndThermal sorral kell zárni.");
+      }
+      continue;
+    }
   }
 
   // Sikeres betöltés után átmásoljuk az eredményt
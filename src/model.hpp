@@ -31,6 +31,7 @@ struct Mixture
   std::string name;
   double density;
   std::vector<MixtureComponent> components;
+  double conductivity = 0.0; // hővezetési tényező [W / (cm K)] a $Thermal blokkból, 0 = nincs megadva
 };
 
 // Anyag hozzárendelés: melyik zónában milyen keverék van
@@ -0,0 +1,981 @@
+#include "modes.hpp"
+#include "eigen.hpp"
+#include "vector_ops.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+namespace
+{
+typedef std::complex<double> Complex;
+typedef std::chrono::steady_clock Clock;
+
+double elapsed_ms(Clock::time_point start)
+{
+  const std::chrono::duration<double, std::milli> d = Clock::now() - start;
+  return d.count();
+}
+
+double sign_of(double a, double b)
+{
+  return b >= 0.0 ? std::fabs(a) : -std::fabs(a);
+}
+
+// A kis (projektált) sűrű mátrix sajátértékei: Hessenberg alak Gauss eliminációval (sorcserével),
+// majd Francis dupla eltolású QR. Az indexelés 1-bázisú, a klasszikus elmhes/hqr algoritmus szerint.
+std::vector<Complex> dense_eigenvalues(std::vector<double> a, int n)
+{
+  const auto at = [&](int i, int j) -> double & {
+    return a[static_cast<std::size_t>(i - 1) * static_cast<std::size_t>(n) + static_cast<std::size_t>(j - 1)];
+  };
+
+  // Hessenberg redukció
+  for (int m = 2; m < n; ++m)
+  {
+    double x = 0.0;
+    int pivot = m;
+    for (int j = m; j <= n; ++j)
+    {
+      if (std::fabs(at(j, m - 1)) > std::fabs(x))
+      {
+        x = at(j, m - 1);
+        pivot = j;
+      }
+    }
+    if (pivot != m)
+    {
+      for (int j = m - 1; j <= n; ++j)
+      {
+        std::swap(at(pivot, j), at(m, j));
+      }
+      for (int j = 1; j <= n; ++j)
+      {
+        std::swap(at(j, pivot), at(j, m));
+      }
+    }
+    if (x != 0.0)
+    {
+      for (int i = m + 1; i <= n; ++i)
+      {
+        double y = at(i, m - 1);
+        if (y != 0.0)
+        {
+          y /= x;
+          at(i, m - 1) = y;
+          for (int j = m; j <= n; ++j)
+          {
+            at(i, j) -= y * at(m, j);
+          }
+          for (int j = 1; j <= n; ++j)
+          {
+            at(j, m) += y * at(j, i);
+          }
+        }
+      }
+    }
+  }
+  for (int i = 3; i <= n; ++i)
+  {
+    for (int j = 1; j <= i - 2; ++j)
+    {
+      at(i, j) = 0.0;
+    }
+  }
+
+  // QR iteráció a Hessenberg mátrixon
+  std::vector<double> wr(static_cast<std::size_t>(n) + 1, 0.0), wi(static_cast<std::size_t>(n) + 1, 0.0);
+  double anorm = 0.0;
+  for (int i = 1; i <= n; ++i)
+  {
+    for (int j = std::max(i - 1, 1); j <= n; ++j)
+    {
+      anorm += std::fabs(at(i, j));
+    }
+  }
+  int nn = n;
+  double t = 0.0;
+  double p = 0.0, q = 0.0, r = 0.0, s = 0.0, w = 0.0, x = 0.0, y = 0.0, z = 0.0;
+  while (nn >= 1)
+  {
+    int its = 0;
+    int l = 0;
+    do
+    {
+      for (l = nn; l >= 2; --l)
+      {
+        s = std::fabs(at(l - 1, l - 1)) + std::fabs(at(l, l));
+        if (s == 0.0)
+        {
+          s = anorm;
+        }
+        if (std::fabs(at(l, l - 1)) + s == s)
+        {
+          at(l, l - 1) = 0.0;
+          break;
+        }
+      }
+      x = at(nn, nn);
+      if (l == nn)
+      {
+        wr[static_cast<std::size_t>(nn)] = x + t;
+        wi[static_cast<std::size_t>(nn)] = 0.0;
+        --nn;
+      }
+      else
+      {
+        y = at(nn - 1, nn - 1);
+        w = at(nn, nn - 1) * at(nn - 1, nn);
+        if (l == nn - 1)
+        {
+          p = 0.5 * (y - x);
+          q = p * p + w;
+          z = std::sqrt(std::fabs(q));
+          x += t;
+          const std::size_t a1 = static_cast<std::size_t>(nn - 1), a2 = static_cast<std::size_t>(nn);
+          if (q >= 0.0)
+          {
+            z = p + sign_of(z, p);
+            wr[a1] = wr[a2] = x + z;
+            if (z != 0.0)
+            {
+              wr[a2] = x - w / z;
+            }
+            wi[a1] = wi[a2] = 0.0;
+          }
+          else
+          {
+            wr[a1] = wr[a2] = x + p;
+            wi[a1] = -z;
+            wi[a2] = z;
+          }
+          nn -= 2;
+        }
+        else
+        {
+          if (its == 60)
+          {
+            throw ModeError("A projektált sajátérték feladat QR iterációja nem konvergált.");
+          }
+          if (its == 10 || its == 20 || its == 40)
+          {
+            // Kivételes eltolás
+            t += x;
+            for (int i = 1; i <= nn; ++i)
+            {
+              at(i, i) -= x;
+            }
+            s = std::fabs(at(nn, nn - 1)) + std::fabs(at(nn - 1, nn - 2));
+            y = x = 0.75 * s;
+            w = -0.4375 * s * s;
+          }
+          ++its;
+          int m = nn - 2;
+          for (; m >= l; --m)
+          {
+            z = at(m, m);
+            r = x - z;
+            s = y - z;
+            p = (r * s - w) / at(m + 1, m) + at(m, m + 1);
+            q = at(m + 1, m + 1) - z - r - s;
+            r = at(m + 2, m + 1);
+            s = std::fabs(p) + std::fabs(q) + std::fabs(r);
+            p /= s;
+            q /= s;
+            r /= s;
+            if (m == l)
+            {
+              break;
+            }
+            const double u = std::fabs(at(m, m - 1)) * (std::fabs(q) + std::fabs(r));
+            const double v = std::fabs(p) * (std::fabs(at(m - 1, m - 1)) + std::fabs(z) + std::fabs(at(m + 1, m + 1)));
+            if (u + v == v)
+            {
+              break;
+            }
+          }
+          for (int i = m + 2; i <= nn; ++i)
+          {
+            at(i, i - 2) = 0.0;
+            if (i != m + 2)
+            {
+              at(i, i - 3) = 0.0;
+            }
+          }
+          for (int k = m; k <= nn - 1; ++k)
+          {
+            if (k != m)
+            {
+              p = at(k, k - 1);
+              q = at(k + 1, k - 1);
+              r = 0.0;
+              if (k != nn - 1)
+              {
+                r = at(k + 2, k - 1);
+              }
+              x = std::fabs(p) + std::fabs(q) + std::fabs(r);
+              if (x != 0.0)
+              {
+                p /= x;
+                q /= x;
+                r /= x;
+              }
+            }
+            s = sign_of(std::sqrt(p * p + q * q + r * r), p);
+            if (s != 0.0)
+            {
+              if (k == m)
+              {
+                if (l != m)
+                {
+                  at(k, k - 1) = -at(k, k - 1);
+                }
+              }
+              else
+              {
+                at(k, k - 1) = -s * x;
+              }
+              p += s;
+              x = p / s;
+              y = q / s;
+              z = r / s;
+              q /= p;
+              r /= p;
+              for (int j = k; j <= nn; ++j)
+              {
+                p = at(k, j) + q * at(k + 1, j);
+                if (k != nn - 1)
+                {
+                  p += r * at(k + 2, j);
+                  at(k + 2, j) -= p * z;
+                }
+                at(k + 1, j) -= p * y;
+                at(k, j) -= p * x;
+              }
+              const int mmin = nn < k + 3 ? nn : k + 3;
+              for (int i = l; i <= mmin; ++i)
+              {
+                p = x * at(i, k) + y * at(i, k + 1);
+                if (k != nn - 1)
+                {
+                  p += z * at(i, k + 2);
+                  at(i, k + 2) -= p * r;
+                }
+                at(i, k + 1) -= p * q;
+                at(i, k) -= p;
+              }
+            }
+          }
+        }
+      }
+    } while (l < nn - 1);
+  }
+
+  std::vector<Complex> values(static_cast<std::size_t>(n));
+  for (int i = 1; i <= n; ++i)
+  {
+    values[static_cast<std::size_t>(i - 1)] = Complex(wr[static_cast<std::size_t>(i)], wi[static_cast<std::size_t>(i)]);
+  }
+  return values;
+}
+
+// Sajátvektor inverz iterációval (komplex LU, részleges főelem választás); egységnyi 2-norma,
+// a legnagyobb abszolút értékű elem valós pozitív
+std::vector<Complex> dense_eigenvector(const std::vector<double> &h, int n, Complex lambda)
+{
+  const std::size_t un = static_cast<std::size_t>(n);
+  std::vector<Complex> a(un * un);
+  double scaleNorm = 0.0;
+  for (std::size_t i = 0; i < un * un; ++i)
+  {
+    a[i] = h[i];
+    scaleNorm = std::max(scaleNorm, std::fabs(h[i]));
+  }
+  for (std::size_t i = 0; i < un; ++i)
+  {
+    a[i * un + i] -= lambda;
+  }
+  const double tiny = 1e-14 * std::max(scaleNorm, 1.0);
+  std::vector<int> pivot(un);
+  for (std::size_t col = 0; col < un; ++col)
+  {
+    std::size_t best = col;
+    for (std::size_t i = col + 1; i < un; ++i)
+    {
+      if (std::abs(a[i * un + col]) > std::abs(a[best * un + col]))
+      {
+        best = i;
+      }
+    }
+    pivot[col] = static_cast<int>(best);
+    if (best != col)
+    {
+      for (std::size_t j = 0; j < un; ++j)
+      {
+        std::swap(a[col * un + j], a[best * un + j]);
+      }
+    }
+    if (std::abs(a[col * un + col]) < tiny)
+    {
+      a[col * un + col] = tiny; // pontos sajátérték: a szinguláris pivot helyett kis eltolás
+    }
+    const Complex diag = a[col * un + col];
+    for (std::size_t i = col + 1; i < un; ++i)
+    {
+      const Complex factor = a[i * un + col] / diag;
+      a[i * un + col] = factor;
+      if (factor != Complex(0.0, 0.0))
+      {
+        for (std::size_t j = col + 1; j < un; ++j)
+        {
+          a[i * un + j] -= factor * a[col * un + j];
+        }
+      }
+    }
+  }
+
+  std::vector<Complex> x(un, Complex(1.0, 0.0));
+  for (int iteration = 0; iteration < 3; ++iteration)
+  {
+    for (std::size_t i = 0; i < un; ++i)
+    {
+      std::swap(x[i], x[static_cast<std::size_t>(pivot[i])]);
+      for (std::size_t j = 0; j < i; ++j)
+      {
+        x[i] -= a[i * un + j] * x[j];
+      }
+    }
+    for (std::size_t ii = un; ii-- > 0;)
+    {
+      for (std::size_t j = ii + 1; j < un; ++j)
+      {
+        x[ii] -= a[ii * un + j] * x[j];
+      }
+      x[ii] /= a[ii * un + ii];
+    }
+    double norm = 0.0;
+    for (const Complex &v : x)
+    {
+      norm += std::norm(v);
+    }
+    norm = std::sqrt(norm);
+    for (Complex &v : x)
+    {
+      v /= norm;
+    }
+  }
+  std::size_t largest = 0;
+  for (std::size_t i = 1; i < un; ++i)
+  {
+    if (std::abs(x[i]) > std::abs(x[largest]))
+    {
+      largest = i;
+    }
+  }
+  const Complex phase = std::abs(x[largest]) > 0.0 ? std::conj(x[largest]) / std::abs(x[largest]) : Complex(1.0, 0.0);
+  for (Complex &v : x)
+  {
+    v *= phase;
+  }
+  return x;
+}
+
+// c[j] = <V[j], z>, j < count. A z egy darabja a gyorsítótárban marad, amíg a teljes bázissal szorzódik.
+void project(const std::vector<std::vector<double>> &V, std::size_t count, const std::vector<double> &z, std::vector<double> &c)
+{
+  const std::size_t threads = static_cast<std::size_t>(thread_count());
+  std::vector<double> partial(threads * count, 0.0);
+  parallel_chunks(0, z.size(), [&](int t, std::size_t b, std::size_t e) {
+    double *out = partial.data() + static_cast<std::size_t>(t) * count;
+    for (std::size_t j = 0; j < count; ++j)
+    {
+      const double *v = V[j].data();
+      double s = 0.0;
+      for (std::size_t i = b; i < e; ++i)
+      {
+        s += v[i] * z[i];
+      }
+      out[j] = s;
+    }
+  });
+  c.assign(count, 0.0);
+  for (std::size_t t = 0; t < threads; ++t)
+  {
+    for (std::size_t j = 0; j < count; ++j)
+    {
+      c[j] += partial[t * count + j];
+    }
+  }
+}
+
+// z -= sum_j c[j] V[j]
+void subtract(const std::vector<std::vector<double>> &V, const std::vector<double> &c, std::vector<double> &z)
+{
+  parallel_for(0, z.size(), [&](std::size_t i) {
+    double s = 0.0;
+    for (std::size_t j = 0; j < c.size(); ++j)
+    {
+      s += c[j] * V[j][i];
+    }
+    z[i] -= s;
+  });
+}
+
+// T = (A - S)^-1 F alkalmazása egy vektorblokkra (vektoronként G * N hosszú, csoportonként egymás után)
+class ModeOperator
+{
+public:
+  ModeOperator(const DiffusionSystem &system, GroupSolver &solver, const ModeOptions &options, ModeResult &result)
+      : m_system(system), m_solver(solver), m_options(options), m_result(result)
+  {
+    for (const GroupCoupling &c : system.scatter)
+    {
+      m_upscatter = m_upscatter || c.from > c.to;
+    }
+  }
+
+  void apply(const std::vector<std::vector<double>> &V, std::size_t first, std::size_t count,
+             std::vector<std::vector<double>> &out)
+  {
+    const Clock::time_point start = Clock::now();
+    const std::size_t G = static_cast<std::size_t>(m_system.groupCount);
+    const std::size_t N = static_cast<std::size_t>(m_system.nodeCount);
+    m_flux.resize(count);
+    m_source.resize(count);
+    for (std::size_t v = 0; v < count; ++v)
+    {
+      m_flux[v].resize(G);
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        const std::vector<double> &x = V[first + v];
+        m_flux[v][g].assign(x.begin() + static_cast<std::ptrdiff_t>(g * N), x.begin() + static_cast<std::ptrdiff_t>((g + 1) * N));
+      }
+      compute_fission_source(m_system, m_flux[v], m_source[v]);
+    }
+
+    // m_y[g][v]: a blokk vektorai csoportonként együtt, hogy egy csoport megoldása blokkolt lehessen
+    m_y.assign(G, std::vector<std::vector<double>>(count, std::vector<double>(N, 0.0)));
+    if (m_solver.coupled())
+    {
+      std::vector<std::vector<double>> y(G, std::vector<double>(N, 0.0));
+      for (std::size_t v = 0; v < count; ++v)
+      {
+        for (std::vector<double> &yg : y)
+        {
+          std::fill(yg.begin(), yg.end(), 0.0);
+        }
+        const InnerStats stats = m_solver.solve_coupled(m_source[v], y);
+        m_result.innerIterations += stats.iterations;
+        ++m_result.innerSolves;
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          m_y[g][v] = y[g];
+        }
+      }
+    }
+    else
+    {
+      // Csoportonkénti Gauss–Seidel; felszórásnál a menetek a változás elhalásáig ismétlődnek
+      m_rhs.resize(count);
+      const int sweeps = m_upscatter ? std::max(1, m_options.maxSweeps) : 1;
+      std::vector<double> previous;
+      for (int sweep = 0; sweep < sweeps; ++sweep)
+      {
+        double change = 0.0, norm = 0.0;
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          for (std::size_t v = 0; v < count; ++v)
+          {
+            m_rhs[v] = m_source[v][g];
+            for (const GroupCoupling &c : m_system.scatter)
+            {
+              if (static_cast<std::size_t>(c.to) == g)
+              {
+                c.matrix.multiply_add(1.0, m_y[static_cast<std::size_t>(c.from)][v], m_rhs[v]);
+              }
+            }
+          }
+          std::vector<std::vector<double>> old;
+          if (m_upscatter)
+          {
+            old = m_y[g];
+          }
+          const InnerStats stats = m_solver.solve_block(static_cast<int>(g), m_rhs, m_y[g]);
+          m_result.innerIterations += stats.iterations;
+          ++m_result.innerSolves;
+          if (m_upscatter)
+          {
+            for (std::size_t v = 0; v < count; ++v)
+            {
+              axpy(-1.0, m_y[g][v], old[v]);
+              change += dot(old[v], old[v]);
+              norm += dot(m_y[g][v], m_y[g][v]);
+            }
+          }
+        }
+        if (!m_upscatter || std::sqrt(change) <= 0.1 * m_options.tolerance * std::sqrt(norm))
+        {
+          break;
+        }
+      }
+    }
+
+    out.resize(count);
+    for (std::size_t v = 0; v < count; ++v)
+    {
+      out[v].resize(G * N);
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        std::copy(m_y[g][v].begin(), m_y[g][v].end(), out[v].begin() + static_cast<std::ptrdiff_t>(g * N));
+      }
+    }
+    m_result.applications += static_cast<int>(count);
+    ++m_result.blockApplications;
+    m_result.operatorMs += elapsed_ms(start);
+  }
+
+private:
+  const DiffusionSystem &m_system;
+  GroupSolver &m_solver;
+  const ModeOptions &m_options;
+  ModeResult &m_result;
+  bool m_upscatter = false;
+  std::vector<std::vector<std::vector<double>>> m_flux;   // [v][g]
+  std::vector<std::vector<std::vector<double>>> m_source; // [v][g]
+  std::vector<std::vector<std::vector<double>>> m_y;      // [g][v]
+  std::vector<std::vector<double>> m_rhs;                 // [v]
+};
+
+// Sajátértékek sorrendje: csökkenő abszolút érték, komplex párnál a pozitív képzetes rész elöl
+std::vector<int> sorted_order(const std::vector<Complex> &values)
+{
+  std::vector<int> order(values.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+  {
+    order[i] = static_cast<int>(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    const Complex &va = values[static_cast<std::size_t>(a)];
+    const Complex &vb = values[static_cast<std::size_t>(b)];
+    const double ma = std::abs(va), mb = std::abs(vb);
+    if (std::fabs(ma - mb) > 1e-14 * std::max(ma, mb))
+    {
+      return ma > mb;
+    }
+    return va.imag() > vb.imag();
+  });
+  return order;
+}
+
+} // namespace
+
+ModeOptions read_mode_options(const SolverConfig &config)
+{
+  ModeOptions options;
+  options.count = config.getInt("modes", options.count);
+  options.block = config.getInt("modes_block", options.block);
+  options.subspace = config.getInt("modes_subspace", options.subspace);
+  options.tolerance = config.getDouble("modes_tol", options.tolerance);
+  options.maxRestarts = config.getInt("modes_max_restarts", options.maxRestarts);
+  options.maxSweeps = config.getInt("modes_max_sweeps", options.maxSweeps);
+  if (options.count < 1)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Hibás módusszám: " << options.count << ", 1-et használok.\n";
+    options.count = 1;
+  }
+  if (options.block < 1 || options.block > 8)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A modes_block 1 és 8 között lehet, " << ModeOptions().block << "-t használok.\n";
+    options.block = ModeOptions().block;
+  }
+  if (options.subspace != 0 && options.subspace < options.count + 2 * options.block)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A modes_subspace legalább modes + 2 * modes_block kell legyen, automatikus méretet használok.\n";
+    options.subspace = 0;
+  }
+  if (options.tolerance <= 0.0)
+  {
+    options.tolerance = ModeOptions().tolerance;
+  }
+  return options;
+}
+
+void solve_modes(const DiffusionSystem &system, GroupSolver &solver, const ModeOptions &options, ModeResult &result)
+{
+  const Clock::time_point start = Clock::now();
+  result = ModeResult();
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t N = static_cast<std::size_t>(system.nodeCount);
+  const std::size_t L = G * N;
+  const int nev = options.count;
+  const int b = options.block;
+  const int mMax = options.subspace > 0 ? options.subspace : std::max(2 * nev, nev + 8) + b;
+  if (static_cast<std::size_t>(mMax + b) > L)
+  {
+    throw ModeError("A Krylov bázis (" + std::to_string(mMax + b) + ") nagyobb, mint az ismeretlenek száma.");
+  }
+  result.basisSize = mMax;
+
+  ModeOperator op(system, solver, options, result);
+  std::mt19937 random(20240601u);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+  // Ortonormált bázis és a projektált (m + b) x m mátrix (sorfolytonos, m = mMax oszlop)
+  std::vector<std::vector<double>> V;
+  V.reserve(static_cast<std::size_t>(mMax + b));
+  const std::size_t ld = static_cast<std::size_t>(mMax);
+  std::vector<double> H(static_cast<std::size_t>(mMax + b) * ld, 0.0);
+  const auto h = [&](int i, int j) -> double & { return H[static_cast<std::size_t>(i) * ld + static_cast<std::size_t>(j)]; };
+
+  // z ortogonalizálása a teljes bázisra (klasszikus Gram–Schmidt, két menet); a visszatérés a maradék normája
+  std::vector<double> pass;
+  const auto orthogonalize = [&](std::vector<double> &z, std::vector<double> &coefficients) {
+    coefficients.assign(V.size(), 0.0);
+    for (int p = 0; p < 2; ++p)
+    {
+      project(V, V.size(), z, pass);
+      subtract(V, pass, z);
+      for (std::size_t j = 0; j < pass.size(); ++j)
+      {
+        coefficients[j] += pass[j];
+      }
+    }
+    return norm2(z);
+  };
+  const auto random_direction = [&](std::vector<double> &z) {
+    std::vector<double> ignored;
+    for (int attempt = 0; attempt < 3; ++attempt)
+    {
+      for (double &value : z)
+      {
+        value = uniform(random);
+      }
+      const double norm = orthogonalize(z, ignored);
+      if (norm > 1e-8 * std::sqrt(static_cast<double>(L)))
+      {
+        scale(1.0 / norm, z);
+        return;
+      }
+    }
+    throw ModeError("Nem található új ortogonális irány a Krylov bázishoz.");
+  };
+
+  // Kezdő blokk: egyenletes fluxus (az alapmódus iránya) + véletlen vektorok
+  {
+    const Clock::time_point orthStart = Clock::now();
+    std::vector<double> coefficients;
+    for (int c = 0; c < b; ++c)
+    {
+      std::vector<double> z(L, 1.0);
+      if (c == 0)
+      {
+        const double norm = orthogonalize(z, coefficients);
+        scale(1.0 / norm, z);
+      }
+      else
+      {
+        random_direction(z);
+      }
+      V.push_back(std::move(z));
+    }
+    result.orthogonalizeMs += elapsed_ms(orthStart);
+  }
+
+  int k = 0; // a Krylov–Schur felbontás mérete: T V[0..k) = V[0..k+b) H[0..k+b, 0..k)
+  std::vector<Complex> values;
+  std::vector<int> order;
+  std::vector<std::vector<Complex>> ritz; // a sorrend szerinti Ritz vektorok (a projektált térben)
+  std::vector<double> estimates;
+  std::vector<std::vector<double>> Z;
+  while (true)
+  {
+    // Bővítés blokkonként, amíg a bázis meg nem telik
+    while (k + b <= mMax)
+    {
+      op.apply(V, static_cast<std::size_t>(k), static_cast<std::size_t>(b), Z);
+      const Clock::time_point orthStart = Clock::now();
+      std::vector<double> coefficients;
+      for (int c = 0; c < b; ++c)
+      {
+        std::vector<double> &z = Z[static_cast<std::size_t>(c)];
+        const double original = norm2(z);
+        const double norm = orthogonalize(z, coefficients);
+        for (std::size_t j = 0; j < coefficients.size(); ++j)
+        {
+          h(static_cast<int>(j), k + c) = coefficients[j];
+        }
+        const int row = static_cast<int>(V.size());
+        if (norm <= 1e-10 * original)
+        {
+          // Invariáns altér (vagy lineárisan függő blokk vektor): a bővítés új irányból folytatódik
+          h(row, k + c) = 0.0;
+          random_direction(z);
+        }
+        else
+        {
+          h(row, k + c) = norm;
+          scale(1.0 / norm, z);
+        }
+        V.push_back(z);
+      }
+      k += b;
+      result.orthogonalizeMs += elapsed_ms(orthStart);
+    }
+
+    // Rayleigh–Ritz a projektált k x k mátrixon
+    const Clock::time_point restartStart = Clock::now();
+    std::vector<double> Hk(static_cast<std::size_t>(k) * static_cast<std::size_t>(k));
+    for (int i = 0; i < k; ++i)
+    {
+      for (int j = 0; j < k; ++j)
+      {
+        Hk[static_cast<std::size_t>(i) * static_cast<std::size_t>(k) + static_cast<std::size_t>(j)] = h(i, j);
+      }
+    }
+    values = dense_eigenvalues(Hk, k);
+    order = sorted_order(values);
+
+    // Megtartott Ritz párok: nev + a maradék fele, a komplex párokat nem vágjuk ketté
+    int keep = std::min(k - b, nev + (k - nev) / 2);
+    const auto splits_pair = [&](int count) {
+      const Complex &last = values[static_cast<std::size_t>(order[static_cast<std::size_t>(count - 1)])];
+      return last.imag() > 0.0 && count < k;
+    };
+    if (splits_pair(keep))
+    {
+      keep = keep + 1 <= k - b || keep == nev ? keep + 1 : keep - 1;
+    }
+    int wanted = nev;
+    if (splits_pair(wanted))
+    {
+      ++wanted; // a pár másik fele is kell a valós bázishoz
+    }
+    keep = std::max(keep, wanted);
+
+    ritz.assign(static_cast<std::size_t>(keep), std::vector<Complex>());
+    estimates.assign(static_cast<std::size_t>(keep), 0.0);
+    bool allConverged = true;
+    for (int i = 0; i < keep; ++i)
+    {
+      const Complex lambda = values[static_cast<std::size_t>(order[static_cast<std::size_t>(i)])];
+      std::vector<Complex> &y = ritz[static_cast<std::size_t>(i)];
+      y = dense_eigenvector(Hk, k, lambda);
+      // ||T x - lambda x|| = ||H[k..k+b, 0..k) y|| (a bázis ortonormált)
+      double tail = 0.0;
+      for (int r = 0; r < b; ++r)
+      {
+        Complex s(0.0, 0.0);
+        for (int j = 0; j < k; ++j)
+        {
+          s += h(k + r, j) * y[static_cast<std::size_t>(j)];
+        }
+        tail += std::norm(s);
+      }
+      estimates[static_cast<std::size_t>(i)] = std::sqrt(tail) / std::max(std::abs(lambda), 1e-300);
+      if (i < nev && estimates[static_cast<std::size_t>(i)] > options.tolerance)
+      {
+        allConverged = false;
+      }
+    }
+    if (allConverged || result.restarts >= options.maxRestarts)
+    {
+      result.converged = allConverged;
+      result.restartMs += elapsed_ms(restartStart);
+      break;
+    }
+
+    // Újraindítás: a megtartott Ritz vektorok valós ortonormált bázisa (Q, k x p)
+    std::vector<std::vector<double>> Q;
+    for (int i = 0; i < keep; ++i)
+    {
+      const std::vector<Complex> &y = ritz[static_cast<std::size_t>(i)];
+      const Complex lambda = values[static_cast<std::size_t>(order[static_cast<std::size_t>(i)])];
+      std::vector<std::vector<double>> parts(1, std::vector<double>(static_cast<std::size_t>(k)));
+      for (int j = 0; j < k; ++j)
+      {
+        parts[0][static_cast<std::size_t>(j)] = y[static_cast<std::size_t>(j)].real();
+      }
+      if (lambda.imag() > 0.0)
+      {
+        parts.push_back(std::vector<double>(static_cast<std::size_t>(k)));
+        for (int j = 0; j < k; ++j)
+        {
+          parts[1][static_cast<std::size_t>(j)] = y[static_cast<std::size_t>(j)].imag();
+        }
+      }
+      else if (lambda.imag() < 0.0)
+      {
+        continue; // a konjugált pár már benne van
+      }
+      for (std::vector<double> &q : parts)
+      {
+        const double original = std::sqrt(std::inner_product(q.begin(), q.end(), q.begin(), 0.0));
+        for (int p = 0; p < 2; ++p)
+        {
+          for (const std::vector<double> &prev : Q)
+          {
+            const double c = std::inner_product(prev.begin(), prev.end(), q.begin(), 0.0);
+            for (int j = 0; j < k; ++j)
+            {
+              q[static_cast<std::size_t>(j)] -= c * prev[static_cast<std::size_t>(j)];
+            }
+          }
+        }
+        const double norm = std::sqrt(std::inner_product(q.begin(), q.end(), q.begin(), 0.0));
+        if (norm > 1e-10 * original)
+        {
+          for (double &value : q)
+          {
+            value /= norm;
+          }
+          Q.push_back(q);
+        }
+      }
+    }
+    const int p = static_cast<int>(Q.size());
+
+    // V <- [V[0..k) Q, V[k..k+b)]
+    std::vector<std::vector<double>> newV(static_cast<std::size_t>(p), std::vector<double>(L, 0.0));
+    parallel_for(0, L, [&](std::size_t i) {
+      for (int j = 0; j < p; ++j)
+      {
+        const std::vector<double> &q = Q[static_cast<std::size_t>(j)];
+        double s = 0.0;
+        for (int l = 0; l < k; ++l)
+        {
+          s += q[static_cast<std::size_t>(l)] * V[static_cast<std::size_t>(l)][i];
+        }
+        newV[static_cast<std::size_t>(j)][i] = s;
+      }
+    });
+    for (int c = 0; c < b; ++c)
+    {
+      newV.push_back(std::move(V[static_cast<std::size_t>(k + c)]));
+    }
+    V.swap(newV);
+
+    // H <- [Q^T H_k Q; H[k..k+b, 0..k) Q]
+    std::vector<double> HQ(static_cast<std::size_t>(k + b) * static_cast<std::size_t>(p), 0.0);
+    for (int i = 0; i < k + b; ++i)
+    {
+      for (int j = 0; j < p; ++j)
+      {
+        double s = 0.0;
+        for (int l = 0; l < k; ++l)
+        {
+          s += h(i, l) * Q[static_cast<std::size_t>(j)][static_cast<std::size_t>(l)];
+        }
+        HQ[static_cast<std::size_t>(i) * static_cast<std::size_t>(p) + static_cast<std::size_t>(j)] = s;
+      }
+    }
+    std::fill(H.begin(), H.end(), 0.0);
+    for (int i = 0; i < p; ++i)
+    {
+      for (int j = 0; j < p; ++j)
+      {
+        double s = 0.0;
+        for (int l = 0; l < k; ++l)
+        {
+          s += Q[static_cast<std::size_t>(i)][static_cast<std::size_t>(l)] *
+               HQ[static_cast<std::size_t>(l) * static_cast<std::size_t>(p) + static_cast<std::size_t>(j)];
+        }
+        h(i, j) = s;
+      }
+    }
+    for (int r = 0; r < b; ++r)
+    {
+      for (int j = 0; j < p; ++j)
+      {
+        h(p + r, j) = HQ[static_cast<std::size_t>(k + r) * static_cast<std::size_t>(p) + static_cast<std::size_t>(j)];
+      }
+    }
+    k = p;
+    ++result.restarts;
+    result.restartMs += elapsed_ms(restartStart);
+  }
+
+  // Módusok: x = V[0..k) y, valódi reziduum a teljes operátorral
+  const Clock::time_point residualStart = Clock::now();
+  for (int i = 0; i < nev && i < static_cast<int>(ritz.size()); ++i)
+  {
+    const std::vector<Complex> &y = ritz[static_cast<std::size_t>(i)];
+    const Complex lambda = values[static_cast<std::size_t>(order[static_cast<std::size_t>(i)])];
+    std::vector<double> xr(L, 0.0), xi(L, 0.0);
+    parallel_for(0, L, [&](std::size_t n) {
+      double sr = 0.0, si = 0.0;
+      for (int j = 0; j < k; ++j)
+      {
+        const double v = V[static_cast<std::size_t>(j)][n];
+        sr += y[static_cast<std::size_t>(j)].real() * v;
+        si += y[static_cast<std::size_t>(j)].imag() * v;
+      }
+      xr[n] = sr;
+      xi[n] = si;
+    });
+
+    // (A - S) x és F x csoportonként, a valós és képzetes részre
+    std::vector<std::vector<double>> partsRe(G), partsIm(G), lossRe(G), lossIm(G), fissRe, fissIm;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      partsRe[g].assign(xr.begin() + static_cast<std::ptrdiff_t>(g * N), xr.begin() + static_cast<std::ptrdiff_t>((g + 1) * N));
+      partsIm[g].assign(xi.begin() + static_cast<std::ptrdiff_t>(g * N), xi.begin() + static_cast<std::ptrdiff_t>((g + 1) * N));
+    }
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      system.groupMatrix[g].multiply(partsRe[g], lossRe[g]);
+      system.groupMatrix[g].multiply(partsIm[g], lossIm[g]);
+    }
+    for (const GroupCoupling &c : system.scatter)
+    {
+      c.matrix.multiply_add(-1.0, partsRe[static_cast<std::size_t>(c.from)], lossRe[static_cast<std::size_t>(c.to)]);
+      c.matrix.multiply_add(-1.0, partsIm[static_cast<std::size_t>(c.from)], lossIm[static_cast<std::size_t>(c.to)]);
+    }
+    compute_fission_source(system, partsRe, fissRe);
+    compute_fission_source(system, partsIm, fissIm);
+    const Complex mu = 1.0 / lambda;
+    double residual = 0.0, reference = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      for (std::size_t n = 0; n < N; ++n)
+      {
+        const Complex f(fissRe[g][n], fissIm[g][n]);
+        const Complex r = Complex(lossRe[g][n], lossIm[g][n]) - mu * f;
+        residual += std::norm(r);
+        reference += std::norm(mu * f);
+      }
+    }
+
+    EigenMode mode;
+    mode.k = lambda.real();
+    mode.kImag = lambda.imag();
+    mode.estimate = estimates[static_cast<std::size_t>(i)];
+    mode.converged = mode.estimate <= options.tolerance;
+    mode.residual = reference > 0.0 ? std::sqrt(residual / reference) : 0.0;
+    // Normálás: egységnyi 2-norma, a legnagyobb abszolút értékű elem pozitív
+    std::size_t largest = 0;
+    for (std::size_t n = 1; n < L; ++n)
+    {
+      if (std::fabs(xr[n]) > std::fabs(xr[largest]))
+      {
+        largest = n;
+      }
+    }
+    const double norm = norm2(xr);
+    const double factor = (xr[largest] < 0.0 ? -1.0 : 1.0) / (norm > 0.0 ? norm : 1.0);
+    mode.flux.resize(G);
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      mode.flux[g].resize(N);
+      for (std::size_t n = 0; n < N; ++n)
+      {
+        mode.flux[g][n] = factor * xr[g * N + n];
+      }
+    }
+    result.modes.push_back(std::move(mode));
+  }
+  result.residualMs = elapsed_ms(residualStart);
+  result.totalMs = elapsed_ms(start);
+}
@@ -0,0 +1,74 @@
+#ifndef MODES_HPP
+#define MODES_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "inner_solver.hpp"
+#include <stdexcept>
+#include <vector>
+
+// Magasabb lambda-módusok (harmonikusok) blokk Krylov–Schur sajátérték megoldóval.
+//
+// Az általánosított feladat (A - S) phi = (1/k) F phi helyett a T = (A - S)^-1 F operátor legnagyobb
+// abszolút értékű sajátértékeit keressük: ezek közvetlenül a k_i értékek. T alkalmazása egy fix forrású
+// többcsoportos megoldás ugyanazzal a belső megoldóval, mint a hatványiterációban (csoportonkénti
+// Gauss–Seidel, vagy csatolt megoldó). A Krylov bázis b vektoros blokkokban bővül: egy blokk minden
+// vektorának csoportmegoldásai együtt futnak (solve_block), így a PCG egy mátrix olvasással szolgálja
+// ki a blokk összes vektorát, és az ortogonalizálás (klasszikus Gram–Schmidt, két menet) is egyetlen
+// menetben skalárszoroz egy vektort a teljes bázissal.
+// A blokkosítás a mérések szerint nem éri meg (b > 1-nél a szükséges T alkalmazások száma gyorsabban nő, mint
+// amennyit a közös SpMV vektoronként megtakarít), ezért az alapértelmezett blokkméret 1.
+//
+// Újraindítás (Krylov–Schur): a kis projektált mátrix kívánt Ritz vektoraiból (komplex pároknál a valós
+// és képzetes rész) ortonormált Q bázis, V <- V Q, H <- Q^T H Q, a maradék blokk sor H_{m+1} Q. Így a
+// megtartott altér invariáns a projektált feladatra, és a bővítés a bázis utolsó blokkjából folytatódik.
+
+class ModeError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct ModeOptions
+{
+  int count = 4;            // keresett módusok száma
+  int block = 1;            // blokkméret: egyszerre alkalmazott vektorok (> 1: közös SpMV menetek)
+  int subspace = 0;         // a Krylov bázis maximális mérete (0 = automatikus: max(2 * count, count + 8) + block)
+  double tolerance = 1e-6;  // ||T x - k x|| / |k| becslés a projektált feladatból
+  int maxRestarts = 50;
+  int maxSweeps = 50;       // felszórásnál csoport Gauss–Seidel menetek egy T alkalmazásban
+};
+
+ModeOptions read_mode_options(const SolverConfig &config);
+
+struct EigenMode
+{
+  double k = 0.0;
+  double kImag = 0.0;                    // nem nulla: komplex konjugált pár (a fluxus a valós rész)
+  std::vector<std::vector<double>> flux; // flux[g][csomópont], egységnyi 2-normára, a legnagyobb elem pozitív
+  double residual = 0.0;                 // valódi relatív reziduum: ||(A - S) x - F x / k|| / ||F x / k||
+  double estimate = 0.0;                 // a Krylov–Schur becslés az utolsó projekcióból
+  bool converged = false;
+};
+
+struct ModeResult
+{
+  std::vector<EigenMode> modes;
+  bool converged = false;
+  int restarts = 0;
+  int basisSize = 0;           // a tényleges maximális bázisméret
+  int applications = 0;        // T alkalmazások (vektoronként)
+  int blockApplications = 0;   // blokkolt T alkalmazások
+  long innerIterations = 0;
+  int innerSolves = 0;         // csoport megoldások (blokkonként egy)
+  double totalMs = 0.0;
+  double operatorMs = 0.0;     // T alkalmazás (belső megoldó + hasadási forrás)
+  double orthogonalizeMs = 0.0;
+  double restartMs = 0.0;      // projektált sajátérték feladat + újraindítás
+  double residualMs = 0.0;
+};
+
+// Az első options.count módus. Sikertelen (nem konvergált) futásnál is a legjobb közelítést adja vissza.
+void solve_modes(const DiffusionSystem &system, GroupSolver &solver, const ModeOptions &options, ModeResult &result);
+
+#endif // MODES_HPP
@@ -0,0 +1,763 @@
+#include "monte_carlo.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace
+{
+  const double PI = 3.14159265358979323846;
+  const long MAX_EVENTS = 10000000; // eseménykorlát részecskénként (csak hibás adatnál érhető el)
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  std::pair<int, int> edge_key(int a, int b)
+  {
+    return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+  }
+
+  std::uint64_t splitmix64(std::uint64_t &state)
+  {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // Egy részecske (vagy egy ciklus) folyamának kulcsa: a mag, a ciklus és a sorszám keverése
+  std::uint64_t stream_key(std::uint64_t seed, std::uint64_t batch, std::uint64_t index)
+  {
+    std::uint64_t s = seed;
+    std::uint64_t key = splitmix64(s);
+    s = key ^ (batch * 0xd1b54a32d192ed03ull);
+    key = splitmix64(s);
+    s = key ^ (index * 0xaef17502108ef2d9ull);
+    return splitmix64(s);
+  }
+
+  // xoshiro256**: gyors, 2^256 periódusú generátor; az állapot a folyam kulcsából splitmix64-gyel
+  class Rng
+  {
+  public:
+    explicit Rng(std::uint64_t key)
+    {
+      for (std::uint64_t &word : m_state)
+      {
+        word = splitmix64(key);
+      }
+    }
+
+    double uniform() // [0, 1)
+    {
+      return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double uniform_open() // (0, 1]
+    {
+      return 1.0 - uniform();
+    }
+
+  private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t next()
+    {
+      const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+      const std::uint64_t t = m_state[1] << 17;
+      m_state[2] ^= m_state[0];
+      m_state[3] ^= m_state[1];
+      m_state[1] ^= m_state[2];
+      m_state[0] ^= m_state[3];
+      m_state[2] ^= t;
+      m_state[3] = rotl(m_state[3], 45);
+      return result;
+    }
+
+    std::uint64_t m_state[4];
+  };
+
+  void isotropic(Rng &rng, double &u, double &v, double &w)
+  {
+    w = 2.0 * rng.uniform() - 1.0;
+    const double phi = 2.0 * PI * rng.uniform();
+    const double s = std::sqrt(std::max(0.0, 1.0 - w * w));
+    u = s * std::cos(phi);
+    v = s * std::sin(phi);
+  }
+
+  int sample_cdf(const double *cdf, int n, double xi)
+  {
+    for (int i = 0; i < n - 1; ++i)
+    {
+      if (xi < cdf[i])
+      {
+        return i;
+      }
+    }
+    return n - 1;
+  }
+}
+
+// Szálankénti becslők és hasadási bank (csak az adott szál írja)
+struct MonteCarlo::Tally
+{
+  std::vector<double> flux; // [régió * G + g]: sum 1 / majoráns minden ütközésben
+  double production = 0.0;  // sum nu sigma_f / majoráns
+  double kCollision = 0.0;
+  double kAbsorption = 0.0;
+  long long collisions = 0;
+  long long realCollisions = 0;
+  long long leaked = 0;
+  long long lost = 0;
+  std::vector<Site> bank;
+};
+
+MonteCarloOptions read_monte_carlo_options(const SolverConfig &config)
+{
+  MonteCarloOptions options;
+  options.particles = config.getInt("mc_particles", options.particles);
+  options.batches = config.getInt("mc_batches", options.batches);
+  options.inactive = config.getInt("mc_inactive", options.inactive);
+  options.seed = static_cast<std::uint64_t>(config.getInt("mc_seed", static_cast<int>(options.seed)));
+  if (options.particles < 1 || options.inactive < 0 || options.batches - options.inactive < 2)
+  {
+    throw MonteCarloError("Az mc_particles pozitív, és legalább két aktív ciklus kell (mc_batches - mc_inactive >= 2).");
+  }
+  return options;
+}
+
+MonteCarlo::MonteCarlo(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system)
+    : m_mesh(mesh), m_system(system), m_groupCount(system.groupCount)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const XsCompiled &xs = library.compiled;
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t M = static_cast<std::size_t>(xs.materialCount);
+  const std::size_t E = mesh.tris.size();
+  if (E == 0)
+  {
+    throw MonteCarloError("A hálóban nincs háromszög.");
+  }
+
+  // --- Anyag táblák: sigma_t, teljes szórás, kumulált szórási és hasadási spektrum ---
+  m_sigmaT.assign(M * G, 0.0);
+  m_scatterTotal.assign(M * G, 0.0);
+  m_nuSigmaF.assign(M * G, 0.0);
+  m_scatterCdf.assign(M * G * G, 1.0);
+  m_chiCdf.assign(M * G, 1.0);
+  for (std::size_t m = 0; m < M; ++m)
+  {
+    const double *scatter = xs.scatter_of(static_cast<int>(m));
+    double chiSum = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      chiSum += std::max(0.0, xs.chi[m * G + g]);
+    }
+    double chiRun = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      m_sigmaT[m * G + g] = xs.sigma_t[m * G + g];
+      m_nuSigmaF[m * G + g] = xs.nu_sigma_f[m * G + g];
+      double total = 0.0;
+      for (std::size_t to = 0; to < G; ++to)
+      {
+        total += std::max(0.0, scatter[g * G + to]);
+      }
+      m_scatterTotal[m * G + g] = std::min(total, m_sigmaT[m * G + g]);
+      double run = 0.0;
+      for (std::size_t to = 0; to < G && total > 0.0; ++to)
+      {
+        run += std::max(0.0, scatter[g * G + to]);
+        m_scatterCdf[(m * G + g) * G + to] = run / total;
+      }
+      chiRun += std::max(0.0, xs.chi[m * G + g]);
+      m_chiCdf[m * G + g] = chiSum > 0.0 ? chiRun / chiSum : 1.0;
+    }
+  }
+
+  // Majoráns: a hálóban ténylegesen előforduló anyagok legnagyobb sigma_t értéke csoportonként
+  m_majorant.assign(G, 0.0);
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    const std::size_t m = static_cast<std::size_t>(system.elementMaterial[e]);
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      m_majorant[g] = std::max(m_majorant[g], m_sigmaT[m * G + g]);
+    }
+  }
+  for (std::size_t g = 0; g < G; ++g)
+  {
+    if (!(m_majorant[g] > 0.0))
+    {
+      throw MonteCarloError("A delta követéshez minden csoportban pozitív teljes hatáskeresztmetszet kell.");
+    }
+  }
+
+  // --- Háromszögek, régiók (fizikai csoportok), hasadási forrás eloszlás ---
+  m_vertex.resize(6 * E);
+  m_region.resize(E);
+  std::map<int, int> regionOf;
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    regionOf[mesh.tris[e].phys] = 0;
+  }
+  for (std::map<int, int>::iterator it = regionOf.begin(); it != regionOf.end(); ++it)
+  {
+    it->second = static_cast<int>(m_regionInfo.size());
+    MonteCarloRegion info;
+    info.phys = it->first;
+    const std::map<int, std::string>::const_iterator name = mesh.physNames.find(it->first);
+    info.name = name != mesh.physNames.end() ? name->second : std::to_string(it->first);
+    m_regionInfo.push_back(info);
+  }
+  double xmin = std::numeric_limits<double>::max(), ymin = xmin, xmax = -xmin, ymax = -xmin;
+  double fissileArea = 0.0;
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int ids[3] = {t.a, t.b, t.c};
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      const Mesh::Node &n = mesh.nodes[static_cast<std::size_t>(ids[k])];
+      m_vertex[6 * e + 2 * k] = n.x;
+      m_vertex[6 * e + 2 * k + 1] = n.y;
+      xmin = std::min(xmin, n.x);
+      xmax = std::max(xmax, n.x);
+      ymin = std::min(ymin, n.y);
+      ymax = std::max(ymax, n.y);
+    }
+    m_region[e] = regionOf[t.phys];
+    const double area = system.geometry[e].area;
+    m_regionInfo[static_cast<std::size_t>(m_region[e])].area += area;
+    const std::size_t m = static_cast<std::size_t>(system.elementMaterial[e]);
+    double production = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      production += m_nuSigmaF[m * G + g];
+    }
+    if (production > 0.0)
+    {
+      fissileArea += area;
+      m_sourceElement.push_back(static_cast<int>(e));
+      m_sourceCdf.push_back(fissileArea);
+    }
+  }
+  if (m_sourceElement.empty())
+  {
+    throw MonteCarloError("A rendszerben nincs hasadóanyag, a k-sajátérték nem értelmezhető.");
+  }
+  for (double &c : m_sourceCdf)
+  {
+    c /= fissileArea;
+  }
+
+  // --- Rács: cellánként a befoglaló dobozukkal átfedő háromszögek és külső élek ---
+  const double W = std::max(xmax - xmin, 1e-12), H = std::max(ymax - ymin, 1e-12);
+  const double cell = std::sqrt(W * H / static_cast<double>(E));
+  m_gx = std::max(1, std::min(4096, static_cast<int>(std::ceil(W / cell))));
+  m_gy = std::max(1, std::min(4096, static_cast<int>(std::ceil(H / cell))));
+  m_xmin = xmin;
+  m_ymin = ymin;
+  m_cellW = W / m_gx;
+  m_cellH = H / m_gy;
+
+  std::map<std::pair<int, int>, int> edgeCount;
+  for (const Mesh::Tri &t : mesh.tris)
+  {
+    ++edgeCount[edge_key(t.a - 1, t.b - 1)];
+    ++edgeCount[edge_key(t.b - 1, t.c - 1)];
+    ++edgeCount[edge_key(t.c - 1, t.a - 1)];
+  }
+  std::set<std::pair<int, int>> vacuum;
+  for (int l : system.vacuumLines)
+  {
+    const Mesh::Line &line = mesh.lines[static_cast<std::size_t>(l)];
+    vacuum.insert(edge_key(line.a - 1, line.b - 1));
+  }
+  for (const std::pair<const std::pair<int, int>, int> &it : edgeCount)
+  {
+    if (it.second != 1)
+    {
+      continue;
+    }
+    const Mesh::Node &p = mesh.nodes[static_cast<std::size_t>(it.first.first + 1)];
+    const Mesh::Node &q = mesh.nodes[static_cast<std::size_t>(it.first.second + 1)];
+    m_edgeCoord.push_back(p.x);
+    m_edgeCoord.push_back(p.y);
+    m_edgeCoord.push_back(q.x);
+    m_edgeCoord.push_back(q.y);
+    m_edgeVacuum.push_back(vacuum.count(it.first) > 0 ? 1 : 0);
+  }
+
+  auto bin_boxes = [&](std::size_t count, auto box, std::vector<int> &ptr, std::vector<int> &items) {
+    ptr.assign(static_cast<std::size_t>(m_gx) * static_cast<std::size_t>(m_gy) + 1, 0);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      std::vector<int> fill;
+      if (pass == 1)
+      {
+        for (std::size_t i = 1; i < ptr.size(); ++i)
+        {
+          ptr[i] += ptr[i - 1];
+        }
+        items.resize(static_cast<std::size_t>(ptr.back()));
+        fill.assign(ptr.begin(), ptr.end() - 1);
+      }
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        double x0, y0, x1, y1;
+        box(i, x0, y0, x1, y1);
+        const int ix0 = std::max(0, std::min(m_gx - 1, static_cast<int>((x0 - m_xmin) / m_cellW)));
+        const int ix1 = std::max(0, std::min(m_gx - 1, static_cast<int>((x1 - m_xmin) / m_cellW)));
+        const int iy0 = std::max(0, std::min(m_gy - 1, static_cast<int>((y0 - m_ymin) / m_cellH)));
+        const int iy1 = std::max(0, std::min(m_gy - 1, static_cast<int>((y1 - m_ymin) / m_cellH)));
+        for (int iy = iy0; iy <= iy1; ++iy)
+        {
+          for (int ix = ix0; ix <= ix1; ++ix)
+          {
+            const std::size_t c = static_cast<std::size_t>(iy) * static_cast<std::size_t>(m_gx) + static_cast<std::size_t>(ix);
+            if (pass == 0)
+            {
+              ++ptr[c + 1];
+            }
+            else
+            {
+              items[static_cast<std::size_t>(fill[c]++)] = static_cast<int>(i);
+            }
+          }
+        }
+      }
+    }
+  };
+  bin_boxes(
+      E,
+      [&](std::size_t e, double &x0, double &y0, double &x1, double &y1) {
+        const double *v = &m_vertex[6 * e];
+        x0 = std::min({v[0], v[2], v[4]});
+        x1 = std::max({v[0], v[2], v[4]});
+        y0 = std::min({v[1], v[3], v[5]});
+        y1 = std::max({v[1], v[3], v[5]});
+      },
+      m_triPtr, m_tris);
+  bin_boxes(
+      m_edgeVacuum.size(),
+      [&](std::size_t i, double &x0, double &y0, double &x1, double &y1) {
+        const double *c = &m_edgeCoord[4 * i];
+        x0 = std::min(c[0], c[2]);
+        x1 = std::max(c[0], c[2]);
+        y0 = std::min(c[1], c[3]);
+        y1 = std::max(c[1], c[3]);
+      },
+      m_edgePtr, m_edges);
+  m_setupMs = elapsed_ms(start);
+}
+
+int MonteCarlo::locate(double x, double y, int hint) const
+{
+  auto inside = [&](int e) {
+    const double *v = &m_vertex[6 * static_cast<std::size_t>(e)];
+    const double d = (v[2] - v[0]) * (v[5] - v[1]) - (v[4] - v[0]) * (v[3] - v[1]);
+    const double l1 = ((v[2] - x) * (v[5] - y) - (v[4] - x) * (v[3] - y)) / d;
+    const double l2 = ((v[4] - x) * (v[1] - y) - (v[0] - x) * (v[5] - y)) / d;
+    const double tol = -1e-10;
+    return l1 >= tol && l2 >= tol && 1.0 - l1 - l2 >= tol;
+  };
+  if (hint >= 0 && inside(hint))
+  {
+    return hint;
+  }
+  const int ix = static_cast<int>(std::floor((x - m_xmin) / m_cellW));
+  const int iy = static_cast<int>(std::floor((y - m_ymin) / m_cellH));
+  if (ix < -1 || iy < -1 || ix > m_gx || iy > m_gy)
+  {
+    return -1;
+  }
+  const std::size_t c = static_cast<std::size_t>(std::max(0, std::min(m_gy - 1, iy))) * static_cast<std::size_t>(m_gx) +
+                        static_cast<std::size_t>(std::max(0, std::min(m_gx - 1, ix)));
+  for (int k = m_triPtr[c]; k < m_triPtr[c + 1]; ++k)
+  {
+    if (inside(m_tris[static_cast<std::size_t>(k)]))
+    {
+      return m_tris[static_cast<std::size_t>(k)];
+    }
+  }
+  return -1;
+}
+
+int MonteCarlo::first_boundary(double x, double y, double dx, double dy, double maxT, int skip, double &t) const
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const double px = x - m_xmin, py = y - m_ymin;
+  int ix = std::max(0, std::min(m_gx - 1, static_cast<int>(std::floor(px / m_cellW))));
+  int iy = std::max(0, std::min(m_gy - 1, static_cast<int>(std::floor(py / m_cellH))));
+  const int stepX = dx > 0.0 ? 1 : -1, stepY = dy > 0.0 ? 1 : -1;
+  double tMaxX = dx > 0.0 ? ((ix + 1) * m_cellW - px) / dx : dx < 0.0 ? (ix * m_cellW - px) / dx : inf;
+  double tMaxY = dy > 0.0 ? ((iy + 1) * m_cellH - py) / dy : dy < 0.0 ? (iy * m_cellH - py) / dy : inf;
+  const double tDeltaX = dx != 0.0 ? m_cellW / std::fabs(dx) : inf;
+  const double tDeltaY = dy != 0.0 ? m_cellH / std::fabs(dy) : inf;
+  const double tiny = 1e-12 * (m_cellW + m_cellH);
+
+  int hit = -1;
+  double best = maxT;
+  while (true)
+  {
+    const std::size_t c = static_cast<std::size_t>(iy) * static_cast<std::size_t>(m_gx) + static_cast<std::size_t>(ix);
+    for (int k = m_edgePtr[c]; k < m_edgePtr[c + 1]; ++k)
+    {
+      const int edge = m_edges[static_cast<std::size_t>(k)];
+      if (edge == skip)
+      {
+        continue;
+      }
+      const double *q = &m_edgeCoord[4 * static_cast<std::size_t>(edge)];
+      const double ex = q[2] - q[0], ey = q[3] - q[1];
+      const double denom = dx * ey - dy * ex;
+      if (denom == 0.0)
+      {
+        continue;
+      }
+      const double qx = q[0] - x, qy = q[1] - y;
+      const double te = (qx * ey - qy * ex) / denom;
+      const double s = (qx * dy - qy * dx) / denom;
+      if (s >= 0.0 && s <= 1.0 && te > tiny && te <= best)
+      {
+        best = te;
+        hit = edge;
+      }
+    }
+    const double next = std::min(tMaxX, tMaxY);
+    if ((hit >= 0 && best <= next) || next > maxT)
+    {
+      break;
+    }
+    if (tMaxX < tMaxY)
+    {
+      ix += stepX;
+      tMaxX += tDeltaX;
+    }
+    else
+    {
+      iy += stepY;
+      tMaxY += tDeltaY;
+    }
+    if (ix < 0 || iy < 0 || ix >= m_gx || iy >= m_gy)
+    {
+      break;
+    }
+  }
+  t = best;
+  return hit;
+}
+
+void MonteCarlo::history(const Site &start, double k, std::uint64_t stream, Tally &tally) const
+{
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  Rng rng(stream);
+  double x = start.x, y = start.y;
+  std::size_t g = static_cast<std::size_t>(start.group);
+  int e = start.element;
+  double u, v, w;
+  isotropic(rng, u, v, w);
+  int skip = -1;
+  for (long event = 0; event < MAX_EVENTS; ++event)
+  {
+    const double sigma = m_majorant[g];
+    const double distance = -std::log(rng.uniform_open()) / sigma;
+    const double planar = std::sqrt(u * u + v * v);
+    if (planar > 1e-14)
+    {
+      const double dx = u / planar, dy = v / planar, travel = distance * planar;
+      double t = 0.0;
+      const int edge = first_boundary(x, y, dx, dy, travel, skip, t);
+      if (edge >= 0)
+      {
+        x += t * dx;
+        y += t * dy;
+        if (m_edgeVacuum[static_cast<std::size_t>(edge)] != 0)
+        {
+          ++tally.leaked;
+          return;
+        }
+        // Tükrözés: az irány síkbeli része az élre tükröződik; az új repülési hossz innen sorsolódik
+        const double *q = &m_edgeCoord[4 * static_cast<std::size_t>(edge)];
+        double ex = q[2] - q[0], ey = q[3] - q[1];
+        const double length = std::sqrt(ex * ex + ey * ey);
+        ex /= length;
+        ey /= length;
+        const double dot = u * ex + v * ey;
+        u = 2.0 * dot * ex - u;
+        v = 2.0 * dot * ey - v;
+        skip = edge;
+        continue;
+      }
+      x += travel * dx;
+      y += travel * dy;
+    }
+    skip = -1;
+    e = locate(x, y, e);
+    if (e < 0)
+    {
+      ++tally.lost;
+      return;
+    }
+
+    // Ütközés (valódi vagy virtuális): ütközési becslő 1 / majoráns súllyal
+    const std::size_t m = static_cast<std::size_t>(m_system.elementMaterial[static_cast<std::size_t>(e)]);
+    const std::size_t mg = m * G + g;
+    ++tally.collisions;
+    tally.flux[static_cast<std::size_t>(m_region[static_cast<std::size_t>(e)]) * G + g] += 1.0 / sigma;
+    tally.production += m_nuSigmaF[mg] / sigma;
+    const double sigmaT = m_sigmaT[mg];
+    if (rng.uniform() * sigma >= sigmaT)
+    {
+      continue;
+    }
+    ++tally.realCollisions;
+
+    const double nuRatio = m_nuSigmaF[mg] / sigmaT;
+    if (nuRatio > 0.0)
+    {
+      tally.kCollision += nuRatio;
+      const int born = static_cast<int>(nuRatio / k + rng.uniform());
+      for (int i = 0; i < born; ++i)
+      {
+        Site site;
+        site.x = x;
+        site.y = y;
+        site.element = e;
+        site.group = sample_cdf(&m_chiCdf[m * G], m_groupCount, rng.uniform());
+        tally.bank.push_back(site);
+      }
+    }
+    if (rng.uniform() * sigmaT >= m_scatterTotal[mg])
+    {
+      const double absorption = sigmaT - m_scatterTotal[mg];
+      if (absorption > 0.0)
+      {
+        tally.kAbsorption += m_nuSigmaF[mg] / absorption;
+      }
+      return;
+    }
+    g = static_cast<std::size_t>(sample_cdf(&m_scatterCdf[mg * G], m_groupCount, rng.uniform()));
+    isotropic(rng, u, v, w);
+  }
+  ++tally.lost;
+}
+
+void MonteCarlo::run(const MonteCarloOptions &options, MonteCarloResult &result) const
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t R = m_regionInfo.size();
+  const std::size_t N = static_cast<std::size_t>(options.particles);
+  const int threads = thread_count();
+
+  MonteCarloResult fresh;
+  fresh.regions = m_regionInfo;
+
+  // Kezdő forrás: egyenletes a hasadóanyagos háromszögeken, a csoport az anyag chi spektrumából
+  std::vector<Site> sites(N);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    Rng rng(stream_key(options.seed, std::numeric_limits<std::uint64_t>::max(), i));
+    const std::size_t pick = static_cast<std::size_t>(
+        std::lower_bound(m_sourceCdf.begin(), m_sourceCdf.end(), rng.uniform()) - m_sourceCdf.begin());
+    const int e = m_sourceElement[std::min(pick, m_sourceElement.size() - 1)];
+    double r1 = rng.uniform(), r2 = rng.uniform();
+    if (r1 + r2 > 1.0)
+    {
+      r1 = 1.0 - r1;
+      r2 = 1.0 - r2;
+    }
+    const double *v = &m_vertex[6 * static_cast<std::size_t>(e)];
+    Site &site = sites[i];
+    site.x = v[0] + r1 * (v[2] - v[0]) + r2 * (v[4] - v[0]);
+    site.y = v[1] + r1 * (v[3] - v[1]) + r2 * (v[5] - v[1]);
+    site.element = e;
+    const std::size_t m = static_cast<std::size_t>(m_system.elementMaterial[static_cast<std::size_t>(e)]);
+    site.group = sample_cdf(&m_chiCdf[m * G], m_groupCount, rng.uniform());
+  }
+
+  // Entrópia rács a befoglaló dobozon: nagyjából 20 forráspont cellánként, legfeljebb a keresőrács felbontásával
+  const double W = m_gx * m_cellW, H = m_gy * m_cellH;
+  const double bins = std::max(1.0, std::min(static_cast<double>(N) / 20.0, static_cast<double>(m_gx) * m_gy));
+  const int ex = std::max(1, std::min(m_gx, static_cast<int>(std::lround(std::sqrt(bins * W / H)))));
+  const int ey = std::max(1, std::min(m_gy, static_cast<int>(std::lround(bins / ex))));
+  const double binW = W / ex, binH = H / ey;
+  fresh.entropyGridX = ex;
+  fresh.entropyGridY = ey;
+
+  std::vector<Tally> tallies(static_cast<std::size_t>(threads));
+  double k = 1.0;
+  double kSum = 0.0, kSquares = 0.0, kAbsSum = 0.0, kAbsSquares = 0.0;
+  std::vector<double> fluxSum(R * G, 0.0), fluxSquares(R * G, 0.0);
+  long long activeHistories = 0, activeCollisions = 0;
+  int active = 0;
+  for (int batch = 0; batch < options.batches; ++batch)
+  {
+    const std::chrono::steady_clock::time_point batchStart = std::chrono::steady_clock::now();
+    for (Tally &t : tallies)
+    {
+      t.flux.assign(R * G, 0.0);
+      t.production = t.kCollision = t.kAbsorption = 0.0;
+      t.collisions = t.realCollisions = 0;
+      t.bank.clear();
+    }
+    parallel_chunks(
+        0, N,
+        [&](int thread, std::size_t begin, std::size_t end) {
+          Tally &tally = tallies[static_cast<std::size_t>(thread)];
+          for (std::size_t i = begin; i < end; ++i)
+          {
+            history(sites[i], k, stream_key(options.seed, static_cast<std::uint64_t>(batch), i), tally);
+          }
+        },
+        1);
+
+    // Összegzés szálsorrendben: a bank sorrendje így a részecskék sorrendje
+    std::vector<double> flux(R * G, 0.0);
+    double production = 0.0, kCollision = 0.0, kAbsorption = 0.0;
+    long long collisions = 0;
+    std::vector<Site> bank;
+    for (Tally &t : tallies)
+    {
+      for (std::size_t i = 0; i < flux.size(); ++i)
+      {
+        flux[i] += t.flux[i];
+      }
+      production += t.production;
+      kCollision += t.kCollision;
+      kAbsorption += t.kAbsorption;
+      collisions += t.collisions;
+      fresh.collisions += t.collisions;
+      fresh.realCollisions += t.realCollisions;
+      bank.insert(bank.end(), t.bank.begin(), t.bank.end());
+    }
+    fresh.histories += static_cast<long long>(N);
+    const double kBatch = kCollision / static_cast<double>(N);
+    const double kAbsBatch = kAbsorption / static_cast<double>(N);
+    fresh.batchK.push_back(kBatch);
+    if (bank.empty())
+    {
+      throw MonteCarloError("A hasadási bank kiürült (a rendszer erősen szubkritikus, vagy kevés a részecske).");
+    }
+
+    // Shannon entrópia a bank térbeli eloszlásán (entrópia rács); a fizikai csoportok szerint minden hasadás
+    // ugyanabba a régióba esne, és az entrópia mindig 0 lenne
+    std::vector<double> share(static_cast<std::size_t>(ex * ey), 0.0);
+    for (const Site &s : bank)
+    {
+      const int ix = std::max(0, std::min(ex - 1, static_cast<int>(std::floor((s.x - m_xmin) / binW))));
+      const int iy = std::max(0, std::min(ey - 1, static_cast<int>(std::floor((s.y - m_ymin) / binH))));
+      share[static_cast<std::size_t>(iy * ex + ix)] += 1.0;
+    }
+    double entropy = 0.0;
+    for (double p : share)
+    {
+      if (p > 0.0)
+      {
+        p /= static_cast<double>(bank.size());
+        entropy -= p * std::log2(p);
+      }
+    }
+    fresh.batchEntropy.push_back(entropy);
+
+    if (batch >= options.inactive)
+    {
+      ++active;
+      kSum += kBatch;
+      kSquares += kBatch * kBatch;
+      kAbsSum += kAbsBatch;
+      kAbsSquares += kAbsBatch * kAbsBatch;
+      for (std::size_t r = 0; r < R; ++r)
+      {
+        for (std::size_t g = 0; g < G; ++g)
+        {
+          const double value = production > 0.0 ? flux[r * G + g] / m_regionInfo[r].area / production : 0.0;
+          fluxSum[r * G + g] += value;
+          fluxSquares[r * G + g] += value * value;
+        }
+      }
+      activeHistories += static_cast<long long>(N);
+      activeCollisions += collisions;
+      fresh.activeMs += elapsed_ms(batchStart);
+    }
+
+    // Következő forrás: N hely a bankból, rendszeres mintavétellel (egy véletlen eltolás ciklusonként)
+    Rng rng(stream_key(options.seed, static_cast<std::uint64_t>(batch), std::numeric_limits<std::uint64_t>::max()));
+    const double offset = rng.uniform();
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      const std::size_t j = static_cast<std::size_t>((static_cast<double>(i) + offset) * static_cast<double>(bank.size()) /
+                                                     static_cast<double>(N));
+      sites[i] = bank[std::min(j, bank.size() - 1)];
+    }
+    k = kBatch;
+  }
+  for (const Tally &t : tallies)
+  {
+    fresh.leaked += t.leaked;
+    fresh.lost += t.lost;
+  }
+
+  // Aktív ciklusok átlaga és az átlag szórása
+  auto statistics = [active](double sum, double squares, double &mean, double &std) {
+    mean = sum / active;
+    std = std::sqrt(std::max(0.0, squares / active - mean * mean) / (active - 1));
+  };
+  statistics(kSum, kSquares, fresh.keff, fresh.keffStd);
+  statistics(kAbsSum, kAbsSquares, fresh.keffAbsorption, fresh.keffAbsorptionStd);
+  for (std::size_t r = 0; r < R; ++r)
+  {
+    MonteCarloRegion &region = fresh.regions[r];
+    region.flux.assign(G, 0.0);
+    region.relativeError.assign(G, 0.0);
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      double mean = 0.0, std = 0.0;
+      statistics(fluxSum[r * G + g], fluxSquares[r * G + g], mean, std);
+      region.flux[g] = mean;
+      region.relativeError[g] = mean > 0.0 ? std / mean : 0.0;
+    }
+  }
+  fresh.totalMs = elapsed_ms(totalStart);
+  if (fresh.activeMs > 0.0)
+  {
+    fresh.particlesPerSecond = 1e3 * static_cast<double>(activeHistories) / fresh.activeMs;
+    fresh.collisionsPerSecond = 1e3 * static_cast<double>(activeCollisions) / fresh.activeMs;
+  }
+  result = std::move(fresh);
+}
+
+std::vector<SnRegionComparison> compare_region_flux(const Mesh &mesh, const DiffusionSystem &system,
+                                                    const MonteCarloResult &transport,
+                                                    const std::vector<std::vector<double>> &diffusionFlux)
+{
+  // A régió átlag minden háromszög minden csúcsára, így az SN összevetése változatlanul használható
+  std::map<int, const MonteCarloRegion *> byPhys;
+  for (const MonteCarloRegion &r : transport.regions)
+  {
+    byPhys[r.phys] = &r;
+  }
+  const std::size_t G = diffusionFlux.size();
+  SnResult asNodal;
+  asNodal.flux.assign(G, std::vector<double>(3 * mesh.tris.size(), 0.0));
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    const std::map<int, const MonteCarloRegion *>::const_iterator it = byPhys.find(mesh.tris[e].phys);
+    for (std::size_t g = 0; g < G && it != byPhys.end() && g < it->second->flux.size(); ++g)
+    {
+      asNodal.flux[g][3 * e] = asNodal.flux[g][3 * e + 1] = asNodal.flux[g][3 * e + 2] = it->second->flux[g];
+    }
+  }
+  return compare_region_flux(mesh, system, asNodal, diffusionFlux);
+}
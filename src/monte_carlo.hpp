@@ -0,0 +1,134 @@
+#ifndef MONTE_CARLO_HPP
+#define MONTE_CARLO_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "sn.hpp"
+#include "xs.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Többcsoportos Monte Carlo k-sajátérték számítás a pontos háromszög geometrián (referencia a determinisztikus
+// megoldókhoz).
+//
+// Részecskekövetés Woodcock (delta) követéssel: a repülési hossz csoportonként a felhasznált anyagok legnagyobb
+// sigma_t értékéből (majoráns) sorsolódik, így nem kell háromszög határokat keresni; az ütközési pontban a hálóban
+// (rácsos keresés) megtalált anyaggal sigma_t / majoráns valószínűséggel valódi, különben virtuális az ütközés.
+// Csak a külső élek számítanak: vákuum élen a részecske kiszökik, minden más külső élen tükröződik.
+// Valódi ütközésnél a hasadási forrás (nu sigma_f / sigma_t / k darab, a chi spektrummal) a bankba kerül, majd
+// abszorpció vagy szórás (a szórási mátrix sora szerint választott csoportba, izotrop irányba).
+//
+// Reprodukálhatóság: minden részecske saját véletlenszám folyamot kap (mag, ciklus, sorszám hash-éből), a szálak
+// folytonos sorszám tartományokat dolgoznak fel, a szálankénti bankok sorrendben fűződnek össze, így a forrás és a
+// becslések a szálszámtól függetlenek (a részösszegek kerekítésétől eltekintve). A szálak csak a saját
+// becslő tömbjeikbe írnak, ezek a ciklus végén, zár nélkül, szálsorrendben összegződnek.
+
+class MonteCarloError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct MonteCarloOptions
+{
+  int particles = 10000;        // részecske ciklusonként
+  int batches = 120;            // összes ciklus
+  int inactive = 20;            // a forrás beállására eldobott ciklusok
+  std::uint64_t seed = 1;
+};
+
+MonteCarloOptions read_monte_carlo_options(const SolverConfig &config);
+
+// Fizikai csoportonkénti átlagfluxus (egységnyi teljes produkcióra normálva) és relatív szórása
+struct MonteCarloRegion
+{
+  std::string name;
+  int phys = -1;
+  double area = 0.0;
+  std::vector<double> flux;         // csoportonként
+  std::vector<double> relativeError;
+};
+
+struct MonteCarloResult
+{
+  double keff = 0.0;                // ütközési becslő, aktív ciklusok átlaga
+  double keffStd = 0.0;             // az átlag szórása
+  double keffAbsorption = 0.0;      // abszorpciós becslő
+  double keffAbsorptionStd = 0.0;
+  std::vector<double> batchK;       // ciklusonként (ütközési becslő)
+  std::vector<double> batchEntropy; // ciklusonként a hasadási bank Shannon entrópiája [bit] az entrópia rácson
+                                    // (az inaktív ciklusokban a forrás beállásának jelzője)
+  int entropyGridX = 0, entropyGridY = 0; // az entrópia rács cellái a befoglaló dobozon
+  std::vector<MonteCarloRegion> regions;
+  long long histories = 0;
+  long long collisions = 0;         // minden (valódi + virtuális) ütközés
+  long long realCollisions = 0;
+  long long leaked = 0;
+  long long lost = 0;               // geometriai hiba miatt elvesztett részecskék (normál esetben 0)
+  double totalMs = 0.0;
+  double activeMs = 0.0;
+  double particlesPerSecond = 0.0;  // aktív ciklusokban
+  double collisionsPerSecond = 0.0;
+};
+
+class MonteCarlo
+{
+public:
+  // Anyag táblák, majoráns, pont kereső rács és a külső élek rácsa itt épül fel
+  MonteCarlo(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system);
+
+  void run(const MonteCarloOptions &options, MonteCarloResult &result) const;
+
+  double majorant(int group) const { return m_majorant[static_cast<std::size_t>(group)]; }
+  double setup_ms() const { return m_setupMs; }
+
+private:
+  struct Site
+  {
+    double x = 0.0, y = 0.0;
+    int group = 0;
+    int element = -1;
+  };
+  struct Tally;
+
+  int locate(double x, double y, int hint) const;
+  // Az első külső él a (x, y) + t (dx, dy), 0 < t <= maxT szakaszon (dx, dy egységvektor), kivéve a skip élt
+  int first_boundary(double x, double y, double dx, double dy, double maxT, int skip, double &t) const;
+  void history(const Site &start, double k, std::uint64_t stream, Tally &tally) const;
+
+  const Mesh &m_mesh;
+  const DiffusionSystem &m_system;
+  int m_groupCount = 0;
+
+  std::vector<double> m_majorant;                 // csoportonként
+  std::vector<double> m_sigmaT, m_scatterTotal;   // [m * G + g]
+  std::vector<double> m_nuSigmaF;                 // [m * G + g]
+  std::vector<double> m_scatterCdf;               // [(m * G + from) * G + to], kumulált, normált
+  std::vector<double> m_chiCdf;                   // [m * G + g], kumulált, normált
+
+  std::vector<double> m_vertex;                   // háromszögenként 6 koordináta
+  std::vector<int> m_region;                      // háromszögenként a régió (fizikai csoport) sorszáma
+  std::vector<MonteCarloRegion> m_regionInfo;
+
+  double m_xmin = 0.0, m_ymin = 0.0, m_cellW = 0.0, m_cellH = 0.0;
+  int m_gx = 1, m_gy = 1;
+  std::vector<int> m_triPtr, m_tris;              // rács cellánként a háromszögek
+  std::vector<int> m_edgePtr, m_edges;            // rács cellánként a külső élek
+  std::vector<double> m_edgeCoord;                // külső élenként x0 y0 x1 y1
+  std::vector<char> m_edgeVacuum;
+
+  std::vector<double> m_sourceCdf;                // hasadóanyagos háromszögek terület szerinti eloszlása
+  std::vector<int> m_sourceElement;
+  double m_setupMs = 0.0;
+};
+
+// Fizikai csoportonkénti összevetés a diffúziós megoldással (mint az SN-nél és a MOC-nál), a régiók sorrendje
+// megegyezik a result.regions sorrendjével
+std::vector<SnRegionComparison> compare_region_flux(const Mesh &mesh, const DiffusionSystem &system,
+                                                    const MonteCarloResult &transport,
+                                                    const std::vector<std::vector<double>> &diffusionFlux);
+
+#endif // MONTE_CARLO_HPP
@@ -0,0 +1,197 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Egyszerű, állandó szálkészlet (thread pool) a párhuzamos ciklusokhoz.
+// A szálak egyszer indulnak, utána minden parallel_for ugyanazokat használja,
+// így a sokszor hívott rövid műveletek (SpMV, vektor műveletek) sem fizetnek szálindítást.
+// A hívó szál is dolgozik (ő a 0. szál).
+class ThreadPool
+{
+public:
+  static ThreadPool &instance()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  // Szálak számának beállítása (0 = hardware_concurrency). Csak akkor hívjuk, amikor nem fut feladat.
+  void resize(int threads)
+  {
+    if (threads <= 0)
+    {
+      threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threads = std::max(threads, 1);
+    if (threads == size())
+    {
+      return;
+    }
+    stop_workers();
+    m_size = threads;
+    m_stop = false;
+    const unsigned long generation = m_generation;
+    for (int t = 1; t < m_size; ++t)
+    {
+      m_workers.emplace_back([this, t, generation]() { worker_loop(t, generation); });
+    }
+  }
+
+  int size() const { return m_size; }
+
+  // job(threadId) minden szálon egyszer lefut; a hívás akkor tér vissza, ha mind végzett.
+  void run(const std::function<void(int)> &job)
+  {
+    bool serial = m_size <= 1;
+    if (!serial)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      serial = m_busy; // beágyazott vagy párhuzamos hívás: a készlet foglalt
+      if (!serial)
+      {
+        m_job = &job;
+        m_pending = m_size - 1;
+        m_busy = true;
+        ++m_generation;
+      }
+    }
+    if (serial)
+    {
+      for (int t = 0; t < m_size; ++t)
+      {
+        job(t);
+      }
+      return;
+    }
+    m_wake.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+    m_job = nullptr;
+    m_busy = false;
+  }
+
+  ~ThreadPool() { stop_workers(); }
+
+private:
+  ThreadPool() { resize(0); }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void worker_loop(int threadId, unsigned long seen)
+  {
+    while (true)
+    {
+      const std::function<void(int)> *job = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this, seen]() { return m_stop || m_generation != seen; });
+        if (m_stop)
+        {
+          return;
+        }
+        seen = m_generation;
+        job = m_job;
+      }
+      (*job)(threadId);
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        --m_pending;
+        if (m_pending == 0)
+        {
+          m_done.notify_one();
+        }
+      }
+    }
+  }
+
+  void stop_workers()
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &worker : m_workers)
+    {
+      worker.join();
+    }
+    m_workers.clear();
+  }
+
+  int m_size = 1;
+  bool m_stop = false;
+  bool m_busy = false;
+  unsigned long m_generation = 0;
+  int m_pending = 0;
+  const std::function<void(int)> *m_job = nullptr;
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+};
+
+inline int thread_count()
+{
+  return ThreadPool::instance().size();
+}
+
+inline void set_thread_count(int threads)
+{
+  ThreadPool::instance().resize(threads);
+}
+
+// [begin, end) tartomány felosztása összefüggő darabokra: fn(threadId, chunkBegin, chunkEnd).
+// A felosztás determinisztikus (csak a szálszámtól függ), így a szálankénti részösszegek
+// sorrendben összeadva reprodukálható eredményt adnak.
+// minParallel: ennél kevesebb elemnél sorosan fut (nagy munkájú elemeknél kisebbre vehető).
+template <typename Fn>
+void parallel_chunks(std::size_t begin, std::size_t end, Fn fn, std::size_t minParallel = 2048)
+{
+  if (end <= begin)
+  {
+    return;
+  }
+  ThreadPool &pool = ThreadPool::instance();
+  const std::size_t n = end - begin;
+  const std::size_t threads = static_cast<std::size_t>(pool.size());
+  // Kis munkánál nem éri meg szétosztani
+  if (threads <= 1 || n < minParallel)
+  {
+    fn(0, begin, end);
+    return;
+  }
+  const std::function<void(int)> job = [&](int t) {
+    const std::size_t chunk = (n + threads - 1) / threads;
+    const std::size_t b = begin + std::min(n, chunk * static_cast<std::size_t>(t));
+    const std::size_t e = begin + std::min(n, chunk * static_cast<std::size_t>(t + 1));
+    if (b < e)
+    {
+      fn(t, b, e);
+    }
+  };
+  pool.run(job);
+}
+
+// Elemenkénti párhuzamos ciklus: fn(i) minden i-re [begin, end)-ből.
+template <typename Fn>
+void parallel_for(std::size_t begin, std::size_t end, Fn fn, std::size_t minParallel = 2048)
+{
+  parallel_chunks(
+      begin, end, [&](int, std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i)
+        {
+          fn(i);
+        }
+      },
+      minParallel);
+}
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,357 @@
+#include "perturbation.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  std::string strip_comment(const std::string &line)
+  {
+    const std::size_t hashPos = line.find('#');
+    return hashPos == std::string::npos ? line : line.substr(0, hashPos);
+  }
+
+  // Csoport mező: 1-bázisú szám vagy '*'
+  int parse_group(const std::string &token, std::size_t lineNo)
+  {
+    if (token == "*")
+    {
+      return -1;
+    }
+    std::istringstream iss(token);
+    int group = 0;
+    char extra = '\0';
+    if (!(iss >> group) || (iss >> extra) || group < 1)
+    {
+      throw PerturbationParseError(lineNo, "Érvénytelen csoport: \"" + token + "\" (1-bázisú szám vagy '*').");
+    }
+    return group - 1;
+  }
+
+  void change(double &x, const XsPerturbation &p)
+  {
+    x = p.relative ? x * (1.0 + p.value) : x + p.value;
+  }
+}
+
+std::vector<std::string> target_physical_groups(const Mesh &mesh, const ModelLibrary &model, const std::string &target)
+{
+  const Zone *zone = model.findZone(target);
+  if (zone != nullptr)
+  {
+    return zone->physicalGroups;
+  }
+  for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+  {
+    if (it->second == target)
+    {
+      return std::vector<std::string>(1, target);
+    }
+  }
+  throw PerturbationError("Ismeretlen zóna vagy fizikai csoport: \"" + target + "\"");
+}
+
+XsPerturbation parse_perturbation(const std::vector<std::string> &tokens, std::size_t lineNo)
+{
+  XsPerturbation p;
+  if (tokens.size() < 6)
+  {
+    throw PerturbationParseError(lineNo, "Túl kevés mező (név zóna mennyiség csoport [cél_csoport] rel|abs érték).");
+  }
+  p.name = tokens[0];
+  p.target = tokens[1];
+  p.quantity = tokens[2];
+  if (p.quantity != "sigma_t" && p.quantity != "sigma_a" && p.quantity != "sigma_s" && p.quantity != "nu_sigma_f" &&
+      p.quantity != "chi")
+  {
+    throw PerturbationParseError(lineNo, "Ismeretlen mennyiség: \"" + p.quantity +
+                                             "\" (sigma_t | sigma_a | sigma_s | nu_sigma_f | chi).");
+  }
+  p.group = parse_group(tokens[3], lineNo);
+  std::size_t next = 4;
+  if (p.quantity == "sigma_s")
+  {
+    p.toGroup = parse_group(tokens[next++], lineNo);
+  }
+  if (tokens.size() != next + 2)
+  {
+    throw PerturbationParseError(lineNo, "Hibás mezőszám a(z) \"" + p.name + "\" perturbációnál.");
+  }
+  if (tokens[next] != "rel" && tokens[next] != "abs")
+  {
+    throw PerturbationParseError(lineNo, "A változás típusa rel vagy abs lehet, nem \"" + tokens[next] + "\".");
+  }
+  p.relative = tokens[next] == "rel";
+  std::istringstream value(tokens[next + 1]);
+  char extra = '\0';
+  if (!(value >> p.value) || (value >> extra))
+  {
+    throw PerturbationParseError(lineNo, "Érvénytelen érték: \"" + tokens[next + 1] + "\"");
+  }
+  return p;
+}
+
+void load_perturbations(const std::string &path, std::vector<XsPerturbation> &perturbations)
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    throw PerturbationError("Nem sikerült megnyitni a perturbáció fájlt: " + path);
+  }
+  std::vector<XsPerturbation> fresh;
+  std::string line;
+  std::size_t lineNo = 0;
+  while (std::getline(in, line))
+  {
+    ++lineNo;
+    std::istringstream iss(strip_comment(line));
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token)
+    {
+      tokens.push_back(token);
+    }
+    if (tokens.empty())
+    {
+      continue;
+    }
+
+    fresh.push_back(parse_perturbation(tokens, lineNo));
+  }
+  perturbations = std::move(fresh);
+}
+
+DiffusionSystem make_adjoint_system(const DiffusionSystem &forward)
+{
+  DiffusionSystem adjoint = forward;
+  for (GroupCoupling &c : adjoint.scatter)
+  {
+    std::swap(c.from, c.to);
+  }
+  for (GroupCoupling &c : adjoint.fission)
+  {
+    std::swap(c.from, c.to);
+  }
+  return adjoint;
+}
+
+int PerturbationIntegrals::region_of(int physId) const
+{
+  const std::vector<int>::const_iterator it = std::lower_bound(physIds.begin(), physIds.end(), physId);
+  return it != physIds.end() && *it == physId ? static_cast<int>(it - physIds.begin()) : -1;
+}
+
+PerturbationIntegrals compute_perturbation_integrals(const Mesh &mesh, const DiffusionSystem &system,
+                                                     const std::vector<std::vector<double>> &flux,
+                                                     const std::vector<std::vector<double>> &adjoint)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  PerturbationIntegrals result;
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  result.groupCount = system.groupCount;
+  for (const Mesh::Tri &t : mesh.tris)
+  {
+    result.physIds.push_back(t.phys);
+  }
+  std::sort(result.physIds.begin(), result.physIds.end());
+  result.physIds.erase(std::unique(result.physIds.begin(), result.physIds.end()), result.physIds.end());
+  const std::size_t R = result.physIds.size();
+  std::vector<int> elementRegion(mesh.tris.size());
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    elementRegion[e] = result.region_of(mesh.tris[e].phys);
+  }
+
+  // Szálankénti részösszegek, a végén sorrendben összeadva (reprodukálható)
+  const std::size_t perRegion = G + G * G;
+  std::vector<std::vector<double>> partial(static_cast<std::size_t>(thread_count()), std::vector<double>(R * perRegion, 0.0));
+  parallel_chunks(0, mesh.tris.size(), [&](int thread, std::size_t begin, std::size_t end) {
+    std::vector<double> &acc = partial[static_cast<std::size_t>(thread)];
+    for (std::size_t e = begin; e < end; ++e)
+    {
+      const Mesh::Tri &t = mesh.tris[e];
+      const ElementGeometry &geo = system.geometry[e];
+      const std::size_t nodes[3] = {static_cast<std::size_t>(t.a - 1), static_cast<std::size_t>(t.b - 1),
+                                    static_cast<std::size_t>(t.c - 1)};
+      double *grad = &acc[static_cast<std::size_t>(elementRegion[e]) * perRegion];
+      double *mass = grad + G;
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        // grad phi = sum_u phi_u (b_u, c_u), elemenként állandó
+        double fx = 0.0, fy = 0.0, ax = 0.0, ay = 0.0;
+        for (int u = 0; u < 3; ++u)
+        {
+          fx += flux[g][nodes[u]] * geo.b[u];
+          fy += flux[g][nodes[u]] * geo.c[u];
+          ax += adjoint[g][nodes[u]] * geo.b[u];
+          ay += adjoint[g][nodes[u]] * geo.c[u];
+        }
+        grad[g] += geo.area * (fx * ax + fy * ay);
+      }
+      // integral phi+_to phi_from = area / 12 * (sum_u a_u f_u + (sum_u a_u)(sum_u f_u))
+      for (std::size_t to = 0; to < G; ++to)
+      {
+        const double a0 = adjoint[to][nodes[0]], a1 = adjoint[to][nodes[1]], a2 = adjoint[to][nodes[2]];
+        for (std::size_t from = 0; from < G; ++from)
+        {
+          const double f0 = flux[from][nodes[0]], f1 = flux[from][nodes[1]], f2 = flux[from][nodes[2]];
+          mass[to * G + from] += geo.area / 12.0 * (a0 * f0 + a1 * f1 + a2 * f2 + (a0 + a1 + a2) * (f0 + f1 + f2));
+        }
+      }
+    }
+  });
+
+  result.grad.assign(R * G, 0.0);
+  result.mass.assign(R * G * G, 0.0);
+  for (const std::vector<double> &acc : partial)
+  {
+    for (std::size_t r = 0; r < R; ++r)
+    {
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        result.grad[r * G + g] += acc[r * perRegion + g];
+      }
+      for (std::size_t k = 0; k < G * G; ++k)
+      {
+        result.mass[r * G * G + k] += acc[r * perRegion + G + k];
+      }
+    }
+  }
+
+  // <phi+, F phi> közvetlenül a hasadási csatolásokból
+  std::vector<double> work;
+  for (const GroupCoupling &c : system.fission)
+  {
+    work.assign(static_cast<std::size_t>(system.nodeCount), 0.0);
+    c.matrix.multiply_add(1.0, flux[static_cast<std::size_t>(c.from)], work);
+    const std::vector<double> &a = adjoint[static_cast<std::size_t>(c.to)];
+    for (std::size_t i = 0; i < work.size(); ++i)
+    {
+      result.production += a[i] * work[i];
+    }
+  }
+  result.computeMs = elapsed_ms(start);
+  return result;
+}
+
+XsLibrary perturbed_library(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model,
+                            const XsPerturbation &perturbation)
+{
+  const int G = library.energyGroupCount;
+  if (perturbation.group >= G || perturbation.toGroup >= G)
+  {
+    throw PerturbationError("A(z) \"" + perturbation.name + "\" perturbáció csoportja nem létezik.");
+  }
+  XsLibrary perturbed = library;
+  for (const std::string &groupName : target_physical_groups(mesh, model, perturbation.target))
+  {
+    const int m = perturbed.material_index(groupName);
+    if (m < 0)
+    {
+      throw PerturbationError("Nincs keresztmetszet anyag a(z) \"" + groupName + "\" fizikai csoporthoz.");
+    }
+    XsMaterial &mat = perturbed.materials[static_cast<std::size_t>(m)];
+    for (int g = 0; g < G; ++g)
+    {
+      if (perturbation.group >= 0 && perturbation.group != g)
+      {
+        continue;
+      }
+      const std::size_t gi = static_cast<std::size_t>(g);
+      if (perturbation.quantity == "sigma_t")
+      {
+        change(mat.sigma_t[gi], perturbation);
+      }
+      else if (perturbation.quantity == "sigma_a")
+      {
+        // Abszorpció változás változatlan szórás mellett: a teljes KM ugyanannyival változik
+        const double before = mat.sigma_a[gi];
+        change(mat.sigma_a[gi], perturbation);
+        mat.sigma_t[gi] += mat.sigma_a[gi] - before;
+      }
+      else if (perturbation.quantity == "nu_sigma_f")
+      {
+        change(mat.nu_sigma_f[gi], perturbation);
+      }
+      else if (perturbation.quantity == "chi")
+      {
+        change(mat.chi[gi], perturbation);
+      }
+      else if (perturbation.quantity == "sigma_s")
+      {
+        for (int h = 0; h < G; ++h)
+        {
+          if (perturbation.toGroup < 0 || perturbation.toGroup == h)
+          {
+            change(mat.scatter[gi][static_cast<std::size_t>(h)], perturbation);
+          }
+        }
+      }
+    }
+  }
+  compile_xs(perturbed);
+  return perturbed;
+}
+
+std::vector<PerturbationResult> evaluate_perturbations(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model,
+                                                       const PerturbationIntegrals &integrals, double keff,
+                                                       const std::vector<XsPerturbation> &perturbations)
+{
+  const std::size_t G = static_cast<std::size_t>(library.energyGroupCount);
+  const XsCompiled &base = library.compiled;
+  std::vector<PerturbationResult> results;
+  for (const XsPerturbation &p : perturbations)
+  {
+    const XsLibrary changed = perturbed_library(mesh, library, model, p);
+    const XsCompiled &xs = changed.compiled;
+    PerturbationResult result;
+    result.name = p.name;
+
+    // A zóna minden fizikai csoportja a saját anyagával; a különbségek az assembly-vel azonos mennyiségekből
+    for (const std::string &groupName : target_physical_groups(mesh, model, p.target))
+    {
+      const int m = library.material_index(groupName);
+      for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+      {
+        const int r = it->second == groupName ? integrals.region_of(it->first) : -1;
+        if (r < 0)
+        {
+          continue;
+        }
+        const double *grad = &integrals.grad[static_cast<std::size_t>(r) * G];
+        const double *mass = &integrals.mass[static_cast<std::size_t>(r) * G * G];
+        for (std::size_t to = 0; to < G; ++to)
+        {
+          const std::size_t i = base.index(m, static_cast<int>(to));
+          result.lossTerm += (xs.diffusion[i] - base.diffusion[i]) * grad[to];
+          result.lossTerm += (xs.sigma_r[i] - base.sigma_r[i]) * mass[to * G + to];
+          for (std::size_t from = 0; from < G; ++from)
+          {
+            const std::size_t j = base.index(m, static_cast<int>(from));
+            if (from != to)
+            {
+              const std::size_t s = j * G + to;
+              result.lossTerm -= (xs.scatter[s] - base.scatter[s]) * mass[to * G + from];
+            }
+            const double dF = xs.chi[i] * xs.nu_sigma_f[j] - base.chi[i] * base.nu_sigma_f[j];
+            result.productionTerm += dF * mass[to * G + from];
+          }
+        }
+      }
+    }
+    result.deltaRho = (result.productionTerm / keff - result.lossTerm) / integrals.production;
+    results.push_back(result);
+  }
+  return results;
+}
@@ -0,0 +1,107 @@
+#ifndef PERTURBATION_HPP
+#define PERTURBATION_HPP
+
+#include "assembly.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "xs.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Adjungált számítás és elsőrendű perturbációszámítás.
+//
+// A P1 operátor csoport mátrixai (K(D) + M(sigma_r) + Marshak) és a csatolások (tömegmátrixok elemenként
+// állandó keresztmetszettel) mind szimmetrikusak, ezért az adjungált rendszer (A - S)^T phi+ = 1/k F^T phi+
+// ugyanazokkal a mátrixokkal áll elő, csak a szórási és hasadási csatolások iránya fordul meg.
+//
+// Egy keresztmetszet változás reaktivitás hatása elsőrendben (M = A - S):
+//   drho = ( <phi+, dF phi> / k - <phi+, dM phi> ) / <phi+, F phi>
+// Elemenként állandó keresztmetszetnél minden skalárszorzat a fizikai csoportonkénti
+//   grad[g]        = integral grad phi+_g . grad phi_g
+//   mass[to][from] = integral phi+_to phi_from
+// integrálok lineáris kombinációja, így ezeket egyetlen elemenkénti menetben számoljuk,
+// és utána tetszőleges számú perturbáció kiértékelése csak anyagonkénti keresztmetszet különbség.
+
+class PerturbationError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class PerturbationParseError : public PerturbationError
+{
+public:
+  PerturbationParseError(std::size_t line, const std::string &message)
+      : PerturbationError(message), m_line(line)
+  {
+  }
+
+  std::size_t line() const noexcept { return m_line; }
+
+private:
+  std::size_t m_line = 0;
+};
+
+// Egy keresztmetszet változás egy zónában (vagy fizikai csoportban)
+struct XsPerturbation
+{
+  std::string name;
+  std::string target;   // Model zóna neve, vagy közvetlenül a háló fizikai csoport neve
+  std::string quantity; // sigma_t | sigma_a | sigma_s | nu_sigma_f | chi
+  int group = -1;       // 0-bázisú csoport, -1 = minden csoport
+  int toGroup = -1;     // sigma_s esetén a cél csoport
+  bool relative = true; // rel: x -> x * (1 + value), abs: x -> x + value
+  double value = 0.0;
+};
+
+// Perturbáció lista beolvasása. Soronként (üres sor és # komment megengedett):
+//   név zóna mennyiség csoport [cél_csoport] rel|abs érték
+// A csoportok 1-bázisúak, '*' = minden csoport; cél csoport csak sigma_s-nél van.
+void load_perturbations(const std::string &path, std::vector<XsPerturbation> &perturbations);
+// Egy már szavakra bontott sor (név zóna mennyiség csoport [cél_csoport] rel|abs érték) értelmezése
+XsPerturbation parse_perturbation(const std::vector<std::string> &tokens, std::size_t lineNo);
+// Egy zóna fizikai csoport nevei: Model zóna, vagy maga a háló fizikai csoport neve (ismeretlenre PerturbationError)
+std::vector<std::string> target_physical_groups(const Mesh &mesh, const ModelLibrary &model, const std::string &target);
+
+// Adjungált rendszer: a mátrixok közösek a direkt rendszerrel, a csatolások iránya megfordítva
+DiffusionSystem make_adjoint_system(const DiffusionSystem &forward);
+
+// Fizikai csoportonkénti súlyozó integrálok (egy elemenkénti menet, szálankénti részösszegekkel)
+struct PerturbationIntegrals
+{
+  int groupCount = 0;
+  std::vector<int> physIds;   // régiók: a hálóban előforduló fizikai csoport id-k
+  std::vector<double> grad;   // [r * G + g]
+  std::vector<double> mass;   // [(r * G + to) * G + from]
+  double production = 0.0;    // <phi+, F phi> a teljes rendszerre
+  double computeMs = 0.0;
+
+  int region_of(int physId) const;
+};
+
+PerturbationIntegrals compute_perturbation_integrals(const Mesh &mesh, const DiffusionSystem &system,
+                                                     const std::vector<std::vector<double>> &flux,
+                                                     const std::vector<std::vector<double>> &adjoint);
+
+// Egy perturbáció reaktivitás hatása
+struct PerturbationResult
+{
+  std::string name;
+  double lossTerm = 0.0;       // <phi+, dM phi>
+  double productionTerm = 0.0; // <phi+, dF phi>
+  double deltaRho = 0.0;       // elsőrendű reaktivitás változás (abszolút, nem pcm)
+};
+
+// A perturbált keresztmetszet könyvtár (ugyanaz a compile_xs) és az eredeti különbségéből, anyagonként.
+// A zóna fizikai csoportjaihoz a hálóban azonos nevű anyag tartozik (mint az assembly-ben).
+std::vector<PerturbationResult> evaluate_perturbations(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model,
+                                                       const PerturbationIntegrals &integrals, double keff,
+                                                       const std::vector<XsPerturbation> &perturbations);
+
+// A perturbált könyvtár (ellenőrző direkt számításhoz; ugyanazt a változtatást alkalmazza, mint az értékelés)
+XsLibrary perturbed_library(const Mesh &mesh, const XsLibrary &library, const ModelLibrary &model,
+                            const XsPerturbation &perturbation);
+
+#endif // PERTURBATION_HPP
@@ -0,0 +1,353 @@
+#include "pin_power.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  const double kPi = 3.14159265358979323846;
+
+  // Unió-keresés útvonal tömörítéssel
+  struct DisjointSets
+  {
+    std::vector<int> parent;
+
+    explicit DisjointSets(std::size_t n) : parent(n)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        parent[i] = static_cast<int>(i);
+      }
+    }
+
+    int find(int x)
+    {
+      while (parent[static_cast<std::size_t>(x)] != x)
+      {
+        parent[static_cast<std::size_t>(x)] = parent[static_cast<std::size_t>(parent[static_cast<std::size_t>(x)])];
+        x = parent[static_cast<std::size_t>(x)];
+      }
+      return x;
+    }
+
+    void unite(int a, int b)
+    {
+      a = find(a);
+      b = find(b);
+      if (a != b)
+      {
+        parent[static_cast<std::size_t>(std::max(a, b))] = std::min(a, b);
+      }
+    }
+  };
+
+  // Tört axiális koordináták kerekítése a legközelebbi hatszög rácspontra (kocka koordinátákon át)
+  void round_axial(double qf, double rf, int &q, int &r)
+  {
+    const double sf = -qf - rf;
+    double qr = std::round(qf), rr = std::round(rf), sr = std::round(sf);
+    const double dq = std::fabs(qr - qf), dr = std::fabs(rr - rf), ds = std::fabs(sr - sf);
+    if (dq > dr && dq > ds)
+    {
+      qr = -rr - sr;
+    }
+    else if (dr > ds)
+    {
+      rr = -qr - sr;
+    }
+    q = static_cast<int>(qr);
+    r = static_cast<int>(rr);
+  }
+}
+
+PinPowerOptions read_pin_power_options(const SolverConfig &config)
+{
+  PinPowerOptions options;
+  options.enabled = config.getBool("pin_power", options.enabled);
+  options.group = config.getString("pin_group", options.group);
+  options.pitch = config.getDouble("pin_pitch", options.pitch);
+  if (options.pitch < 0.0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A pin_pitch nem lehet negatív, automatikus rácsállandó használata.\n";
+    options.pitch = 0.0;
+  }
+  return options;
+}
+
+PinLattice identify_pins(const Mesh &mesh, const PinPowerOptions &options)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  PinLattice lattice;
+  std::vector<int> groupIds;
+  for (std::map<int, std::string>::const_iterator it = mesh.physNames.begin(); it != mesh.physNames.end(); ++it)
+  {
+    if (it->second == options.group)
+    {
+      groupIds.push_back(it->first);
+    }
+  }
+  if (groupIds.empty())
+  {
+    throw PinPowerError("A hálóban nincs " + options.group + " nevű fizikai csoport (pin_group).");
+  }
+  const std::vector<ElementGeometry> geometry = compute_element_geometry(mesh);
+
+  // 1) A csoport háromszögeinek élen át összefüggő komponensei
+  const std::size_t T = mesh.tris.size();
+  std::vector<char> inGroup(T, 0);
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    inGroup[e] = std::find(groupIds.begin(), groupIds.end(), mesh.tris[e].phys) != groupIds.end() ? 1 : 0;
+  }
+  DisjointSets sets(T);
+  std::unordered_map<std::uint64_t, int> edgeOwner;
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    if (!inGroup[e])
+    {
+      continue;
+    }
+    const Mesh::Tri &t = mesh.tris[e];
+    const int nodes[3] = {t.a, t.b, t.c};
+    for (int k = 0; k < 3; ++k)
+    {
+      const std::uint64_t lo = static_cast<std::uint64_t>(std::min(nodes[k], nodes[(k + 1) % 3]));
+      const std::uint64_t hi = static_cast<std::uint64_t>(std::max(nodes[k], nodes[(k + 1) % 3]));
+      const std::pair<std::unordered_map<std::uint64_t, int>::iterator, bool> ins =
+          edgeOwner.emplace((lo << 32) | hi, static_cast<int>(e));
+      if (!ins.second)
+      {
+        sets.unite(ins.first->second, static_cast<int>(e));
+      }
+    }
+  }
+  std::vector<Pin> pins;
+  std::vector<int> rootPin(T, -1);
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    if (!inGroup[e])
+    {
+      continue;
+    }
+    int &pin = rootPin[static_cast<std::size_t>(sets.find(static_cast<int>(e)))];
+    if (pin < 0)
+    {
+      pin = static_cast<int>(pins.size());
+      pins.push_back(Pin());
+    }
+    Pin &p = pins[static_cast<std::size_t>(pin)];
+    const Mesh::Tri &t = mesh.tris[e];
+    const double cx = (mesh.nodes[static_cast<std::size_t>(t.a)].x + mesh.nodes[static_cast<std::size_t>(t.b)].x +
+                       mesh.nodes[static_cast<std::size_t>(t.c)].x) / 3.0;
+    const double cy = (mesh.nodes[static_cast<std::size_t>(t.a)].y + mesh.nodes[static_cast<std::size_t>(t.b)].y +
+                       mesh.nodes[static_cast<std::size_t>(t.c)].y) / 3.0;
+    p.x += geometry[e].area * cx;
+    p.y += geometry[e].area * cy;
+    p.area += geometry[e].area;
+    p.elements.push_back(static_cast<int>(e));
+  }
+  if (pins.empty())
+  {
+    throw PinPowerError("A(z) " + options.group + " fizikai csoportnak nincs háromszöge.");
+  }
+  double meanX = 0.0, meanY = 0.0;
+  for (Pin &p : pins)
+  {
+    p.x /= p.area;
+    p.y /= p.area;
+    meanX += p.x / static_cast<double>(pins.size());
+    meanY += p.y / static_cast<double>(pins.size());
+  }
+
+  // 2) Rácsállandó és elforgatás a legközelebbi szomszédokból (medián távolság, a 6-szoros szög átlaga)
+  if (pins.size() > 1)
+  {
+    std::vector<double> distance(pins.size());
+    double sin6 = 0.0, cos6 = 0.0;
+    for (std::size_t i = 0; i < pins.size(); ++i)
+    {
+      double best = -1.0, dx = 0.0, dy = 0.0;
+      for (std::size_t j = 0; j < pins.size(); ++j)
+      {
+        const double d = std::hypot(pins[j].x - pins[i].x, pins[j].y - pins[i].y);
+        if (j != i && (best < 0.0 || d < best))
+        {
+          best = d;
+          dx = pins[j].x - pins[i].x;
+          dy = pins[j].y - pins[i].y;
+        }
+      }
+      distance[i] = best;
+      sin6 += std::sin(6.0 * std::atan2(dy, dx));
+      cos6 += std::cos(6.0 * std::atan2(dy, dx));
+    }
+    std::nth_element(distance.begin(), distance.begin() + static_cast<std::ptrdiff_t>(distance.size() / 2), distance.end());
+    lattice.pitch = options.pitch > 0.0 ? options.pitch : distance[distance.size() / 2];
+    lattice.rotation = std::atan2(sin6, cos6) / 6.0;
+  }
+  else
+  {
+    lattice.pitch = options.pitch;
+  }
+
+  // 3) Rácspontok: a középhez legközelebbi pinhez viszonyított koordináták, majd eltolás a rács közepére
+  if (lattice.pitch > 0.0)
+  {
+    std::size_t reference = 0;
+    for (std::size_t i = 1; i < pins.size(); ++i)
+    {
+      if (std::hypot(pins[i].x - meanX, pins[i].y - meanY) < std::hypot(pins[reference].x - meanX, pins[reference].y - meanY))
+      {
+        reference = i;
+      }
+    }
+    const double c = std::cos(lattice.rotation), s = std::sin(lattice.rotation);
+    const double rowHeight = lattice.pitch * std::sqrt(3.0) / 2.0;
+    auto axial = [&](double x, double y, double &qf, double &rf) {
+      const double u = c * (x - pins[reference].x) + s * (y - pins[reference].y);
+      const double v = -s * (x - pins[reference].x) + c * (y - pins[reference].y);
+      rf = v / rowHeight;
+      qf = u / lattice.pitch - 0.5 * rf;
+    };
+    double meanQ = 0.0, meanR = 0.0;
+    for (Pin &p : pins)
+    {
+      double qf = 0.0, rf = 0.0;
+      axial(p.x, p.y, qf, rf);
+      round_axial(qf, rf, p.q, p.r);
+      const double u = lattice.pitch * (p.q + 0.5 * p.r), v = rowHeight * p.r;
+      p.offset = std::hypot(pins[reference].x + c * u - s * v - p.x, pins[reference].y + s * u + c * v - p.y);
+      lattice.maxOffset = std::max(lattice.maxOffset, p.offset);
+      meanQ += p.q / static_cast<double>(pins.size());
+      meanR += p.r / static_cast<double>(pins.size());
+    }
+    int shiftQ = 0, shiftR = 0;
+    round_axial(meanQ, meanR, shiftQ, shiftR);
+    for (Pin &p : pins)
+    {
+      p.q -= shiftQ;
+      p.r -= shiftR;
+      p.ring = std::max(std::abs(p.q), std::max(std::abs(p.r), std::abs(p.q + p.r)));
+    }
+  }
+  std::sort(pins.begin(), pins.end(), [](const Pin &a, const Pin &b) { return a.r != b.r ? a.r > b.r : a.q < b.q; });
+  for (std::size_t i = 1; i < pins.size(); ++i)
+  {
+    if (lattice.pitch > 0.0 && pins[i].q == pins[i - 1].q && pins[i].r == pins[i - 1].r)
+    {
+      throw PinPowerError("Két pin ugyanarra a rácspontra esik (q = " + std::to_string(pins[i].q) + ", r = " +
+                          std::to_string(pins[i].r) + "); adjon meg pin_pitch értéket.");
+    }
+  }
+  lattice.pins = pins;
+  lattice.rotation *= 180.0 / kPi;
+  lattice.buildMs = elapsed_ms(start);
+  return lattice;
+}
+
+void tally_pins(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system, const PinLattice &lattice,
+                const std::vector<std::vector<double>> &flux, PinPowerResult &result)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const XsCompiled &xs = library.compiled;
+  const std::size_t G = static_cast<std::size_t>(system.groupCount);
+  const std::size_t T = mesh.tris.size();
+  result = PinPowerResult();
+
+  // Elemenkénti integrálok (párhuzamosan, minden elem a saját helyére ír)
+  std::vector<double> elementFlux(T * G), elementAbsorption(T), elementFission(T);
+  parallel_for(0, T, [&](std::size_t e) {
+    const Mesh::Tri &t = mesh.tris[e];
+    const int m = system.elementMaterial[e];
+    double absorption = 0.0, fission = 0.0;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      const std::vector<double> &phi = flux[g];
+      const double value = system.geometry[e].area *
+                           (phi[static_cast<std::size_t>(t.a - 1)] + phi[static_cast<std::size_t>(t.b - 1)] + phi[static_cast<std::size_t>(t.c - 1)]) / 3.0;
+      elementFlux[e * G + g] = value;
+      absorption += xs.sigma_a[xs.index(m, static_cast<int>(g))] * value;
+      fission += xs.nu_sigma_f[xs.index(m, static_cast<int>(g))] * value;
+    }
+    elementAbsorption[e] = absorption;
+    elementFission[e] = fission;
+  }, 1024);
+
+  // Összegzés rögzített elemsorrendben: egy pin / fizikai csoport egy szálon
+  auto reduce = [&](const std::vector<int> &elements, ReactionTally &tally) {
+    tally.flux.assign(G, 0.0);
+    for (int e : elements)
+    {
+      const std::size_t k = static_cast<std::size_t>(e);
+      tally.area += system.geometry[k].area;
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        tally.flux[g] += elementFlux[k * G + g];
+      }
+      tally.absorption += elementAbsorption[k];
+      tally.fission += elementFission[k];
+    }
+  };
+  result.pins.resize(lattice.pins.size());
+  parallel_for(0, lattice.pins.size(), [&](std::size_t p) {
+    const Pin &pin = lattice.pins[p];
+    result.pins[p].name = std::to_string(p + 1);
+    reduce(pin.elements, result.pins[p]);
+  }, 8);
+
+  std::map<int, std::vector<int>> physElements;
+  for (std::size_t e = 0; e < T; ++e)
+  {
+    physElements[mesh.tris[e].phys].push_back(static_cast<int>(e));
+  }
+  std::vector<const std::vector<int> *> regionElements;
+  for (std::map<int, std::vector<int>>::const_iterator it = physElements.begin(); it != physElements.end(); ++it)
+  {
+    ReactionTally region;
+    const std::map<int, std::string>::const_iterator name = mesh.physNames.find(it->first);
+    region.name = name != mesh.physNames.end() ? name->second : "phys" + std::to_string(it->first);
+    result.regions.push_back(region);
+    regionElements.push_back(&it->second);
+  }
+  parallel_for(0, result.regions.size(), [&](std::size_t r) { reduce(*regionElements[r], result.regions[r]); }, 2);
+
+  // Relatív pin teljesítmények
+  double total = 0.0;
+  for (const ReactionTally &pin : result.pins)
+  {
+    total += pin.fission;
+  }
+  if (!result.pins.empty() && total > 0.0)
+  {
+    const double mean = total / static_cast<double>(result.pins.size());
+    result.power.resize(result.pins.size());
+    result.minimum = result.pins[0].fission / mean;
+    for (std::size_t p = 0; p < result.pins.size(); ++p)
+    {
+      result.power[p] = result.pins[p].fission / mean;
+      if (result.power[p] > result.peaking)
+      {
+        result.peaking = result.power[p];
+        result.peakPin = static_cast<int>(p);
+      }
+      result.minimum = std::min(result.minimum, result.power[p]);
+    }
+  }
+  else if (!result.pins.empty())
+  {
+    throw PinPowerError("A pinekben nincs hasadás (nu sigma_f phi = 0), a pin teljesítmény nem normálható.");
+  }
+  result.tallyMs = elapsed_ms(start);
+}
@@ -0,0 +1,86 @@
+#ifndef PIN_POWER_HPP
+#define PIN_POWER_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "mesh.hpp"
+#include "xs.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Pin teljesítmények és reakciógyakoriságok (utófeldolgozás a sajátérték megoldás után).
+//
+// A pinek a háló pin_group fizikai csoportjának (alapból Fuel) élen át összefüggő komponensei; a komponens
+// súlypontja a hatszögrácshoz illesztődik: a rácsállandó és az elforgatás (ha nincs megadva) a legközelebbi
+// szomszédok távolságából és irányából adódik, a pin axiális (q, r) koordinátái a rácspontra kerekítéssel,
+// a rács közepéhez (a koordináták átlagához) viszonyítva.
+//
+// A tally elemenként párhuzamos (P1: az elem integrálja a terület és a csúcsértékek átlagának szorzata), a
+// pinenkénti és fizikai csoportonkénti összegek rögzített elemsorrendben, pinenként / csoportonként egy szálon
+// készülnek, így az eredmény a szálszámtól független. A hasadási gyakoriság a nu sigma_f phi produkció (az
+// XS könyvtár nem tartalmaz külön sigma_f-et; állandó nu mellett arányos a teljesítménnyel).
+
+class PinPowerError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct PinPowerOptions
+{
+  bool enabled = false;
+  std::string group = "Fuel";   // a pineket alkotó fizikai csoport
+  double pitch = 0.0;           // rácsállandó [cm] (0 = automatikus, a szomszédos pinek távolságából)
+};
+
+PinPowerOptions read_pin_power_options(const SolverConfig &config);
+
+// Egy pin a rácsban
+struct Pin
+{
+  int q = 0, r = 0;             // axiális hatszög koordináták
+  int ring = 0;                 // a középponttól számított gyűrű
+  double x = 0.0, y = 0.0;      // súlypont
+  double area = 0.0;
+  double offset = 0.0;          // a súlypont távolsága a rácsponttól [cm]
+  std::vector<int> elements;    // növekvő elemsorrendben
+};
+
+// A pinek felismerése a hálóból (csak a geometriától függ, több megoldáshoz újrahasználható)
+struct PinLattice
+{
+  std::vector<Pin> pins;        // soronként felülről lefelé (r csökkenő), soron belül q szerint rendezve
+  double pitch = 0.0;
+  double rotation = 0.0;        // a rács elforgatása [fok]
+  double maxOffset = 0.0;
+  double buildMs = 0.0;
+};
+
+PinLattice identify_pins(const Mesh &mesh, const PinPowerOptions &options);
+
+// Egy pin vagy fizikai csoport integrált reakciógyakoriságai (egységnyi teljes produkcióra normált fluxussal)
+struct ReactionTally
+{
+  std::string name;
+  double area = 0.0;
+  std::vector<double> flux;     // csoportonként a fluxus integrálja
+  double absorption = 0.0;
+  double fission = 0.0;         // nu sigma_f phi
+};
+
+struct PinPowerResult
+{
+  std::vector<ReactionTally> pins;    // a PinLattice::pins sorrendjében
+  std::vector<double> power;          // relatív pin teljesítmény (átlag = 1)
+  std::vector<ReactionTally> regions; // fizikai csoportonként
+  double peaking = 0.0;               // a legnagyobb relatív pin teljesítmény
+  double minimum = 0.0;
+  int peakPin = -1;
+  double tallyMs = 0.0;
+};
+
+void tally_pins(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system, const PinLattice &lattice,
+                const std::vector<std::vector<double>> &flux, PinPowerResult &result);
+
+#endif // PIN_POWER_HPP
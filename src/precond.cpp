@@ -0,0 +1,261 @@
+#include "precond.hpp"
+#include "amg.hpp"
+#include "parallel.hpp"
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+  // "none": z = r
+  class IdentityPreconditioner : public Preconditioner
+  {
+  public:
+    std::string name() const override { return "none"; }
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override { z = r; }
+    std::size_t memory_bytes() const override { return 0; }
+  };
+}
+
+JacobiPreconditioner::JacobiPreconditioner(const CsrMatrix &A)
+{
+  const std::vector<int> diag = A.pattern->diagonal_positions();
+  m_invDiag.resize(diag.size());
+  for (std::size_t i = 0; i < diag.size(); ++i)
+  {
+    const double d = diag[i] >= 0 ? A.values[static_cast<std::size_t>(diag[i])] : 0.0;
+    m_invDiag[i] = d != 0.0 ? 1.0 / d : 1.0;
+  }
+}
+
+void JacobiPreconditioner::apply(const std::vector<double> &r, std::vector<double> &z) const
+{
+  z.resize(r.size());
+  parallel_for(0, r.size(), [&](std::size_t i) { z[i] = m_invDiag[i] * r[i]; });
+}
+
+Ic0Preconditioner::Ic0Preconditioner(const CsrMatrix &A)
+{
+  // Elakadás esetén egyre nagyobb relatív diagonális eltolással próbáljuk újra
+  double shift = 0.0;
+  while (!factorize(A, shift))
+  {
+    shift = shift == 0.0 ? 1e-3 : shift * 10.0;
+    if (shift > 1.0)
+    {
+      std::cerr << "[FIGYELMEZTETÉS] IC(0) faktorizáció nem sikerült, Jacobi-szerű diagonálisra váltok.\n";
+      factorize(A, -1.0);
+      break;
+    }
+  }
+  m_shift = shift;
+}
+
+bool Ic0Preconditioner::factorize(const CsrMatrix &A, double shift)
+{
+  const CsrPattern &P = *A.pattern;
+  m_n = P.rows;
+  const std::size_t n = static_cast<std::size_t>(m_n);
+
+  // Alsó háromszög mintázat (col <= row), a diagonális minden sorban az utolsó
+  m_lowerPtr.assign(n + 1, 0);
+  m_lowerCol.clear();
+  m_lowerVal.clear();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (int k = P.rowPtr[i]; k < P.rowPtr[i + 1]; ++k)
+    {
+      const int col = P.colIdx[static_cast<std::size_t>(k)];
+      // shift < 0: csak a diagonális (tartalék megoldás)
+      if (col < static_cast<int>(i) && shift >= 0.0)
+      {
+        m_lowerCol.push_back(col);
+        m_lowerVal.push_back(A.values[static_cast<std::size_t>(k)]);
+      }
+      else if (col == static_cast<int>(i))
+      {
+        m_lowerCol.push_back(col);
+        m_lowerVal.push_back(A.values[static_cast<std::size_t>(k)] * (1.0 + std::max(shift, 0.0)));
+      }
+    }
+    m_lowerPtr[i + 1] = static_cast<int>(m_lowerCol.size());
+  }
+
+  // Soronkénti IC(0): L_ik = (a_ik - sum_j L_ij L_kj) / L_kk, L_ii = sqrt(a_ii - sum_j L_ij^2)
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const int rowBegin = m_lowerPtr[i];
+    const int rowEnd = m_lowerPtr[i + 1]; // utolsó = diagonális
+    for (int p = rowBegin; p < rowEnd - 1; ++p)
+    {
+      const std::size_t k = static_cast<std::size_t>(m_lowerCol[static_cast<std::size_t>(p)]);
+      double s = m_lowerVal[static_cast<std::size_t>(p)];
+      // Közös oszlopok (< k) két rendezett listában
+      int a = rowBegin;
+      int b = m_lowerPtr[k];
+      const int bEnd = m_lowerPtr[k + 1] - 1;
+      while (a < p && b < bEnd)
+      {
+        const int ca = m_lowerCol[static_cast<std::size_t>(a)];
+        const int cb = m_lowerCol[static_cast<std::size_t>(b)];
+        if (ca == cb)
+        {
+          s -= m_lowerVal[static_cast<std::size_t>(a)] * m_lowerVal[static_cast<std::size_t>(b)];
+          ++a;
+          ++b;
+        }
+        else if (ca < cb)
+        {
+          ++a;
+        }
+        else
+        {
+          ++b;
+        }
+      }
+      m_lowerVal[static_cast<std::size_t>(p)] = s / m_lowerVal[static_cast<std::size_t>(bEnd)];
+    }
+    double d = m_lowerVal[static_cast<std::size_t>(rowEnd - 1)];
+    for (int p = rowBegin; p < rowEnd - 1; ++p)
+    {
+      d -= m_lowerVal[static_cast<std::size_t>(p)] * m_lowerVal[static_cast<std::size_t>(p)];
+    }
+    if (!(d > 0.0))
+    {
+      return false;
+    }
+    m_lowerVal[static_cast<std::size_t>(rowEnd - 1)] = std::sqrt(d);
+  }
+
+  // U = L^T (soronként), a hátrafelé helyettesítéshez
+  m_upperPtr.assign(n + 1, 0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (int p = m_lowerPtr[i]; p < m_lowerPtr[i + 1]; ++p)
+    {
+      ++m_upperPtr[static_cast<std::size_t>(m_lowerCol[static_cast<std::size_t>(p)]) + 1];
+    }
+  }
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    m_upperPtr[i + 1] += m_upperPtr[i];
+  }
+  m_upperCol.assign(m_lowerCol.size(), 0);
+  m_upperVal.assign(m_lowerVal.size(), 0.0);
+  std::vector<int> cursor(m_upperPtr.begin(), m_upperPtr.end() - 1);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (int p = m_lowerPtr[i]; p < m_lowerPtr[i + 1]; ++p)
+    {
+      const std::size_t col = static_cast<std::size_t>(m_lowerCol[static_cast<std::size_t>(p)]);
+      const std::size_t dst = static_cast<std::size_t>(cursor[col]++);
+      m_upperCol[dst] = static_cast<int>(i);
+      m_upperVal[dst] = m_lowerVal[static_cast<std::size_t>(p)];
+    }
+  }
+  return true;
+}
+
+void Ic0Preconditioner::apply(const std::vector<double> &r, std::vector<double> &z) const
+{
+  const std::size_t n = static_cast<std::size_t>(m_n);
+  z.resize(n);
+  // L y = r (előre)
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    double s = r[i];
+    const int end = m_lowerPtr[i + 1] - 1;
+    for (int p = m_lowerPtr[i]; p < end; ++p)
+    {
+      s -= m_lowerVal[static_cast<std::size_t>(p)] * z[static_cast<std::size_t>(m_lowerCol[static_cast<std::size_t>(p)])];
+    }
+    z[i] = s / m_lowerVal[static_cast<std::size_t>(end)];
+  }
+  // L^T z = y (hátra, helyben)
+  for (std::size_t i = n; i-- > 0;)
+  {
+    const int begin = m_upperPtr[i];
+    double s = z[i];
+    for (int p = begin + 1; p < m_upperPtr[i + 1]; ++p)
+    {
+      s -= m_upperVal[static_cast<std::size_t>(p)] * z[static_cast<std::size_t>(m_upperCol[static_cast<std::size_t>(p)])];
+    }
+    z[i] = s / m_upperVal[static_cast<std::size_t>(begin)];
+  }
+}
+
+std::size_t Ic0Preconditioner::memory_bytes() const
+{
+  return (m_lowerPtr.size() + m_lowerCol.size() + m_upperPtr.size() + m_upperCol.size()) * sizeof(int) +
+         (m_lowerVal.size() + m_upperVal.size()) * sizeof(double);
+}
+
+SsorPreconditioner::SsorPreconditioner(const CsrMatrix &A, double omega)
+    : m_A(A), m_omega(omega)
+{
+  m_diagPos = A.pattern->diagonal_positions();
+  m_diag.resize(m_diagPos.size());
+  for (std::size_t i = 0; i < m_diagPos.size(); ++i)
+  {
+    m_diag[i] = m_diagPos[i] >= 0 ? A.values[static_cast<std::size_t>(m_diagPos[i])] : 1.0;
+  }
+}
+
+void SsorPreconditioner::apply(const std::vector<double> &r, std::vector<double> &z) const
+{
+  const CsrPattern &P = *m_A.pattern;
+  const std::size_t n = static_cast<std::size_t>(P.rows);
+  const double w = m_omega;
+  z.resize(n);
+  // (D/w + L) y = r
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    double s = r[i];
+    for (int k = P.rowPtr[i]; k < m_diagPos[i]; ++k)
+    {
+      s -= m_A.values[static_cast<std::size_t>(k)] * z[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)])];
+    }
+    z[i] = s * w / m_diag[i];
+  }
+  // y <- (D/w) y, majd (D/w + U) z = y
+  for (std::size_t i = n; i-- > 0;)
+  {
+    double s = z[i] * m_diag[i] / w;
+    for (int k = m_diagPos[i] + 1; k < P.rowPtr[i + 1]; ++k)
+    {
+      s -= m_A.values[static_cast<std::size_t>(k)] * z[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)])];
+    }
+    z[i] = s * w / m_diag[i];
+  }
+  const double factor = (2.0 - w) / w;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    z[i] *= factor;
+  }
+}
+
+Preconditioner::UPtr make_preconditioner(const std::string &type, const CsrMatrix &A, double ssorOmega,
+                                         const AmgOptions &amg)
+{
+  if (type == "jacobi")
+  {
+    return Preconditioner::UPtr(new JacobiPreconditioner(A));
+  }
+  if (type == "ic0" || type == "ilu0")
+  {
+    return Preconditioner::UPtr(new Ic0Preconditioner(A));
+  }
+  if (type == "ssor")
+  {
+    return Preconditioner::UPtr(new SsorPreconditioner(A, ssorOmega));
+  }
+  if (type == "amg")
+  {
+    return Preconditioner::UPtr(new AmgPreconditioner(A, amg));
+  }
+  if (type != "none")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen prekondicionáló: \"" << type << "\", jacobi-t használok.\n";
+    return Preconditioner::UPtr(new JacobiPreconditioner(A));
+  }
+  return Preconditioner::UPtr(new IdentityPreconditioner());
+}
@@ -0,0 +1,89 @@
+#ifndef PRECOND_HPP
+#define PRECOND_HPP
+
+#include "sparse.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Prekondicionáló: z = M^{-1} r. A felépítés (setup) egyszer történik a konstruktorban,
+// az apply többször hívható (a csoport mátrixok a külső iterációk alatt nem változnak).
+class Preconditioner
+{
+public:
+  typedef std::unique_ptr<Preconditioner> UPtr;
+
+  virtual ~Preconditioner() {}
+  virtual std::string name() const = 0;
+  virtual void apply(const std::vector<double> &r, std::vector<double> &z) const = 0;
+  virtual std::size_t memory_bytes() const = 0;
+  // Opcionális részletes leírás (pl. AMG hierarchia), üres ha nincs mit mondani
+  virtual std::string details() const { return std::string(); }
+};
+
+// AMG beállítások ($Solver: amg_strength, amg_sweeps, amg_coarse_size, amg_max_levels)
+struct AmgOptions
+{
+  double strength = 0.08; // erős kapcsolat küszöb (theta)
+  int sweeps = 2;         // Jacobi elő- és utósimítások száma szintenként
+  int coarseSize = 200;   // ennél kisebb szinten sűrű direkt megoldás
+  int maxLevels = 12;
+};
+
+// Jacobi: M = diag(A)
+class JacobiPreconditioner : public Preconditioner
+{
+public:
+  explicit JacobiPreconditioner(const CsrMatrix &A);
+  std::string name() const override { return "jacobi"; }
+  void apply(const std::vector<double> &r, std::vector<double> &z) const override;
+  std::size_t memory_bytes() const override { return m_invDiag.size() * sizeof(double); }
+
+private:
+  std::vector<double> m_invDiag;
+};
+
+// Nulla kitöltésű inkomplett Cholesky: A ~ L L^T, L mintázata A alsó háromszöge.
+// Szimmetrikus mátrixra ez azonos az ILU(0)-val. Ha a faktorizáció elakad (nem pozitív pivot),
+// diagonális eltolással újrapróbálja.
+class Ic0Preconditioner : public Preconditioner
+{
+public:
+  explicit Ic0Preconditioner(const CsrMatrix &A);
+  std::string name() const override { return "ic0"; }
+  void apply(const std::vector<double> &r, std::vector<double> &z) const override;
+  std::size_t memory_bytes() const override;
+  double shift() const { return m_shift; }
+
+private:
+  bool factorize(const CsrMatrix &A, double shift);
+
+  int m_n = 0;
+  std::vector<int> m_lowerPtr, m_lowerCol; // L soronként, a diagonális a sor utolsó eleme
+  std::vector<double> m_lowerVal;
+  std::vector<int> m_upperPtr, m_upperCol; // U = L^T soronként, a diagonális a sor első eleme
+  std::vector<double> m_upperVal;
+  double m_shift = 0.0;
+};
+
+// Szimmetrikus SOR: M = w/(2-w) (D/w + L) (D/w)^{-1} (D/w + U)
+class SsorPreconditioner : public Preconditioner
+{
+public:
+  SsorPreconditioner(const CsrMatrix &A, double omega);
+  std::string name() const override { return "ssor"; }
+  void apply(const std::vector<double> &r, std::vector<double> &z) const override;
+  std::size_t memory_bytes() const override { return m_diag.size() * (sizeof(double) + sizeof(int)); }
+
+private:
+  const CsrMatrix &m_A;
+  double m_omega = 1.0;
+  std::vector<int> m_diagPos;
+  std::vector<double> m_diag;
+};
+
+// Prekondicionáló létrehozása név alapján: jacobi | ic0 | ilu0 | ssor | amg | none
+Preconditioner::UPtr make_preconditioner(const std::string &type, const CsrMatrix &A, double ssorOmega,
+                                         const AmgOptions &amg = AmgOptions());
+
+#endif // PRECOND_HPP
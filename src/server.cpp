@@ -0,0 +1,590 @@
+#include "server.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SERVER_UNIX_SOCKET 1
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace
+{
+  std::string strip_comment(const std::string &line)
+  {
+    const std::size_t hashPos = line.find('#');
+    return hashPos == std::string::npos ? line : line.substr(0, hashPos);
+  }
+
+  // Egy kliens: a válaszsorok célja és a még futó kéréseinek száma (a kapcsolat csak ezek után zárható)
+  class Client
+  {
+  public:
+    virtual ~Client() {}
+    virtual void write_line(const std::string &line) = 0;
+
+    void send(const std::string &line)
+    {
+      std::lock_guard<std::mutex> lock(m_writeMutex);
+      write_line(line);
+    }
+    void begin()
+    {
+      std::lock_guard<std::mutex> lock(m_pendingMutex);
+      ++m_pending;
+    }
+    void end()
+    {
+      std::lock_guard<std::mutex> lock(m_pendingMutex);
+      if (--m_pending == 0)
+      {
+        m_idle.notify_all();
+      }
+    }
+    void wait_idle()
+    {
+      std::unique_lock<std::mutex> lock(m_pendingMutex);
+      m_idle.wait(lock, [this]() { return m_pending == 0; });
+    }
+
+  private:
+    std::mutex m_writeMutex;
+    std::mutex m_pendingMutex;
+    std::condition_variable m_idle;
+    int m_pending = 0;
+  };
+
+  class StreamClient : public Client
+  {
+  public:
+    explicit StreamClient(std::ostream &out) : m_out(out) {}
+    void write_line(const std::string &line) override { m_out << line << "\n" << std::flush; }
+
+  private:
+    std::ostream &m_out;
+  };
+
+  // Kérések sora a munkás szálaknak; close után a maradékot még kiszolgálják
+  class RequestQueue
+  {
+  public:
+    void push(std::function<void()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+      }
+      m_ready.notify_one();
+    }
+    bool pop(std::function<void()> &task)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_ready.wait(lock, [this]() { return m_closed || !m_tasks.empty(); });
+      if (m_tasks.empty())
+      {
+        return false;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+      return true;
+    }
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+      }
+      m_ready.notify_all();
+    }
+    std::size_t size()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_tasks.size();
+    }
+
+  private:
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    bool m_closed = false;
+  };
+
+  std::string format_result(const BatchCaseResult &result, bool cached, bool withPins)
+  {
+    std::ostringstream oss;
+    if (!result.ok)
+    {
+      oss << "error " << result.name << " " << result.error;
+      return oss.str();
+    }
+    oss << "ok " << result.name << std::fixed << std::setprecision(6) << " keff=" << result.keff << std::setprecision(1)
+        << " drho_pcm=" << result.deltaRho * 1e5 << " outer=" << result.outerIterations
+        << " converged=" << (result.converged ? 1 : 0) << std::setprecision(4) << " peaking=" << result.peaking
+        << std::setprecision(2) << " ms=" << result.totalMs;
+    if (cached)
+    {
+      oss << " cached=1";
+    }
+    if (withPins)
+    {
+      oss << " pins=" << std::setprecision(4);
+      for (std::size_t i = 0; i < result.pinPower.size(); ++i)
+      {
+        oss << (i > 0 ? "," : "") << result.pinPower[i];
+      }
+    }
+    return oss.str();
+  }
+
+  class Server
+  {
+  public:
+    Server(const BatchSession &session, const ServerOptions &options) : m_session(session), m_options(options)
+    {
+      const int workers = std::max(1, options.workers > 0 ? options.workers : thread_count());
+      for (int w = 0; w < workers; ++w)
+      {
+        m_workers.emplace_back([this]() {
+          std::function<void()> task;
+          while (m_queue.pop(task))
+          {
+            task();
+          }
+        });
+      }
+    }
+
+    ~Server() { stop_workers(); }
+
+    void stop_workers()
+    {
+      m_queue.close();
+      for (std::thread &worker : m_workers)
+      {
+        if (worker.joinable())
+        {
+          worker.join();
+        }
+      }
+    }
+
+    // Egy bemeneti sor feldolgozása; false, ha a kliens (quit) vagy a szerver (shutdown) befejezte
+    bool handle(const std::string &line, const std::shared_ptr<Client> &client)
+    {
+      std::istringstream iss(strip_comment(line));
+      std::vector<std::string> tokens;
+      std::string token;
+      while (iss >> token)
+      {
+        tokens.push_back(token);
+      }
+      if (tokens.empty())
+      {
+        return true;
+      }
+      const std::string &command = tokens[0];
+      if (command == "quit")
+      {
+        return false;
+      }
+      if (command == "shutdown")
+      {
+        request_shutdown();
+        return false;
+      }
+      const std::size_t requestNo = count_request();
+      if (command == "status")
+      {
+        client->send(status_line());
+        return true;
+      }
+      if (command == "reference")
+      {
+        count_cached();
+        client->send(format_result(m_session.reference(), true, m_session.has_pins()));
+        return true;
+      }
+      if (command != "solve" && command != "pins")
+      {
+        count_failed();
+        client->send("error - Ismeretlen kérés: \"" + command + "\" (solve | pins | reference | status | quit | shutdown)");
+        return true;
+      }
+      const bool withPins = command == "pins";
+      if (withPins && !m_session.has_pins())
+      {
+        count_failed();
+        client->send("error " + (tokens.size() > 1 ? tokens[1] : std::string("-")) + " Nincs pin rács (pin_power off).");
+        return true;
+      }
+
+      BatchCase batchCase;
+      try
+      {
+        batchCase = parse_batch_case(std::vector<std::string>(tokens.begin() + 1, tokens.end()), requestNo);
+      }
+      catch (const BatchError &ex)
+      {
+        count_failed();
+        client->send("error " + (tokens.size() > 1 ? tokens[1] : std::string("-")) + " " + ex.what());
+        return true;
+      }
+
+      // Gyorsítótár: a kulcs a változtatások sorozata (a név nem számít)
+      std::string key;
+      for (std::size_t i = 2; i < tokens.size(); ++i)
+      {
+        key += (i > 2 ? " " : "") + tokens[i];
+      }
+      // Ugyanaz a kulcs már megoldás alatt: a kérés a futó megoldás eredményére vár (gyorsítótárból kiszolgáltnak számít)
+      if (m_options.cache)
+      {
+        BatchCaseResult result;
+        bool hit = false;
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          std::map<std::string, BatchCaseResult>::const_iterator it = m_cache.find(key);
+          if (it != m_cache.end())
+          {
+            result = it->second;
+            hit = true;
+            ++m_stats.cached;
+          }
+          else
+          {
+            std::map<std::string, std::vector<Waiter>>::iterator pending = m_pending.find(key);
+            if (pending != m_pending.end())
+            {
+              client->begin();
+              pending->second.push_back(Waiter{client, batchCase, withPins});
+              return true;
+            }
+            m_pending[key];
+          }
+        }
+        if (hit)
+        {
+          result.name = batchCase.name;
+          client->send(format_result(result, true, withPins));
+          return true;
+        }
+      }
+
+      client->begin();
+      m_queue.push([this, client, batchCase, key, withPins]() { solve_case(client, batchCase, key, withPins, true); });
+      return true;
+    }
+
+    bool shutting_down()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_shutdown;
+    }
+
+    // A shutdown kérés után hívódik (pl. a socket lezárása a várakozó accept felébresztésére)
+    void on_shutdown(std::function<void()> callback) { m_onShutdown = std::move(callback); }
+
+    void add_connection()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_stats.connections;
+    }
+
+    ServerStats stats()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_stats;
+    }
+
+  private:
+    // Egy már futó megoldásra váró kérés
+    struct Waiter
+    {
+      std::shared_ptr<Client> client;
+      BatchCase batchCase;
+      bool withPins = false;
+    };
+
+    // Egy eset megoldása és a válasz (munkás szálon). A kulcs gazdája (owner) a rá váró kéréseknek is válaszol; hibánál
+    // ezek külön futnak, mert a hibaüzenet a kérés nevét is tartalmazhatja
+    void solve_case(const std::shared_ptr<Client> &client, const BatchCase &batchCase, const std::string &key,
+                    bool withPins, bool owner)
+    {
+      BatchCaseResult result;
+      m_session.solve(batchCase, result);
+      std::vector<Waiter> waiters;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!result.ok)
+        {
+          ++m_stats.failed;
+        }
+        else if (batchCase.changes.empty())
+        {
+          ++m_stats.cached;
+        }
+        else
+        {
+          ++m_stats.solved;
+          m_stats.solveMs += result.totalMs;
+          if (m_options.cache)
+          {
+            m_cache[key] = result;
+          }
+        }
+        std::map<std::string, std::vector<Waiter>>::iterator pending = m_pending.find(key);
+        if (owner && pending != m_pending.end())
+        {
+          waiters.swap(pending->second);
+          m_pending.erase(pending);
+          if (result.ok)
+          {
+            m_stats.cached += static_cast<long>(waiters.size());
+          }
+        }
+      }
+      client->send(format_result(result, false, withPins));
+      client->end();
+      for (const Waiter &waiter : waiters)
+      {
+        if (!result.ok)
+        {
+          m_queue.push([this, waiter, key]() {
+            solve_case(waiter.client, waiter.batchCase, key, waiter.withPins, false);
+          });
+          continue;
+        }
+        BatchCaseResult copy = result;
+        copy.name = waiter.batchCase.name;
+        waiter.client->send(format_result(copy, true, waiter.withPins));
+        waiter.client->end();
+      }
+    }
+
+    void request_shutdown()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+      }
+      if (m_onShutdown)
+      {
+        m_onShutdown();
+      }
+    }
+    // A kérés sorszáma (a hibaüzenetek "sor" mezője)
+    std::size_t count_request()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return static_cast<std::size_t>(++m_stats.requests);
+    }
+    void count_cached()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_stats.cached;
+    }
+    void count_failed()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_stats.failed;
+    }
+    std::string status_line()
+    {
+      std::ostringstream oss;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      oss << "ok status requests=" << m_stats.requests << " solved=" << m_stats.solved << " cached=" << m_stats.cached
+          << " failed=" << m_stats.failed << " queued=" << m_queue.size() << " workers=" << m_workers.size()
+          << " pins=" << m_session.pin_count() << " cache_entries=" << m_cache.size() << std::fixed << std::setprecision(6)
+          << " keff_ref=" << m_session.reference().keff;
+      return oss.str();
+    }
+
+    const BatchSession &m_session;
+    ServerOptions m_options;
+    RequestQueue m_queue;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex; // m_stats, m_cache, m_pending, m_shutdown
+    ServerStats m_stats;
+    std::map<std::string, BatchCaseResult> m_cache;
+    std::map<std::string, std::vector<Waiter>> m_pending; // megoldás alatt álló kulcsok és a rájuk váró kérések
+    bool m_shutdown = false;
+    std::function<void()> m_onShutdown;
+  };
+
+#ifdef SERVER_UNIX_SOCKET
+  class SocketClient : public Client
+  {
+  public:
+    explicit SocketClient(int fd) : m_fd(fd) {}
+    void write_line(const std::string &line) override
+    {
+      const std::string data = line + "\n";
+      std::size_t sent = 0;
+      while (sent < data.size())
+      {
+        const ssize_t n = ::send(m_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+          return; // a kliens bontott, a választ eldobjuk
+        }
+        sent += static_cast<std::size_t>(n);
+      }
+    }
+
+  private:
+    int m_fd;
+  };
+
+  void serve_socket(Server &server, const std::string &path)
+  {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+      throw ServerError("Túl hosszú socket útvonal: " + path);
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    const int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+    {
+      throw ServerError(std::string("Nem sikerült socketet nyitni: ") + std::strerror(errno));
+    }
+    ::unlink(path.c_str());
+    if (::bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || ::listen(listenFd, 16) < 0)
+    {
+      const std::string reason = std::strerror(errno);
+      ::close(listenFd);
+      throw ServerError("Nem sikerült a sockethez kötni (" + path + "): " + reason);
+    }
+
+    std::mutex connectionMutex;
+    std::vector<int> openFds;
+    std::vector<std::thread> connections;
+    server.on_shutdown([&]() {
+      // Az accept és a kliensek olvasása is felébred; a futó kérések még válaszolnak
+      ::shutdown(listenFd, SHUT_RDWR);
+      std::lock_guard<std::mutex> lock(connectionMutex);
+      for (int fd : openFds)
+      {
+        ::shutdown(fd, SHUT_RD);
+      }
+    });
+
+    while (!server.shutting_down())
+    {
+      const int fd = ::accept(listenFd, nullptr, nullptr);
+      if (fd < 0)
+      {
+        if (errno == EINTR && !server.shutting_down())
+        {
+          continue;
+        }
+        break;
+      }
+      {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (server.shutting_down())
+        {
+          ::close(fd);
+          break;
+        }
+        openFds.push_back(fd);
+      }
+      server.add_connection();
+      connections.emplace_back([&server, &connectionMutex, &openFds, fd]() {
+        std::shared_ptr<Client> client(new SocketClient(fd));
+        std::string buffer;
+        char chunk[4096];
+        bool open = true;
+        while (open)
+        {
+          const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+          if (n <= 0)
+          {
+            break;
+          }
+          buffer.append(chunk, static_cast<std::size_t>(n));
+          std::size_t newline = 0;
+          while (open && (newline = buffer.find('\n')) != std::string::npos)
+          {
+            const std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            open = server.handle(line, client);
+          }
+        }
+        client->wait_idle();
+        {
+          std::lock_guard<std::mutex> lock(connectionMutex);
+          openFds.erase(std::remove(openFds.begin(), openFds.end(), fd), openFds.end());
+        }
+        ::close(fd);
+      });
+    }
+    for (std::thread &connection : connections)
+    {
+      connection.join();
+    }
+    server.on_shutdown(std::function<void()>());
+    ::close(listenFd);
+    ::unlink(path.c_str());
+  }
+#endif
+}
+
+ServerOptions read_server_options(const SolverConfig &config)
+{
+  ServerOptions options;
+  options.socket = config.getString("server_socket", options.socket);
+  options.workers = config.getInt("server_workers", options.workers);
+  options.cache = config.getBool("server_cache", options.cache);
+  if (options.workers < 0)
+  {
+    std::cerr << "[FIGYELMEZTETÉS] A server_workers nem lehet negatív, a szálak számát használom.\n";
+    options.workers = 0;
+  }
+  return options;
+}
+
+void run_server(const BatchSession &session, const ServerOptions &options, ServerStats &stats)
+{
+  Server server(session, options);
+  if (options.socket.empty())
+  {
+    std::shared_ptr<Client> client(new StreamClient(std::cout));
+    server.add_connection();
+    std::string line;
+    while (std::getline(std::cin, line) && server.handle(line, client))
+    {
+    }
+    client->wait_idle();
+  }
+  else
+  {
+#ifdef SERVER_UNIX_SOCKET
+    serve_socket(server, options.socket);
+#else
+    throw ServerError("Unix domain socket ezen a platformon nem támogatott (server_socket).");
+#endif
+  }
+  server.stop_workers();
+  stats = server.stats();
+}
@@ -0,0 +1,58 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "batch.hpp"
+#include "control.hpp"
+#include <stdexcept>
+#include <string>
+
+// Rezidens szerver mód (mode server): a háló, az XS könyvtár, a model és a felépített operátor (a közös CSR
+// mintázat, színezés, szimbolikus analízis, pin rács) a memóriában marad, a kérések soronként érkeznek a standard
+// bemeneten vagy egy Unix domain socketen (server_socket), a válaszok soronként mennek vissza ugyanott.
+//
+// Egy kérés az esetlista egy sora (BatchSession): csak a változtatott keresztmetszetek, a numerikus összegzés és a
+// sajátérték megoldás fut újra; változtatás nélkül a referencia megoldás az eredmény, a már kiszámolt változtatás
+// sorozatok eredménye pedig a gyorsítótárból jön (a még megoldás alatt álló sorozatra érkező kérés a futó megoldást
+// várja meg). A kérések egy munkás készleten párhuzamosan futnak, ezért a válaszok sorrendje eltérhet a kérésekétől
+// (a válasz tartalmazza a kérés nevét).
+//
+// Kérések:
+//   solve név [változtatás ...]   k-eff, reaktivitás, iterációk, pin csúcstényező
+//   pins név [változtatás ...]    ugyanez a relatív pin teljesítményekkel (a pin rács sorrendjében)
+//   reference                     a módosítatlan rendszer eredménye
+//   status                        számlálók
+//   quit                          a kapcsolat (standard bemenetnél a szerver) vége
+//   shutdown                      a szerver leállítása (a folyamatban lévő kérések még válaszolnak)
+// Válaszok:
+//   ok név keff=... drho_pcm=... outer=... converged=0|1 peaking=... ms=... [cached=1] [pins=p1,p2,...]
+//   error név üzenet
+
+class ServerError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct ServerOptions
+{
+  std::string socket;           // Unix domain socket útvonala (üres = standard bemenet / kimenet)
+  int workers = 0;              // párhuzamosan futó kérések (0 = a szálak száma)
+  bool cache = true;            // a kiszámolt változtatás sorozatok eredményének megőrzése
+};
+
+ServerOptions read_server_options(const SolverConfig &config);
+
+struct ServerStats
+{
+  long requests = 0;            // minden értelmezett kérés
+  long solved = 0;              // ténylegesen megoldott esetek
+  long cached = 0;              // gyorsítótárból (vagy a referenciából) kiszolgált esetek
+  long failed = 0;
+  int connections = 0;
+  double solveMs = 0.0;         // a megoldott esetek összes ideje
+};
+
+// Addig fut, amíg a bemenet el nem fogy, quit (standard bemenet) vagy shutdown kérés nem jön
+void run_server(const BatchSession &session, const ServerOptions &options, ServerStats &stats);
+
+#endif // SERVER_HPP
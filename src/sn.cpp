@@ -0,0 +1,846 @@
+#include "sn.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace
+{
+  const double PI = 3.14159265358979323846;
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  std::pair<int, int> edge_key(int a, int b)
+  {
+    return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+  }
+
+  // 3x3 lineáris rendszer (részleges főelem-kiválasztással), a a sorfolytonos mátrix, b a jobb oldal -> x
+  inline void solve3(double a[9], double b[3], double x[3])
+  {
+    int perm[3] = {0, 1, 2};
+    for (int k = 0; k < 3; ++k)
+    {
+      int pivot = k;
+      for (int i = k + 1; i < 3; ++i)
+      {
+        if (std::fabs(a[perm[i] * 3 + k]) > std::fabs(a[perm[pivot] * 3 + k]))
+        {
+          pivot = i;
+        }
+      }
+      std::swap(perm[k], perm[pivot]);
+      const int pk = perm[k];
+      for (int i = k + 1; i < 3; ++i)
+      {
+        const int pi = perm[i];
+        const double f = a[pi * 3 + k] / a[pk * 3 + k];
+        for (int j = k; j < 3; ++j)
+        {
+          a[pi * 3 + j] -= f * a[pk * 3 + j];
+        }
+        b[pi] -= f * b[pk];
+      }
+    }
+    for (int k = 2; k >= 0; --k)
+    {
+      const int pk = perm[k];
+      double s = b[pk];
+      for (int j = k + 1; j < 3; ++j)
+      {
+        s -= a[pk * 3 + j] * x[j];
+      }
+      x[k] = s / a[pk * 3 + k];
+    }
+  }
+}
+
+void gauss_legendre_half(int half, std::vector<double> &nodes, std::vector<double> &weights)
+{
+  const int n = 2 * half;
+  nodes.clear();
+  weights.clear();
+  for (int i = 1; i <= half; ++i)
+  {
+    double x = std::cos(PI * (i - 0.25) / (n + 0.5));
+    double dp = 1.0;
+    for (int it = 0; it < 100; ++it)
+    {
+      double p0 = 1.0, p1 = x;
+      for (int j = 2; j <= n; ++j)
+      {
+        const double p2 = ((2.0 * j - 1.0) * x * p1 - (j - 1.0) * p0) / j;
+        p0 = p1;
+        p1 = p2;
+      }
+      dp = n * (x * p1 - p0) / (x * x - 1.0);
+      const double dx = p1 / dp;
+      x -= dx;
+      if (std::fabs(dx) < 1e-15)
+      {
+        break;
+      }
+    }
+    nodes.push_back(x);
+    weights.push_back(2.0 / ((1.0 - x * x) * dp * dp));
+  }
+}
+
+SnOptions read_sn_options(const SolverConfig &config)
+{
+  SnOptions options;
+  options.polar = config.getInt("sn_polar", options.polar);
+  options.azimuthal = config.getInt("sn_azimuthal", options.azimuthal);
+  options.parallel = config.getString("sn_parallel", options.parallel);
+  options.kTolerance = config.getDouble("sn_k_tol", options.kTolerance);
+  options.sourceTolerance = config.getDouble("sn_source_tol", options.sourceTolerance);
+  options.maxOuter = config.getInt("sn_max_outer", options.maxOuter);
+  options.innerTolerance = config.getDouble("sn_inner_tol", options.innerTolerance);
+  options.maxInner = config.getInt("sn_max_inner", options.maxInner);
+  options.dsa = config.getBool("sn_dsa", options.dsa);
+  options.dsaTolerance = config.getDouble("sn_dsa_tol", options.dsaTolerance);
+  if (options.polar < 1 || options.azimuthal < 4 || options.azimuthal % 4 != 0)
+  {
+    throw SnError("Az sn_polar legalább 1, az sn_azimuthal néggyel osztható és legalább 4 kell legyen.");
+  }
+  if (options.parallel != "auto" && options.parallel != "angles" && options.parallel != "wavefront")
+  {
+    std::cerr << "[FIGYELMEZTETÉS] Ismeretlen sn_parallel: \"" << options.parallel << "\", auto-t használok.\n";
+    options.parallel = "auto";
+  }
+  return options;
+}
+
+SnTransport::SnTransport(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system,
+                         const SolverConfig &config, const SnOptions &options)
+    : m_mesh(mesh), m_library(library), m_system(system), m_groupCount(system.groupCount),
+      m_elementCount(static_cast<int>(mesh.tris.size()))
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const std::size_t E = static_cast<std::size_t>(m_elementCount);
+
+  // --- Kvadratúra: polár Gauss–Legendre x egyenközű azimut, a felső félgömb (2D-ben az alsó szimmetrikus) ---
+  std::vector<double> polarCos, polarWeight;
+  gauss_legendre_half(options.polar, polarCos, polarWeight);
+  const int nA = options.azimuthal;
+  for (std::size_t p = 0; p < polarCos.size(); ++p)
+  {
+    const double sinTheta = std::sqrt(1.0 - polarCos[p] * polarCos[p]);
+    for (int a = 0; a < nA; ++a)
+    {
+      const double phi = (a + 0.5) * 2.0 * PI / nA;
+      m_mu.push_back(sinTheta * std::cos(phi));
+      m_eta.push_back(sinTheta * std::sin(phi));
+      m_weight.push_back(polarWeight[p] / nA);
+    }
+  }
+  const std::size_t D = m_weight.size();
+
+  // --- Elemenkénti geometria és szomszédság ---
+  m_nodes.resize(3 * E);
+  m_normal.resize(6 * E);
+  m_neighbor.assign(3 * E, -1);
+  m_neighborLocal.assign(6 * E, -1);
+  m_boundarySlot.assign(3 * E, -1);
+  std::map<std::pair<int, int>, int> edgeOwner; // (csúcs, csúcs) -> 3 * e + k
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    m_nodes[3 * e] = t.a - 1;
+    m_nodes[3 * e + 1] = t.b - 1;
+    m_nodes[3 * e + 2] = t.c - 1;
+  }
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      const int p = m_nodes[3 * e + (k + 1) % 3];
+      const int q = m_nodes[3 * e + (k + 2) % 3];
+      const int r = m_nodes[3 * e + k];
+      const Mesh::Node &np = mesh.nodes[static_cast<std::size_t>(p + 1)];
+      const Mesh::Node &nq = mesh.nodes[static_cast<std::size_t>(q + 1)];
+      const Mesh::Node &nr = mesh.nodes[static_cast<std::size_t>(r + 1)];
+      double nx = nq.y - np.y, ny = -(nq.x - np.x); // |n| = élhossz
+      if (nx * (nr.x - np.x) + ny * (nr.y - np.y) > 0.0)
+      {
+        nx = -nx;
+        ny = -ny;
+      }
+      m_normal[(3 * e + k) * 2] = nx;
+      m_normal[(3 * e + k) * 2 + 1] = ny;
+
+      const std::pair<int, int> key = edge_key(p, q);
+      const std::map<std::pair<int, int>, int>::iterator it = edgeOwner.find(key);
+      if (it == edgeOwner.end())
+      {
+        edgeOwner[key] = static_cast<int>(3 * e + k);
+        continue;
+      }
+      const int other = it->second;
+      if (other < 0)
+      {
+        throw SnError("Nem konform háló: egy élhez kettőnél több háromszög tartozik.");
+      }
+      const std::size_t oe = static_cast<std::size_t>(other / 3);
+      m_neighbor[3 * e + k] = static_cast<int>(oe);
+      m_neighbor[static_cast<std::size_t>(other)] = static_cast<int>(e);
+      for (std::size_t j = 0; j < 3; ++j)
+      {
+        const int node = m_nodes[3 * oe + j];
+        if (node == p)
+        {
+          m_neighborLocal[(3 * e + k) * 2] = static_cast<int>(j);
+        }
+        if (node == q)
+        {
+          m_neighborLocal[(3 * e + k) * 2 + 1] = static_cast<int>(j);
+        }
+      }
+      const int op = m_nodes[3 * oe + (static_cast<std::size_t>(other % 3) + 1) % 3];
+      for (std::size_t j = 0; j < 3; ++j)
+      {
+        const int node = m_nodes[3 * e + j];
+        if (node == op)
+        {
+          m_neighborLocal[static_cast<std::size_t>(other) * 2] = static_cast<int>(j);
+        }
+        else if (node != r)
+        {
+          m_neighborLocal[static_cast<std::size_t>(other) * 2 + 1] = static_cast<int>(j);
+        }
+      }
+      it->second = -1;
+    }
+  }
+
+  // --- Külső élek: vákuum a vákuum típusú 1D elemeken, különben tükröző ---
+  std::set<std::pair<int, int>> vacuum;
+  for (int l : system.vacuumLines)
+  {
+    const Mesh::Line &line = mesh.lines[static_cast<std::size_t>(l)];
+    vacuum.insert(edge_key(line.a - 1, line.b - 1));
+  }
+  for (std::size_t e = 0; e < E; ++e)
+  {
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      if (m_neighbor[3 * e + k] >= 0)
+      {
+        continue;
+      }
+      const int p = m_nodes[3 * e + (k + 1) % 3];
+      const int q = m_nodes[3 * e + (k + 2) % 3];
+      if (vacuum.count(edge_key(p, q)) > 0)
+      {
+        ++m_vacuumEdges;
+        continue;
+      }
+      m_neighbor[3 * e + k] = -2;
+      m_boundarySlot[3 * e + k] = m_reflectiveEdges++;
+      m_boundaryEdge.push_back(static_cast<int>(3 * e + k));
+      const double nx = m_normal[(3 * e + k) * 2], ny = m_normal[(3 * e + k) * 2 + 1];
+      const double len = std::sqrt(nx * nx + ny * ny);
+      for (std::size_t d = 0; d < D; ++d)
+      {
+        // Síkbeli tükrözés, a legközelebbi irány ugyanazon a polárszinten
+        const double on = (m_mu[d] * nx + m_eta[d] * ny) / len;
+        const double rx = m_mu[d] - 2.0 * on * nx / len, ry = m_eta[d] - 2.0 * on * ny / len;
+        const std::size_t level = d / static_cast<std::size_t>(nA);
+        std::size_t best = level * static_cast<std::size_t>(nA);
+        double bestDistance = 1e300;
+        for (std::size_t a = 0; a < static_cast<std::size_t>(nA); ++a)
+        {
+          const std::size_t c = level * static_cast<std::size_t>(nA) + a;
+          const double dist = (m_mu[c] - rx) * (m_mu[c] - rx) + (m_eta[c] - ry) * (m_eta[c] - ry);
+          if (dist < bestDistance)
+          {
+            bestDistance = dist;
+            best = c;
+          }
+        }
+        m_reflected.push_back(static_cast<int>(best));
+      }
+    }
+  }
+
+  // --- Söprési ütemterv irányonként: topologikus rendezés hullámfrontokra (Kahn), ciklusnál késleltetett él ---
+  m_schedules.resize(D);
+  parallel_for(0, D, [&](std::size_t d) {
+    Schedule &s = m_schedules[d];
+    std::vector<int> remaining(E, 0);
+    std::vector<unsigned char> scheduled(E, 0);
+    s.lagged.assign(E, 0);
+    for (std::size_t e = 0; e < E; ++e)
+    {
+      for (std::size_t k = 0; k < 3; ++k)
+      {
+        const double on = m_mu[d] * m_normal[(3 * e + k) * 2] + m_eta[d] * m_normal[(3 * e + k) * 2 + 1];
+        if (on < 0.0 && m_neighbor[3 * e + k] >= 0)
+        {
+          ++remaining[e];
+        }
+      }
+    }
+    std::vector<int> frontier;
+    for (std::size_t e = 0; e < E; ++e)
+    {
+      if (remaining[e] == 0)
+      {
+        frontier.push_back(static_cast<int>(e));
+      }
+    }
+    s.levelPtr.push_back(0);
+    std::size_t done = 0;
+    std::vector<int> next;
+    while (done < E)
+    {
+      if (frontier.empty())
+      {
+        // Ciklus: a legkevesebb hiányzó bemenetű elem indul, a hiányzó bemenetei az előző söprésből jönnek
+        std::size_t pick = E;
+        for (std::size_t e = 0; e < E; ++e)
+        {
+          if (!scheduled[e] && (pick == E || remaining[e] < remaining[pick]))
+          {
+            pick = e;
+          }
+        }
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+          const int nb = m_neighbor[3 * pick + k];
+          const double on = m_mu[d] * m_normal[(3 * pick + k) * 2] + m_eta[d] * m_normal[(3 * pick + k) * 2 + 1];
+          if (on < 0.0 && nb >= 0 && !scheduled[static_cast<std::size_t>(nb)])
+          {
+            s.lagged[pick] |= static_cast<unsigned char>(1u << k);
+            s.laggedSlot.push_back(static_cast<int>(3 * pick + k));
+          }
+        }
+        remaining[pick] = 0;
+        frontier.push_back(static_cast<int>(pick));
+      }
+      std::sort(frontier.begin(), frontier.end());
+      next.clear();
+      for (int e : frontier)
+      {
+        scheduled[static_cast<std::size_t>(e)] = 1;
+      }
+      for (int e : frontier)
+      {
+        s.order.push_back(e);
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+          const std::size_t slot = 3 * static_cast<std::size_t>(e) + k;
+          const int nb = m_neighbor[slot];
+          const double on = m_mu[d] * m_normal[slot * 2] + m_eta[d] * m_normal[slot * 2 + 1];
+          if (on > 0.0 && nb >= 0 && !scheduled[static_cast<std::size_t>(nb)] && --remaining[static_cast<std::size_t>(nb)] == 0)
+          {
+            next.push_back(nb);
+          }
+        }
+      }
+      done += frontier.size();
+      s.levelPtr.push_back(static_cast<int>(s.order.size()));
+      frontier.swap(next);
+    }
+    std::sort(s.laggedSlot.begin(), s.laggedSlot.end());
+  }, 1);
+
+  // --- Késleltetett és perem tárolók, szálankénti pufferek ---
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  m_laggedPsi.assign(G, std::vector<std::vector<double>>(D));
+  for (std::size_t g = 0; g < G; ++g)
+  {
+    for (std::size_t d = 0; d < D; ++d)
+    {
+      m_laggedPsi[g][d].assign(2 * m_schedules[d].laggedSlot.size(), 0.0);
+    }
+  }
+  m_boundaryOld.assign(G, std::vector<double>(2 * static_cast<std::size_t>(m_reflectiveEdges) * D, 0.0));
+  m_boundaryNew = m_boundaryOld;
+
+  if (options.parallel == "angles")
+  {
+    m_parallelByAngle = true;
+  }
+  else if (options.parallel == "wavefront")
+  {
+    m_parallelByAngle = false;
+  }
+  else
+  {
+    m_parallelByAngle = static_cast<int>(D) >= thread_count();
+  }
+  const std::size_t buffers = m_parallelByAngle ? static_cast<std::size_t>(thread_count()) : 1;
+  m_threadPsi.assign(buffers, std::vector<double>(3 * E, 0.0));
+  m_threadPhi.assign(buffers, std::vector<double>(3 * E, 0.0));
+
+  // --- DSA: a diffúziós csoport mátrixok csoportonkénti megoldója (csatolt megoldó helyett PCG) ---
+  if (options.dsa)
+  {
+    SolverConfig dsaConfig = config;
+    dsaConfig.options["inner_tol"] = std::to_string(options.dsaTolerance);
+    dsaConfig.options["inner_history"] = "off";
+    if (dsaConfig.getString("inner_solver", "pcg") == "coupled")
+    {
+      dsaConfig.options["inner_solver"] = "pcg";
+    }
+    if (dsaConfig.getString("spmv", "sell") == "matrix_free")
+    {
+      dsaConfig.options["spmv"] = "sell";
+    }
+    m_dsaSolver = make_group_solver(system, dsaConfig, nullptr);
+  }
+  m_setupMs = elapsed_ms(start);
+}
+
+double SnTransport::average_levels() const
+{
+  if (m_schedules.empty())
+  {
+    return 0.0;
+  }
+  double total = 0.0;
+  for (const Schedule &s : m_schedules)
+  {
+    total += static_cast<double>(s.levelPtr.size() - 1);
+  }
+  return total / static_cast<double>(m_schedules.size());
+}
+
+int SnTransport::max_level_width() const
+{
+  int width = 0;
+  for (const Schedule &s : m_schedules)
+  {
+    for (std::size_t l = 0; l + 1 < s.levelPtr.size(); ++l)
+    {
+      width = std::max(width, s.levelPtr[l + 1] - s.levelPtr[l]);
+    }
+  }
+  return width;
+}
+
+long SnTransport::lagged_edges() const
+{
+  long total = 0;
+  for (const Schedule &s : m_schedules)
+  {
+    total += static_cast<long>(s.laggedSlot.size());
+  }
+  return total;
+}
+
+void SnTransport::solve_element(int group, int d, int e, const std::vector<double> &source, std::vector<double> &psi) const
+{
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t D = m_weight.size();
+  const std::size_t ue = static_cast<std::size_t>(e);
+  const std::size_t ud = static_cast<std::size_t>(d);
+  const XsCompiled &xs = m_library.compiled;
+  const double sigmaT = xs.sigma_t[static_cast<std::size_t>(m_system.elementMaterial[ue]) * G + static_cast<std::size_t>(group)];
+  const ElementGeometry &geo = m_system.geometry[ue];
+  const double area = geo.area;
+  const double mu = m_mu[ud], eta = m_eta[ud];
+
+  const double *q = &source[3 * ue];
+  const double qSum = q[0] + q[1] + q[2];
+  double a[9], b[3], x[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    const double stream = -(mu * geo.b[i] + eta * geo.c[i]) * area / 3.0;
+    for (int j = 0; j < 3; ++j)
+    {
+      a[i * 3 + j] = stream + sigmaT * area / 12.0 * (i == j ? 2.0 : 1.0);
+    }
+    b[i] = area / 12.0 * (q[i] + qSum);
+  }
+  const Schedule &schedule = m_schedules[ud];
+  for (int k = 0; k < 3; ++k)
+  {
+    const std::size_t slot = 3 * ue + static_cast<std::size_t>(k);
+    const double on = mu * m_normal[slot * 2] + eta * m_normal[slot * 2 + 1];
+    const int i1 = (k + 1) % 3, i2 = (k + 2) % 3;
+    if (on > 0.0)
+    {
+      a[i1 * 3 + i1] += on / 3.0;
+      a[i2 * 3 + i2] += on / 3.0;
+      a[i1 * 3 + i2] += on / 6.0;
+      a[i2 * 3 + i1] += on / 6.0;
+      continue;
+    }
+    if (on == 0.0)
+    {
+      continue;
+    }
+    const int nb = m_neighbor[slot];
+    double u1 = 0.0, u2 = 0.0;
+    if (nb >= 0)
+    {
+      if ((schedule.lagged[ue] >> k) & 1u)
+      {
+        const std::vector<int>::const_iterator it =
+            std::lower_bound(schedule.laggedSlot.begin(), schedule.laggedSlot.end(), static_cast<int>(slot));
+        const std::size_t l = static_cast<std::size_t>(it - schedule.laggedSlot.begin());
+        u1 = m_laggedPsi[static_cast<std::size_t>(group)][ud][2 * l];
+        u2 = m_laggedPsi[static_cast<std::size_t>(group)][ud][2 * l + 1];
+      }
+      else
+      {
+        u1 = psi[3 * static_cast<std::size_t>(nb) + static_cast<std::size_t>(m_neighborLocal[slot * 2])];
+        u2 = psi[3 * static_cast<std::size_t>(nb) + static_cast<std::size_t>(m_neighborLocal[slot * 2 + 1])];
+      }
+    }
+    else if (nb == -2)
+    {
+      const std::size_t boundary = static_cast<std::size_t>(m_boundarySlot[slot]);
+      const std::size_t reflected = static_cast<std::size_t>(m_reflected[boundary * D + ud]);
+      const std::vector<double> &old = m_boundaryOld[static_cast<std::size_t>(group)];
+      u1 = old[(boundary * D + reflected) * 2];
+      u2 = old[(boundary * D + reflected) * 2 + 1];
+    }
+    b[i1] -= on * (u1 / 3.0 + u2 / 6.0);
+    b[i2] -= on * (u1 / 6.0 + u2 / 3.0);
+  }
+  solve3(a, b, x);
+  psi[3 * ue] = x[0];
+  psi[3 * ue + 1] = x[1];
+  psi[3 * ue + 2] = x[2];
+}
+
+void SnTransport::sweep_direction(int group, int d, const std::vector<double> &source, std::vector<double> &psi,
+                                  std::vector<double> &phi, bool parallelElements)
+{
+  const std::size_t D = m_weight.size();
+  const std::size_t ud = static_cast<std::size_t>(d);
+  const Schedule &s = m_schedules[ud];
+  const double w = m_weight[ud];
+  std::vector<double> &boundaryNew = m_boundaryNew[static_cast<std::size_t>(group)];
+  auto element = [&](std::size_t position) {
+    const std::size_t e = static_cast<std::size_t>(s.order[position]);
+    solve_element(group, d, static_cast<int>(e), source, psi);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      phi[3 * e + i] += w * psi[3 * e + i];
+    }
+    // Tükröző peremen a kimenő psi a következő söprés bejövő értéke
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      const int slot = m_boundarySlot[3 * e + k];
+      if (slot < 0)
+      {
+        continue;
+      }
+      const double on = m_mu[ud] * m_normal[(3 * e + k) * 2] + m_eta[ud] * m_normal[(3 * e + k) * 2 + 1];
+      if (on > 0.0)
+      {
+        const std::size_t pos = (static_cast<std::size_t>(slot) * D + ud) * 2;
+        boundaryNew[pos] = psi[3 * e + (k + 1) % 3];
+        boundaryNew[pos + 1] = psi[3 * e + (k + 2) % 3];
+      }
+    }
+  };
+  for (std::size_t l = 0; l + 1 < s.levelPtr.size(); ++l)
+  {
+    const std::size_t begin = static_cast<std::size_t>(s.levelPtr[l]);
+    const std::size_t end = static_cast<std::size_t>(s.levelPtr[l + 1]);
+    if (parallelElements)
+    {
+      parallel_for(begin, end, element, 256);
+    }
+    else
+    {
+      for (std::size_t p = begin; p < end; ++p)
+      {
+        element(p);
+      }
+    }
+  }
+  // Ciklus élek: a felvízi elem mostani értéke a következő söprésre
+  std::vector<double> &lagged = m_laggedPsi[static_cast<std::size_t>(group)][ud];
+  for (std::size_t l = 0; l < s.laggedSlot.size(); ++l)
+  {
+    const std::size_t slot = static_cast<std::size_t>(s.laggedSlot[l]);
+    const std::size_t nb = static_cast<std::size_t>(m_neighbor[slot]);
+    lagged[2 * l] = psi[3 * nb + static_cast<std::size_t>(m_neighborLocal[slot * 2])];
+    lagged[2 * l + 1] = psi[3 * nb + static_cast<std::size_t>(m_neighborLocal[slot * 2 + 1])];
+  }
+}
+
+void SnTransport::sweep_group(int group, const std::vector<double> &source, std::vector<double> &phi)
+{
+  const std::size_t n = 3 * static_cast<std::size_t>(m_elementCount);
+  phi.assign(n, 0.0);
+  if (m_parallelByAngle)
+  {
+    for (std::vector<double> &partial : m_threadPhi)
+    {
+      std::fill(partial.begin(), partial.end(), 0.0);
+    }
+    parallel_chunks(0, m_weight.size(), [&](int t, std::size_t b, std::size_t e) {
+      for (std::size_t d = b; d < e; ++d)
+      {
+        sweep_direction(group, static_cast<int>(d), source, m_threadPsi[static_cast<std::size_t>(t)],
+                        m_threadPhi[static_cast<std::size_t>(t)], false);
+      }
+    }, 1);
+    for (const std::vector<double> &partial : m_threadPhi)
+    {
+      parallel_for(0, n, [&](std::size_t i) { phi[i] += partial[i]; });
+    }
+  }
+  else
+  {
+    for (std::size_t d = 0; d < m_weight.size(); ++d)
+    {
+      sweep_direction(group, static_cast<int>(d), source, m_threadPsi[0], phi, true);
+    }
+  }
+  m_boundaryOld[static_cast<std::size_t>(group)].swap(m_boundaryNew[static_cast<std::size_t>(group)]);
+}
+
+void SnTransport::solve(const SnOptions &options, SnResult &result)
+{
+  const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+  const std::size_t G = static_cast<std::size_t>(m_groupCount);
+  const std::size_t E = static_cast<std::size_t>(m_elementCount);
+  const std::size_t n = 3 * E;
+  const std::size_t N = static_cast<std::size_t>(m_system.nodeCount);
+  const XsCompiled &xs = m_library.compiled;
+  const std::vector<int> &material = m_system.elementMaterial;
+
+  SnResult fresh;
+  std::vector<std::vector<double>> &flux = fresh.flux;
+  if (result.flux.size() == G && result.flux[0].size() == n)
+  {
+    flux = result.flux;
+  }
+  else
+  {
+    flux.assign(G, std::vector<double>(n, 1.0));
+  }
+  double k = result.keff > 0.0 ? result.keff : 1.0;
+
+  // Hasadási sűrűség csúcsonként és a teljes produkció (int nuSigmaF phi)
+  auto fission_density = [&](std::vector<double> &f) {
+    f.assign(n, 0.0);
+    parallel_for(0, E, [&](std::size_t e) {
+      const std::size_t m = static_cast<std::size_t>(material[e]);
+      for (std::size_t g = 0; g < G; ++g)
+      {
+        const double nsf = xs.nu_sigma_f[m * G + g];
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+          f[3 * e + i] += nsf * flux[g][3 * e + i];
+        }
+      }
+    });
+    double production = 0.0;
+    for (std::size_t e = 0; e < E; ++e)
+    {
+      production += m_system.geometry[e].area / 3.0 * (f[3 * e] + f[3 * e + 1] + f[3 * e + 2]);
+    }
+    return production;
+  };
+
+  std::vector<double> fission;
+  double production = fission_density(fission);
+  if (production <= 0.0)
+  {
+    throw SnError("A rendszerben nincs hasadóanyag, a k-sajátérték nem értelmezhető.");
+  }
+  for (std::vector<double> &v : flux)
+  {
+    for (double &x : v)
+    {
+      x /= production;
+    }
+  }
+  for (double &x : fission)
+  {
+    x /= production;
+  }
+
+  std::vector<double> base(n), q(n), half(n), dsaRhs(N), dsaCorrection(N);
+  std::vector<double> fissionNew;
+  for (int outer = 1; outer <= options.maxOuter; ++outer)
+  {
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      // Rögzített rész: hasadás / k és a beszórás a többi csoportból (Gauss–Seidel: a legfrissebb fluxussal)
+      parallel_for(0, E, [&](std::size_t e) {
+        const std::size_t m = static_cast<std::size_t>(material[e]);
+        const double *scatter = xs.scatter_of(static_cast<int>(m));
+        const double chi = xs.chi[m * G + g] / k;
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+          double s = chi * fission[3 * e + i];
+          for (std::size_t from = 0; from < G; ++from)
+          {
+            if (from != g)
+            {
+              s += scatter[from * G + g] * flux[from][3 * e + i];
+            }
+          }
+          base[3 * e + i] = s;
+        }
+      });
+
+      // Csoporton belüli forrás iteráció, DSA gyorsítással
+      std::vector<double> &phi = flux[g];
+      for (int inner = 0; inner < options.maxInner; ++inner)
+      {
+        parallel_for(0, E, [&](std::size_t e) {
+          const double self = xs.scatter_of(material[e])[g * G + g];
+          for (std::size_t i = 0; i < 3; ++i)
+          {
+            q[3 * e + i] = base[3 * e + i] + self * phi[3 * e + i];
+          }
+        });
+        const std::chrono::steady_clock::time_point sweepStart = std::chrono::steady_clock::now();
+        sweep_group(static_cast<int>(g), q, half);
+        fresh.sweepMs += elapsed_ms(sweepStart);
+        ++fresh.sweeps;
+
+        if (m_dsaSolver)
+        {
+          // A_g delta = int w_i sigma_s,gg (phi^{l+1/2} - phi^l), a folytonos korrekció minden csúcsra
+          const std::chrono::steady_clock::time_point dsaStart = std::chrono::steady_clock::now();
+          std::fill(dsaRhs.begin(), dsaRhs.end(), 0.0);
+          for (std::size_t e = 0; e < E; ++e)
+          {
+            const double self = xs.scatter_of(material[e])[g * G + g];
+            if (self == 0.0)
+            {
+              continue;
+            }
+            double r[3];
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+              r[i] = self * (half[3 * e + i] - phi[3 * e + i]);
+            }
+            const double rSum = r[0] + r[1] + r[2];
+            const double scale = m_system.geometry[e].area / 12.0;
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+              dsaRhs[static_cast<std::size_t>(m_nodes[3 * e + i])] += scale * (r[i] + rSum);
+            }
+          }
+          std::fill(dsaCorrection.begin(), dsaCorrection.end(), 0.0);
+          const InnerStats stats = m_dsaSolver->solve(static_cast<int>(g), dsaRhs, dsaCorrection);
+          fresh.dsaIterations += stats.iterations;
+          ++fresh.dsaSolves;
+          parallel_for(0, n, [&](std::size_t i) { half[i] += dsaCorrection[static_cast<std::size_t>(m_nodes[i])]; });
+          // A tükröző peremen tárolt (késleltetett) psi is megkapja az izotrop korrekciót, különben a perem
+          // hiba korrigálatlanul visszafolyik, és a gyorsítás instabil
+          std::vector<double> &boundary = m_boundaryOld[g];
+          const std::size_t D = m_weight.size();
+          for (std::size_t b = 0; b < m_boundaryEdge.size(); ++b)
+          {
+            const std::size_t slot = static_cast<std::size_t>(m_boundaryEdge[b]);
+            const std::size_t e = slot / 3, k = slot % 3;
+            const double d1 = dsaCorrection[static_cast<std::size_t>(m_nodes[3 * e + (k + 1) % 3])];
+            const double d2 = dsaCorrection[static_cast<std::size_t>(m_nodes[3 * e + (k + 2) % 3])];
+            for (std::size_t d = 0; d < D; ++d)
+            {
+              boundary[(b * D + d) * 2] += d1;
+              boundary[(b * D + d) * 2 + 1] += d2;
+            }
+          }
+          fresh.dsaMs += elapsed_ms(dsaStart);
+        }
+
+        double change = 0.0, largest = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+          change = std::max(change, std::fabs(half[i] - phi[i]));
+          largest = std::max(largest, std::fabs(half[i]));
+        }
+        phi.swap(half);
+        if (largest > 0.0 && change / largest < options.innerTolerance)
+        {
+          break;
+        }
+      }
+    }
+
+    // Új k és normált forrás
+    production = fission_density(fissionNew);
+    const double kNew = k * production;
+    for (std::vector<double> &v : flux)
+    {
+      for (double &x : v)
+      {
+        x /= production;
+      }
+    }
+    double sourceChange = 0.0, sourceMax = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      fissionNew[i] /= production;
+      sourceChange = std::max(sourceChange, std::fabs(fissionNew[i] - fission[i]));
+      sourceMax = std::max(sourceMax, std::fabs(fissionNew[i]));
+    }
+    fission.swap(fissionNew);
+    const double kChange = std::fabs(kNew - k) / kNew;
+    k = kNew;
+    fresh.kHistory.push_back(k);
+    fresh.outerIterations = outer;
+    if (kChange < options.kTolerance && sourceMax > 0.0 && sourceChange / sourceMax < options.sourceTolerance)
+    {
+      fresh.converged = true;
+      break;
+    }
+  }
+  fresh.keff = k;
+  fresh.totalMs = elapsed_ms(totalStart);
+  result = std::move(fresh);
+}
+
+std::vector<SnRegionComparison> compare_region_flux(const Mesh &mesh, const DiffusionSystem &system,
+                                                    const SnResult &transport,
+                                                    const std::vector<std::vector<double>> &diffusionFlux)
+{
+  const std::size_t G = transport.flux.size();
+  std::map<int, SnRegionComparison> regions;
+  for (std::size_t e = 0; e < mesh.tris.size(); ++e)
+  {
+    const Mesh::Tri &t = mesh.tris[e];
+    SnRegionComparison &r = regions[t.phys];
+    if (r.transport.empty())
+    {
+      const std::map<int, std::string>::const_iterator name = mesh.physNames.find(t.phys);
+      r.name = name != mesh.physNames.end() ? name->second : std::to_string(t.phys);
+      r.transport.assign(G, 0.0);
+      r.diffusion.assign(G, 0.0);
+    }
+    const double third = system.geometry[e].area / 3.0;
+    r.area += system.geometry[e].area;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      r.transport[g] += third * (transport.flux[g][3 * e] + transport.flux[g][3 * e + 1] + transport.flux[g][3 * e + 2]);
+      r.diffusion[g] += third * (diffusionFlux[g][static_cast<std::size_t>(t.a - 1)] +
+                                 diffusionFlux[g][static_cast<std::size_t>(t.b - 1)] +
+                                 diffusionFlux[g][static_cast<std::size_t>(t.c - 1)]);
+    }
+  }
+  std::vector<SnRegionComparison> out;
+  for (std::map<int, SnRegionComparison>::iterator it = regions.begin(); it != regions.end(); ++it)
+  {
+    SnRegionComparison &r = it->second;
+    for (std::size_t g = 0; g < G; ++g)
+    {
+      r.transport[g] /= r.area;
+      r.diffusion[g] /= r.area;
+    }
+    out.push_back(r);
+  }
+  return out;
+}
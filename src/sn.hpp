@@ -0,0 +1,156 @@
+#ifndef SN_HPP
+#define SN_HPP
+
+#include "assembly.hpp"
+#include "control.hpp"
+#include "inner_solver.hpp"
+#include "mesh.hpp"
+#include "xs.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Diszkrét ordináta (SN) transzport a háromszöghálón, lineáris diszkontinuus végeselemekkel (DFEM).
+//
+// Irányonként és elemenként a 3x3 lokális feladat (upwind peremtagokkal):
+//   -int (Omega.grad w_i) psi + sum_{kifelé} (Omega.n) int_él w_i psi + sigma_t int w_i psi
+//        = int w_i q + sum_{befelé} |Omega.n| int_él w_i psi_upwind
+// Az elemek egy irányon belül csak a befelé mutató élek szomszédaitól függnek, így a söprési sorrend (topologikus
+// rendezés hullámfrontokra) irányonként egyszer, a konstruktorban épül fel, és minden söprés újrahasználja: egy
+// söprés csak aritmetika. Ciklusnál (nem konvex / torz hálón) a ciklust záró él az előző söprés értékét kapja.
+//
+// Párhuzamosítás: irányok szerint (szálanként saját psi puffer és részösszeg), vagy kevés iránynál egy irányon
+// belül hullámfrontonként (egy front elemei függetlenek).
+//
+// A csoporton belüli forrás iterációt diffúziós szintetikus gyorsítás (DSA) gyorsítja: a szórási forrás változásából
+// a diffúziós csoport mátrixszal (A_g = K(D) + M(sigma_r) + Marshak, ugyanaz a felépített operátor és belső
+// megoldó) számolt folytonos korrekció kerül a diszkontinuus fluxusra.
+//
+// Peremek: a vákuum típusú 1D elemeken nincs bejövő fluxus, minden más külső él tükröző (a diffúzió természetes
+// peremfeltételével egyezően); a tükrözött irány a kvadratúra legközelebbi iránya, a bejövő érték az előző söprésből.
+
+class SnError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct SnOptions
+{
+  // A kvadratúra és a párhuzamosítás (a konstruktor használja)
+  int polar = 2;                  // Gauss–Legendre polárszögek a felső félgömbön
+  int azimuthal = 16;             // azimutszögek 2 pi-n (néggyel osztható)
+  std::string parallel = "auto";  // auto | angles | wavefront
+
+  // Iteráció (solve használja)
+  double kTolerance = 1e-6;
+  double sourceTolerance = 1e-5;  // a normált hasadási forrás relatív változása (max norma)
+  int maxOuter = 500;
+  double innerTolerance = 1e-4;   // csoporton belüli forrás iteráció: a fluxus relatív változása (max norma)
+  int maxInner = 20;
+  bool dsa = true;
+  double dsaTolerance = 1e-4;     // a DSA diffúziós megoldások relatív reziduuma
+};
+
+SnOptions read_sn_options(const SolverConfig &config);
+
+// Gauss–Legendre pontok és súlyok [-1, 1]-en, ebből a pozitív fele (a súlyok összege 1); a MOC polár kvadratúrája is
+void gauss_legendre_half(int half, std::vector<double> &nodes, std::vector<double> &weights);
+
+struct SnResult
+{
+  double keff = 0.0;
+  bool converged = false;
+  int outerIterations = 0;
+  int sweeps = 0;                  // csoport söprések (minden irány egyszer)
+  int dsaSolves = 0;
+  long dsaIterations = 0;
+  // flux[g][3 * e + k]: az e háromszög k-adik csúcsában (diszkontinuus), egységnyi teljes produkcióra normálva
+  std::vector<std::vector<double>> flux;
+  std::vector<double> kHistory;
+  double totalMs = 0.0;
+  double sweepMs = 0.0;
+  double dsaMs = 0.0;
+};
+
+class SnTransport
+{
+public:
+  // A szomszédsági adatok, a kvadratúra, a perem leképezések és irányonként a söprési ütemterv itt épül fel
+  SnTransport(const Mesh &mesh, const XsLibrary &library, const DiffusionSystem &system, const SolverConfig &config,
+              const SnOptions &options);
+
+  // k-sajátérték hatványiterációval. Ha result.flux megfelelő méretű, kezdőértékként használja.
+  void solve(const SnOptions &options, SnResult &result);
+
+  int direction_count() const { return static_cast<int>(m_weight.size()); }
+  std::string parallel_mode() const { return m_parallelByAngle ? "angles" : "wavefront"; }
+  double setup_ms() const { return m_setupMs; }
+  double average_levels() const;   // hullámfrontok átlagos száma irányonként
+  int max_level_width() const;     // a legszélesebb hullámfront
+  long lagged_edges() const;       // ciklus miatt késleltetett élek (összes irányra)
+  int reflective_edges() const { return m_reflectiveEdges; }
+  int vacuum_edges() const { return m_vacuumEdges; }
+
+private:
+  struct Schedule
+  {
+    std::vector<int> levelPtr;          // hullámfrontonként az első elem pozíciója az order-ben
+    std::vector<int> order;             // elemek hullámfrontok szerint
+    std::vector<unsigned char> lagged;  // elemenként bitmaszk: a késleltetett bejövő élek
+    std::vector<int> laggedSlot;        // késleltetett élenként (elem * 3 + él) a tároló pozíciója, rendezve
+  };
+
+  void sweep_group(int group, const std::vector<double> &source, std::vector<double> &phi);
+  void sweep_direction(int group, int d, const std::vector<double> &source, std::vector<double> &psi,
+                       std::vector<double> &phi, bool parallelElements);
+  void solve_element(int group, int d, int e, const std::vector<double> &source, std::vector<double> &psi) const;
+
+  const Mesh &m_mesh;
+  const XsLibrary &m_library;
+  const DiffusionSystem &m_system;
+  GroupSolver::UPtr m_dsaSolver;
+  int m_groupCount = 0;
+  int m_elementCount = 0;
+
+  // Kvadratúra: irányonként a síkbeli vetület és a súly (összeg 1)
+  std::vector<double> m_mu, m_eta, m_weight;
+
+  // Elemenként: csomópont indexek (0-bázisú), élenként (a k-adik csúcs szemközti éle) a kifelé mutató normális
+  // szorozva az él hosszával, a szomszéd elem és a közös csúcsok helyi indexei a szomszédban
+  std::vector<int> m_nodes;            // [3 * e + k]
+  std::vector<double> m_normal;        // [(3 * e + k) * 2 + {x, y}]
+  std::vector<int> m_neighbor;         // [3 * e + k], -1 = vákuum perem, -2 = tükröző perem
+  std::vector<int> m_neighborLocal;    // [(3 * e + k) * 2 + {0, 1}]: az él két csúcsa a szomszédban
+  std::vector<int> m_boundarySlot;     // [3 * e + k]: tükröző perem élek sorszáma, különben -1
+  std::vector<int> m_reflected;        // [b * D + d]: a tükrözött irány
+  std::vector<int> m_boundaryEdge;     // tükröző perem élenként: 3 * e + k
+  int m_reflectiveEdges = 0;
+  int m_vacuumEdges = 0;
+
+  std::vector<Schedule> m_schedules;   // irányonként
+  bool m_parallelByAngle = true;
+
+  // Késleltetett értékek az előző söprésből: [g][d][slot * 2 + {0, 1}] a ciklus éleken,
+  // [g][(b * D + d) * 2 + {0, 1}] a tükröző peremeken kimenő psi (régi / új puffer)
+  std::vector<std::vector<std::vector<double>>> m_laggedPsi;
+  std::vector<std::vector<double>> m_boundaryOld, m_boundaryNew;
+
+  std::vector<std::vector<double>> m_threadPsi, m_threadPhi; // szálankénti pufferek (irány szerinti párhuzamosítás)
+  double m_setupMs = 0.0;
+};
+
+// Fizikai csoportonkénti átlagfluxus összevetés (mindkettő egységnyi teljes produkcióra normálva)
+struct SnRegionComparison
+{
+  std::string name;
+  double area = 0.0;
+  std::vector<double> transport; // csoportonként
+  std::vector<double> diffusion;
+};
+
+std::vector<SnRegionComparison> compare_region_flux(const Mesh &mesh, const DiffusionSystem &system,
+                                                    const SnResult &transport,
+                                                    const std::vector<std::vector<double>> &diffusionFlux);
+
+#endif // SN_HPP
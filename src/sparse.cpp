@@ -0,0 +1,259 @@
+#include "sparse.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+
+int CsrPattern::find(int row, int col) const
+{
+  const std::vector<int>::const_iterator first = colIdx.begin() + rowPtr[static_cast<std::size_t>(row)];
+  const std::vector<int>::const_iterator last = colIdx.begin() + rowPtr[static_cast<std::size_t>(row) + 1];
+  const std::vector<int>::const_iterator it = std::lower_bound(first, last, col);
+  if (it == last || *it != col)
+  {
+    return -1;
+  }
+  return static_cast<int>(it - colIdx.begin());
+}
+
+std::vector<int> CsrPattern::diagonal_positions() const
+{
+  std::vector<int> diag(static_cast<std::size_t>(rows), -1);
+  for (int i = 0; i < rows; ++i)
+  {
+    diag[static_cast<std::size_t>(i)] = find(i, i);
+  }
+  return diag;
+}
+
+std::size_t CsrPattern::memory_bytes() const
+{
+  return rowPtr.size() * sizeof(int) + colIdx.size() * sizeof(int);
+}
+
+void CsrMatrix::multiply(const std::vector<double> &x, std::vector<double> &y) const
+{
+  y.resize(static_cast<std::size_t>(rows()));
+  const int *rp = pattern->rowPtr.data();
+  const int *ci = pattern->colIdx.data();
+  const double *v = values.data();
+  const double *xv = x.data();
+  double *yv = y.data();
+  parallel_chunks(0, static_cast<std::size_t>(rows()), [&](int, std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i)
+    {
+      double sum = 0.0;
+      for (int k = rp[i]; k < rp[i + 1]; ++k)
+      {
+        sum += v[k] * xv[ci[k]];
+      }
+      yv[i] = sum;
+    }
+  });
+}
+
+void CsrMatrix::multiply_add(double alpha, const std::vector<double> &x, std::vector<double> &y) const
+{
+  const int *rp = pattern->rowPtr.data();
+  const int *ci = pattern->colIdx.data();
+  const double *v = values.data();
+  const double *xv = x.data();
+  double *yv = y.data();
+  parallel_chunks(0, static_cast<std::size_t>(rows()), [&](int, std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i)
+    {
+      double sum = 0.0;
+      for (int k = rp[i]; k < rp[i + 1]; ++k)
+      {
+        sum += v[k] * xv[ci[k]];
+      }
+      yv[i] += alpha * sum;
+    }
+  });
+}
+
+namespace
+{
+// Blokkolt SpMV W vektorra: fordítási idejű W-vel a részösszegek regiszterben maradnak
+template <int W>
+void csr_multiply_lanes(const CsrMatrix &A, const double *const *xv, double *const *yv)
+{
+  const int *rp = A.pattern->rowPtr.data();
+  const int *ci = A.pattern->colIdx.data();
+  const double *v = A.values.data();
+  parallel_chunks(0, static_cast<std::size_t>(A.rows()), [&](int, std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i)
+    {
+      double sum[W] = {};
+      for (int k = rp[i]; k < rp[i + 1]; ++k)
+      {
+        const double a = v[k];
+        const int j = ci[k];
+        for (int c = 0; c < W; ++c)
+        {
+          sum[c] += a * xv[c][j];
+        }
+      }
+      for (int c = 0; c < W; ++c)
+      {
+        yv[c][i] = sum[c];
+      }
+    }
+  });
+}
+} // namespace
+
+void CsrMatrix::multiply_block(const std::vector<std::vector<double>> &x, std::vector<std::vector<double>> &y,
+                               const std::vector<int> &columns) const
+{
+  // Legfeljebb Lanes vektor egy menetben
+  const int Lanes = 4;
+  for (std::size_t first = 0; first < columns.size(); first += Lanes)
+  {
+    const int width = static_cast<int>(std::min<std::size_t>(Lanes, columns.size() - first));
+    const double *xv[Lanes];
+    double *yv[Lanes];
+    for (int c = 0; c < width; ++c)
+    {
+      const std::size_t col = static_cast<std::size_t>(columns[first + static_cast<std::size_t>(c)]);
+      y[col].resize(static_cast<std::size_t>(rows()));
+      xv[c] = x[col].data();
+      yv[c] = y[col].data();
+    }
+    switch (width)
+    {
+    case 1:
+      csr_multiply_lanes<1>(*this, xv, yv);
+      break;
+    case 2:
+      csr_multiply_lanes<2>(*this, xv, yv);
+      break;
+    case 3:
+      csr_multiply_lanes<3>(*this, xv, yv);
+      break;
+    default:
+      csr_multiply_lanes<4>(*this, xv, yv);
+      break;
+    }
+  }
+}
+
+std::size_t CsrMatrix::memory_bytes() const
+{
+  return values.size() * sizeof(double);
+}
+
+CsrPattern::CPtr build_csr_pattern(std::vector<std::vector<int>> &rowColumns, int cols)
+{
+  std::shared_ptr<CsrPattern> pattern = std::make_shared<CsrPattern>();
+  pattern->rows = static_cast<int>(rowColumns.size());
+  pattern->cols = cols < 0 ? pattern->rows : cols;
+  pattern->rowPtr.assign(rowColumns.size() + 1, 0);
+  for (std::size_t i = 0; i < rowColumns.size(); ++i)
+  {
+    std::vector<int> &cols = rowColumns[i];
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    pattern->rowPtr[i + 1] = pattern->rowPtr[i] + static_cast<int>(cols.size());
+  }
+  pattern->colIdx.reserve(static_cast<std::size_t>(pattern->rowPtr.back()));
+  for (std::size_t i = 0; i < rowColumns.size(); ++i)
+  {
+    pattern->colIdx.insert(pattern->colIdx.end(), rowColumns[i].begin(), rowColumns[i].end());
+  }
+  return pattern;
+}
+
+CsrMatrix csr_transpose(const CsrMatrix &A)
+{
+  const CsrPattern &P = *A.pattern;
+  std::shared_ptr<CsrPattern> pattern = std::make_shared<CsrPattern>();
+  pattern->rows = P.cols;
+  pattern->cols = P.rows;
+  pattern->rowPtr.assign(static_cast<std::size_t>(P.cols) + 1, 0);
+  for (std::size_t k = 0; k < P.colIdx.size(); ++k)
+  {
+    ++pattern->rowPtr[static_cast<std::size_t>(P.colIdx[k]) + 1];
+  }
+  for (int i = 0; i < P.cols; ++i)
+  {
+    pattern->rowPtr[static_cast<std::size_t>(i) + 1] += pattern->rowPtr[static_cast<std::size_t>(i)];
+  }
+  pattern->colIdx.assign(P.colIdx.size(), 0);
+  CsrMatrix T;
+  T.values.assign(P.colIdx.size(), 0.0);
+  std::vector<int> cursor(pattern->rowPtr.begin(), pattern->rowPtr.end() - 1);
+  // Soronként haladva az új sorokban növekvő oszlopindexek keletkeznek
+  for (int i = 0; i < P.rows; ++i)
+  {
+    for (int k = P.rowPtr[static_cast<std::size_t>(i)]; k < P.rowPtr[static_cast<std::size_t>(i) + 1]; ++k)
+    {
+      const std::size_t dst = static_cast<std::size_t>(cursor[static_cast<std::size_t>(P.colIdx[static_cast<std::size_t>(k)])]++);
+      pattern->colIdx[dst] = i;
+      T.values[dst] = A.values[static_cast<std::size_t>(k)];
+    }
+  }
+  T.pattern = pattern;
+  return T;
+}
+
+CsrMatrix csr_multiply(const CsrMatrix &A, const CsrMatrix &B)
+{
+  const CsrPattern &PA = *A.pattern;
+  const CsrPattern &PB = *B.pattern;
+  const std::size_t rows = static_cast<std::size_t>(PA.rows);
+
+  // Gustavson algoritmus, soronként párhuzamosan: először a sorok, aztán összefűzés
+  std::vector<std::vector<int>> rowCols(rows);
+  std::vector<std::vector<double>> rowVals(rows);
+  const int threads = thread_count();
+  std::vector<std::vector<double>> accumulators(static_cast<std::size_t>(threads), std::vector<double>(static_cast<std::size_t>(PB.cols), 0.0));
+  std::vector<std::vector<int>> markers(static_cast<std::size_t>(threads), std::vector<int>(static_cast<std::size_t>(PB.cols), -1));
+  parallel_chunks(0, rows, [&](int t, std::size_t b, std::size_t e) {
+    std::vector<double> &acc = accumulators[static_cast<std::size_t>(t)];
+    std::vector<int> &mark = markers[static_cast<std::size_t>(t)];
+    for (std::size_t i = b; i < e; ++i)
+    {
+      std::vector<int> &cols = rowCols[i];
+      for (int ka = PA.rowPtr[i]; ka < PA.rowPtr[i + 1]; ++ka)
+      {
+        const std::size_t k = static_cast<std::size_t>(PA.colIdx[static_cast<std::size_t>(ka)]);
+        const double a = A.values[static_cast<std::size_t>(ka)];
+        for (int kb = PB.rowPtr[k]; kb < PB.rowPtr[k + 1]; ++kb)
+        {
+          const int j = PB.colIdx[static_cast<std::size_t>(kb)];
+          if (mark[static_cast<std::size_t>(j)] != static_cast<int>(i))
+          {
+            mark[static_cast<std::size_t>(j)] = static_cast<int>(i);
+            acc[static_cast<std::size_t>(j)] = 0.0;
+            cols.push_back(j);
+          }
+          acc[static_cast<std::size_t>(j)] += a * B.values[static_cast<std::size_t>(kb)];
+        }
+      }
+      std::sort(cols.begin(), cols.end());
+      rowVals[i].resize(cols.size());
+      for (std::size_t c = 0; c < cols.size(); ++c)
+      {
+        rowVals[i][c] = acc[static_cast<std::size_t>(cols[c])];
+      }
+    }
+  });
+
+  std::shared_ptr<CsrPattern> pattern = std::make_shared<CsrPattern>();
+  pattern->rows = PA.rows;
+  pattern->cols = PB.cols;
+  pattern->rowPtr.assign(rows + 1, 0);
+  for (std::size_t i = 0; i < rows; ++i)
+  {
+    pattern->rowPtr[i + 1] = pattern->rowPtr[i] + static_cast<int>(rowCols[i].size());
+  }
+  CsrMatrix C;
+  pattern->colIdx.reserve(static_cast<std::size_t>(pattern->rowPtr.back()));
+  C.values.reserve(static_cast<std::size_t>(pattern->rowPtr.back()));
+  for (std::size_t i = 0; i < rows; ++i)
+  {
+    pattern->colIdx.insert(pattern->colIdx.end(), rowCols[i].begin(), rowCols[i].end());
+    C.values.insert(C.values.end(), rowVals[i].begin(), rowVals[i].end());
+  }
+  C.pattern = pattern;
+  return C;
+}
@@ -0,0 +1,158 @@
+#ifndef SPARSE_HPP
+#define SPARSE_HPP
+
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// CSR ritka mátrix szerkezet (sorpointerek + oszlopindexek).
+// A P1 végeselem mátrixok mind ugyanazon a hálón élnek, ezért ugyanaz a mintázat
+// közös lehet: minden CsrMatrix csak shared_ptr-rel hivatkozik rá, és saját értéktömbje van.
+struct CsrPattern
+{
+  typedef std::shared_ptr<const CsrPattern> CPtr;
+
+  int rows = 0;
+  int cols = 0;            // oszlopok száma (négyzetes mátrixnál = rows)
+  std::vector<int> rowPtr; // rows + 1 elem
+  std::vector<int> colIdx; // soronként növekvő oszlopindexek
+
+  std::size_t nnz() const { return colIdx.size(); }
+  // (row, col) pozíciója a colIdx/values tömbben, -1 ha nincs benne a mintázatban
+  int find(int row, int col) const;
+  // Pozíció a diagonális elemekhez (sorontként), -1 ha hiányzik
+  std::vector<int> diagonal_positions() const;
+  std::size_t memory_bytes() const;
+};
+
+struct CsrMatrix
+{
+  CsrPattern::CPtr pattern;
+  std::vector<double> values;
+
+  int rows() const { return pattern ? pattern->rows : 0; }
+  // y = A * x (szálpárhuzamos, soronként)
+  void multiply(const std::vector<double> &x, std::vector<double> &y) const;
+  // y += alpha * A * x
+  void multiply_add(double alpha, const std::vector<double> &x, std::vector<double> &y) const;
+  // y[c] = A * x[c] a megadott vektorokra egyszerre: minden mátrix elem egyszer olvasódik be
+  // az összes vektorhoz (blokkolt SpMV, több jobb oldal közös memóriaforgalommal)
+  void multiply_block(const std::vector<std::vector<double>> &x, std::vector<std::vector<double>> &y,
+                      const std::vector<int> &columns) const;
+  std::size_t memory_bytes() const;
+};
+
+// SELL-C (sliced ELLPACK) tárolás a SIMD SpMV-hez: C egymás utáni sor egy szeletet alkot,
+// a szeleten belül oszlopfolytonosan tárolunk (a legrövidebb sorokat nullákkal kitöltve).
+// Így a belső ciklus C független sorra fut azonos lépésközzel, amit a fordító vektorizál.
+// A Real a tárolt értékek típusa (double vagy float); az összegzés mindig double-ben történik.
+template <typename Real>
+struct SellMatrix
+{
+  static const int C = 8;
+
+  int rows = 0;
+  std::vector<int> slicePtr;   // szeletenként az első elem pozíciója (sliceCount + 1)
+  std::vector<int> sliceWidth; // szeletenként a leghosszabb sor hossza
+  std::vector<int> colIdx;
+  std::vector<Real> values;
+
+  std::size_t memory_bytes() const
+  {
+    return (slicePtr.size() + sliceWidth.size() + colIdx.size()) * sizeof(int) + values.size() * sizeof(Real);
+  }
+};
+
+template <typename Real>
+SellMatrix<Real> build_sell(const CsrMatrix &A)
+{
+  const int C = SellMatrix<Real>::C;
+  const CsrPattern &P = *A.pattern;
+  SellMatrix<Real> S;
+  S.rows = P.rows;
+  const int sliceCount = (P.rows + C - 1) / C;
+  S.slicePtr.assign(static_cast<std::size_t>(sliceCount) + 1, 0);
+  S.sliceWidth.assign(static_cast<std::size_t>(sliceCount), 0);
+  for (int s = 0; s < sliceCount; ++s)
+  {
+    int width = 0;
+    for (int r = s * C; r < std::min(P.rows, (s + 1) * C); ++r)
+    {
+      width = std::max(width, P.rowPtr[static_cast<std::size_t>(r) + 1] - P.rowPtr[static_cast<std::size_t>(r)]);
+    }
+    S.sliceWidth[static_cast<std::size_t>(s)] = width;
+    S.slicePtr[static_cast<std::size_t>(s) + 1] = S.slicePtr[static_cast<std::size_t>(s)] + width * C;
+  }
+  S.colIdx.assign(static_cast<std::size_t>(S.slicePtr.back()), 0);
+  S.values.assign(static_cast<std::size_t>(S.slicePtr.back()), Real(0));
+  for (int s = 0; s < sliceCount; ++s)
+  {
+    for (int lane = 0; lane < C; ++lane)
+    {
+      const int r = s * C + lane;
+      // Kitöltés: a saját sorra (vagy 0-ra) mutató nulla érték, így az x olvasás mindig érvényes
+      const int padCol = r < P.rows ? r : 0;
+      const int len = r < P.rows ? P.rowPtr[static_cast<std::size_t>(r) + 1] - P.rowPtr[static_cast<std::size_t>(r)] : 0;
+      for (int j = 0; j < S.sliceWidth[static_cast<std::size_t>(s)]; ++j)
+      {
+        const std::size_t dst = static_cast<std::size_t>(S.slicePtr[static_cast<std::size_t>(s)] + j * C + lane);
+        if (j < len)
+        {
+          const std::size_t src = static_cast<std::size_t>(P.rowPtr[static_cast<std::size_t>(r)] + j);
+          S.colIdx[dst] = P.colIdx[src];
+          S.values[dst] = static_cast<Real>(A.values[src]);
+        }
+        else
+        {
+          S.colIdx[dst] = padCol;
+        }
+      }
+    }
+  }
+  return S;
+}
+
+// y = S * x, szeletenként szálpárhuzamosan, a szeleten belül SIMD
+template <typename Real>
+void sell_multiply(const SellMatrix<Real> &S, const std::vector<double> &x, std::vector<double> &y)
+{
+  const int C = SellMatrix<Real>::C;
+  y.resize(static_cast<std::size_t>(S.rows));
+  const std::size_t sliceCount = S.sliceWidth.size();
+  const double *xv = x.data();
+  double *yv = y.data();
+  parallel_chunks(0, sliceCount, [&](int, std::size_t b, std::size_t e) {
+    for (std::size_t s = b; s < e; ++s)
+    {
+      double acc[C] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+      const Real *val = S.values.data() + S.slicePtr[s];
+      const int *col = S.colIdx.data() + S.slicePtr[s];
+      const int width = S.sliceWidth[s];
+      for (int j = 0; j < width; ++j)
+      {
+        for (int lane = 0; lane < C; ++lane)
+        {
+          acc[lane] += static_cast<double>(val[j * C + lane]) * xv[col[j * C + lane]];
+        }
+      }
+      const int rowBegin = static_cast<int>(s) * C;
+      const int lanes = std::min(C, S.rows - rowBegin);
+      for (int lane = 0; lane < lanes; ++lane)
+      {
+        yv[rowBegin + lane] = acc[lane];
+      }
+    }
+  });
+}
+
+// Új mintázat létrehozása soronkénti szomszédsági listákból (rendezi, duplikátumokat kiszűri).
+// cols < 0 esetén négyzetes mátrixot feltételez.
+CsrPattern::CPtr build_csr_pattern(std::vector<std::vector<int>> &rowColumns, int cols = -1);
+
+// Általános CSR műveletek (AMG hierarchia, Galerkin szorzat)
+CsrMatrix csr_transpose(const CsrMatrix &A);
+CsrMatrix csr_multiply(const CsrMatrix &A, const CsrMatrix &B);
+
+#endif // SPARSE_HPP
@@ -0,0 +1,168 @@
+#include "startup.hpp"
+#include "assembly.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+  double elapsed_ms(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+}
+
+int StageGraph::add(const std::string &name, std::function<void()> run, const std::vector<int> &dependencies)
+{
+  Stage stage;
+  stage.name = name;
+  stage.run = std::move(run);
+  stage.dependencies = dependencies;
+  for (int d : dependencies)
+  {
+    if (d < 0 || d >= static_cast<int>(m_stages.size()))
+    {
+      throw std::logic_error("Érvénytelen fázis függőség: " + name);
+    }
+  }
+  m_stages.push_back(std::move(stage));
+  return static_cast<int>(m_stages.size()) - 1;
+}
+
+void StageGraph::run()
+{
+  const std::size_t n = m_stages.size();
+  std::vector<std::vector<int>> dependents(n);
+  std::vector<int> waiting(n, 0);
+  std::deque<int> ready;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    waiting[i] = static_cast<int>(m_stages[i].dependencies.size());
+    for (int d : m_stages[i].dependencies)
+    {
+      dependents[static_cast<std::size_t>(d)].push_back(static_cast<int>(i));
+    }
+    if (waiting[i] == 0)
+    {
+      ready.push_back(static_cast<int>(i));
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::size_t finished = 0;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  // Egy fázis lezárása (a zár alatt): a függők várakozása csökken; hibánál a függők láncban kimaradnak
+  std::function<void(int, bool)> complete = [&](int index, bool ok) {
+    ++finished;
+    for (int next : dependents[static_cast<std::size_t>(index)])
+    {
+      Stage &stage = m_stages[static_cast<std::size_t>(next)];
+      if (stage.skipped)
+      {
+        continue;
+      }
+      if (!ok)
+      {
+        stage.skipped = true;
+        complete(next, false);
+      }
+      else if (--waiting[static_cast<std::size_t>(next)] == 0)
+      {
+        ready.push_back(next);
+      }
+    }
+  };
+
+  const std::function<void(int)> job = [&](int thread) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      changed.wait(lock, [&]() { return finished == n || !ready.empty(); });
+      if (ready.empty())
+      {
+        return;
+      }
+      const int index = ready.front();
+      ready.pop_front();
+      Stage &stage = m_stages[static_cast<std::size_t>(index)];
+      lock.unlock();
+
+      stage.thread = thread;
+      stage.startMs = elapsed_ms(start);
+      try
+      {
+        stage.run();
+      }
+      catch (...)
+      {
+        stage.error = std::current_exception();
+      }
+      stage.ms = elapsed_ms(start) - stage.startMs;
+
+      lock.lock();
+      stage.done = true;
+      complete(index, !stage.error);
+      changed.notify_all();
+    }
+  };
+  ThreadPool::instance().run(job);
+  m_wallMs = elapsed_ms(start);
+}
+
+double StageGraph::critical_path_ms() const
+{
+  // A fázisok a hozzáadás sorrendjében topologikusan rendezettek (függőség csak korábbira mutathat)
+  std::vector<double> finish(m_stages.size(), 0.0);
+  double longest = 0.0;
+  for (std::size_t i = 0; i < m_stages.size(); ++i)
+  {
+    double begin = 0.0;
+    for (int d : m_stages[i].dependencies)
+    {
+      begin = std::max(begin, finish[static_cast<std::size_t>(d)]);
+    }
+    finish[i] = begin + m_stages[i].ms;
+    longest = std::max(longest, finish[i]);
+  }
+  return longest;
+}
+
+double StageGraph::serial_ms() const
+{
+  double total = 0.0;
+  for (const Stage &stage : m_stages)
+  {
+    total += stage.ms;
+  }
+  return total;
+}
+
+void InputLoading::rethrow(int stage) const
+{
+  if (stage >= 0 && graph.stage(stage).error)
+  {
+    std::rethrow_exception(graph.stage(stage).error);
+  }
+}
+
+void load_inputs(const std::string &meshPath, const std::string &xsPath, const std::string &modelPath, Mesh &mesh,
+                 XsLibrary &library, ModelLibrary &model, InputLoading &loading)
+{
+  StageGraph &graph = loading.graph;
+  loading.meshStage = graph.add("háló beolvasás", [&]() { load_msh2(meshPath, mesh); });
+  loading.xsStage = graph.add("XS beolvasás", [&]() { load_xs(xsPath, library, false); });
+  loading.modelStage = graph.add("model beolvasás", [&]() { loadModel(modelPath, model); });
+  loading.compileStage = graph.add("XS fordítás", [&]() { compile_xs(library); }, std::vector<int>{loading.xsStage});
+  // Keresztellenőrzés: minden háromszög fizikai csoportjához van-e XS anyag (az assembly ezt használja)
+  loading.validateStage = graph.add(
+      "keresztellenőrzés", [&]() { loading.elementMaterial = resolve_element_materials(mesh, library); },
+      std::vector<int>{loading.meshStage, loading.xsStage});
+  graph.run();
+}
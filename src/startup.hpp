@@ -0,0 +1,72 @@
+#ifndef STARTUP_HPP
+#define STARTUP_HPP
+
+#include "mesh.hpp"
+#include "model.hpp"
+#include "xs.hpp"
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Indítási fázisok függőségi gráfként: a háló, az XS könyvtár és a model beolvasása egymástól független, ezért a
+// szálkészleten egyszerre futnak; az XS fordítása csak a beolvasott könyvtárra vár, a háló–XS keresztellenőrzés
+// (elemenkénti anyagindexek) a hálóra és az XS-re. A falióra idő így nagyjából a leghosszabb beolvasás, nem az összeg.
+//
+// Egy fázis kivétele a fázisnál marad (a hívó a megszokott sorrendben, a megszokott hibaüzenettel dobhatja tovább);
+// a hibás fázisra (közvetve) épülő fázisok nem futnak le.
+
+class StageGraph
+{
+public:
+  struct Stage
+  {
+    std::string name;
+    std::function<void()> run;
+    std::vector<int> dependencies;
+    double startMs = 0.0;         // a gráf indításához képest
+    double ms = 0.0;
+    int thread = -1;              // a futtató szál a készletben
+    bool done = false;
+    bool skipped = false;         // egy függősége hibával állt le
+    std::exception_ptr error;
+  };
+
+  // Új fázis; a függőségek a korábban hozzáadott fázisok indexei
+  int add(const std::string &name, std::function<void()> run, const std::vector<int> &dependencies = std::vector<int>());
+
+  // Minden fázis lefuttatása a szálkészleten (ready listából, a függőségek teljesülése szerint)
+  void run();
+
+  const std::vector<Stage> &stages() const { return m_stages; }
+  const Stage &stage(int index) const { return m_stages[static_cast<std::size_t>(index)]; }
+  double wall_ms() const { return m_wallMs; }
+  // A leghosszabb függőségi lánc ideje (ennél gyorsabb nem lehet a gráf)
+  double critical_path_ms() const;
+  // A fázisok idejének összege (soros futás becsült ideje)
+  double serial_ms() const;
+
+private:
+  std::vector<Stage> m_stages;
+  double m_wallMs = 0.0;
+};
+
+// A bemenetek beolvasása a fázisgráffal. A hibák a fázisokban maradnak: a hívó rethrow()-val dobhatja tovább.
+struct InputLoading
+{
+  StageGraph graph;
+  int meshStage = -1;
+  int xsStage = -1;
+  int modelStage = -1;
+  int compileStage = -1;
+  int validateStage = -1;
+  std::vector<int> elementMaterial; // a keresztellenőrzés eredménye (háromszögenként az XS anyagindex)
+
+  // A fázis kivételének továbbdobása (ha volt); kihagyott fázisnál semmi
+  void rethrow(int stage) const;
+};
+
+void load_inputs(const std::string &meshPath, const std::string &xsPath, const std::string &modelPath, Mesh &mesh,
+                 XsLibrary &library, ModelLibrary &model, InputLoading &loading);
+
+#endif // STARTUP_HPP
@@ -0,0 +1,73 @@
+#ifndef VECTOR_OPS_HPP
+#define VECTOR_OPS_HPP
+
+#include "parallel.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Párhuzamos vektorműveletek a megoldókhoz.
+// A skaláris szorzat szálanként részösszegekből áll össze, rögzített sorrendben,
+// így adott szálszám mellett az eredmény bitre reprodukálható.
+
+inline double dot(const std::vector<double> &a, const std::vector<double> &b)
+{
+  std::vector<double> partial(static_cast<std::size_t>(thread_count()), 0.0);
+  parallel_chunks(0, a.size(), [&](int t, std::size_t begin, std::size_t end) {
+    double sum = 0.0;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    partial[static_cast<std::size_t>(t)] = sum;
+  });
+  double total = 0.0;
+  for (double p : partial)
+  {
+    total += p;
+  }
+  return total;
+}
+
+inline double norm2(const std::vector<double> &a)
+{
+  return std::sqrt(dot(a, a));
+}
+
+inline double sum(const std::vector<double> &a)
+{
+  std::vector<double> partial(static_cast<std::size_t>(thread_count()), 0.0);
+  parallel_chunks(0, a.size(), [&](int t, std::size_t begin, std::size_t end) {
+    double s = 0.0;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      s += a[i];
+    }
+    partial[static_cast<std::size_t>(t)] = s;
+  });
+  double total = 0.0;
+  for (double p : partial)
+  {
+    total += p;
+  }
+  return total;
+}
+
+// y += alpha * x
+inline void axpy(double alpha, const std::vector<double> &x, std::vector<double> &y)
+{
+  parallel_for(0, x.size(), [&](std::size_t i) { y[i] += alpha * x[i]; });
+}
+
+// y = x + beta * y
+inline void xpay(const std::vector<double> &x, double beta, std::vector<double> &y)
+{
+  parallel_for(0, x.size(), [&](std::size_t i) { y[i] = x[i] + beta * y[i]; });
+}
+
+inline void scale(double alpha, std::vector<double> &x)
+{
+  parallel_for(0, x.size(), [&](std::size_t i) { x[i] *= alpha; });
+}
+
+#endif // VECTOR_OPS_HPP
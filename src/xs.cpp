@@ -1,4 +1,6 @@
 #include "xs.hpp"
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -119,6 +121,44 @@ const XsMaterial::SPtr XsLibrary::find_material(const std::string &name) const
   return nullptr;
 }
 
+int XsLibrary::material_index(const std::string &name) const
+{
+  for (std::size_t i = 0; i < materials.size(); ++i)
+  {
+    if (materials[i].name == name)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+const XsFeedback *XsLibrary::find_feedback(const std::string &material) const
+{
+  for (std::size_t i = 0; i < feedback.size(); ++i)
+  {
+    if (feedback[i].material == material)
+    {
+      return &feedback[i];
+    }
+  }
+  return nullptr;
+}
+
+void apply_temperature(XsMaterial &material, const XsFeedback &feedback, double temperature)
+{
+  const double delta = std::sqrt(std::max(temperature, 0.0)) - std::sqrt(feedback.referenceTemperature);
+  for (std::size_t g = 0; g < feedback.sigma_a.size() && g < material.sigma_a.size(); ++g)
+  {
+    material.sigma_a[g] += feedback.sigma_a[g] * delta;
+    material.sigma_t[g] += feedback.sigma_a[g] * delta;
+  }
+  for (std::size_t g = 0; g < feedback.nu_sigma_f.size() && g < material.nu_sigma_f.size(); ++g)
+  {
+    material.nu_sigma_f[g] += feedback.nu_sigma_f[g] * delta;
+  }
+}
+
 const XsBoundary *XsLibrary::find_boundary(const std::string &name) const
 {
   for (std::size_t i = 0; i < boundaries.size(); ++i)
@@ -131,7 +171,7 @@ const XsBoundary *XsLibrary::find_boundary(const std::string &name) const
   return nullptr;
 }
 
-void load_xs(const std::string &path, XsLibrary &library)
+void load_xs(const std::string &path, XsLibrary &library, bool compile)
 {
   std::ifstream input(path);
   if (!input)
@@ -447,6 +487,314 @@ void load_xs(const std::string &path, XsLibrary &library)
       }
       continue;
     }
+
+    // --- 5) Kinetics (késő neutron családok, neutron sebességek) ---
+    if (cleaned == "$Kinetics")
+    {
+      if (fresh.energyGroupCount <= 0)
+      {
+        throw_at_line(lineNo, "A $Kinetics blokk előtt meg kell adni az $EnergyGroups blokkot.");
+      }
+      const std::size_t familyCount = read_count(input, lineNo, "$Kinetics");
+      if (familyCount == 0)
+      {
+        throw_at_line(lineNo, "A $Kinetics blokkban legalább egy késő neutron család kell.");
+      }
+      XsKinetics kinetics;
+      // Három kötelező sor tetszőleges sorrendben: beta, lambda (családonként), velocity (csoportonként)
+      for (int read = 0; read < 3; ++read)
+      {
+        std::string dataLine;
+        while (dataLine.empty())
+        {
+          if (!std::getline(input, line))
+          {
+            throw_at_line(lineNo + 1, "$Kinetics blokk vége előtt elfogyott a fájl.");
+          }
+          ++lineNo;
+          dataLine = strip_comment(line);
+          trim_inplace(dataLine);
+        }
+        std::string key, value;
+        if (!parse_key_value(dataLine, key, value))
+        {
+          throw_at_line(lineNo, "Várt 'beta', 'lambda' vagy 'velocity' sort a $Kinetics blokkban.");
+        }
+        std::vector<double> *target = nullptr;
+        int expected = static_cast<int>(familyCount);
+        if (key == "beta")
+        {
+          target = &kinetics.beta;
+        }
+        else if (key == "lambda")
+        {
+          target = &kinetics.lambda;
+        }
+        else if (key == "velocity")
+        {
+          target = &kinetics.velocity;
+          expected = fresh.energyGroupCount;
+        }
+        else
+        {
+          throw_at_line(lineNo, "Ismeretlen kulcs a $Kinetics blokkban: " + key);
+        }
+        if (!target->empty())
+        {
+          throw_at_line(lineNo, "A(z) " + key + " sor már szerepelt a $Kinetics blokkban.");
+        }
+        *target = parse_vector(value, lineNo, expected);
+        for (double x : *target)
+        {
+          if (key == "beta" ? (x < 0.0) : (x <= 0.0))
+          {
+            throw_at_line(lineNo, "Nem fizikai érték a(z) " + key + " sorban.");
+          }
+        }
+      }
+      if (kinetics.beta_total() >= 1.0)
+      {
+        throw_at_line(lineNo, "A késő neutron hányadok összege legalább 1.");
+      }
+
+      // Blokk lezárása kötelező: $EndKinetics
+      if (!std::getline(input, line))
+      {
+        throw_at_line(lineNo + 1, "Hiányzik a $EndKinetics sor.");
+      }
+      ++lineNo;
+      std::string endLine = strip_comment(line);
+      trim_inplace(endLine);
+      if (endLine != "$EndKinetics")
+      {
+        throw_at_line(lineNo, "A $Kinetics blokkot $EndKinetics sorral kell zárni.");
+      }
+      fresh.kinetics = kinetics;
+      continue;
+    }
+
+    // --- 6) Depletion (nuklidok, kiégési lánc) ---
+    if (cleaned == "$Depletion")
+    {
+      if (fresh.energyGroupCount <= 0)
+      {
+        throw_at_line(lineNo, "A $Depletion blokk előtt meg kell adni az $EnergyGroups blokkot.");
+      }
+      const std::size_t nuclideCount = read_count(input, lineNo, "$Depletion");
+      XsDepletion depletion;
+      // Nuklidonként: a név egy sorban, utána tetszőleges sorrendben a kulcsos sorok, a következő névig
+      while (true)
+      {
+        if (!std::getline(input, line))
+        {
+          throw_at_line(lineNo + 1, "$Depletion blokk vége előtt elfogyott a fájl.");
+        }
+        ++lineNo;
+        std::string dataLine = strip_comment(line);
+        trim_inplace(dataLine);
+        if (dataLine.empty())
+        {
+          continue;
+        }
+        if (dataLine == "$EndDepletion")
+        {
+          break;
+        }
+        std::string key, value;
+        if (!parse_key_value(dataLine, key, value))
+        {
+          if (depletion.index(dataLine) >= 0)
+          {
+            throw_at_line(lineNo, "Ez a nuklid név már szerepelt: " + dataLine);
+          }
+          XsNuclide nuclide;
+          nuclide.name = dataLine;
+          depletion.nuclides.push_back(nuclide);
+          continue;
+        }
+        if (depletion.nuclides.empty())
+        {
+          throw_at_line(lineNo, "A $Depletion blokkban a nuklid nevének kell elöl állnia.");
+        }
+        XsNuclide &nuclide = depletion.nuclides.back();
+        if (key == "mass" || key == "lambda")
+        {
+          const double x = parse_vector(value, lineNo, 1)[0];
+          if (key == "mass" ? (x <= 0.0) : (x < 0.0))
+          {
+            throw_at_line(lineNo, "Nem fizikai érték a(z) " + key + " sorban (" + nuclide.name + ").");
+          }
+          (key == "mass" ? nuclide.mass : nuclide.lambda) = x;
+        }
+        else if (key == "sigma_c" || key == "sigma_f" || key == "nu")
+        {
+          std::vector<double> &target = key == "sigma_c" ? nuclide.sigma_c : (key == "sigma_f" ? nuclide.sigma_f : nuclide.nu);
+          if (!target.empty())
+          {
+            throw_at_line(lineNo, "A(z) " + key + " sor már szerepelt a(z) " + nuclide.name + " nuklidnál.");
+          }
+          target = parse_vector(value, lineNo, fresh.energyGroupCount);
+          for (double x : target)
+          {
+            if (x < 0.0)
+            {
+              throw_at_line(lineNo, "Negatív érték a(z) " + key + " sorban (" + nuclide.name + ").");
+            }
+          }
+        }
+        else if (key == "capture" || key == "decay")
+        {
+          if (value.find(' ') != std::string::npos)
+          {
+            throw_at_line(lineNo, "A(z) " + key + " sorban egyetlen termék nuklid adható meg.");
+          }
+          (key == "capture" ? nuclide.captureProduct : nuclide.decayProduct) = value;
+        }
+        else if (key == "yield")
+        {
+          std::istringstream iss(value);
+          std::string product;
+          double fraction = 0.0;
+          while (iss >> product)
+          {
+            if (!(iss >> fraction) || fraction < 0.0)
+            {
+              throw_at_line(lineNo, "A yield sorban termék-hozam párok kellenek (" + nuclide.name + ").");
+            }
+            nuclide.yields.push_back(std::make_pair(product, fraction));
+          }
+        }
+        else
+        {
+          throw_at_line(lineNo, "Ismeretlen kulcs a $Depletion blokkban: " + key);
+        }
+      }
+
+      if (depletion.nuclides.size() != nuclideCount)
+      {
+        throw_at_line(lineNo, "A $Depletion blokkban " + std::to_string(nuclideCount) + " nuklid szerepel a fejlécben, de " +
+                                  std::to_string(depletion.nuclides.size()) + " van megadva.");
+      }
+      for (const XsNuclide &nuclide : depletion.nuclides)
+      {
+        if (nuclide.mass <= 0.0)
+        {
+          throw_at_line(lineNo, "Hiányzik a mass sor a(z) " + nuclide.name + " nuklidnál.");
+        }
+        if (nuclide.fissile() && nuclide.nu.empty())
+        {
+          throw_at_line(lineNo, "A hasadó " + nuclide.name + " nuklidnál meg kell adni a nu sort.");
+        }
+        std::vector<std::string> products;
+        products.push_back(nuclide.captureProduct);
+        products.push_back(nuclide.decayProduct);
+        for (const std::pair<std::string, double> &y : nuclide.yields)
+        {
+          products.push_back(y.first);
+        }
+        for (const std::string &product : products)
+        {
+          if (!product.empty() && depletion.index(product) < 0)
+          {
+            throw_at_line(lineNo, "Ismeretlen termék nuklid (" + nuclide.name + " -> " + product + ").");
+          }
+        }
+      }
+      fresh.depletion = depletion;
+      continue;
+    }
+
+    // --- 7) Feedback (hőmérséklet visszacsatolás anyagonként) ---
+    if (cleaned == "$Feedback")
+    {
+      if (fresh.materials.empty())
+      {
+        throw_at_line(lineNo, "A $Feedback blokk előtt meg kell adni a $Materials blokkot.");
+      }
+      const std::size_t feedbackCount = read_count(input, lineNo, "$Feedback");
+      std::vector<XsFeedback> feedback;
+      // Anyagonként: a név egy sorban, utána t_ref, sigma_a, nu_sigma_f kulcsos sorok (mind opcionális)
+      while (true)
+      {
+        if (!std::getline(input, line))
+        {
+          throw_at_line(lineNo + 1, "$Feedback blokk vége előtt elfogyott a fájl.");
+        }
+        ++lineNo;
+        std::string dataLine = strip_comment(line);
+        trim_inplace(dataLine);
+        if (dataLine.empty())
+        {
+          continue;
+        }
+        if (dataLine == "$EndFeedback")
+        {
+          break;
+        }
+        std::string key, value;
+        if (!parse_key_value(dataLine, key, value))
+        {
+          if (fresh.find_material(dataLine) == nullptr)
+          {
+            throw_at_line(lineNo, "Ismeretlen anyag a $Feedback blokkban: " + dataLine);
+          }
+          for (const XsFeedback &other : feedback)
+          {
+            if (other.material == dataLine)
+            {
+              throw_at_line(lineNo, "Ez az anyag már szerepelt a $Feedback blokkban: " + dataLine);
+            }
+          }
+          XsFeedback entry;
+          entry.material = dataLine;
+          feedback.push_back(entry);
+          continue;
+        }
+        if (feedback.empty())
+        {
+          throw_at_line(lineNo, "A $Feedback blokkban az anyag nevének kell elöl állnia.");
+        }
+        XsFeedback &entry = feedback.back();
+        if (key == "t_ref")
+        {
+          entry.referenceTemperature = parse_vector(value, lineNo, 1)[0];
+          if (entry.referenceTemperature <= 0.0)
+          {
+            throw_at_line(lineNo, "A t_ref pozitív kell legyen (" + entry.material + ").");
+          }
+        }
+        else if (key == "t_range")
+        {
+          const std::vector<double> range = parse_vector(value, lineNo, 2);
+          if (!(range[0] > 0.0) || !(range[1] > range[0]))
+          {
+            throw_at_line(lineNo, "A t_range két növekvő, pozitív hőmérséklet kell legyen (" + entry.material + ").");
+          }
+          entry.minTemperature = range[0];
+          entry.maxTemperature = range[1];
+        }
+        else if (key == "sigma_a" || key == "nu_sigma_f")
+        {
+          std::vector<double> &target = key == "sigma_a" ? entry.sigma_a : entry.nu_sigma_f;
+          if (!target.empty())
+          {
+            throw_at_line(lineNo, "A(z) " + key + " sor már szerepelt a(z) " + entry.material + " anyagnál.");
+          }
+          target = parse_vector(value, lineNo, fresh.energyGroupCount);
+        }
+        else
+        {
+          throw_at_line(lineNo, "Ismeretlen kulcs a $Feedback blokkban: " + key);
+        }
+      }
+      if (feedback.size() != feedbackCount)
+      {
+        throw_at_line(lineNo, "A $Feedback blokkban " + std::to_string(feedbackCount) + " anyag szerepel a fejlécben, de " +
+                                  std::to_string(feedback.size()) + " van megadva.");
+      }
+      fresh.feedback = feedback;
+      continue;
+    }
   }
 
   // Validációk
@@ -455,6 +803,137 @@ void load_xs(const std::string &path, XsLibrary &library)
     throw XsError("A fájl nem tartalmaz $EnergyGroups blokkot vagy az energia csoportok száma 0.");
   }
 
+  // Származtatott adatok egyszer, itt számolódnak ki
+  if (compile)
+  {
+    compile_xs(fresh);
+  }
+
   // Sikeres betöltés után átmásoljuk az eredményt
   library = fresh;
 }
+
+void compile_xs(XsLibrary &library)
+{
+  const int G = library.energyGroupCount;
+  const int M = static_cast<int>(library.materials.size());
+  const std::size_t n = static_cast<std::size_t>(M) * static_cast<std::size_t>(G);
+
+  XsCompiled c;
+  c.groupCount = G;
+  c.materialCount = M;
+  c.sigma_t.resize(n);
+  c.sigma_a.resize(n);
+  c.nu_sigma_f.resize(n);
+  c.chi.resize(n);
+  c.scatter.resize(n * static_cast<std::size_t>(G));
+  c.sigma_tr.resize(n);
+  c.diffusion.resize(n);
+  c.sigma_r.resize(n);
+  c.sigma_s_out.resize(n);
+  c.flags.assign(n, XS_FLAG_NONE);
+
+  // 1) Nyers adatok átmásolása egybefüggő tömbökbe
+  for (int m = 0; m < M; ++m)
+  {
+    const XsMaterial &mat = library.materials[static_cast<std::size_t>(m)];
+    for (int g = 0; g < G; ++g)
+    {
+      const std::size_t i = c.index(m, g);
+      c.sigma_t[i] = mat.sigma_t[static_cast<std::size_t>(g)];
+      c.sigma_a[i] = mat.sigma_a[static_cast<std::size_t>(g)];
+      c.nu_sigma_f[i] = mat.nu_sigma_f[static_cast<std::size_t>(g)];
+      c.chi[i] = mat.chi[static_cast<std::size_t>(g)];
+      for (int h = 0; h < G; ++h)
+      {
+        c.scatter[i * static_cast<std::size_t>(G) + static_cast<std::size_t>(h)] = mat.scatter[static_cast<std::size_t>(g)][static_cast<std::size_t>(h)];
+      }
+    }
+  }
+
+  // 2) Kiszórás összege és önszórás (sor menti összeg a G x G blokkokon)
+  std::vector<double> selfScatter(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double *row = c.scatter.data() + i * static_cast<std::size_t>(G);
+    double sum = 0.0;
+    for (int h = 0; h < G; ++h)
+    {
+      sum += row[h];
+    }
+    c.sigma_s_out[i] = sum;
+    selfScatter[i] = row[i % static_cast<std::size_t>(G)];
+  }
+
+  // 3) Származtatott mennyiségek: elágazás nélküli ciklusok, hogy a fordító vektorizálhassa.
+  //    Az adatban nincs anizotrópia (mu_bar), ezért sigma_tr = sigma_t.
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    c.sigma_tr[i] = c.sigma_t[i];
+    c.sigma_r[i] = c.sigma_t[i] - selfScatter[i];
+    c.diffusion[i] = c.sigma_tr[i] > 0.0 ? 1.0 / (3.0 * c.sigma_tr[i]) : 0.0;
+  }
+
+  // 4) Konzisztencia ellenőrzés ugyanígy, egy menetben az összes (anyag, csoport) párra
+  const double relTol = 1e-6;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const unsigned char balance = (c.sigma_a[i] + c.sigma_s_out[i] > c.sigma_t[i] * (1.0 + relTol)) ? XS_FLAG_BALANCE : 0;
+    const unsigned char negative = (c.sigma_t[i] < 0.0 || c.sigma_a[i] < 0.0 || c.nu_sigma_f[i] < 0.0 || c.chi[i] < 0.0) ? XS_FLAG_NEGATIVE : 0;
+    const unsigned char transport = (c.sigma_tr[i] <= 0.0) ? XS_FLAG_TRANSPORT : 0;
+    c.flags[i] = static_cast<unsigned char>(balance | negative | transport);
+  }
+  for (std::size_t i = 0; i < n * static_cast<std::size_t>(G); ++i)
+  {
+    if (c.scatter[i] < 0.0)
+    {
+      c.flags[i / static_cast<std::size_t>(G)] |= XS_FLAG_NEGATIVE;
+    }
+  }
+
+  // Hasadó anyagnál a chi összege 1 kell legyen (anyagonként egyszer, az első csoporthoz jegyezzük)
+  for (int m = 0; m < M; ++m)
+  {
+    double nuSfSum = 0.0;
+    double chiSum = 0.0;
+    for (int g = 0; g < G; ++g)
+    {
+      nuSfSum += c.nu_sigma_f[c.index(m, g)];
+      chiSum += c.chi[c.index(m, g)];
+    }
+    if (nuSfSum > 0.0 && (chiSum < 1.0 - 1e-3 || chiSum > 1.0 + 1e-3))
+    {
+      c.flags[c.index(m, 0)] |= XS_FLAG_CHI;
+    }
+  }
+
+  for (int m = 0; m < M; ++m)
+  {
+    for (int g = 0; g < G; ++g)
+    {
+      const unsigned char f = c.flags[c.index(m, g)];
+      if (f != XS_FLAG_NONE)
+      {
+        XsConsistencyIssue issue;
+        issue.material = m;
+        issue.group = g;
+        issue.flags = f;
+        c.issues.push_back(issue);
+      }
+    }
+  }
+
+  // Per-anyag másolat a kényelmes (nem hot loop) eléréshez
+  for (int m = 0; m < M; ++m)
+  {
+    XsMaterial &mat = library.materials[static_cast<std::size_t>(m)];
+    const std::size_t begin = c.index(m, 0);
+    const std::size_t end = begin + static_cast<std::size_t>(G);
+    mat.sigma_tr.assign(c.sigma_tr.begin() + static_cast<std::ptrdiff_t>(begin), c.sigma_tr.begin() + static_cast<std::ptrdiff_t>(end));
+    mat.diffusion.assign(c.diffusion.begin() + static_cast<std::ptrdiff_t>(begin), c.diffusion.begin() + static_cast<std::ptrdiff_t>(end));
+    mat.sigma_r.assign(c.sigma_r.begin() + static_cast<std::ptrdiff_t>(begin), c.sigma_r.begin() + static_cast<std::ptrdiff_t>(end));
+    mat.sigma_s_out.assign(c.sigma_s_out.begin() + static_cast<std::ptrdiff_t>(begin), c.sigma_s_out.begin() + static_cast<std::ptrdiff_t>(end));
+  }
+
+  library.compiled = c;
+}
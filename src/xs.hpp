@@ -2,8 +2,10 @@
 #define XS_HPP
 
 #include <cstddef>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 struct XsMaterial
@@ -17,7 +19,63 @@ struct XsMaterial
   std::vector<double> sigma_a;
   std::vector<double> nu_sigma_f;
   std::vector<double> chi;
-  std::vector<std::vector<double>> scatter;
+  std::vector<std::vector<double>> scatter; // scatter[from][to]: g -> g' szórás
+
+  // --- Származtatott csoportállandók (compile_xs tölti ki, nem a fájlból jönnek) ---
+  std::vector<double> sigma_tr;    // transzport KM (izotróp szórás: = sigma_t)
+  std::vector<double> diffusion;   // D = 1 / (3 * sigma_tr)
+  std::vector<double> sigma_r;     // removal: sigma_t - sigma_s(g -> g)
+  std::vector<double> sigma_s_out; // teljes kiszórás: sum_g' sigma_s(g -> g')
+};
+
+// Konzisztencia hibák bitjei (XsCompiled::flags)
+enum XsFlag : unsigned char
+{
+  XS_FLAG_NONE = 0,
+  XS_FLAG_BALANCE = 1,   // sigma_a + sum sigma_s > sigma_t
+  XS_FLAG_NEGATIVE = 2,  // negatív keresztmetszet
+  XS_FLAG_TRANSPORT = 4, // sigma_tr <= 0 --> D nem értelmezhető
+  XS_FLAG_CHI = 8        // hasadó anyag, de a chi összege nem 1
+};
+
+// Egy nem fizikai érték leírása (anyag, csoport, melyik hiba)
+struct XsConsistencyIssue
+{
+  int material = -1;
+  int group = -1;
+  unsigned char flags = XS_FLAG_NONE;
+};
+
+// Az összes anyag adatai egybefüggő tömbökben (anyag-major: [m * G + g]).
+// A hot loopok (assembly, forrás számítás) ezt használják, nem a per-anyag vectorokat.
+struct XsCompiled
+{
+  int groupCount = 0;
+  int materialCount = 0;
+
+  std::vector<double> sigma_t;
+  std::vector<double> sigma_a;
+  std::vector<double> nu_sigma_f;
+  std::vector<double> chi;
+  std::vector<double> scatter; // [(m * G + from) * G + to]
+
+  std::vector<double> sigma_tr;
+  std::vector<double> diffusion;
+  std::vector<double> sigma_r;
+  std::vector<double> sigma_s_out;
+
+  std::vector<unsigned char> flags; // [m * G + g], XsFlag bitek
+  std::vector<XsConsistencyIssue> issues;
+
+  std::size_t index(int material, int group) const
+  {
+    return static_cast<std::size_t>(material) * static_cast<std::size_t>(groupCount) + static_cast<std::size_t>(group);
+  }
+  // Egy anyag G x G szórási mátrixának eleje
+  const double *scatter_of(int material) const
+  {
+    return scatter.data() + static_cast<std::size_t>(material) * static_cast<std::size_t>(groupCount * groupCount);
+  }
 };
 
 struct XsBoundary
@@ -26,6 +84,89 @@ struct XsBoundary
   std::string type; // "vacuum" vagy "interface"
 };
 
+// Késő neutron adatok ($Kinetics blokk, opcionális; időfüggő számításhoz kell).
+// A családok (beta, lambda) minden hasadó anyagra közösek; a késő neutronok spektruma az anyag chi-je.
+struct XsKinetics
+{
+  std::vector<double> beta;     // családonként a késő neutron hányad
+  std::vector<double> lambda;   // családonként a bomlási állandó [1/s]
+  std::vector<double> velocity; // csoportonként a neutron sebesség [cm/s]
+
+  bool present() const { return !beta.empty(); }
+  int family_count() const { return static_cast<int>(beta.size()); }
+  double beta_total() const
+  {
+    double total = 0.0;
+    for (double b : beta)
+    {
+      total += b;
+    }
+    return total;
+  }
+};
+
+// Kiégési adatok ($Depletion blokk, opcionális; kiégés számításhoz kell).
+// Egy nuklid: moláris tömeg, bomlási állandó, csoportonkénti mikroszkopikus befogási és hasadási
+// keresztmetszet [barn], hasadásonkénti neutronszám, valamint a befogási / bomlási termék és a hasadási hozamok.
+// A keverékek (model fájl) minden komponensének itt kell szerepelnie (a tömeg miatt), a stabil, nem elnyelő
+// nuklidoknak elég a tömeg.
+struct XsNuclide
+{
+  std::string name;
+  double mass = 0.0;            // [g/mol]
+  double lambda = 0.0;          // [1/s]
+  std::vector<double> sigma_c;  // [barn], csoportonként (üres = 0)
+  std::vector<double> sigma_f;  // [barn], csoportonként (üres = 0)
+  std::vector<double> nu;       // csoportonként (csak hasadó nuklidnál)
+  std::string captureProduct;   // üres = a lánc itt véget ér
+  std::string decayProduct;
+  std::vector<std::pair<std::string, double>> yields; // hasadási termékek és hozamuk (hasadásonként)
+
+  bool fissile() const
+  {
+    for (double s : sigma_f)
+    {
+      if (s > 0.0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+struct XsDepletion
+{
+  std::vector<XsNuclide> nuclides; // a fájlbeli sorrendben (ez a kiégési mátrix sorrendje is)
+
+  bool present() const { return !nuclides.empty(); }
+  // Nuklid indexe (-1, ha nincs ilyen)
+  int index(const std::string &name) const
+  {
+    for (std::size_t i = 0; i < nuclides.size(); ++i)
+    {
+      if (nuclides[i].name == name)
+      {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+};
+
+// Hőmérséklet visszacsatolás ($Feedback blokk, opcionális; mode feedback használja). Anyagonként:
+//   x(T) = x + c_x (sqrt(T) - sqrt(T_ref)),  x = sigma_a (sigma_t ugyanannyival), nu_sigma_f
+// ahol a könyvtárbeli érték a T_ref hőmérséklethez tartozik (Doppler jellegű függés).
+struct XsFeedback
+{
+  std::string material;
+  double referenceTemperature = 900.0; // [K]
+  double minTemperature = 300.0;       // a sqrt(T) illesztés érvényességi tartománya [K] (t_range)
+  double maxTemperature = 3000.0;
+  std::vector<double> sigma_a;         // [1 / (cm sqrt(K))], csoportonként (üres = 0)
+  std::vector<double> nu_sigma_f;
+};
+
 struct XsLibrary
 {
   std::string title;
@@ -33,9 +174,17 @@ struct XsLibrary
   std::vector<std::string> energyGroupNames;
   std::vector<XsMaterial> materials;
   std::vector<XsBoundary> boundaries;
+  XsKinetics kinetics;
+  XsDepletion depletion;
+  std::vector<XsFeedback> feedback;
+  XsCompiled compiled; // származtatott adatok, compile_xs után érvényes
 
   const XsMaterial::SPtr find_material(const std::string &name) const;
   const XsBoundary *find_boundary(const std::string &name) const;
+  // Anyag indexe a materials tömbben (-1, ha nincs ilyen)
+  int material_index(const std::string &name) const;
+  // Egy anyag hőmérséklet visszacsatolási adatai (nullptr, ha nincs)
+  const XsFeedback *find_feedback(const std::string &material) const;
 };
 
 class XsError : public std::runtime_error
@@ -58,6 +207,14 @@ private:
   std::size_t m_line = 0;
 };
 
-void load_xs(const std::string &path, XsLibrary &library);
+// compile = false: csak a beolvasás, a compile_xs-t a hívó futtatja (pl. külön indítási fázisként)
+void load_xs(const std::string &path, XsLibrary &library, bool compile = true);
+
+// Származtatott mennyiségek (D, removal, kiszórás) kiszámolása és a konzisztencia ellenőrzés.
+// load_xs a végén meghívja; ha a library-t utólag módosítjuk, újra kell hívni.
+void compile_xs(XsLibrary &library);
+
+// Egy anyag keresztmetszetei a megadott hőmérsékleten (a $Feedback adatai szerint); compile_xs utána kell
+void apply_temperature(XsMaterial &material, const XsFeedback &feedback, double temperature);
 
 #endif // XS_HPP
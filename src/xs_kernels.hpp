@@ -0,0 +1,105 @@
+#ifndef XS_KERNELS_HPP
+#define XS_KERNELS_HPP
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Keresztmetszet-fogyasztó kernelek egy régióra (szórási forrás, hasadási forrás); a MOC régiónkénti forrása és a
+// blokk mátrixok G x G műveletei használják. A többi csoportciklus (FEM assembly és sajátérték, SN, fix forrás,
+// CMFD) futásidejű G-vel fut: ezek csoportonkénti Gauss–Seidel menetek vagy mátrix összegzések, nem régiónkénti
+// G x G műveletek.
+//
+// Egy régió adatai egymás mellett: phi[g], a szórási mátrix scatter[h * G + g] (XsCompiled::scatter_of).
+// A kernelek a csoportszámra sablonosak: G = 2, 4, 8 esetén a ciklusok fix hosszúak
+// (constexpr), a fordító teljesen ki tudja görgetni és vektorizálni a G x G műveleteket.
+// FixedG = 0 a generikus (futásidejű G) változat, ugyanazzal a kóddal.
+
+namespace xs_kernels
+{
+  // Csoportszám + lokális tároló típusa fix és generikus esetre
+  template <int FixedG>
+  struct Groups
+  {
+    typedef std::array<double, FixedG> Vec;
+    static constexpr int count(int) { return FixedG; }
+    static Vec make(int) { return Vec(); }
+  };
+
+  template <>
+  struct Groups<0>
+  {
+    typedef std::vector<double> Vec;
+    static int count(int runtimeG) { return runtimeG; }
+    static Vec make(int runtimeG) { return Vec(static_cast<std::size_t>(runtimeG), 0.0); }
+  };
+
+  // Az éppen támogatott specializációk (a dispatch ezekre vált)
+  inline bool is_specialized(int G)
+  {
+    return G == 2 || G == 4 || G == 8;
+  }
+
+  // Futásidejű G -> fordítási idejű specializáció kiválasztása.
+  // A fn egy generikus lambda, ami std::integral_constant<int, FixedG>-t kap (0 = generikus).
+  template <typename Fn>
+  auto dispatch_groups(int G, Fn &&fn) -> decltype(fn(std::integral_constant<int, 0>()))
+  {
+    switch (G)
+    {
+    case 2:
+      return fn(std::integral_constant<int, 2>());
+    case 4:
+      return fn(std::integral_constant<int, 4>());
+    case 8:
+      return fn(std::integral_constant<int, 8>());
+    default:
+      return fn(std::integral_constant<int, 0>());
+    }
+  }
+
+  // Szórási forrás (az önszórással együtt, mint a MOC izotrop forrásában): q[g] = sum_h scatter[h][g] * phi[h]
+  template <int FixedG>
+  inline void scatter_source(int runtimeG, const double *scatter, const double *phi, double *q)
+  {
+    const int G = Groups<FixedG>::count(runtimeG);
+    typename Groups<FixedG>::Vec acc = Groups<FixedG>::make(G);
+    for (int g = 0; g < G; ++g)
+    {
+      acc[g] = 0.0;
+    }
+    for (int h = 0; h < G; ++h)
+    {
+      const double ph = phi[h];
+      for (int g = 0; g < G; ++g)
+      {
+        acc[g] += scatter[h * G + g] * ph;
+      }
+    }
+    for (int g = 0; g < G; ++g)
+    {
+      q[g] = acc[g];
+    }
+  }
+
+  // Hasadási forrás: q[g] = chi[g] * invK * sum_h nuSf[h] * phi[h]. Visszatér a (k-val nem osztott) produkcióval.
+  template <int FixedG>
+  inline double fission_source(int runtimeG, const double *nuSf, const double *chi, const double *phi, double invK, double *q)
+  {
+    const int G = Groups<FixedG>::count(runtimeG);
+    double production = 0.0;
+    for (int h = 0; h < G; ++h)
+    {
+      production += nuSf[h] * phi[h];
+    }
+    const double scaled = production * invK;
+    for (int g = 0; g < G; ++g)
+    {
+      q[g] = chi[g] * scaled;
+    }
+    return production;
+  }
+}
+
+#endif // XS_KERNELS_HPP